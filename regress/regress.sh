@@ -0,0 +1,188 @@
+#!/bin/sh
+#
+# regress.sh
+# golden-output regression tests for Biome-BGC
+#
+# Runs the shipped scenarios (enf_test1_spinup, enf_test1 and oth) and a
+# spinup and model run of the enf_test1 site for each epc file in epc/,
+# and compares their restart and output files with the golden results in
+# regress/golden. A spinup of the enf_test1 site on representative met
+# years (-Y) is also run, and the model run from it is checked against
+# the one from the full spinup (epc_enf) within the tolerances in
+# regress/repyear_tolerance.txt. Run from the top directory of the distribution, after
+# building bgc, restart_cmp and output_diff ('make regress' in src/).
+#
+#   regress.sh      the results must match the golden results bit for bit
+#   regress.sh -t   the results must match within the tolerances in
+#                   regress/tolerance.txt
+#   regress.sh -b   replace the golden results with the results of this
+#                   build
+#
+# Each case runs from copies of the shipped ini files, rewritten to read
+# and write their files in regress/run/<case>, so the outputs/ and
+# restart/ directories are left alone.
+
+RUN=regress/run
+GOLD=regress/golden
+TOL=regress/tolerance.txt
+YTOL=regress/repyear_tolerance.txt
+EPCS="c3grass c4grass dbf dnf ebf enf shrub"
+
+mode=exact
+case "$1" in
+	"") ;;
+	-t) mode=tolerance ;;
+	-b) mode=bless ;;
+	*) echo "usage: $0 {-t | -b}"; exit 2 ;;
+esac
+
+for prog in ./bgc ./restart_cmp ./output_diff; do
+	if [ ! -x $prog ]; then
+		echo "$prog not found, build it first ('make regress' in src/)"
+		exit 2
+	fi
+done
+
+# copy ini file $1 to $RUN/$2/$3.ini, with the restart file and output
+# prefix moved to the run directory of case $2. Further sed expressions
+# can follow.
+mkini()
+{
+	src=$1; cname=$2; ini=$3; shift 3
+	sed -e "s|restart/[a-z_0-9]*\.endpoint|$RUN/$cname/$cname.endpoint|" \
+		-e "s|^outputs/[a-z_0-9]*|$RUN/$cname/$cname|" "$@" $src > $RUN/$cname/$ini.ini
+}
+
+# run bgc with ini file $RUN/$1/$2.ini and any further flags
+runbgc()
+{
+	cname=$1; ini=$2; shift 2
+	echo "running $cname/$ini.ini"
+	if ! ./bgc -s "$@" $RUN/$cname/$ini.ini; then
+		echo "bgc failed for $cname/$ini.ini"
+		failed=1
+	fi
+}
+
+rm -rf $RUN
+failed=0
+
+# shipped scenarios
+mkdir -p $RUN/enf_test1_spinup $RUN/enf_test1 $RUN/oth
+mkini ini/enf_test1_spinup.ini enf_test1_spinup enf_test1_spinup
+runbgc enf_test1_spinup enf_test1_spinup
+mkini ini/enf_test1.ini enf_test1 enf_test1
+runbgc enf_test1 enf_test1 -a
+mkini ini/oth.ini oth oth
+runbgc oth oth -g -a -n co2/ndep.txt
+
+# synthetic cases, one spinup and one model run from its endpoint for
+# each epc file, without daily output to keep the golden results small
+for epc in $EPCS; do
+	cname=epc_$epc
+	mkdir -p $RUN/$cname
+	mkini ini/enf_test1_spinup.ini $cname ${cname}_spinup -e "s|^epc/enf\.epc|epc/$epc.epc|"
+	runbgc $cname ${cname}_spinup
+	mkini ini/enf_test1.ini $cname $cname -e "s|^epc/enf\.epc|epc/$epc.epc|" \
+		-e "s|^0\( *(flag) *1 = read restart file\)|1\1|" \
+		-e "s|^1\( *(flag) *1 = write daily output\)|0\1|"
+	runbgc $cname $cname
+done
+
+# representative-year spinup of the enf_test1 site. 17 of its 44 met
+# years is the most that gives a shorter spinup block (85 years instead
+# of 88); with fewer, bgc refuses -Y as the block would be longer
+mkdir -p $RUN/repyear
+mkini ini/enf_test1_spinup.ini repyear repyear_spinup
+runbgc repyear repyear_spinup -Y 17
+mkini ini/enf_test1.ini repyear repyear -e "s|^0\( *(flag) *1 = read restart file\)|1\1|" \
+	-e "s|^1\( *(flag) *1 = write daily output\)|0\1|"
+runbgc repyear repyear
+
+if [ $failed -ne 0 ]; then
+	echo "regression runs FAILED"
+	exit 1
+fi
+
+# the large daily and monthly ascii files are not kept, they only repeat
+# the binary outputs
+rm -f $RUN/*/*.dayout.ascii $RUN/*/*.monavgout.ascii
+
+if [ $mode = bless ]; then
+	rm -rf $GOLD
+	mkdir -p $GOLD
+	for dir in $RUN/*; do
+		cname=`basename $dir`
+		mkdir -p $GOLD/$cname
+		for f in $dir/*; do
+			case $f in *.ini) ;; *) cp $f $GOLD/$cname/ ;; esac
+		done
+	done
+	echo "golden results replaced from this build"
+	exit 0
+fi
+
+if [ ! -d $GOLD ]; then
+	echo "no golden results in $GOLD, make them with 'regress.sh -b'"
+	exit 2
+fi
+
+# the restart tolerances are the 'restart' line of the tolerance file
+rabs=`awk '$1 == "restart" { print $2 }' $TOL`
+rrel=`awk '$1 == "restart" { print $3 }' $TOL`
+
+nfile=0
+nfail=0
+for gold in $GOLD/*/*; do
+	cname=`basename \`dirname $gold\``
+	name=`basename $gold`
+	new=$RUN/$cname/$name
+	nfile=`expr $nfile + 1`
+	if [ ! -f $new ]; then
+		echo "FAIL $cname/$name: not written"
+		nfail=`expr $nfail + 1`
+		continue
+	fi
+	if [ $mode = exact ]; then
+		if cmp -s $gold $new; then
+			echo "ok   $cname/$name"
+		else
+			echo "FAIL $cname/$name: differs"
+			nfail=`expr $nfail + 1`
+		fi
+		continue
+	fi
+	case $name in
+		*.endpoint)
+			./restart_cmp -q -a ${rabs:-0} -r ${rrel:-0} $gold $new > $RUN/$cname/$name.diff ;;
+		*.dayout|*.monavgout|*.annavgout|*.annout)
+			./output_diff -q -t $TOL $RUN/$cname/$cname.ini $gold $new > $RUN/$cname/$name.diff ;;
+		*)
+			# text outputs repeat the binary outputs they are written from
+			echo "--   $cname/$name: not compared in tolerance mode"
+			continue ;;
+	esac
+	if [ $? -eq 0 ]; then
+		echo "ok   $cname/$name"
+	else
+		echo "FAIL $cname/$name"
+		cat $RUN/$cname/$name.diff
+		nfail=`expr $nfail + 1`
+	fi
+done
+
+echo
+echo "$nfail of $nfile files failed ($mode comparison)"
+
+# the -Y spinup is not the full spinup, so its model run is held to the
+# looser tolerances of $YTOL; the table gives the residuals
+echo
+echo "representative-year spinup (-Y 17) against the full spinup:"
+if ./output_diff -t $YTOL $RUN/repyear/repyear.ini $RUN/epc_enf/epc_enf.annout \
+	$RUN/repyear/repyear.annout; then
+	echo "ok   repyear/repyear.annout within the tolerances of $YTOL"
+else
+	echo "FAIL repyear/repyear.annout over the tolerances of $YTOL"
+	nfail=`expr $nfail + 1`
+fi
+[ $nfail -eq 0 ]
@@ -0,0 +1,289 @@
+/*
+batch_run.c
+start the worker processes, and supervise them until the site queue is
+empty
+
+Each worker takes sites from the shared queue and runs them with
+point_run(). A site whose point_run() returns an error is marked failed
+by its worker, which goes on with the queue. A site that ends the worker
+process by a crash is marked failed by the supervisor, which starts a
+new worker in the same slot while sites remain in the queue.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#include "batchbgc.h"
+
+static void batch_worker(batch_struct* batch, int slot);
+
+static const char* batch_status_names[5] = {"queued", "running", "done", "failed", "stopped"};
+
+/* name of a site status (SITE_*) */
+const char* batch_status_name(int status)
+{
+	return ((status >= 0 && status < 5) ? batch_status_names[status] : "unknown");
+}
+
+/* write the dashboard: one line for each site with its status and its
+last spinup telemetry record, and an estimate of the time it still
+needs at its rate so far. The file is written under a temporary name
+and renamed, so that a reader never sees it half written. */
+int batch_dashboard(const batch_struct* batch)
+{
+	int ok = 1;
+	int i;
+	char tmpname[256+8];
+	FILE* fp;
+	double now, elapsed, eta;
+	const batch_site_struct* site;
+	spinup_telem_struct rec;
+
+	if (!batch->dashboard) return (0);
+	sprintf(tmpname, "%.256s.tmp", batch->dashboard);
+	if (!(fp = fopen(tmpname, "w")))
+	{
+		bgc_printf(BV_ERROR, "Error opening %s for the dashboard: %s\n",tmpname,strerror(errno));
+		return (1);
+	}
+
+	now = (double)time(NULL);
+	fprintf(fp, "site\tstatus\tworker\tspinyears\tphase\tsoilc\tsoilc_trend\t"
+		"forecast_years\telapsed_s\teta_s\n");
+	for (i=0 ; i<batch->hdr->nsites ; i++)
+	{
+		site = &batch->sites[i];
+		rec = site->telem;
+		elapsed = 0.0;
+		if (site->start > 0.0) elapsed = ((site->end > 0.0) ? site->end : now) - site->start;
+		fprintf(fp, "%s\t%s\t%d", site->ini, batch_status_name(site->status), site->worker);
+		if (rec.spinyears > 0)
+		{
+			fprintf(fp, "\t%d\t%s\t%.6f\t%.6g", rec.spinyears, bgc_phase_name(rec.phase),
+				rec.soilc, rec.soilc_trend);
+			if (rec.forecast >= 0.0) fprintf(fp, "\t%.0f", rec.forecast);
+			else fprintf(fp, "\tNA");
+		}
+		else
+		{
+			fprintf(fp, "\tNA\tNA\tNA\tNA\tNA");
+		}
+		fprintf(fp, "\t%.0f", elapsed);
+
+		/* time left at the spinup rate so far */
+		if (site->status == SITE_RUNNING && rec.spinyears > 0 && rec.forecast >= 0.0 &&
+			rec.wall > 0.0)
+		{
+			eta = rec.forecast * rec.wall / (double)rec.spinyears;
+			fprintf(fp, "\t%.0f\n", eta);
+		}
+		else
+		{
+			fprintf(fp, "\tNA\n");
+		}
+	}
+	if (ferror(fp)) ok=0;
+	if (fclose(fp)) ok=0;
+	if (ok && rename(tmpname, batch->dashboard))
+	{
+		bgc_printf(BV_ERROR, "Error renaming %s to %s: %s\n",tmpname,batch->dashboard,strerror(errno));
+		ok=0;
+	}
+
+	return (!ok);
+}
+
+/* start a worker process in a slot of the worker table */
+int batch_spawn(batch_struct* batch, int slot)
+{
+	int ok = 1;
+	pid_t pid;
+	batch_worker_struct* w = &batch->workers[slot];
+
+	/* flush the supervisor output so it is not written twice */
+	fflush(NULL);
+	w->site = -1;
+	if ((pid = fork()) < 0)
+	{
+		bgc_printf(BV_ERROR, "Error starting worker %d: %s\n",slot,strerror(errno));
+		ok=0;
+	}
+	else if (pid == 0)
+	{
+		batch_worker(batch, slot);
+	}
+	else
+	{
+		w->pid = pid;
+		w->nspawn++;
+	}
+
+	return (!ok);
+}
+
+/* wait for the workers, replacing any that end while running a site,
+until the queue is empty and every worker has exited */
+int batch_supervise(batch_struct* batch)
+{
+	int ok = 1;
+	int i, status, slot, nactive = 0;
+	int forwarded = 0;
+	pid_t pid;
+	double lastdash = 0.0;
+	batch_header_struct* hdr = batch->hdr;
+	batch_site_struct* site;
+
+	for (i=0 ; i<hdr->nworkers ; i++)
+	{
+		if (batch->workers[i].pid) nactive++;
+	}
+
+	while (nactive > 0)
+	{
+		/* on SIGTERM or SIGINT, pass the signal on to the workers, which
+		stop their sites cleanly and start no more */
+		if (bgc_stop_signal && !forwarded)
+		{
+			bgc_printf(BV_WARN, "Stopping the batch on signal %d\n",(int)bgc_stop_signal);
+			for (i=0 ; i<hdr->nworkers ; i++)
+			{
+				if (batch->workers[i].pid) kill(batch->workers[i].pid, SIGTERM);
+			}
+			forwarded = 1;
+		}
+
+		/* with a dashboard, poll the workers and rewrite it every
+		BATCH_DASH_INTERVAL seconds */
+		if ((pid = waitpid(-1, &status, batch->dashboard ? WNOHANG : 0)) < 0)
+		{
+			if (errno == EINTR) continue;
+			bgc_printf(BV_ERROR, "Error waiting for workers: %s\n",strerror(errno));
+			ok=0;
+			break;
+		}
+		if (pid == 0)
+		{
+			if ((double)time(NULL) - lastdash >= BATCH_DASH_INTERVAL)
+			{
+				if (batch_dashboard(batch))
+				{
+					bgc_printf(BV_WARN, "Warning: could not write the dashboard file %s\n",batch->dashboard);
+				}
+				lastdash = (double)time(NULL);
+			}
+			sleep(1);
+			continue;
+		}
+		for (slot=0 ; slot<hdr->nworkers && batch->workers[slot].pid != pid ; slot++);
+		if (slot == hdr->nworkers) continue;
+		nactive--;
+		batch->workers[slot].pid = 0;
+
+		/* a worker only exits by itself once the queue is empty, so if
+		it was running a site, that site ended the process */
+		if (batch->workers[slot].site >= 0)
+		{
+			site = &batch->sites[batch->workers[slot].site];
+			site->status = SITE_FAILED;
+			site->end = (double)time(NULL);
+			if (WIFSIGNALED(status))
+			{
+				bgc_printf(BV_WARN, "Site %s failed: worker %d (pid %ld) killed by signal %d\n",
+					site->ini, slot, (long)pid, WTERMSIG(status));
+			}
+			else
+			{
+				bgc_printf(BV_WARN, "Site %s failed: worker %d (pid %ld) exited with status %d\n",
+					site->ini, slot, (long)pid, WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+			}
+			batch->workers[slot].site = -1;
+
+			/* replace the worker if there is work left */
+			if (hdr->next_site < hdr->nsites && !bgc_stop_signal)
+			{
+				if (batch_spawn(batch, slot))
+				{
+					bgc_printf(BV_ERROR, "Error in call to batch_spawn() from batch_supervise()\n");
+					ok=0;
+				}
+				else nactive++;
+			}
+		}
+	}
+
+	/* a site still queued or running here was lost with a worker that
+	could not be replaced. After a signal, the sites that were not
+	started stay queued. */
+	for (i=0 ; i<hdr->nsites ; i++)
+	{
+		site = &batch->sites[i];
+		if (bgc_stop_signal && site->status == SITE_QUEUED) continue;
+		if (site->status == SITE_QUEUED || site->status == SITE_RUNNING)
+		{
+			bgc_printf(BV_WARN, "Site %s was not run\n",site->ini);
+			site->status = SITE_FAILED;
+		}
+	}
+
+	/* the final state of every site */
+	if (batch->dashboard && batch_dashboard(batch))
+	{
+		bgc_printf(BV_WARN, "Warning: could not write the dashboard file %s\n",batch->dashboard);
+	}
+
+	return (!ok);
+}
+
+/* worker process: run sites from the queue until it is empty */
+static void batch_worker(batch_struct* batch, int slot)
+{
+	long i;
+	int rc;
+	batch_header_struct* hdr = batch->hdr;
+	batch_worker_struct* w = &batch->workers[slot];
+	batch_site_struct* site;
+	const batch_met_struct* met;
+	point_shared_struct shared;
+
+	while (!bgc_stop_signal && (i = __sync_fetch_and_add(&hdr->next_site, 1)) < hdr->nsites)
+	{
+		site = &batch->sites[i];
+		w->site = (int) i;
+		site->worker = slot;
+		site->start = (double)time(NULL);
+		site->status = SITE_RUNNING;
+		batch->opts.telem_last = &site->telem;
+		batch->opts.container_site = (int) i;
+
+		if (site->met >= 0)
+		{
+			/* met and epc from the shared segment */
+			met = &batch->mets[site->met];
+			shared.ndays = met->ndays;
+			shared.tmax = batch->data + met->offset;
+			shared.tmin = shared.tmax + met->ndays;
+			shared.prcp = shared.tmin + met->ndays;
+			shared.vpd = shared.prcp + met->ndays;
+			shared.swavgfd = shared.vpd + met->ndays;
+			shared.dayl = shared.swavgfd + met->ndays;
+			shared.epc = (site->epc >= 0) ? &batch->epcs[site->epc] : NULL;
+			shared.metarr = NULL;
+			shared.cache = NULL;
+			shared.initext = NULL;
+			rc = point_run(site->ini, &batch->opts, &shared);
+		}
+		else
+		{
+			rc = point_run(site->ini, &batch->opts, NULL);
+		}
+
+		site->end = (double)time(NULL);
+		if (rc == BGC_EXIT_STOPPED) site->status = SITE_STOPPED;
+		else site->status = rc ? SITE_FAILED : SITE_DONE;
+		w->site = -1;
+	}
+
+	exit(EXIT_SUCCESS);
+}
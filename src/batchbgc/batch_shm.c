@@ -0,0 +1,294 @@
+/*
+batch_shm.c
+read the site list, the met files and the epc files once, and publish
+them to the workers in a POSIX shared memory segment
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#include "batchbgc.h"
+
+/* round a segment offset up to a multiple of 8 bytes */
+#define SHM_ALIGN(n) (((n) + 7L) & ~7L)
+
+/* met data held by the supervisor until the segment is sized */
+typedef struct
+{
+	char name[128];
+	metdata_struct md;
+} metbuf_struct;
+
+static int batch_epc_name(file init, char* name);
+
+int batch_publish(const char* listname, int nworkers, batch_struct* batch)
+{
+	int ok = 1;
+	int i, j, k, fd;
+	double* arr[6];
+	int nsites = 0, maxsites = 0, nmet = 0, nepc = 0;
+	char line[256], name[128];
+	char shmname[64];
+	char (*ini)[128] = NULL;
+	int *sitemet = NULL, *siteepc = NULL;
+	char (*epcname)[128] = NULL;
+	epconst_struct* epcs = NULL;
+	metbuf_struct* mets = NULL;
+	long ndata = 0;
+	long size;
+	file list, init, epcf;
+	point_struct point;
+	batch_header_struct* hdr;
+	void* seg = NULL;
+
+	/* read the site list, one ini file name per line. Blank lines and
+	lines starting with # are skipped. */
+	strcpy(list.name, listname);
+	if (file_open(&list, 'i'))
+	{
+		bgc_printf(BV_ERROR, "Error opening site list %s: batch_publish()\n",listname);
+		ok=0;
+	}
+	while (ok && fgets(line, sizeof(line), list.ptr))
+	{
+		if (sscanf(line, "%127s", name) != 1 || name[0] == '#') continue;
+		if (nsites == maxsites)
+		{
+			maxsites = maxsites ? 2*maxsites : 64;
+			if (!(ini = realloc(ini, maxsites * sizeof(*ini))))
+			{
+				bgc_printf(BV_ERROR, "Error allocating for site list: batch_publish()\n");
+				ok=0;
+			}
+		}
+		if (ok) strcpy(ini[nsites++], name);
+	}
+	if (ok) fclose(list.ptr);
+	if (ok && nsites == 0)
+	{
+		bgc_printf(BV_ERROR, "Error: no sites in %s: batch_publish()\n",listname);
+		ok=0;
+	}
+
+	/* per-site indices, and room for one met and epc file per site */
+	if (ok && (!(sitemet = (int*) malloc(nsites * sizeof(int))) ||
+		!(siteepc = (int*) malloc(nsites * sizeof(int))) ||
+		!(mets = (metbuf_struct*) calloc(nsites, sizeof(metbuf_struct))) ||
+		!(epcname = malloc(nsites * sizeof(*epcname))) ||
+		!(epcs = (epconst_struct*) malloc(nsites * sizeof(epconst_struct)))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating for site tables: batch_publish()\n");
+		ok=0;
+	}
+
+	/* read each distinct met and epc file once. A site whose ini file
+	cannot be scanned here gets no shared data, and reads its own files
+	in the worker, where any error only affects that site. */
+	for (i=0 ; ok && i<nsites ; i++)
+	{
+		sitemet[i] = -1;
+		siteepc[i] = -1;
+		strcpy(init.name, ini[i]);
+		if (file_open(&init, 'i'))
+		{
+			bgc_printf(BV_WARN, "Warning: cannot open %s, site is not shared\n",ini[i]);
+			continue;
+		}
+		if (fgets(point.header, 100, init.ptr) == NULL || met_init(init, &point))
+		{
+			bgc_printf(BV_WARN, "Warning: cannot read met block of %s, site is not shared\n",ini[i]);
+			fclose(init.ptr);
+			continue;
+		}
+		for (j=0 ; j<nmet && strcmp(mets[j].name, point.metf.name) ; j++);
+		if (j == nmet)
+		{
+			strcpy(mets[j].name, point.metf.name);
+			if (met_parse(point.metf, point.nhead, 0, &mets[j].md))
+			{
+				bgc_printf(BV_WARN, "Warning: cannot read met file %s, site %s is not shared\n",
+					point.metf.name, ini[i]);
+				memset(&mets[j], 0, sizeof(metbuf_struct));
+				j = -1;
+			}
+			else
+			{
+				ndata += 6L * mets[j].md.ndays;
+				nmet++;
+			}
+		}
+		fclose(point.metf.ptr);
+		sitemet[i] = j;
+
+		/* epc file, from the EPC_FILE block */
+		if (j >= 0 && !batch_epc_name(init, epcf.name))
+		{
+			for (k=0 ; k<nepc && strcmp(epcname[k], epcf.name) ; k++);
+			if (k == nepc)
+			{
+				if (file_open(&epcf, 'r') == 0)
+				{
+					if (epc_read(epcf, &epcs[k]) == 0)
+					{
+						strcpy(epcname[k], epcf.name);
+						nepc++;
+					}
+					else k = -1;
+					fclose(epcf.ptr);
+				}
+				else k = -1;
+			}
+			siteepc[i] = k;
+		}
+		fclose(init.ptr);
+	}
+
+	/* size, create and map the segment. The name is unlinked straight
+	away, so the segment goes when the last process using it exits. */
+	if (ok)
+	{
+		size = SHM_ALIGN((long)sizeof(batch_header_struct));
+		size += SHM_ALIGN((long)nsites * sizeof(batch_site_struct));
+		size += SHM_ALIGN((long)nworkers * sizeof(batch_worker_struct));
+		size += SHM_ALIGN((long)nmet * sizeof(batch_met_struct));
+		size += SHM_ALIGN((long)nepc * sizeof(epconst_struct));
+		size += ndata * (long)sizeof(double);
+
+		sprintf(shmname, "/bgcbatch.%ld", (long)getpid());
+		if ((fd = shm_open(shmname, O_CREAT | O_EXCL | O_RDWR, 0600)) < 0)
+		{
+			bgc_printf(BV_ERROR, "Error creating shared memory %s: %s\n",shmname,strerror(errno));
+			ok=0;
+		}
+		else
+		{
+			if (ftruncate(fd, size) ||
+				(seg = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED)
+			{
+				bgc_printf(BV_ERROR, "Error mapping shared memory %s: %s\n",shmname,strerror(errno));
+				ok=0;
+			}
+			close(fd);
+			shm_unlink(shmname);
+		}
+	}
+
+	/* fill in the segment */
+	if (ok)
+	{
+		memset(seg, 0, size);
+		hdr = batch->hdr = (batch_header_struct*) seg;
+		hdr->size = size;
+		hdr->nsites = nsites;
+		hdr->nworkers = nworkers;
+		hdr->nmet = nmet;
+		hdr->nepc = nepc;
+		hdr->next_site = 0;
+		hdr->site_off = SHM_ALIGN((long)sizeof(batch_header_struct));
+		hdr->worker_off = hdr->site_off + SHM_ALIGN((long)nsites * sizeof(batch_site_struct));
+		hdr->met_off = hdr->worker_off + SHM_ALIGN((long)nworkers * sizeof(batch_worker_struct));
+		hdr->epc_off = hdr->met_off + SHM_ALIGN((long)nmet * sizeof(batch_met_struct));
+		hdr->data_off = hdr->epc_off + SHM_ALIGN((long)nepc * sizeof(epconst_struct));
+		batch->sites = (batch_site_struct*) ((char*)seg + hdr->site_off);
+		batch->workers = (batch_worker_struct*) ((char*)seg + hdr->worker_off);
+		batch->mets = (batch_met_struct*) ((char*)seg + hdr->met_off);
+		batch->epcs = (epconst_struct*) ((char*)seg + hdr->epc_off);
+		batch->data = (double*) ((char*)seg + hdr->data_off);
+
+		for (i=0 ; i<nsites ; i++)
+		{
+			strcpy(batch->sites[i].ini, ini[i]);
+			batch->sites[i].met = sitemet[i];
+			batch->sites[i].epc = siteepc[i];
+			batch->sites[i].status = SITE_QUEUED;
+			batch->sites[i].worker = -1;
+		}
+		for (i=0 ; i<nworkers ; i++)
+		{
+			batch->workers[i].pid = 0;
+			batch->workers[i].site = -1;
+		}
+		ndata = 0;
+		for (j=0 ; j<nmet ; j++)
+		{
+			strcpy(batch->mets[j].name, mets[j].name);
+			batch->mets[j].ndays = mets[j].md.ndays;
+			batch->mets[j].offset = ndata;
+			arr[0] = mets[j].md.tmax;
+			arr[1] = mets[j].md.tmin;
+			arr[2] = mets[j].md.prcp;
+			arr[3] = mets[j].md.vpd;
+			arr[4] = mets[j].md.swavgfd;
+			arr[5] = mets[j].md.dayl;
+			for (k=0 ; k<6 ; k++)
+			{
+				memcpy(batch->data + ndata, arr[k], mets[j].md.ndays * sizeof(double));
+				ndata += mets[j].md.ndays;
+			}
+		}
+		for (k=0 ; k<nepc ; k++)
+		{
+			batch->epcs[k] = epcs[k];
+		}
+
+		bgc_printf(BV_PROGRESS, "Published %d sites, %d met files and %d epc files (%ld bytes) to shared memory\n",
+			nsites, nmet, nepc, size);
+	}
+
+	/* the supervisor copies are no longer needed */
+	if (mets)
+	{
+		for (j=0 ; j<nsites ; j++)
+		{
+			metdata_free(&mets[j].md);
+		}
+	}
+	free(mets);
+	free(ini);
+	free(sitemet);
+	free(siteepc);
+	free(epcname);
+	free(epcs);
+
+	return (!ok);
+}
+
+/* unmap the shared segment */
+int batch_unmap(batch_struct* batch)
+{
+	int ok = 1;
+
+	if (batch->hdr && munmap(batch->hdr, batch->hdr->size))
+	{
+		bgc_printf(BV_WARN, "Warning: error unmapping shared memory: %s\n",strerror(errno));
+		ok=0;
+	}
+	batch->hdr = NULL;
+
+	return (!ok);
+}
+
+/* scan an ini file forward to the EPC_FILE block, and read the epc file
+name from it */
+static int batch_epc_name(file init, char* name)
+{
+	int ok = 1;
+	char keyword[128];
+
+	do
+	{
+		if (fscanf(init.ptr, "%127s%*[^\n]", keyword) != 1)
+		{
+			ok=0;
+			break;
+		}
+	} while (strcmp(keyword, "EPC_FILE"));
+	if (ok && fscanf(init.ptr, "%127s%*[^\n]", name) != 1)
+	{
+		ok=0;
+	}
+
+	return (!ok);
+}
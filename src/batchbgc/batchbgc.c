@@ -0,0 +1,260 @@
+/*
+batchbgc.c
+front-end to BIOME-BGC for running a list of point simulations on a
+pool of worker processes
+Uses BIOME-BGC function library
+
+The supervisor reads each distinct met and epc file named by the site
+ini files once, and publishes them in POSIX shared memory together with
+the site queue. Worker processes take sites from the queue and run them
+with point_run(), so a site that exits or crashes only ends its own
+worker, which the supervisor logs and replaces.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#include "batchbgc.h"
+
+char *argv_zero = NULL;
+signed char cli_mode = MODE_INI;
+
+static void batch_print_usage(void)
+{
+	bgc_printf(BV_ERROR, "\nusage: %s {-l <logfile>} {-s | -v [0..4]} {-p} {-V} {-a} {-u | -g | -m} {-b <mode>} {-n <ndepfile>} {-T <telemetryfile>} {-Y <years>} {-K <years>} {-W <seconds>} {-y <years>} {-c} {-j <workers>} {-o <statusfile>} {-D <dashboardfile>} {-C <container>} <site list file>\n\n", argv_zero);
+	bgc_printf(BV_ERROR, "       The site list file has one point ini file name per line.\n");
+	bgc_printf(BV_ERROR, "       -j <workers> number of worker processes, default one per processor\n");
+	bgc_printf(BV_ERROR, "       -W <seconds> stop each site early after this much wall clock time\n");
+	bgc_printf(BV_ERROR, "       -y <years> stop each site early after this many simulated years\n");
+	bgc_printf(BV_ERROR, "       -c continue the sites that stopped early\n");
+	bgc_printf(BV_ERROR, "       -o <statusfile> write the final status of each site to statusfile\n");
+	bgc_printf(BV_ERROR, "       -D <dashboardfile> keep a summary of the progress of every site in dashboardfile\n");
+	bgc_printf(BV_ERROR, "       -C <container> write the output files of all the sites into one indexed container\n");
+	bgc_printf(BV_ERROR, "       The other flags are those of the point model, see USAGE.TXT\n");
+}
+
+int main(int argc, char *argv[])
+{
+	batch_struct batch;
+	file status_file;
+	file telem_file;
+	file container_file;
+	int c, i, ok = 1;
+	int nworkers = 0;
+	int writestatus = 0;
+	int writetelem = 0;
+	int writecontainer = 0;
+	int ndone = 0, nfailed = 0, nstopped = 0;
+	struct sigaction sa;
+	extern signed char summary_sanity;
+	extern signed char bgc_verbosity;
+	extern int optind, opterr;
+	extern char *optarg;
+
+	memset(&batch, 0, sizeof(batch_struct));
+	batch.opts.balance_mode = BALANCE_DAILY;
+	batch.opts.balance_interval = 1;
+	batch.opts.stats = NULL;
+
+	/* Store command name for use by batch_print_usage() */
+	argv_zero = (char *)malloc(strlen(argv[0])+1);
+	strncpy(argv_zero, argv[0], strlen(argv[0])+1);
+
+	/* Process command line arguments */
+	opterr = 0;
+	while((c = getopt(argc, argv, "pVsl:v:ugmn:ab:T:Y:K:W:y:cj:o:D:C:")) != -1)
+	{
+		switch(c)
+		{
+			case 'V':
+				bgc_printf(BV_ERROR, "BiomeBGC version %s (built %s %s by %s on %s)\n", VERS, __DATE__, __TIME__, USER, HOST);
+				exit(EXIT_SUCCESS);
+				break;
+			case 's':
+				bgc_verbosity = BV_SILENT;
+				break;
+			case 'v':
+				bgc_verbosity = bgc_verbosity_decode(optarg);
+				if (bgc_verbosity == BV_UNKNOWN) exit(EXIT_FAILURE);
+				break;
+			case 'l':
+				if (bgc_logfile_setup(optarg)) exit(EXIT_FAILURE);
+				bgc_printf(BV_DIAG, "Using logfile for output.\n");
+				break;
+			case 'p':
+				summary_sanity = SANE;
+				break;
+			case 'u':
+				cli_mode = MODE_SPINUP;
+				break;
+			case 'm':
+				cli_mode = MODE_MODEL;
+				break;
+			case 'g':
+				cli_mode = MODE_SPINNGO;
+				break;
+			case 'a':
+				batch.opts.bgc_ascii = 1;
+				break;
+			case 'n':  /* Nitrogen deposition file */
+				strcpy(batch.opts.ndep_file.name,optarg);
+				batch.opts.readndepfile = 1;
+				break;
+			case 'b':  /* mass balance check mode */
+				batch.opts.balance_mode = bgc_balance_decode(optarg, &batch.opts.balance_interval);
+				if (batch.opts.balance_mode == BALANCE_UNKNOWN) exit(EXIT_FAILURE);
+				break;
+			case 'T':  /* spinup telemetry file, shared by the workers */
+				strcpy(telem_file.name,optarg);
+				writetelem = 1;
+				break;
+			case 'Y':  /* spinup on representative met years */
+				batch.opts.repyears = atoi(optarg);
+				break;
+			case 'K':  /* coarse spinup steps */
+				batch.opts.spincoarse = atoi(optarg);
+				break;
+			case 'W':  /* wall clock budget of each site */
+				batch.opts.stop_wall = atoi(optarg);
+				break;
+			case 'y':  /* simulated year budget of each site */
+				batch.opts.stop_years = atoi(optarg);
+				break;
+			case 'c':  /* continue stopped sites */
+				batch.opts.resume = 1;
+				break;
+			case 'j':  /* number of worker processes */
+				nworkers = atoi(optarg);
+				break;
+			case 'o':  /* site status file */
+				strcpy(status_file.name,optarg);
+				writestatus = 1;
+				break;
+			case 'D':  /* dashboard file */
+				batch.dashboard = optarg;
+				break;
+			case 'C':  /* multi-site output container */
+				strcpy(container_file.name,optarg);
+				writecontainer = 1;
+				break;
+			case '?':
+				break;
+			default:
+				break;
+		}
+	}
+
+	if (optind >= argc)
+	{
+		batch_print_usage();
+		exit(EXIT_FAILURE);
+	}
+	if (nworkers <= 0) nworkers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	if (nworkers <= 0) nworkers = 1;
+
+	/* the telemetry file is written with its column names, and opened
+	again for appending, so that the lines of the workers do not
+	overwrite each other. Continued sites add to the file as it is. */
+	if (writetelem)
+	{
+		if (file_open(&telem_file,batch.opts.resume ? 'e' : 'o') ||
+			(ftell(telem_file.ptr) == 0 && bgc_telemetry_header(telem_file.ptr)) ||
+			fclose(telem_file.ptr) || !(telem_file.ptr = fopen(telem_file.name, "a")))
+		{
+			bgc_printf(BV_ERROR, "Error opening spinup telemetry file, batchbgc.c\n");
+			exit(EXIT_FAILURE);
+		}
+		batch.opts.telemetry = telem_file.ptr;
+	}
+
+	/* the output container is started empty, or kept for continued
+	sites, and then each site opens it for appending */
+	if (writecontainer)
+	{
+		if (file_open(&container_file,batch.opts.resume ? 'a' : 'w') || fclose(container_file.ptr))
+		{
+			bgc_printf(BV_ERROR, "Error opening output container, batchbgc.c\n");
+			exit(EXIT_FAILURE);
+		}
+		container_file.ptr = NULL;
+		batch.opts.container = container_file.name;
+	}
+
+	/* stop cleanly on SIGTERM and SIGINT. Without SA_RESTART, so that
+	the supervisor is woken from waitpid() to pass the signal on. The
+	workers inherit the handler. */
+	memset(&sa, 0, sizeof(struct sigaction));
+	sa.sa_handler = bgc_stop_handler;
+	sigemptyset(&sa.sa_mask);
+	if (sigaction(SIGTERM, &sa, NULL) || sigaction(SIGINT, &sa, NULL))
+	{
+		bgc_printf(BV_ERROR, "Error setting the signal handlers: %s\n",strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+
+	/* read the site list and the shared inputs */
+	if (batch_publish(argv[optind], nworkers, &batch))
+	{
+		bgc_printf(BV_ERROR, "Error in call to batch_publish() from batchbgc.c... Exiting\n");
+		exit(EXIT_FAILURE);
+	}
+	if (nworkers > batch.hdr->nsites) nworkers = batch.hdr->nsites;
+	batch.hdr->nworkers = nworkers;
+
+	/* start the workers and wait for the queue to empty */
+	for (i=0 ; ok && i<nworkers ; i++)
+	{
+		if (batch_spawn(&batch, i))
+		{
+			bgc_printf(BV_ERROR, "Error in call to batch_spawn() from batchbgc.c\n");
+			ok=0;
+		}
+	}
+	if (batch_supervise(&batch))
+	{
+		bgc_printf(BV_ERROR, "Error in call to batch_supervise() from batchbgc.c\n");
+		ok=0;
+	}
+
+	/* report the outcome of each site */
+	if (writestatus && file_open(&status_file, 'o'))
+	{
+		bgc_printf(BV_ERROR, "Error opening site status file, batchbgc.c\n");
+		writestatus = 0;
+		ok=0;
+	}
+	for (i=0 ; i<batch.hdr->nsites ; i++)
+	{
+		if (batch.sites[i].status == SITE_DONE) ndone++;
+		else if (batch.sites[i].status == SITE_STOPPED || batch.sites[i].status == SITE_QUEUED) nstopped++;
+		else nfailed++;
+		if (writestatus)
+		{
+			fprintf(status_file.ptr, "%s\t%s\n", batch.sites[i].ini,
+				batch_status_name(batch.sites[i].status));
+		}
+	}
+	if (writestatus) fclose(status_file.ptr);
+	if (writetelem) fclose(telem_file.ptr);
+	/* index the container once all the sites are done writing to it */
+	if (writecontainer && output_container_index(container_file.name))
+	{
+		bgc_printf(BV_ERROR, "Error in call to output_container_index() from batchbgc.c\n");
+		ok=0;
+	}
+	bgc_printf(BV_PROGRESS, "Finished %d sites: %d done, %d failed, %d stopped or not started\n",
+		batch.hdr->nsites, ndone, nfailed, nstopped);
+	if (nfailed)
+	{
+		bgc_printf(BV_WARN, "Warning: %d of %d sites failed\n", nfailed, batch.hdr->nsites);
+	}
+
+	batch_unmap(&batch);
+	bgc_logfile_finish();
+	free(argv_zero);
+	if (ok && nfailed) return (BGC_EXIT_SITES_FAILED);
+	if (ok && nstopped) return (BGC_EXIT_STOPPED);
+	return (ok ? EXIT_SUCCESS : EXIT_FAILURE);
+} /* end of main */
@@ -0,0 +1,113 @@
+/*
+arena.c
+run-scoped arena allocator: the arrays that live as long as one run (met
+and phenology arrays, the forcing-derivative cache, CO2 and Ndep tables,
+output codes and buffers) are carved from a few large blocks, and all of
+them are released at once at the end of the run
+
+Every allocation starts on an ARENA_ALIGN byte boundary, so the daily
+arrays are aligned for vector loads. A request larger than the block
+size gets a block of its own. Nothing is released before
+arena_release(): arena_free() only frees memory that was allocated
+without an arena. The functions that take an arena allocate with plain
+malloc() when it is NULL, and their arrays are then freed one by one as
+before (free_phenmem(), free_metcache(), metarr_free(), ...).
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#include "bgc.h"
+
+/* round a size up to a multiple of ARENA_ALIGN bytes */
+#define ARENA_ROUND(n) (((n) + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1))
+
+/* an empty arena of blocks of blocksize bytes (0 = ARENA_BLOCK) */
+void arena_init(arena_struct* arena, size_t blocksize)
+{
+	arena->blocks = NULL;
+	arena->blocksize = blocksize ? ARENA_ROUND(blocksize) : ARENA_BLOCK;
+	arena->bytes = 0;
+}
+
+/* a new block with room for size bytes from its aligned base */
+static arena_block_struct* arena_block(size_t size)
+{
+	arena_block_struct* block;
+	char* mem;
+
+	if (!(mem = (char*) malloc(sizeof(arena_block_struct) + ARENA_ALIGN + size)))
+	{
+		return (NULL);
+	}
+	block = (arena_block_struct*) mem;
+	mem += sizeof(arena_block_struct);
+	block->base = mem + ((ARENA_ALIGN - ((size_t) mem % ARENA_ALIGN)) % ARENA_ALIGN);
+	block->size = size;
+	block->used = 0;
+
+	return (block);
+}
+
+/* size bytes from the arena, aligned on ARENA_ALIGN bytes and not
+cleared, or from malloc() when arena is NULL. Returns NULL when out of
+memory, like malloc(). */
+void* arena_alloc(arena_struct* arena, size_t size)
+{
+	arena_block_struct* block;
+	void* ptr;
+
+	if (!arena) return (malloc(size));
+
+	size = size ? ARENA_ROUND(size) : ARENA_ALIGN;
+	block = arena->blocks;
+	if (!block || block->size - block->used < size)
+	{
+		if (!(block = arena_block(size > arena->blocksize ? size : arena->blocksize)))
+		{
+			bgc_printf(BV_ERROR, "Error allocating an arena block of %lu bytes: arena_alloc()\n",
+				(unsigned long) (size > arena->blocksize ? size : arena->blocksize));
+			return (NULL);
+		}
+		if (size > arena->blocksize && arena->blocks)
+		{
+			/* a block of its own, behind the block that still has room */
+			block->next = arena->blocks->next;
+			arena->blocks->next = block;
+		}
+		else
+		{
+			block->next = arena->blocks;
+			arena->blocks = block;
+		}
+	}
+	ptr = block->base + block->used;
+	block->used += size;
+	arena->bytes += size;
+
+	return (ptr);
+}
+
+/* free memory from arena_alloc() when it did not come from an arena.
+Memory in an arena is only released with the arena. */
+void arena_free(arena_struct* arena, void* ptr)
+{
+	if (!arena) free(ptr);
+}
+
+/* release every block of the arena, which is left empty and ready for
+reuse */
+void arena_release(arena_struct* arena)
+{
+	arena_block_struct *block, *next;
+
+	for (block=arena->blocks ; block ; block=next)
+	{
+		next = block->next;
+		free(block);
+	}
+	arena->blocks = NULL;
+	arena->bytes = 0;
+}
@@ -10,7 +10,8 @@ See copyright.txt for Copyright information
 
 #include "bgc.h"
 
-int baresoil_evap(const metvar_struct* metv, wflux_struct* wf, double* dsr_ptr)
+int baresoil_evap(const metvar_struct* metv, wflux_struct* wf, double* dsr_ptr,
+bgcstats_struct* stats)
 {
 	int ok=1;
 	double dsr;              /* number of days since rain */
@@ -49,6 +50,7 @@ int baresoil_evap(const metvar_struct* metv, wflux_struct* wf, double* dsr_ptr)
 
 	/* calculate pot_evap in kg/m2/s */
 	penmon(&pmet_in, 0, &pot_evap);
+	stats->penmon_calls++;
 
 	/* convert to daily total kg/m2 */
 	pot_evap *= metv->dayl;
@@ -23,9 +23,9 @@ int bgc_logfile_setup(char *logfile)
 	{
 		bgc_printf(BV_ERROR, "Couldn't Open logfile for writing: '%s' (Error: %s)\n", logfile, strerror(errno));
 		bgc_print_usage();
-		exit(EXIT_FAILURE);
+		return 1;
 	}
-	return 1;
+	return 0;
 }
 
 int bgc_logfile_finish(void)
@@ -43,7 +43,8 @@ void bgc_print_usage(void)
 {
 	extern char *argv_zero;
 
-	bgc_printf(BV_ERROR, "\nusage: %s {-l <logfile>} {-s | -v [0..4]} {-p} {-V} {-a} {-u | -g | -m} <ini file>\n\n", argv_zero);
+	bgc_printf(BV_ERROR, "\nusage: %s {-l <logfile>} {-s | -v [0..4]} {-p} {-V} {-a} {-u | -g | -m} {-b <mode>} {-S <statsfile>} {-T <telemetryfile>} {-Y <years>} {-K <years>} {-P <slices>} {-W <seconds>} {-y <years>} {-c} {-t <tap>} {-B <year> {-j <threads>}} <ini file> {<scenario ini file> ...}\n", argv_zero);
+	bgc_printf(BV_ERROR, "       %s {options} {-j <threads>} --serve{=<socket>}\n\n", argv_zero);
 	bgc_printf(BV_ERROR, "       -l <logfile> send output to logfile, overwrite old logfile\n"); 
 	bgc_printf(BV_ERROR, "       -V print version number and build information and exit\n");
 	bgc_printf(BV_ERROR, "       -p do alternate calculation for summary outputs (see USAGE.TXT)\n");
@@ -59,6 +60,22 @@ void bgc_print_usage(void)
 	bgc_printf(BV_ERROR, "       -g Run in spin 'n go mode: do spinup and model in one run\n");
 	bgc_printf(BV_ERROR, "       -m Run in model mode (over ride ini setting).\n");
 	bgc_printf(BV_ERROR, "       -n <ndepfile> use an external nitrogen deposition file.\n");
+	bgc_printf(BV_ERROR, "       -S <statsfile> write run statistics (event counters) to statsfile\n");
+	bgc_printf(BV_ERROR, "       -T <telemetryfile> write a spinup convergence record per block to telemetryfile\n");
+	bgc_printf(BV_ERROR, "       -b <mode> mass balance check mode (see USAGE.TXT)\n");
+	bgc_printf(BV_ERROR, "           daily - check every day (default)\n");
+	bgc_printf(BV_ERROR, "           <N> - check every N days, replay daily on failure\n");
+	bgc_printf(BV_ERROR, "           annual - check once a year, replay daily on failure\n");
+	bgc_printf(BV_ERROR, "       -B <year> run the ini file up to year, then each scenario ini file from there\n");
+	bgc_printf(BV_ERROR, "       -j <threads> threads for the scenarios or the job server, default one per processor\n");
+	bgc_printf(BV_ERROR, "       -Y <years> spin up on this many representative met years (screening only)\n");
+	bgc_printf(BV_ERROR, "       -K <years> coarse spinup: years of soil pools advanced per daily year\n");
+	bgc_printf(BV_ERROR, "       -P <slices> parareal spinup on this many threads (experimental)\n");
+	bgc_printf(BV_ERROR, "       -W <seconds> stop early after this much wall clock time, to be continued with -c\n");
+	bgc_printf(BV_ERROR, "       -y <years> stop early after this many simulated years, to be continued with -c\n");
+	bgc_printf(BV_ERROR, "       -c continue a run that stopped early, from its output restart file\n");
+	bgc_printf(BV_ERROR, "       -t <tap> publish the outputs live to the shared memory tap <tap>, for tap_read\n");
+	bgc_printf(BV_ERROR, "       --serve{=<socket>} run the jobs sent on stdin, or on a UNIX socket (see USAGE.TXT)\n");
 
 }
 
@@ -119,11 +136,142 @@ signed char bgc_verbosity_decode(char *keyword)
 		{
 			bgc_printf(BV_ERROR, "Unknown Verbosity Keyword: %s\n", keyword);
 			bgc_print_usage();
-			exit(EXIT_FAILURE);
+			return BV_UNKNOWN;
+		}
+	}
+}
+
+/* decode the -b argument into a mass balance check mode. For
+BALANCE_INTERVAL, the number of days between checks is returned through
+interval. */
+int bgc_balance_decode(char *keyword, int *interval)
+{
+	int i;
+	
+	*interval = 1;
+	
+	if (isdigit((char)(keyword[0])))
+	{
+		*interval = atoi(keyword);
+		if (*interval <= 1)
+		{
+			*interval = 1;
+			return BALANCE_DAILY;
+		}
+		else
+		{
+			/* checks are always made on the last day of the year */
+			if (*interval > 365) *interval = 365;
+			return BALANCE_INTERVAL;
+		}
+	}
+	else
+	{
+		for(i=0; i<4 && i<(int)strlen(keyword); i++)
+		{
+			keyword[i] = toupper(keyword[i]);
+		}
+		
+		if (strncmp("DAILY", keyword, 4) == 0)
+		{
+			return BALANCE_DAILY;
+		}
+		else if (strncmp("ANNUAL", keyword, 4) == 0)
+		{
+			*interval = 365;
+			return BALANCE_INTERVAL;
+		}
+		else
+		{
+			bgc_printf(BV_ERROR, "Unknown Balance Check Keyword: %s\n", keyword);
+			bgc_print_usage();
+			return BALANCE_UNKNOWN;
 		}
 	}
 }
 
+/* names of the precision_control() pools, in PREC_* order, for the
+statistics file */
+static const char *bgc_prec_names[NPREC] = {"leafc", "livestemc",
+	"deadstemc", "livecrootc", "deadcrootc", "cwdc", "litr1c", "litr2c",
+	"litr3c", "litr4c", "soil1c", "soil2c", "soil3c", "soil4c", "sminn",
+	"retransn", "soilw", "snoww", "canopyw"};
+
+/* write the column names for bgc_stats_write() */
+int bgc_stats_header(FILE *fp)
+{
+	int i;
+	
+	fprintf(fp, "site\tmode\tdays\tpsn_days\tsnow_days\tpenmon_calls\tnlimit_days\t"
+		"cpool_deficit_days\tspinup_switch\tspinup_switchback\tspinup_coarse");
+	for (i=0 ; i<NPREC ; i++)
+	{
+		fprintf(fp, "\tprec_%s", bgc_prec_names[i]);
+	}
+	fprintf(fp, "\n");
+	
+	return (ferror(fp) != 0);
+}
+
+/* write one tab delimited line of run statistics */
+int bgc_stats_write(FILE *fp, const char *site, const char *mode,
+	const bgcstats_struct *stats)
+{
+	int i;
+	
+	fprintf(fp, "%s\t%s\t%ld\t%ld\t%ld\t%ld\t%ld\t%ld\t%d\t%d\t%d", site, mode,
+		stats->days, stats->psn_days, stats->snow_days, stats->penmon_calls,
+		stats->nlimit_days, stats->cpool_deficit_days, stats->spinup_switch,
+		stats->spinup_switchback, stats->spinup_coarse);
+	for (i=0 ; i<NPREC ; i++)
+	{
+		fprintf(fp, "\t%ld", stats->prec_trunc[i]);
+	}
+	fprintf(fp, "\n");
+	fflush(fp);
+	
+	return (ferror(fp) != 0);
+}
+
+/* names of the spinup phases (SPINUP_PHASE_*) in the telemetry */
+static const char *bgc_phase_names[3] = {"nadd", "steady", "done"};
+
+const char* bgc_phase_name(int phase)
+{
+	return ((phase >= 0 && phase < 3) ? bgc_phase_names[phase] : "unknown");
+}
+
+/* write the column names of the spinup telemetry file */
+int bgc_telemetry_header(FILE *fp)
+{
+	fprintf(fp, "site\tspinyears\tmetcycle\tphase\tsoilc\ttotalc\tsoilc_trend\t"
+		"totalc_trend\ttest_trend\twall_s\tforecast_years\n");
+	fflush(fp);
+
+	return (ferror(fp) != 0);
+}
+
+/* write one tab delimited line of spinup telemetry. Values that are not
+known are written as NA. */
+int bgc_telemetry_write(FILE *fp, const char *site,
+	const spinup_telem_struct *rec)
+{
+	char test[32], forecast[32];
+
+	if (rec->tested) sprintf(test, "%.6g", rec->test_trend);
+	else strcpy(test, "NA");
+	if (rec->forecast >= 0.0) sprintf(forecast, "%.0f", rec->forecast);
+	else strcpy(forecast, "NA");
+
+	fprintf(fp, "%s\t%d\t%d\t%s\t%.6f\t%.6f\t%.6g\t%.6g\t%s\t%.0f\t%s\n",
+		site ? site : "", rec->spinyears, rec->metcycle, bgc_phase_name(rec->phase),
+		rec->soilc, rec->totalc, rec->soilc_trend, rec->totalc_trend, test,
+		rec->wall, forecast);
+	fflush(fp);
+
+	return (ferror(fp) != 0);
+}
+
 #ifdef __USE_ISOC99
 int _bgc_printf(const char *file, int line, signed char verbosity, const char *format, ...)
 #else
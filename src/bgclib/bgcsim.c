@@ -0,0 +1,1787 @@
+/*
+bgcsim.c
+Persistent simulation object for the core BGC model logic
+
+bgcsim_init() does all of the one-time setup (output arrays and mapping,
+zero-flux structures, phenology arrays, met cache, initial or restart
+state), bgcsim_step_day() and bgcsim_step_year() advance the model, and
+bgcsim_finish() and bgcsim_free() produce the restart data and release the
+memory. bgc() is a loop over these calls, and a host program can use them
+directly to drive the model one day at a time without restarting it.
+
+Like bgc(), this module writes to the daily and annual output files, and
+so it includes bgc_io.h.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#include <time.h>
+#include "bgc.h"
+
+/* days in each month, and the last yday of each month, for monthly
+average output */
+static const int mondays[12] = {31,28,31,30,31,30,31,31,30,31,30,31};
+static const int endday[12] = {30,58,89,119,150,180,211,242,272,303,333,364};
+
+static int bgcsim_year_start(bgcsim_struct* sim);
+static int bgcsim_year_end(bgcsim_struct* sim);
+static int bgcsim_block_end(bgcsim_struct* sim);
+static int bgcsim_telemetry(bgcsim_struct* sim, int metcycle);
+
+/* the block size in spinup control for a met record of metyears years */
+int bgcsim_spinup_block(int metyears)
+{
+	int ntimesmet;
+
+	/* for simulations with fewer than 50 metyears, find the multiple of
+	metyears that gets close to 100, use this as the block size in
+	spinup control */
+	if (metyears < 50)
+	{
+		ntimesmet = 100 / metyears;
+		return (metyears * ntimesmet);
+	}
+	return (metyears);
+}
+
+int bgcsim_init(bgcsim_struct* sim, bgcin_struct* bgcin, bgcout_struct* bgcout,
+	int mode)
+{
+	int ok=1;
+	int i, nmetdays, outv;
+	double tair_avg;
+	output_meta_struct meta;
+
+	/* start from zero. This clears the dynamic memory pointers, so that
+	bgcsim_free() can be called after an error at any point in this
+	function. Some epv variables are never set for some vegetation types
+	(the live wood turnover increments of grasses), and are written to the
+	restart file as they are. */
+	memset(sim, 0, sizeof(bgcsim_struct));
+
+	sim->bgcin = bgcin;
+	sim->bgcout = bgcout;
+	sim->mode = mode;
+
+	if (mode != MODE_SPINUP && mode != MODE_MODEL)
+	{
+		bgc_printf(BV_ERROR, "Error: Unknown MODE given when calling bgcsim_init()\n");
+		ok=0;
+	}
+
+	/* copy the input structures into local structures */
+	sim->ws = bgcin->ws;
+	sim->cinit = bgcin->cinit;
+	sim->cs = bgcin->cs;
+	sim->ns = bgcin->ns;
+	sim->sitec = bgcin->sitec;
+	sim->epc = bgcin->epc;
+	/* note that the following three structures have dynamic memory elements,
+	and so the notion of copying the input structure to a local structure
+	value-by-value is not the same as above. In this case, the array pointers
+	are being copied, so the local members use the same memory that was
+	allocated in the calling function. Note also that the simulation does not
+	modify the contents of these structures. */
+	sim->ctrl = bgcin->ctrl;
+	sim->metarr = bgcin->metarr;
+	sim->co2 = bgcin->co2;
+	if (mode == MODE_MODEL)
+	{
+		sim->ramp_ndep = bgcin->ramp_ndep;
+	}
+
+	bgc_printf(BV_DIAG, "done copy input\n");
+
+	/* local variable that signals the need for daily output array */
+	sim->dayout = (sim->ctrl.dodaily || sim->ctrl.domonavg || sim->ctrl.doannavg);
+
+	/* the arrays of the simulation come from one arena block, sized for
+	the output arrays and map, the phenology arrays and the
+	forcing-derivative cache, and released together by bgcsim_free() */
+	nmetdays = 365 * sim->ctrl.metyears;
+	arena_init(&sim->arena, 3 * (sim->ctrl.ndayout * sizeof(float) + ARENA_ALIGN) +
+		sim->ctrl.nannout * sizeof(float) + NMAP * sizeof(double*) +
+		2 * ((sim->ctrl.metyears + 1) * sizeof(int) + ARENA_ALIGN) +
+		5 * (nmetdays * sizeof(int) + ARENA_ALIGN) +
+		15 * (nmetdays * sizeof(double) + ARENA_ALIGN) + 2 * ARENA_ALIGN);
+
+	/* allocate memory for local output arrays */
+	if (ok && sim->dayout && !(sim->dayarr = (float*) arena_alloc(&sim->arena, sim->ctrl.ndayout * sizeof(float))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating for local daily output array in bgcsim_init()\n");
+		ok=0;
+	}
+	if (ok && sim->ctrl.domonavg && !(sim->monavgarr = (float*) arena_alloc(&sim->arena, sim->ctrl.ndayout * sizeof(float))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating for monthly average output array in bgcsim_init()\n");
+		ok=0;
+	}
+	if (ok && sim->ctrl.doannavg && !(sim->annavgarr = (float*) arena_alloc(&sim->arena, sim->ctrl.ndayout * sizeof(float))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating for annual average output array in bgcsim_init()\n");
+		ok=0;
+	}
+	if (ok && sim->ctrl.doannual && !(sim->annarr = (float*) arena_alloc(&sim->arena, sim->ctrl.nannout * sizeof(float))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating for local annual output array in bgcsim_init()\n");
+		ok=0;
+	}
+	/* allocate space for the output map pointers */
+	if (ok && !(sim->output_map = (double**) arena_alloc(&sim->arena, NMAP * sizeof(double*))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating for output map in bgcsim_init()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "done allocate out arrays\n");
+
+	/* initialize monavg and annavg to 0.0 */
+	if (ok && sim->ctrl.domonavg)
+	{
+		for (outv=0 ; outv<sim->ctrl.ndayout ; outv++)
+		{
+			sim->monavgarr[outv] = 0.0;
+		}
+	}
+	if (ok && sim->ctrl.doannavg)
+	{
+		for (outv=0 ; outv<sim->ctrl.ndayout ; outv++)
+		{
+			sim->annavgarr[outv] = 0.0;
+		}
+	}
+
+	/* initialize the output mapping array */
+	if (ok && output_map_init(sim->output_map,&sim->metv,&sim->ws,&sim->wf,
+		&sim->cs,&sim->cf,&sim->ns,&sim->nf,&sim->phen,&sim->epv,
+		&sim->psn_sun,&sim->psn_shade,&sim->summary))
+	{
+		bgc_printf(BV_ERROR, "Error in call to output_map_init() from bgcsim_init()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "done initialize outmap\n");
+
+	/* the summary terms to compute each day */
+	sim->sum_need = summary_demand(&sim->ctrl, mode);
+
+	/* the photosynthesis variables are only calculated on growing season
+	days, so start them at zero instead of leaving them undefined for the
+	output map before the first growing season */
+	memset(&sim->psn_sun, 0, sizeof(psn_struct));
+	memset(&sim->psn_shade, 0, sizeof(psn_struct));
+
+	/* make zero-flux structures for use inside annual and daily loops */
+	if (ok && make_zero_flux_struct(&sim->zero_wf, &sim->zero_cf, &sim->zero_nf))
+	{
+		bgc_printf(BV_ERROR, "Error in call to make_zero_flux_struct() from bgcsim_init()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "done make_zero_flux\n");
+
+	/* atmospheric pressure (Pa) as a function of elevation (m) */
+	if (ok && atm_pres(sim->sitec.elev, &sim->metv.pa))
+	{
+		bgc_printf(BV_ERROR, "Error in atm_pres() from bgcsim_init()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "done atm_pres\n");
+
+	/* determine phenological signals, or use the arrays the caller
+	made for the same inputs */
+	if (ok && bgcin->phenarr)
+	{
+		sim->phenarr = *bgcin->phenarr;
+		sim->phen_shared = 1;
+	}
+	else if (ok && prephenology(&sim->ctrl, &sim->epc, &sim->sitec, &sim->metarr,
+		&sim->phenarr, &sim->arena))
+	{
+		bgc_printf(BV_ERROR, "Error in call to prephenology(), from bgcsim_init()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "done prephenology\n");
+
+	/* calculate the annual average air temperature for use in soil
+	temperature corrections. This code added 9 February 1999, in
+	conjunction with soil temperature testing done with Mike White. */
+	tair_avg = 0.0;
+	nmetdays = sim->ctrl.metyears * 365;
+	for (i=0 ; i<nmetdays ; i++)
+	{
+		tair_avg += sim->metarr.tavg[i];
+	}
+	tair_avg /= (double)nmetdays;
+
+	/* precompute the met-only forcing derivatives for every metday, so
+	that they are not recalculated each time the met record is cycled */
+	if (ok && metcache_init(&sim->ctrl, &sim->metarr, tair_avg, sim->metv.pa,
+		&sim->metcache, &sim->arena))
+	{
+		bgc_printf(BV_ERROR, "Error in call to metcache_init(), from bgcsim_init()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "done metcache_init\n");
+
+	/* if this simulation is using a restart file for its initial
+	conditions, then copy restart info into structures */
+	if (ok && sim->ctrl.read_restart)
+	{
+		if (ok && restart_input(&sim->ctrl, &sim->ws, &sim->cs, &sim->ns,
+			&sim->epv, &sim->metyr, &(bgcin->restart_input)))
+		{
+			bgc_printf(BV_ERROR, "Error in call to restart_input() from bgcsim_init()\n");
+			ok=0;
+		}
+
+		bgc_printf(BV_DIAG, "done restart_input\n");
+
+	}
+	else if (ok)
+	/* no restart file, user supplies initial conditions */
+	{
+		/* initialize leaf C and N pools depending on phenology signals for
+		the first metday */
+		if (ok && firstday(&sim->epc, &sim->cinit, &sim->epv, &sim->phenarr,
+			&sim->cs, &sim->ns))
+		{
+			bgc_printf(BV_ERROR, "Error in call to firstday(), from bgcsim_init()\n");
+			ok=0;
+		}
+
+		/* initial value for metyr */
+		sim->metyr = 0;
+
+		bgc_printf(BV_DIAG, "done firstday\n");
+	}
+
+	/* zero water, carbon, and nitrogen source and sink variables */
+	if (ok && zero_srcsnk(&sim->cs,&sim->ns,&sim->ws,&sim->summary))
+	{
+		bgc_printf(BV_ERROR, "Error in call to zero_srcsnk(), from bgcsim_init()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "done zero_srcsnk\n");
+
+	/* zero the event counters */
+	memset(&sim->stats, 0, sizeof(bgcstats_struct));
+
+	/* initialize the indicator for first day of current simulation, so
+	that the checks for mass balance can have two days for comparison */
+	sim->bal.first = 1;
+	sim->bal.quiet = 0;
+	sim->bal_days = 0;
+	sim->bal_yday = -1;
+	sim->replay_yday = -1;
+
+	/* initialize the variables used for monthly and annual output */
+	sim->monmaxlai = 0.0;
+	sim->annmaxlai = 0.0;
+	sim->monmaxsnoww = 0.0;
+	sim->eomsnoww = 0.0;
+	sim->eomsoilw = 0.0;
+	sim->annmaxplai = 0.0;
+
+	/* initialize spinup control variables */
+	sim->spinyears = 0;
+	sim->metcycle = 0;
+	sim->steady1 = 0;
+	sim->steady2 = 0;
+	sim->rising = 1;
+	sim->tally1 = 0.0;
+	sim->tally1b = 0.0;
+	sim->tally2 = 0.0;
+	sim->tally2b = 0.0;
+	sim->t1 = 0.0;
+	sim->vegsteady = 0;
+	sim->coarse_rec = 0;
+
+	/* spinup convergence telemetry */
+	sim->telem_start = (double)time(NULL);
+	sim->telem_years = 0;
+	sim->telem_soilc = 0.0;
+	sim->telem_totalc = 0.0;
+	sim->telem_n = 0;
+
+	/* mode == MODE_SPINUP only*/
+	if (mode == MODE_SPINUP)
+	{
+		sim->nblock = bgcsim_spinup_block(sim->ctrl.metyears);
+		sim->nyears = sim->nblock;
+	}
+	else
+	{
+		sim->nblock = 0;
+		sim->nyears = sim->ctrl.simyears;
+	}
+
+	/* start at the first day of the first year */
+	sim->simyr = 0;
+	sim->yday = 0;
+	sim->newyear = 1;
+	if (sim->nyears <= 0) sim->done = 1;
+
+	/* the outputs go to the sinks of bgcout, or to its files */
+	if (ok && bgcout->sink)
+	{
+		sim->sink = bgcout->sink;
+	}
+	else if (ok)
+	{
+		output_file_sink_init(&sim->filesink, bgcout);
+		sim->sink = &sim->filesink;
+	}
+	if (ok)
+	{
+		meta.mode = mode;
+		meta.simstartyear = sim->ctrl.simstartyear;
+		meta.dodaily = sim->ctrl.dodaily;
+		meta.domonavg = sim->ctrl.domonavg;
+		meta.doannavg = sim->ctrl.doannavg;
+		meta.doannual = sim->ctrl.doannual;
+		meta.ndayout = sim->ctrl.ndayout;
+		meta.daycodes = sim->ctrl.daycodes;
+		meta.nannout = sim->ctrl.nannout;
+		meta.anncodes = sim->ctrl.anncodes;
+		sim->sink_open = 1;
+		if (output_sink_open(sim->sink, &meta))
+		{
+			bgc_printf(BV_ERROR, "Error in call to output_sink_open() from bgcsim_init()\n");
+			ok=0;
+		}
+	}
+
+	return (!ok);
+}
+
+/* annual setup, done before the first day of each simulation year */
+static int bgcsim_year_start(bgcsim_struct* sim)
+{
+	int ok=1;
+	int ind_simyr;
+	double ndep_scalar, ndep_diff, ndep;
+	control_struct* ctrl = &sim->ctrl;
+	co2control_struct* co2 = &sim->co2;
+	ramp_ndep_struct* ramp_ndep = &sim->ramp_ndep;
+	int simyr = sim->simyr;
+
+	if (sim->mode == MODE_MODEL)
+	{
+		/* reset the simple annual output variables for text output */
+		sim->annmaxlai = 0.0;
+		sim->annet = 0.0;
+		sim->annoutflow = 0.0;
+		sim->annnpp = 0.0;
+		sim->annnbp = 0.0;
+		sim->annprcp = 0.0;
+		sim->anntavg = 0.0;
+	}
+
+	/* set current month to 0 (january) at the beginning of each year */
+	sim->curmonth = 0;
+
+	/* the last balance check was on the last day of the previous year */
+	sim->bal_yday = -1;
+
+	if (sim->mode == MODE_SPINUP)
+	{
+		/* calculate scaling for N additions (decreasing with
+		time since the beginning of metcycle = 0 block */
+		sim->naddfrac = 1.0 - ((double)simyr/(double)sim->nblock);
+
+		if (sim->metcycle == 0)
+		{
+			sim->tally1 = 0.0;
+			sim->tally1b = 0.0;
+			sim->tally2 = 0.0;
+			sim->tally2b = 0.0;
+		}
+
+		/* in coarse mode, once the vegetation is at steady state and
+		no supplemental N is being added, a metcycle = 0 block records
+		the fluxes of the litter, CWD and soil pools for a coarse step
+		at its end, with the rates of the whole block. The two
+		convergence test blocks that follow are daily. */
+		if (simyr == 0)
+		{
+			sim->coarse_rec = (ctrl->spincoarse > 0 && sim->vegsteady &&
+				sim->metcycle == 0 && (sim->steady1 || !sim->rising));
+			if (sim->coarse_rec && coarse_start(&sim->cs, &sim->ns, &sim->coarse))
+			{
+				bgc_printf(BV_ERROR, "Error in coarse_start() from bgcsim_year_start()\n");
+				ok=0;
+			}
+		}
+	}
+
+	/* test whether metyr needs to be reset */
+	if (sim->metyr == ctrl->metyears)
+	{
+		if (sim->mode == MODE_MODEL)
+		{
+			if (ctrl->onscreen) bgc_printf(BV_DETAIL, "Resetting met data for cyclic input\n");
+		}
+		if (sim->mode == MODE_SPINUP)
+		{
+			bgc_printf(BV_DIAG, "Resetting met data for cyclic input\n");
+		}
+		sim->metyr = 0;
+	}
+
+	if (sim->mode == MODE_MODEL)
+	{
+		/* output to screen to indicate start of simulation year */
+		if (ctrl->onscreen) bgc_printf(BV_DETAIL, "Year: %6d\n",ctrl->simstartyear+simyr);
+	}
+	else if (sim->mode == MODE_SPINUP)
+	{
+		/* output to screen to indicate start of simulation year */
+		if (ctrl->onscreen) bgc_printf(BV_DETAIL, "Year: %6d\n",sim->spinyears);
+	}
+
+	/* set the max lai variable, for annual diagnostic output */
+	sim->epv.ytd_maxplai = 0.0;
+
+	if (sim->mode == MODE_MODEL)
+	{
+		/* atmospheric CO2 and Ndep handling */
+		if (!(co2->varco2))
+		{
+			/* constant CO2, constant Ndep */
+			sim->metv.co2 = co2->co2ppm;
+			sim->daily_ndep = sim->sitec.ndep/365.0;
+			sim->daily_nfix = sim->sitec.nfix/365.0;
+		}
+		else
+		{
+			/* when varco2 = 1, use file for co2 */
+			if (co2->varco2 == 1) sim->metv.co2 = get_co2(co2,(ctrl->simstartyear+simyr));
+			bgc_printf(BV_DIAG,"CO2 val: %lf Year: %i\n",sim->metv.co2,(ctrl->simstartyear+simyr));
+			if (sim->metv.co2 < -999)
+			{
+				bgc_printf(BV_ERROR,"Error finding CO2 value for year: %i\n",(ctrl->simstartyear+simyr));
+				ok=0;
+			}
+
+			/* when varco2 = 2, use the constant CO2 value, but vary Ndep */
+			if (co2->varco2 == 2) sim->metv.co2 = co2->co2ppm;
+
+			if (ramp_ndep->doramp && !sim->bgcin->ndepctrl.varndep)
+			{
+				/* increasing CO2, ramped Ndep */
+				ind_simyr = ramp_ndep->ind_year - ctrl->simstartyear;
+				ndep_scalar = (ramp_ndep->ind_ndep - ramp_ndep->preind_ndep) /
+					(co2->co2ppm_array[ind_simyr]-co2->co2ppm_array[0]);
+				ndep_diff = (co2->co2ppm_array[simyr] - co2->co2ppm_array[0]) *
+					ndep_scalar;
+				ndep = ramp_ndep->preind_ndep + ndep_diff;
+				/* don't allow the industrial ndep levels to be less than
+				the preindustrial levels */
+				if (ndep < ramp_ndep->preind_ndep) ndep = ramp_ndep->preind_ndep;
+				sim->daily_ndep = ndep/365.0;
+				sim->daily_nfix = sim->sitec.nfix/365.0;
+			}
+			else
+			{
+				/* increasing CO2, constant Ndep */
+				sim->daily_ndep = sim->sitec.ndep/365.0;
+				sim->daily_nfix = sim->sitec.nfix/365.0;
+			}
+		}
+		if (ok && sim->bgcin->ndepctrl.varndep)
+		{
+			sim->daily_ndep = get_ndep(&sim->bgcin->ndepctrl,(ctrl->simstartyear + simyr));
+			if (sim->daily_ndep < -999)
+			{
+				bgc_printf(BV_ERROR, "Error finding NDEP for year: %i\n",(ctrl->simstartyear+simyr));
+				ok=0;
+			}
+			else
+			{
+				bgc_printf(BV_DIAG, "Using annual NDEP value: %lf\n",sim->daily_ndep);
+				sim->daily_ndep /= 365.0;
+			}
+		}
+	}
+	else if (sim->mode == MODE_SPINUP)
+	{
+		/* atmospheric concentration of CO2 (ppm) */
+		/* Always assign a fixed CO2 value for spinups */
+		sim->metv.co2 = co2->co2ppm;
+	}
+
+	return (!ok);
+}
+
+int bgcsim_step_day(bgcsim_struct* sim)
+{
+	extern signed char summary_sanity;
+	int ok=1;
+	int metday, annual_alloc, outv;
+	int bal_check, bal_fail;
+	int simyr, yday;
+	control_struct* ctrl = &sim->ctrl;
+	bgcout_struct* bgcout = sim->bgcout;
+	metvar_struct* metv = &sim->metv;
+	wstate_struct* ws = &sim->ws;
+	wflux_struct* wf = &sim->wf;
+	cstate_struct* cs = &sim->cs;
+	cflux_struct* cf = &sim->cf;
+	nstate_struct* ns = &sim->ns;
+	nflux_struct* nf = &sim->nf;
+	epvar_struct* epv = &sim->epv;
+	epconst_struct* epc = &sim->epc;
+	siteconst_struct* sitec = &sim->sitec;
+	phenology_struct* phen = &sim->phen;
+	summary_struct* summary = &sim->summary;
+	float* dayarr = sim->dayarr;
+
+	if (sim->done)
+	{
+		bgc_printf(BV_ERROR, "Error: bgcsim_step_day() called after the end of the simulation\n");
+		return (1);
+	}
+
+	/* annual setup before the first day of each year */
+	if (sim->newyear)
+	{
+		if (bgcsim_year_start(sim))
+		{
+			bgc_printf(BV_ERROR, "Error in bgcsim_year_start() from bgcsim_step_day()\n");
+			return (1);
+		}
+		sim->newyear = 0;
+	}
+
+	simyr = sim->simyr;
+	yday = sim->yday;
+
+	bgc_printf(BV_DIAG, "year %d\tyday %d\n",simyr,yday);
+	sim->stats.days++;
+
+	/* Test for very low state variable values and force them
+	to 0.0 to avoid rounding and floating point overflow errors */
+	if (ok && precision_control(ws, cs, ns, &sim->stats))
+	{
+		bgc_printf(BV_ERROR, "Error in call to precision_control() from bgcsim_step_day()\n");
+		ok=0;
+	}
+
+	/* set the day index for meteorological and phenological arrays */
+	metday = sim->metyr*365 + yday;
+
+	/* zero all the daily flux variables */
+	*wf = sim->zero_wf;
+	*cf = sim->zero_cf;
+	*nf = sim->zero_nf;
+
+	/* daily meteorological variables from metarrays, including
+	the soil temperature correction using difference from
+	annual average tair (stronger under a snowpack) */
+	if (ok && daymet(&sim->metarr, &sim->metcache, metv, metday, (ws->snoww != 0.0)))
+	{
+		bgc_printf(BV_ERROR, "Error in daymet() from bgcsim_step_day()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "%d\t%d\tdone daymet\n",simyr,yday);
+
+	/* daily phenological variables from phenarrays */
+	if (ok && dayphen(&sim->phenarr, phen, metday))
+	{
+		bgc_printf(BV_ERROR, "Error in dayphen() from bgcsim_step_day()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "%d\t%d\tdone dayphen\n",simyr,yday);
+
+	/* test for the annual allocation day */
+	if (phen->remdays_litfall == 1) annual_alloc = 1;
+	else annual_alloc = 0;
+
+	/* phenology fluxes */
+	if (ok && phenology(epc, phen, epv, cs, cf, ns, nf))
+	{
+		bgc_printf(BV_ERROR, "Error in phenology() from bgcsim_step_day()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "%d\t%d\tdone phenology\n",simyr,yday);
+
+	/* calculate leaf area index, sun and shade fractions, and specific
+	leaf area for sun and shade canopy fractions, then calculate
+	canopy radiation interception and transmission */
+	if (ok && radtrans(cs, epc, metv, epv, sitec->sw_alb))
+	{
+		bgc_printf(BV_ERROR, "Error in radtrans() from bgcsim_step_day()\n");
+		ok=0;
+	}
+
+	/* update the ann max LAI for annual diagnostic output */
+	if (epv->proj_lai > epv->ytd_maxplai) epv->ytd_maxplai = epv->proj_lai;
+
+	bgc_printf(BV_DIAG, "%d\t%d\tdone radtrans\n",simyr,yday);
+
+	/* precip routing (when there is precip) */
+	if (ok && metv->prcp && prcp_route(metv, epc->int_coef, epv->all_lai, wf))
+	{
+		bgc_printf(BV_ERROR, "Error in prcp_route() from bgcsim_step_day()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "%d\t%d\tdone prcp_route\n",simyr,yday);
+
+	/* snowmelt (when there is a snowpack) */
+	if (ws->snoww) sim->stats.snow_days++;
+	if (ok && ws->snoww && snowmelt(metv, wf, ws->snoww))
+	{
+		bgc_printf(BV_ERROR, "Error in snowmelt() from bgcsim_step_day()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "%d\t%d\tdone snowmelt\n",simyr,yday);
+
+	/* bare-soil evaporation (when there is no snowpack) */
+	if (ok && !ws->snoww && baresoil_evap(metv, wf, &epv->dsr, &sim->stats))
+	{
+		bgc_printf(BV_ERROR, "Error in baresoil_evap() from bgcsim_step_day()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "%d\t%d\tdone bare_soil evap\n",simyr,yday);
+
+	/* soil water potential */
+	if (ok && soilpsi(sitec, ws->soilw, &epv->psi, &epv->vwc))
+	{
+		bgc_printf(BV_ERROR, "Error in soilpsi() from bgcsim_step_day()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "%d\t%d\tdone soilpsi\n",simyr,yday);
+
+	/* daily maintenance respiration */
+	if (ok && maint_resp(cs, ns, epc, metv, cf, epv))
+	{
+		bgc_printf(BV_ERROR, "Error in m_resp() from bgcsim_step_day()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "%d\t%d\tdone maint resp\n",simyr,yday);
+
+	/* begin canopy bio-physical process simulation */
+	/* do canopy ET calculations whenever there is leaf area
+	displayed, since there may be intercepted water on the
+	canopy that needs to be dealt with */
+	if (ok && cs->leafc && metv->dayl)
+	{
+		/* conductance and evapo-transpiration */
+		if (ok && canopy_et(metv, epc, epv, wf, 1, &sim->stats))
+		{
+			bgc_printf(BV_ERROR, "Error in canopy_et() from bgcsim_step_day()\n");
+			ok=0;
+		}
+
+		bgc_printf(BV_DIAG, "%d\t%d\tdone canopy_et\n",simyr,yday);
+
+	}
+	/* do photosynthesis only when it is part of the current
+	growth season, as defined by the remdays_curgrowth flag.  This
+	keeps the occurrence of new growth consistent with the treatment
+	of litterfall and allocation */
+	if (ok && cs->leafc && phen->remdays_curgrowth && metv->dayl)
+	{
+		sim->stats.psn_days++;
+		if (ok && total_photosynthesis(metv, epc, epv, cf, &sim->psn_sun, &sim->psn_shade))
+		{
+			bgc_printf(BV_ERROR, "Error in total_photosynthesis() from bgcsim_step_day()\n");
+			ok=0;
+		}
+
+	} /* end of photosynthesis calculations */
+	else
+	{
+		epv->assim_sun = epv->assim_shade = 0.0;
+	}
+
+	if (sim->mode == MODE_MODEL)
+	{
+		/* nitrogen deposition and fixation */
+		nf->ndep_to_sminn = sim->daily_ndep;
+		nf->nfix_to_sminn = sim->daily_nfix;
+	}
+	else if (sim->mode == MODE_SPINUP)
+	{
+		/* nitrogen deposition and fixation */
+		nf->ndep_to_sminn = sitec->ndep/365.0;
+		nf->nfix_to_sminn = sitec->nfix/365.0;
+	}
+
+	/* calculate outflow */
+	if (ok && outflow(sitec, ws, wf))
+	{
+		bgc_printf(BV_ERROR, "Error in outflow() from bgcsim_step_day()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "%d\t%d\tdone outflow\n",simyr,yday);
+
+	/* daily litter and soil decomp and nitrogen fluxes */
+	if (ok && decomp(metv,epc,epv,sitec,cs,cf,ns,nf,&sim->nt))
+	{
+		bgc_printf(BV_ERROR, "Error in decomp() from bgcsim_step_day()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "%d\t%d\tdone decomp\n",simyr,yday);
+
+	/* Daily allocation gets called whether or not this is a
+	current growth day, because the competition between decomp
+	immobilization fluxes and plant growth N demand is resolved
+	here.  On days with no growth, no allocation occurs, but
+	immobilization fluxes are updated normally */
+	if (sim->mode == MODE_MODEL)
+	{
+		if (ok && daily_allocation(cf,cs,nf,ns,epc,epv,&sim->nt,1.0,MODE_MODEL,&sim->stats))
+		{
+			bgc_printf(BV_ERROR, "Error in daily_allocation() from bgcsim_step_day()\n");
+			ok=0;
+		}
+	}
+	else if (sim->mode == MODE_SPINUP)
+	{
+		/* spinup control */
+		/* in the rising limb, use the spinup allocation code
+		that supplements N supply */
+		if (!sim->steady1 && sim->rising && sim->metcycle == 0)
+		{
+			if (ok && daily_allocation(cf,cs,nf,ns,epc,epv,&sim->nt,sim->naddfrac,MODE_SPINUP,&sim->stats))
+			{
+				bgc_printf(BV_ERROR, "Error in daily_allocation() from bgcsim_step_day()\n");
+				ok=0;
+			}
+		}
+		else
+		{
+			if (ok && daily_allocation(cf,cs,nf,ns,epc,epv,&sim->nt,1.0,MODE_MODEL,&sim->stats))
+			{
+				bgc_printf(BV_ERROR, "Error in daily_allocation() from bgcsim_step_day()\n");
+				ok=0;
+			}
+		}
+	}
+
+	bgc_printf(BV_DIAG, "%d\t%d\tdone daily_allocation\n",simyr,yday);
+
+	/* reassess the annual turnover rates for livewood --> deadwood,
+	and for evergreen leaf and fine root litterfall. This happens
+	once each year, on the annual_alloc day (the last litterfall day) */
+	if (ok && annual_alloc)
+	{
+		if (ok && annual_rates(epc,epv))
+		{
+			bgc_printf(BV_ERROR, "Error in annual_rates() from bgcsim_step_day()\n");
+			ok=0;
+		}
+
+		bgc_printf(BV_DIAG, "%d\t%d\tdone annual rates\n",simyr,yday);
+	}
+
+	/* daily growth respiration */
+	if (ok && growth_resp(epc, cf))
+	{
+		bgc_printf(BV_ERROR, "Error in daily_growth_resp() from bgcsim_step_day()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "%d\t%d\tdone growth_resp\n",simyr,yday);
+
+	/* daily update of the water state variables */
+	if (ok && daily_water_state_update(wf, ws))
+	{
+		bgc_printf(BV_ERROR, "Error in daily_water_state_update() from bgcsim_step_day()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "%d\t%d\tdone water state update\n",simyr,yday);
+
+	/* daily update of carbon state variables */
+	if (ok && daily_carbon_state_update(cf, cs, annual_alloc,
+		epc->woody, epc->evergreen))
+	{
+		bgc_printf(BV_ERROR, "Error in daily_carbon_state_update() from bgcsim_step_day()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "%d\t%d\tdone carbon state update\n",simyr,yday);
+
+	/* daily update of nitrogen state variables */
+	if (ok && daily_nitrogen_state_update(nf, ns, annual_alloc,
+		epc->woody, epc->evergreen))
+	{
+		bgc_printf(BV_ERROR, "Error in daily_nitrogen_state_update() from bgcsim_step_day()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "%d\t%d\tdone nitrogen state update\n",simyr,yday);
+
+	/* calculate N leaching loss.  This is a special state variable
+	update routine, done after the other fluxes and states are
+	reconciled in order to avoid negative sminn under heavy leaching
+	potential */
+	if (ok && nleaching(ns, nf, ws, wf))
+	{
+		bgc_printf(BV_ERROR, "Error in nleaching() from bgcsim_step_day()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "%d\t%d\tdone nitrogen leaching\n",simyr,yday);
+
+	/* calculate daily mortality fluxes and update state variables */
+	/* this is done last, with a special state update procedure, to
+	insure that pools don't go negative due to mortality fluxes
+	conflicting with other proportional fluxes */
+	if (ok && mortality(epc,cs,cf,ns,nf))
+	{
+		bgc_printf(BV_ERROR, "Error in mortality() from bgcsim_step_day()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "%d\t%d\tdone mortality\n",simyr,yday);
+
+	/* calculate carbon summary variables */
+	if (ok && csummary(cf, cs, summary, sim->sum_need))
+	{
+		bgc_printf(BV_ERROR, "Error in csummary() from bgcsim_step_day()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "%d\t%d\tdone carbon summary\n",simyr,yday);
+
+	/* calculate water summary variables */
+	if (ok && (sim->sum_need & SUM_WATER) && wsummary(ws,wf,summary))
+	{
+		bgc_printf(BV_ERROR, "Error in wsummary() from bgcsim_step_day()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "%d\t%d\tdone water summary\n", simyr,yday);
+
+	/* MASS BALANCE CHECKS */
+	/* the balances are checked every day, except in interval mode.
+	The first day, the last day of each year, and every day that is
+	being replayed after a failed check are always checked. */
+	sim->bal_days++;
+	bal_check = (ctrl->balance_mode != BALANCE_INTERVAL || sim->bal.first ||
+		sim->replay_yday >= 0 || yday == 364 ||
+		sim->bal_days >= ctrl->balance_interval);
+
+	if (ok && bal_check)
+	{
+		sim->bal_days = 0;
+		bal_fail = 0;
+
+		/* a failed interval check only triggers a replay, so its
+		details are not reported as an error */
+		sim->bal.quiet = (ctrl->balance_mode == BALANCE_INTERVAL && sim->replay_yday < 0);
+
+		/* test for water balance */
+		if (ok && check_water_balance(ws, &sim->bal))
+		{
+			if (sim->bal.quiet) bal_fail = 1;
+			else
+			{
+				bgc_printf(BV_ERROR, "Error in check_water_balance() from bgcsim_step_day()\n");
+				bgc_printf(BV_ERROR, "%d\n",metday);
+				ok=0;
+			}
+		}
+
+		bgc_printf(BV_DIAG, "%d\t%d\tdone water balance\n",simyr,yday);
+
+		/* test for carbon balance */
+		if (ok && check_carbon_balance(cs, &sim->bal))
+		{
+			if (sim->bal.quiet) bal_fail = 1;
+			else
+			{
+				bgc_printf(BV_ERROR, "Error in check_carbon_balance() from bgcsim_step_day()\n");
+				bgc_printf(BV_ERROR, "%d\n",metday);
+				ok=0;
+			}
+		}
+
+		bgc_printf(BV_DIAG, "%d\t%d\tdone carbon balance\n",simyr,yday);
+
+		/* test for nitrogen balance */
+		if (ok && check_nitrogen_balance(ns, &sim->bal))
+		{
+			if (sim->bal.quiet) bal_fail = 1;
+			else
+			{
+				bgc_printf(BV_ERROR, "Error in check_nitrogen_balance() from bgcsim_step_day()\n");
+				bgc_printf(BV_ERROR, "%d\n",metday);
+				ok=0;
+			}
+		}
+
+		bgc_printf(BV_DIAG, "%d\t%d\tdone nitrogen balance\n",simyr,yday);
+
+		if (ok && bal_fail)
+		{
+			/* restore the state saved at the last good check and
+			replay the days since then with daily checks, so that the
+			error is reported for the day on which it occurred */
+			bgc_printf(BV_WARN, "Mass balance check failed for yday %d to %d, replaying with daily checks\n",
+				sim->bal_yday+1,yday);
+			*ws = sim->bal_ws;
+			*cs = sim->bal_cs;
+			*ns = sim->bal_ns;
+			*epv = sim->bal_epv;
+			*summary = sim->bal_summary;
+			sim->stats = sim->bal_stats;
+			sim->bal = sim->bal_snap;
+			/* the state saved at the end of the previous year
+			still holds that year's maximum LAI */
+			if (sim->bal_yday < 0) epv->ytd_maxplai = 0.0;
+			sim->replay_yday = yday;
+			sim->yday = sim->bal_yday + 1;
+			return (!ok);
+		}
+
+		/* a replay that gets back to the failed check without
+		finding a daily error ends here, and the run goes on */
+		if (yday == sim->replay_yday) sim->replay_yday = -1;
+
+		/* save the state at this good check */
+		if (ok && ctrl->balance_mode == BALANCE_INTERVAL && sim->replay_yday < 0)
+		{
+			sim->bal_ws = *ws;
+			sim->bal_cs = *cs;
+			sim->bal_ns = *ns;
+			sim->bal_epv = *epv;
+			sim->bal_summary = *summary;
+			sim->bal_stats = sim->stats;
+			sim->bal_snap = sim->bal;
+			sim->bal_yday = yday;
+		}
+
+		/* after the first check, the checks have a previous
+		balance for comparison */
+		sim->bal.first = 0;
+	}
+
+	/* the outputs for days being replayed were already written */
+	if (ok && sim->replay_yday >= 0)
+	{
+		sim->yday++;
+		return (!ok);
+	}
+
+	/* DAILY OUTPUT HANDLING */
+	/* fill the daily output array if daily output is requested,
+	or if the monthly or annual average of daily output variables
+	have been requested */
+	bgc_printf(BV_DIAG, "Number of daily outputs: %d\n", ctrl->ndayout);
+	if (ok && sim->dayout)
+	{
+		/* fill the daily output array */
+		for (outv=0 ; outv<ctrl->ndayout ; outv++)
+		{
+			bgc_printf(BV_DIAG, "Outv: %d, ", outv);
+			bgc_printf(BV_DIAG, "DayCode: %d, ", ctrl->daycodes[outv]);
+			bgc_printf(BV_DIAG, "Output: %f\n", *sim->output_map[ctrl->daycodes[outv]]);
+			dayarr[outv] = (float) *sim->output_map[ctrl->daycodes[outv]];
+		}
+		/* and publish it to the live output tap, if anyone reads it */
+		if (bgcout->tap && bgcout->tap->readers)
+		{
+			output_tap_publish(bgcout->tap, TAP_DAY, (sim->mode == MODE_MODEL) ?
+				ctrl->simstartyear+simyr : sim->spinyears, yday, dayarr, ctrl->ndayout);
+		}
+	}
+	/* only write daily outputs if requested */
+	if (ok && ctrl->dodaily)
+	{
+		/* send the daily output array to the output sinks */
+		if (output_sink_day(sim->sink, (sim->mode == MODE_MODEL) ?
+			ctrl->simstartyear+simyr : sim->spinyears, yday, dayarr))
+		{
+			bgc_printf(BV_ERROR, "Error in output_sink_day() from bgcsim_step_day(): simyear = %d, simday = %d\n",
+				simyr,yday);
+			ok=0;
+		}
+
+		bgc_printf(BV_DIAG, "%d\t%d\tdone daily output\n",simyr,yday);
+	}
+
+	/*******************/
+	/* MONTHLY OUTPUTS */
+	/*******************/
+
+	/* MONTHLY AVERAGE OF DAILY OUTPUT VARIABLES */
+	if (ok && ctrl->domonavg)
+	{
+		/* update the monthly average array */
+		for (outv=0 ; outv<ctrl->ndayout ; outv++)
+		{
+			sim->monavgarr[outv] += dayarr[outv];
+
+			switch (ctrl->daycodes[outv])
+			{
+				/* Leaf area index */
+				case 545:
+					if (dayarr[outv] > sim->monmaxlai) sim->monmaxlai = dayarr[outv];
+					break;
+			}
+		}
+
+		/* if this is the last day of the current month, output... */
+		if (yday == endday[sim->curmonth])
+		{
+			/* finish the averages */
+			for (outv=0 ; outv<ctrl->ndayout ; outv++)
+			{
+				if (summary_sanity == SANE)
+				{
+					switch (ctrl->daycodes[outv])
+					{
+						/* Leaf area index */
+						/* Maximum monthly */
+						case 545:
+							sim->monavgarr[outv] = sim->monmaxlai;
+							break;
+						/* Snow water */
+						case 21:
+							sim->monavgarr[outv] = dayarr[outv] - sim->eomsnoww;
+							sim->eomsnoww = dayarr[outv];
+							break;
+						/* Soil water content */
+						case 20:
+							sim->monavgarr[outv] = dayarr[outv] - sim->eomsoilw;
+							sim->eomsoilw = dayarr[outv];
+							break;
+						default:
+							sim->monavgarr[outv] /= (float)mondays[sim->curmonth];
+							break;
+					}
+				}
+				else
+				{
+					sim->monavgarr[outv] /= (float)mondays[sim->curmonth];
+				}
+			}
+
+			/* send to the output sinks */
+			if (output_sink_month(sim->sink, (sim->mode == MODE_MODEL) ?
+				ctrl->simstartyear+simyr : sim->spinyears, sim->curmonth, sim->monavgarr))
+			{
+				bgc_printf(BV_ERROR, "Error in output_sink_month() from bgcsim_step_day(): simyear = %d, simday = %d\n",
+					simyr,yday);
+				ok=0;
+			}
+
+			/* reset monthly average variables for next month */
+			for (outv=0 ; outv<ctrl->ndayout ; outv++)
+			{
+				sim->monavgarr[outv] = 0.0;
+				sim->monmaxlai = 0.0;
+				sim->monmaxsnoww = 0.0;
+			}
+
+			/* increment current month counter */
+			sim->curmonth++;
+
+			bgc_printf(BV_DIAG, "%d\t%d\tdone monavg output\n",simyr,yday);
+		}
+	}
+
+	/* ANNUAL AVERAGE OF DAILY OUTPUT VARIABLES */
+	if (ok && ctrl->doannavg)
+	{
+		/* update the annual average array */
+		for (outv=0 ; outv<ctrl->ndayout ; outv++)
+		{
+			sim->annavgarr[outv] += dayarr[outv];
+			switch (ctrl->daycodes[outv])
+			{
+				/* Leaf area index */
+				case 545:
+					if (dayarr[outv] > sim->annmaxplai) sim->annmaxplai = dayarr[outv];
+					break;
+			}
+		}
+
+		/* if this is the last day of the year, output... */
+		if (yday == 364)
+		{
+			/* finish averages */
+			for (outv=0 ; outv<ctrl->ndayout ; outv++)
+			{
+				if (summary_sanity == SANE)
+				{
+					switch (ctrl->daycodes[outv])
+					{
+						/* Leaf area index*/
+						case 545:
+							sim->annavgarr[outv] = (float)sim->annmaxplai;
+							break;
+						default:
+							sim->annavgarr[outv] /= 365.0;
+							break;
+					}
+				}
+				else
+				{
+					sim->annavgarr[outv] /= 365.0;
+				}
+			}
+
+			/* sent to the output sinks with the annual outputs, at the
+			end of the year */
+			bgc_printf(BV_DIAG, "%d\t%d\tdone annavg output\n",simyr,yday);
+		}
+	}
+
+	if (sim->mode == MODE_MODEL)
+	{
+		/* very simple annual summary variables for text file output */
+		if (epv->proj_lai > (double)sim->annmaxlai) sim->annmaxlai = (float)epv->proj_lai;
+		sim->annet += wf->canopyw_evap + wf->snoww_subl + wf->soilw_evap +
+			wf->soilw_trans;
+		sim->annoutflow += wf->soilw_outflow;
+		sim->annnpp += summary->daily_npp * 1000.0;
+		sim->annnbp += summary->daily_nee * 1000.0;
+		sim->annprcp += metv->prcp;
+		sim->anntavg += metv->tavg/365.0;
+	}
+	else if (sim->mode == MODE_SPINUP)
+	{
+		/* spinup control */
+		/* keep a tally of total soil C during successive
+		met cycles for comparison */
+		if (sim->metcycle == 1)
+		{
+			sim->tally1 += summary->soilc;
+			sim->tally1b += summary->totalc;
+		}
+		if (sim->metcycle == 2)
+		{
+			sim->tally2 += summary->soilc;
+			sim->tally2b += summary->totalc;
+		}
+		/* soil and total C at the start of the spinup, for the trends
+		of the first telemetry record */
+		if (sim->telem_n == 0 && sim->spinyears == 0 && simyr == 0 && yday == 0)
+		{
+			sim->telem_soilc = summary->soilc;
+			sim->telem_totalc = summary->totalc;
+		}
+		if (ok && sim->coarse_rec && coarse_record(cs, ns, cf, &sim->coarse))
+		{
+			bgc_printf(BV_ERROR, "Error in coarse_record() from bgcsim_step_day()\n");
+			ok=0;
+		}
+	}
+
+	/* advance to the next day, and handle the end of the year */
+	if (ok)
+	{
+		sim->yday++;
+		if (sim->yday == 365)
+		{
+			if (bgcsim_year_end(sim))
+			{
+				bgc_printf(BV_ERROR, "Error in bgcsim_year_end() from bgcsim_step_day()\n");
+				ok=0;
+			}
+		}
+	}
+
+	return (!ok);
+}
+
+/* annual output and the advance to the next year, done after the last
+day of each simulation year */
+static int bgcsim_year_end(bgcsim_struct* sim)
+{
+	int ok=1;
+	int outv;
+	control_struct* ctrl = &sim->ctrl;
+	bgcout_struct* bgcout = sim->bgcout;
+	int simyr = sim->simyr;
+	int yday = 364;
+	output_year_struct rec;
+
+	/* ANNUAL OUTPUT HANDLING */
+	/* only write annual outputs if requested */
+	if (ok && ctrl->doannual)
+	{
+		/* fill the annual output array */
+		for (outv=0 ; outv<ctrl->nannout ; outv++)
+		{
+			sim->annarr[outv] = (float) *sim->output_map[ctrl->anncodes[outv]];
+		}
+		if (bgcout->tap && bgcout->tap->readers)
+		{
+			output_tap_publish(bgcout->tap, TAP_YEAR, (sim->mode == MODE_MODEL) ?
+				ctrl->simstartyear+simyr : sim->spinyears, yday, sim->annarr, ctrl->nannout);
+		}
+		bgc_printf(BV_DIAG, "%d\t%d\tdone annual output\n",simyr,yday);
+	}
+
+	/* send the annual averages, the annual outputs and the simple
+	annual text values to the output sinks */
+	memset(&rec, 0, sizeof(output_year_struct));
+	rec.annavg = ctrl->doannavg ? sim->annavgarr : NULL;
+	rec.ann = ctrl->doannual ? sim->annarr : NULL;
+	if (sim->mode == MODE_MODEL)
+	{
+		rec.text = 1;
+		rec.prcp = sim->annprcp;
+		rec.tavg = sim->anntavg;
+		rec.maxlai = sim->annmaxlai;
+		rec.et = sim->annet;
+		rec.outflow = sim->annoutflow;
+		rec.npp = sim->annnpp;
+		rec.nbp = sim->annnbp;
+	}
+	if (ok && output_sink_year(sim->sink, (sim->mode == MODE_MODEL) ?
+		ctrl->simstartyear+simyr : sim->spinyears, &rec))
+	{
+		bgc_printf(BV_ERROR, "Error in output_sink_year() from bgcsim_year_end(): simyear = %d\n",simyr);
+		ok=0;
+	}
+
+	/* reset annual average variables for next year */
+	if (ctrl->doannavg)
+	{
+		for (outv=0 ; outv<ctrl->ndayout ; outv++)
+		{
+			sim->annavgarr[outv] = 0.0;
+		}
+		sim->annmaxplai = 0.0;
+	}
+
+	sim->metyr++;
+
+	if (sim->mode == MODE_SPINUP)
+	{
+		/* spinup control */
+		sim->spinyears++;
+
+		/* at the end of a recorded block, advance the litter, CWD and
+		soil pools by spincoarse years for each year of the block */
+		if (ok && sim->coarse_rec && simyr == sim->nblock - 1)
+		{
+			if (coarse_advance(&sim->coarse, &sim->cs, &sim->ns, ctrl->spincoarse * sim->nblock))
+			{
+				bgc_printf(BV_ERROR, "Error in coarse_advance() from bgcsim_year_end()\n");
+				ok=0;
+			}
+			sim->stats.spinup_coarse += ctrl->spincoarse * sim->nblock;
+			sim->coarse_rec = 0;
+		}
+	}
+
+	/* move to the first day of the next year */
+	sim->yday = 0;
+	sim->simyr++;
+	sim->newyear = 1;
+
+	/* end of a block of years */
+	if (ok && sim->simyr == sim->nyears)
+	{
+		if (bgcsim_block_end(sim))
+		{
+			bgc_printf(BV_ERROR, "Error in bgcsim_block_end() from bgcsim_year_end()\n");
+			ok=0;
+		}
+	}
+
+	return (!ok);
+}
+
+/* spinup control at the end of each block of years, and the test for
+the end of the simulation */
+static int bgcsim_block_end(bgcsim_struct* sim)
+{
+	int ok=1;
+	double nblock = (double)sim->nblock;
+	int metcycle = sim->metcycle;   /* metcycle of the block just ended */
+
+	if (sim->mode == MODE_SPINUP)
+	{
+		/* spinup control */
+		/* the trend of the vegetation and litter C over the same
+		cycles, for the coarse spinup steps */
+		if (sim->metcycle == 2)
+		{
+			sim->vegsteady = (fabs(((sim->tally2b - sim->tally2) - (sim->tally1b - sim->tally1)) /
+				(nblock * 365.0) / nblock) < SPINUP_TOLERANCE);
+			bgc_printf(BV_DIAG, "vegsteady = %d\n",sim->vegsteady);
+		}
+
+		/* if this is the third pass through metcycle, do comparison */
+		/* first block is during the rising phase */
+		if (!sim->steady1 && sim->metcycle == 2)
+		{
+			/* convert tally1 and tally2 to average daily soilc */
+			sim->tally1 /= nblock * 365.0;
+			sim->tally2 /= nblock * 365.0;
+			sim->rising = (sim->tally2 > sim->tally1);
+			sim->t1 = (sim->tally2-sim->tally1)/nblock;
+			sim->steady1 = (fabs(sim->t1) < SPINUP_TOLERANCE);
+
+			bgc_printf(BV_DIAG, "spinyears = %d rising = %d steady1 = %d\n",sim->spinyears,
+				sim->rising,sim->steady1);
+			bgc_printf(BV_DIAG, "metcycle = %d tally1 = %lf tally2 = %lf pdif = %lf\n\n",
+				sim->metcycle,sim->tally1,sim->tally2,sim->t1);
+			if (sim->steady1)
+			{
+				bgc_printf(BV_DIAG, "SWITCH\n\n");
+				sim->stats.spinup_switch++;
+			}
+
+			sim->metcycle = 0;
+		}
+		/* second block is after supplemental N turned off */
+		else if (sim->steady1 && sim->metcycle == 2)
+		{
+			/* convert tally1 and tally2 to average daily soilc */
+			sim->tally1 /= nblock * 365.0;
+			sim->tally2 /= nblock * 365.0;
+			sim->t1 = (sim->tally2-sim->tally1)/nblock;
+			sim->steady2 = (fabs(sim->t1) < SPINUP_TOLERANCE);
+
+			/* if rising above critical rate, back to steady1=0 */
+			if (sim->t1 > SPINUP_TOLERANCE)
+			{
+				bgc_printf(BV_DIAG, "\nSWITCH BACK\n");
+				sim->stats.spinup_switchback++;
+
+				sim->steady1 = 0;
+				sim->rising = 1;
+			}
+
+			bgc_printf(BV_DIAG, "spinyears = %d rising = %d steady2 = %d\n",sim->spinyears,
+				sim->rising,sim->steady2);
+			bgc_printf(BV_DIAG, "metcycle = %d tally1 = %lf tally2 = %lf pdif = %lf\n\n",
+				sim->metcycle,sim->tally1,sim->tally2,sim->t1);
+
+			sim->metcycle = 0;
+		}
+		else
+		{
+			bgc_printf(BV_DIAG, "spinyears = %d rising = %d steady1 = %d\n",sim->spinyears,
+				sim->rising,sim->steady1);
+			bgc_printf(BV_DIAG, "metcycle = %d tally1 = %lf tally2 = %lf pdif = %lf\n",
+				sim->metcycle,sim->tally1,sim->tally2,sim->t1);
+
+			sim->metcycle++;
+		}
+
+		/* test for steady state, otherwise start another block */
+		if (!(sim->steady1 && sim->steady2) && (sim->spinyears < sim->ctrl.maxspinyears ||
+			sim->metcycle != 0))
+		{
+			sim->simyr = 0;
+		}
+		else
+		{
+			sim->done = 1;
+		}
+
+		/* convergence telemetry for the block */
+		if (ok && (sim->bgcout->telemetry || sim->bgcout->telem_last) &&
+			bgcsim_telemetry(sim, metcycle))
+		{
+			bgc_printf(BV_ERROR, "Error in bgcsim_telemetry() from bgcsim_block_end()\n");
+			ok=0;
+		}
+	}
+	else
+	{
+		sim->done = 1;
+	}
+
+	return (!ok);
+}
+
+/* spinup convergence record at the end of a block, written to the
+telemetry file and copied to telem_last. The years left are estimated
+from the decay of the soil C trend over the last three blocks, taken as
+exponential, to the spinup tolerance, and then to the end of the next
+steady state test that can end the spinup. */
+static int bgcsim_telemetry(bgcsim_struct* sim, int metcycle)
+{
+	int ok=1;
+	int i, years, left;
+	double a, b, rate;
+	spinup_telem_struct rec;
+	bgcout_struct* bgcout = sim->bgcout;
+
+	memset(&rec, 0, sizeof(spinup_telem_struct));
+	rec.spinyears = sim->spinyears;
+	rec.metcycle = metcycle;
+	if (sim->done) rec.phase = SPINUP_PHASE_DONE;
+	else rec.phase = sim->steady1 ? SPINUP_PHASE_STEADY : SPINUP_PHASE_NADD;
+	rec.soilc = sim->summary.soilc;
+	rec.totalc = sim->summary.totalc;
+	years = sim->spinyears - sim->telem_years;
+	if (years > 0)
+	{
+		rec.soilc_trend = (rec.soilc - sim->telem_soilc) / (double)years;
+		rec.totalc_trend = (rec.totalc - sim->telem_totalc) / (double)years;
+	}
+	rec.tested = (metcycle == 2);
+	if (rec.tested) rec.test_trend = sim->t1;
+	rec.wall = (double)time(NULL) - sim->telem_start;
+
+	/* soil C trends of the last four blocks, newest first */
+	for (i=3 ; i>0 ; i--) sim->telem_trend[i] = sim->telem_trend[i-1];
+	sim->telem_trend[0] = rec.soilc_trend;
+	sim->telem_n++;
+
+	rec.forecast = -1.0;
+	if (sim->done)
+	{
+		rec.forecast = 0.0;
+	}
+	else if (sim->telem_n >= 4)
+	{
+		a = fabs(sim->telem_trend[3]);
+		b = fabs(sim->telem_trend[0]);
+		if (b < SPINUP_TOLERANCE) rec.forecast = 0.0;
+		else if (a > b)
+		{
+			rate = log(a / b) / (3.0 * (double)sim->nblock);
+			rec.forecast = log(b / SPINUP_TOLERANCE) / rate;
+		}
+	}
+	if (rec.forecast >= 0.0 && !sim->done)
+	{
+		/* blocks to the end of the next test, and one more group of
+		three blocks while supplemental N is on */
+		rec.forecast += (double)((3 - sim->metcycle) * sim->nblock);
+		if (!sim->steady1) rec.forecast += (double)(3 * sim->nblock);
+
+		/* the spinup stops at the first metcycle 0 after maxspinyears */
+		left = ((3 - sim->metcycle) % 3) * sim->nblock;
+		while (sim->spinyears + left < sim->ctrl.maxspinyears) left += 3 * sim->nblock;
+		if (rec.forecast > (double)left) rec.forecast = (double)left;
+	}
+
+	sim->telem_years = sim->spinyears;
+	sim->telem_soilc = rec.soilc;
+	sim->telem_totalc = rec.totalc;
+
+	if (bgcout->telem_last) *bgcout->telem_last = rec;
+	if (bgcout->telemetry && bgc_telemetry_write(bgcout->telemetry, bgcout->site, &rec))
+	{
+		bgc_printf(BV_ERROR, "Error writing spinup telemetry\n");
+		ok=0;
+	}
+
+	return (!ok);
+}
+
+/* advance the simulation to the start of the next year, or to the end of
+the simulation */
+int bgcsim_step_year(bgcsim_struct* sim)
+{
+	int ok=1;
+
+	do
+	{
+		if (bgcsim_step_day(sim))
+		{
+			bgc_printf(BV_ERROR, "Error in bgcsim_step_day() from bgcsim_step_year()\n");
+			ok=0;
+		}
+	} while (ok && !sim->done && !sim->newyear);
+
+	return (!ok);
+}
+
+int bgcsim_get_state(const bgcsim_struct* sim, bgcstate_struct* state)
+{
+	int ok=1;
+
+	state->ws = sim->ws;
+	state->cs = sim->cs;
+	state->ns = sim->ns;
+	state->epv = sim->epv;
+	state->summary = sim->summary;
+	state->bal = sim->bal;
+	state->stats = sim->stats;
+	state->co2 = sim->metv.co2;
+	state->daily_ndep = sim->daily_ndep;
+	state->daily_nfix = sim->daily_nfix;
+	state->simyr = sim->simyr;
+	state->yday = sim->yday;
+	state->metyr = sim->metyr;
+	state->newyear = sim->newyear;
+	state->done = sim->done;
+	state->curmonth = sim->curmonth;
+	state->monmaxlai = sim->monmaxlai;
+	state->annmaxlai = sim->annmaxlai;
+	state->monmaxsnoww = sim->monmaxsnoww;
+	state->eomsnoww = sim->eomsnoww;
+	state->eomsoilw = sim->eomsoilw;
+	state->steady1 = sim->steady1;
+	state->steady2 = sim->steady2;
+	state->rising = sim->rising;
+	state->metcycle = sim->metcycle;
+	state->spinyears = sim->spinyears;
+	state->tally1 = sim->tally1;
+	state->tally1b = sim->tally1b;
+	state->tally2 = sim->tally2;
+	state->tally2b = sim->tally2b;
+	state->t1 = sim->t1;
+	state->naddfrac = sim->naddfrac;
+	state->vegsteady = sim->vegsteady;
+	state->coarse_rec = sim->coarse_rec;
+	state->coarse = sim->coarse;
+	state->annmaxplai = sim->annmaxplai;
+	state->annet = sim->annet;
+	state->annoutflow = sim->annoutflow;
+	state->annnpp = sim->annnpp;
+	state->annnbp = sim->annnbp;
+	state->annprcp = sim->annprcp;
+	state->anntavg = sim->anntavg;
+
+	/* a state is only taken between days */
+	if (sim->replay_yday >= 0)
+	{
+		bgc_printf(BV_ERROR, "Error: bgcsim_get_state() called during a mass balance replay\n");
+		ok=0;
+	}
+
+	return (!ok);
+}
+
+int bgcsim_set_state(bgcsim_struct* sim, const bgcstate_struct* state)
+{
+	int ok=1;
+
+	if (state->yday < 0 || state->yday > 364 || state->simyr < 0 ||
+		(state->simyr >= sim->nyears && !state->done) ||
+		state->metyr < 0 || state->metyr > sim->ctrl.metyears)
+	{
+		bgc_printf(BV_ERROR, "Error: invalid simulation position in bgcsim_set_state()\n");
+		ok=0;
+	}
+
+	if (ok)
+	{
+		sim->ws = state->ws;
+		sim->cs = state->cs;
+		sim->ns = state->ns;
+		sim->epv = state->epv;
+		sim->summary = state->summary;
+		sim->bal = state->bal;
+		sim->stats = state->stats;
+		sim->metv.co2 = state->co2;
+		sim->daily_ndep = state->daily_ndep;
+		sim->daily_nfix = state->daily_nfix;
+		sim->simyr = state->simyr;
+		sim->yday = state->yday;
+		sim->metyr = state->metyr;
+		sim->newyear = state->newyear;
+		sim->done = state->done;
+		sim->curmonth = state->curmonth;
+		sim->monmaxlai = state->monmaxlai;
+		sim->annmaxlai = state->annmaxlai;
+		sim->monmaxsnoww = state->monmaxsnoww;
+		sim->eomsnoww = state->eomsnoww;
+		sim->eomsoilw = state->eomsoilw;
+		sim->steady1 = state->steady1;
+		sim->steady2 = state->steady2;
+		sim->rising = state->rising;
+		sim->metcycle = state->metcycle;
+		sim->spinyears = state->spinyears;
+		sim->tally1 = state->tally1;
+		sim->tally1b = state->tally1b;
+		sim->tally2 = state->tally2;
+		sim->tally2b = state->tally2b;
+		sim->t1 = state->t1;
+		sim->naddfrac = state->naddfrac;
+		sim->vegsteady = state->vegsteady;
+		sim->coarse_rec = state->coarse_rec;
+		sim->coarse = state->coarse;
+		sim->annmaxplai = state->annmaxplai;
+		sim->annet = state->annet;
+		sim->annoutflow = state->annoutflow;
+		sim->annnpp = state->annnpp;
+		sim->annnbp = state->annnbp;
+		sim->annprcp = state->annprcp;
+		sim->anntavg = state->anntavg;
+
+		/* the restored state is the reference for any later balance
+		replay */
+		sim->bal_ws = sim->ws;
+		sim->bal_cs = sim->cs;
+		sim->bal_ns = sim->ns;
+		sim->bal_epv = sim->epv;
+		sim->bal_summary = sim->summary;
+		sim->bal_stats = sim->stats;
+		sim->bal_snap = sim->bal;
+		sim->bal_yday = (sim->newyear ? -1 : sim->yday - 1);
+		sim->bal_days = 0;
+		sim->replay_yday = -1;
+	}
+
+	return (!ok);
+}
+
+/* resume record of a run stopped early between days for reason: the
+state, and the partial monthly and annual averages of the daily
+outputs, so that the outputs of the continued run carry on from those
+written so far */
+int bgcsim_get_resume(const bgcsim_struct* sim, int reason,
+restart_resume_struct* resume)
+{
+	int ok=1;
+	int outv;
+
+	memset(resume, 0, sizeof(restart_resume_struct));
+	resume->magic = RESUME_MAGIC;
+	resume->mode = sim->mode;
+	resume->reason = reason;
+	resume->ndayout = sim->ctrl.ndayout;
+	if (sim->ctrl.ndayout > NMAP)
+	{
+		bgc_printf(BV_ERROR, "Error: %d daily outputs, a resume record holds at most %d: bgcsim_get_resume()\n",
+			sim->ctrl.ndayout, NMAP);
+		ok=0;
+	}
+	if (ok && bgcsim_get_state(sim, &resume->state))
+	{
+		bgc_printf(BV_ERROR, "Error in call to bgcsim_get_state() from bgcsim_get_resume()\n");
+		ok=0;
+	}
+	resume->psn_sun = sim->psn_sun;
+	resume->psn_shade = sim->psn_shade;
+	for (outv=0 ; ok && outv<sim->ctrl.ndayout ; outv++)
+	{
+		if (sim->monavgarr) resume->monavg[outv] = sim->monavgarr[outv];
+		if (sim->annavgarr) resume->annavg[outv] = sim->annavgarr[outv];
+	}
+
+	return (!ok);
+}
+
+/* continue a stopped run from its resume record, after bgcsim_init()
+with the same inputs */
+int bgcsim_set_resume(bgcsim_struct* sim, const restart_resume_struct* resume)
+{
+	int ok=1;
+	int outv;
+
+	if (resume->magic != RESUME_MAGIC || resume->mode != sim->mode ||
+		resume->ndayout != sim->ctrl.ndayout)
+	{
+		bgc_printf(BV_ERROR, "Error: the resume record is not from a %s run with %d daily outputs: bgcsim_set_resume()\n",
+			(sim->mode == MODE_SPINUP) ? "spinup" : "model", sim->ctrl.ndayout);
+		ok=0;
+	}
+	if (ok && bgcsim_set_state(sim, &resume->state))
+	{
+		bgc_printf(BV_ERROR, "Error in call to bgcsim_set_state() from bgcsim_set_resume()\n");
+		ok=0;
+	}
+	for (outv=0 ; ok && outv<sim->ctrl.ndayout ; outv++)
+	{
+		if (sim->monavgarr) sim->monavgarr[outv] = resume->monavg[outv];
+		if (sim->annavgarr) sim->annavgarr[outv] = resume->annavg[outv];
+	}
+
+	/* telemetry trends from here on */
+	if (ok)
+	{
+		sim->psn_sun = resume->psn_sun;
+		sim->psn_shade = resume->psn_shade;
+		sim->telem_years = sim->spinyears;
+		sim->telem_soilc = sim->summary.soilc;
+		sim->telem_totalc = sim->summary.totalc;
+	}
+
+	return (!ok);
+}
+
+/* end of simulation: spinup status and restart data */
+int bgcsim_finish(bgcsim_struct* sim)
+{
+	int ok=1;
+	bgcout_struct* bgcout = sim->bgcout;
+	double nblock = (double)sim->nblock;
+
+	/* mode == MODE_SPINUP only */
+	if (sim->mode == MODE_SPINUP)
+	{
+		/* save some information on the end status of spinup */
+		sim->tally1b /= nblock * 365.0;
+		sim->tally2b /= nblock * 365.0;
+		bgcout->spinup_resid_trend = (sim->tally2b-sim->tally1b)/nblock;
+		bgcout->spinup_years = sim->spinyears;
+	}
+
+	/* event counters for the run */
+	bgcout->stats = sim->stats;
+
+	/* RESTART OUTPUT HANDLING */
+	/* if write_restart flag is set, copy data to the output restart struct */
+	/* Removed 'write_restart' restriction to ensure that restart data are */
+	/* available for spin and go operation.  WMJ 3/16/2005 */
+	if (restart_output(&sim->ctrl, &sim->ws, &sim->cs, &sim->ns, &sim->epv,
+		sim->metyr, &(bgcout->restart_output)))
+	{
+		bgc_printf(BV_ERROR, "Error in call to restart_output() from bgcsim_finish()\n");
+		ok=0;
+	}
+
+	bgc_printf(BV_DIAG, "done restart output\n");
+
+	return (!ok);
+}
+
+/* release the memory held by the simulation. Safe to call after a failed
+bgcsim_init() */
+int bgcsim_free(bgcsim_struct* sim)
+{
+	int ok=1;
+
+	/* the end of the outputs, whether the simulation finished or not */
+	if (sim->sink_open && output_sink_close(sim->sink))
+	{
+		bgc_printf(BV_ERROR, "Error in call to output_sink_close() from bgcsim_free()\n");
+		ok=0;
+	}
+	sim->sink_open = 0;
+
+	/* the phenology arrays, the forcing-derivative cache and the local
+	output arrays and map are all in the arena */
+	arena_release(&sim->arena);
+	sim->phenarr.remdays_curgrowth = NULL;
+	sim->phenarr.remdays_transfer = NULL;
+	sim->phenarr.remdays_litfall = NULL;
+	sim->phenarr.predays_transfer = NULL;
+	sim->phenarr.predays_litfall = NULL;
+	sim->dayarr = NULL;
+	sim->monavgarr = NULL;
+	sim->annavgarr = NULL;
+	sim->annarr = NULL;
+	sim->output_map = NULL;
+
+	bgc_printf(BV_DIAG, "done free simulation memory\n");
+
+	return (!ok);
+}
@@ -12,7 +12,7 @@ See copyright.txt for Copyright information
 #include "bgc.h"
 
 int canopy_et(const metvar_struct* metv, const epconst_struct* epc, 
-epvar_struct* epv, wflux_struct* wf, int verbose)
+epvar_struct* epv, wflux_struct* wf, int verbose, bgcstats_struct* stats)
 {
 	int ok=1;
 	double gl_bl, gl_c, gl_s_sun, gl_s_shade;
@@ -45,8 +45,10 @@ epvar_struct* epv, wflux_struct* wf, int verbose)
 	vpd_open =  epc->vpd_open;
 	vpd_close = epc->vpd_close;
 
-	/* temperature and pressure correction factor for conductances */
-	gcorr = pow((metv->tday+273.15)/293.15, 1.75) * 101300/metv->pa;
+	/* temperature and pressure correction factor for conductances,
+	gcorr = pow((tday+273.15)/293.15, 1.75) * 101300/pa, taken from the
+	forcing-derivative cache (see metcache_init()) */
+	gcorr = metv->gcorr;
 	
 	/* calculate leaf- and canopy-level conductances to water vapor and
 	sensible heat fluxes */
@@ -160,6 +162,7 @@ epvar_struct* epv, wflux_struct* wf, int verbose)
 		pmet_in.irad = metv->swabs;
 		
 		/* call penman-monteith function, returns e in kg/m2/s */
+		stats->penmon_calls++;
 		if (penmon(&pmet_in, 0, &e))
 		{
 			bgc_printf(BV_ERROR, "Error: penmon() for canopy evap... \n");
@@ -188,6 +191,7 @@ epvar_struct* epv, wflux_struct* wf, int verbose)
 			pmet_in.rv = 1.0/gl_t_wv_sun;
 			pmet_in.rh = 1.0/gl_sh;
 			pmet_in.irad = metv->swabs_per_plaisun;
+			stats->penmon_calls++;
 			if (penmon(&pmet_in, 0, &t))
 			{
 				bgc_printf(BV_ERROR, "Error: penmon() for adjusted transpiration... \n");
@@ -199,6 +203,7 @@ epvar_struct* epv, wflux_struct* wf, int verbose)
 			pmet_in.rv = 1.0/gl_t_wv_shade;
 			pmet_in.rh = 1.0/gl_sh;
 			pmet_in.irad = metv->swabs_per_plaishade;
+			stats->penmon_calls++;
 			if (penmon(&pmet_in, 0, &t))
 			{
 				bgc_printf(BV_ERROR, "Error: penmon() for adjusted transpiration... \n");
@@ -215,6 +220,7 @@ epvar_struct* epv, wflux_struct* wf, int verbose)
 		pmet_in.rv = 1.0/gl_t_wv_sun;
 		pmet_in.rh = 1.0/gl_sh;
 		pmet_in.irad = metv->swabs_per_plaisun;
+		stats->penmon_calls++;
 		if (penmon(&pmet_in, 0, &t))
 		{
 			bgc_printf(BV_ERROR, "Error: penmon() for adjusted transpiration... \n");
@@ -226,6 +232,7 @@ epvar_struct* epv, wflux_struct* wf, int verbose)
 		pmet_in.rv = 1.0/gl_t_wv_shade;
 		pmet_in.rh = 1.0/gl_sh;
 		pmet_in.irad = metv->swabs_per_plaishade;
+		stats->penmon_calls++;
 		if (penmon(&pmet_in, 0, &t))
 		{
 			bgc_printf(BV_ERROR, "Error: penmon() for adjusted transpiration... \n");
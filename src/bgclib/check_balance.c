@@ -2,6 +2,12 @@
 check_balance.c
 daily test of mass balance (water, carbon, and nitrogen state variables)
 
+The balance from the previous check is carried in a balance_struct
+rather than in static variables, so that bgc() can restore it when a
+failed check is replayed day by day (see the -b option in USAGE.TXT).
+When bal->quiet is set, the details of a failed check are only reported
+at the diagnostic verbosity level.
+
 *-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
 Biome-BGC version 4.2 (final release)
 See copyright.txt for Copyright information
@@ -10,11 +16,11 @@ See copyright.txt for Copyright information
 
 #include "bgc.h"
 
-int check_water_balance(wstate_struct* ws, int first_balance)
+int check_water_balance(wstate_struct* ws, balance_struct* bal)
 {
 	int ok=1;
-	static double old_balance;
 	double in, out, store, balance;
+	signed char level;
 	
 	/* DAILY CHECK ON WATER BALANCE */
 	
@@ -31,32 +37,33 @@ int check_water_balance(wstate_struct* ws, int first_balance)
 	/* calculate current balance */
 	balance = in - out - store;
 	 
-	if (!first_balance)
+	level = (bal->quiet ? BV_DIAG : BV_ERROR);
+	if (!bal->first)
 	{
-		if (fabs(old_balance - balance) > 1e-4)
+		if (fabs(bal->old_wbal - balance) > 1e-4)
 		{
-			bgc_printf(BV_ERROR, "FATAL ERRROR: Water balance error:\n");
-			bgc_printf(BV_ERROR, "Balance from previous day = %lf\n",old_balance);
-			bgc_printf(BV_ERROR, "Balance from current day  = %lf\n",balance);
-			bgc_printf(BV_ERROR, "Difference (previous - current) = %lf\n",old_balance-balance);
-			bgc_printf(BV_ERROR, "Components of current balance:\n");
-			bgc_printf(BV_ERROR, "Sources (summed over entire run)  = %lf\n",in);
-			bgc_printf(BV_ERROR, "Sinks   (summed over entire run)  = %lf\n",out);
-			bgc_printf(BV_ERROR, "Storage (current state variables) = %lf\n",store);
-			bgc_printf(BV_ERROR, "Exiting...\n");
+			bgc_printf(level, "FATAL ERRROR: Water balance error:\n");
+			bgc_printf(level, "Balance from previous day = %lf\n",bal->old_wbal);
+			bgc_printf(level, "Balance from current day  = %lf\n",balance);
+			bgc_printf(level, "Difference (previous - current) = %lf\n",bal->old_wbal-balance);
+			bgc_printf(level, "Components of current balance:\n");
+			bgc_printf(level, "Sources (summed over entire run)  = %lf\n",in);
+			bgc_printf(level, "Sinks   (summed over entire run)  = %lf\n",out);
+			bgc_printf(level, "Storage (current state variables) = %lf\n",store);
+			bgc_printf(level, "Exiting...\n");
 			ok=0;
 		}
 	}
-	old_balance = balance;
+	bal->old_wbal = balance;
 	
 	return (!ok);
 }
 
-int check_carbon_balance(cstate_struct* cs, int first_balance)
+int check_carbon_balance(cstate_struct* cs, balance_struct* bal)
 {
 	int ok=1;
-	static double old_balance;
 	double in, out, store, balance;
+	signed char level;
 	
 	/* DAILY CHECK ON CARBON BALANCE */
 	
@@ -85,32 +92,33 @@ int check_carbon_balance(cstate_struct* cs, int first_balance)
 	/* calculate current balance */
 	balance = in - out - store;
 	 
-	if (!first_balance)
+	level = (bal->quiet ? BV_DIAG : BV_ERROR);
+	if (!bal->first)
 	{
-		if (fabs(old_balance - balance) > 1e-8)
+		if (fabs(bal->old_cbal - balance) > 1e-8)
 		{
-			bgc_printf(BV_ERROR, "FATAL ERRROR: carbon balance error:\n");
-			bgc_printf(BV_ERROR, "Balance from previous day = %lf\n",old_balance);
-			bgc_printf(BV_ERROR, "Balance from current day  = %lf\n",balance);
-			bgc_printf(BV_ERROR, "Difference (previous - current) = %lf\n",old_balance-balance);
-			bgc_printf(BV_ERROR, "Components of current balance:\n");
-			bgc_printf(BV_ERROR, "Sources (summed over entire run)  = %lf\n",in);
-			bgc_printf(BV_ERROR, "Sinks   (summed over entire run)  = %lf\n",out);
-			bgc_printf(BV_ERROR, "Storage (current state variables) = %lf\n",store);
-			bgc_printf(BV_ERROR, "Exiting...\n");
+			bgc_printf(level, "FATAL ERRROR: carbon balance error:\n");
+			bgc_printf(level, "Balance from previous day = %lf\n",bal->old_cbal);
+			bgc_printf(level, "Balance from current day  = %lf\n",balance);
+			bgc_printf(level, "Difference (previous - current) = %lf\n",bal->old_cbal-balance);
+			bgc_printf(level, "Components of current balance:\n");
+			bgc_printf(level, "Sources (summed over entire run)  = %lf\n",in);
+			bgc_printf(level, "Sinks   (summed over entire run)  = %lf\n",out);
+			bgc_printf(level, "Storage (current state variables) = %lf\n",store);
+			bgc_printf(level, "Exiting...\n");
 			ok=0;
 		}
 	}
-	old_balance = balance;
+	bal->old_cbal = balance;
 
 	return (!ok);
 }		
 
-int check_nitrogen_balance(nstate_struct* ns, int first_balance)
+int check_nitrogen_balance(nstate_struct* ns, balance_struct* bal)
 {
 	int ok=1;
 	double in,out,store,balance;
-	static double old_balance = 0.0;
+	signed char level;
 
 	/* DAILY CHECK ON NITROGEN BALANCE */
 	
@@ -134,23 +142,24 @@ int check_nitrogen_balance(nstate_struct* ns, int first_balance)
 	/* calculate current balance */
 	balance = in - out - store;
 	 
-	if (!first_balance)
+	level = (bal->quiet ? BV_DIAG : BV_ERROR);
+	if (!bal->first)
 	{
-		if (fabs(old_balance - balance) > 1e-8)
+		if (fabs(bal->old_nbal - balance) > 1e-8)
 		{
-			bgc_printf(BV_ERROR, "FATAL ERRROR: nitrogen balance error:\n");
-			bgc_printf(BV_ERROR, "Balance from previous day = %lf\n",old_balance);
-			bgc_printf(BV_ERROR, "Balance from current day  = %lf\n",balance);
-			bgc_printf(BV_ERROR, "Difference (previous - current) = %lf\n",old_balance-balance);
-			bgc_printf(BV_ERROR, "Components of current balance:\n");
-			bgc_printf(BV_ERROR, "Sources (summed over entire run)  = %lf\n",in);
-			bgc_printf(BV_ERROR, "Sinks   (summed over entire run)  = %lf\n",out);
-			bgc_printf(BV_ERROR, "Storage (current state variables) = %lf\n",store);
-			bgc_printf(BV_ERROR, "Exiting...\n");
+			bgc_printf(level, "FATAL ERRROR: nitrogen balance error:\n");
+			bgc_printf(level, "Balance from previous day = %lf\n",bal->old_nbal);
+			bgc_printf(level, "Balance from current day  = %lf\n",balance);
+			bgc_printf(level, "Difference (previous - current) = %lf\n",bal->old_nbal-balance);
+			bgc_printf(level, "Components of current balance:\n");
+			bgc_printf(level, "Sources (summed over entire run)  = %lf\n",in);
+			bgc_printf(level, "Sinks   (summed over entire run)  = %lf\n",out);
+			bgc_printf(level, "Storage (current state variables) = %lf\n",store);
+			bgc_printf(level, "Exiting...\n");
 			ok=0;
 		}
 	}
-	old_balance = balance;
+	bal->old_nbal = balance;
 	
 	return (!ok);
 }
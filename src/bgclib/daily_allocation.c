@@ -29,7 +29,7 @@ Revisions from version 4.1.1:
 
 int daily_allocation(cflux_struct* cf, cstate_struct* cs,
 nflux_struct* nf, nstate_struct* ns, epconst_struct* epc, epvar_struct* epv,
-ntemp_struct* nt, double naddfrac, int mode) /* mode is MODE_SPINUP or MODE_MODEL */
+ntemp_struct* nt, double naddfrac, int mode, bgcstats_struct* stats) /* mode is MODE_SPINUP or MODE_MODEL */
 {
 	int ok=1;
 	double day_gpp;     /* daily gross production */
@@ -87,6 +87,8 @@ ntemp_struct* nt, double naddfrac, int mode) /* mode is MODE_SPINUP or MODE_MODE
 	/* test for cpool deficit */
 	if (cs->cpool < 0.0)
 	{
+		stats->cpool_deficit_days++;
+		
 		/* running a deficit in cpool, so the first priority
 		is to let some of today's available C accumulate in cpool.  The actual
 		accumulation in the cpool is resolved in day_carbon_state(). */
@@ -210,6 +212,7 @@ ntemp_struct* nt, double naddfrac, int mode) /* mode is MODE_SPINUP or MODE_MODE
 		plant growth demands, so these two demands compete for available
 		soil mineral N */
 		nlimit = 1;
+		stats->nlimit_days++;
 		if (sum_ndemand)
 		{
 			actual_immob = ns->sminn * (nt->potential_immob/sum_ndemand);
@@ -14,29 +14,46 @@ Revisions from version 4.1.1:
 
 #include "bgc.h"
 
-int daymet(const metarr_struct* metarr, metvar_struct* metv, int metday)
+int daymet(const metarr_struct* metarr, const metcache_struct* metcache,
+metvar_struct* metv, int metday, int snowpack)
 {
-	/* generates daily meteorological variables from the metarray struct */
+	/* generates daily meteorological variables from the metarray struct,
+	and picks up the precomputed forcing derivatives from the metcache
+	struct. snowpack selects the snow-covered soil temperature terms. */
 	int ok=1;
-	double tmax,tmin,tavg,tday;
 	
 	/* convert prcp from cm --> kg/m2 */
 	metv->prcp = metarr->prcp[metday] * 10.0;
 
-	/* air temperature calculations (all temperatures deg C) */
-	metv->tmax = tmax = metarr->tmax[metday];
-	metv->tmin = tmin = metarr->tmin[metday];
-	metv->tavg = tavg = metarr->tavg[metday];
-	metv->tday = tday = 0.45 * (tmax - tavg) + tavg;
-	metv->tnight = (tday + tmin) / 2.0;
+	/* air temperature calculations (all temperatures deg C). The
+	daylight and nighttime temperatures are computed in metcache_init() as
+	tday = 0.45 * (tmax - tavg) + tavg and tnight = (tday + tmin) / 2 */
+	metv->tmax = metarr->tmax[metday];
+	metv->tmin = metarr->tmin[metday];
+	metv->tavg = metarr->tavg[metday];
+	metv->tday = metcache->tday[metday];
+	metv->tnight = metcache->tnight[metday];
 
 	/* for this version, an 11-day running weighted average of daily
 	average temperature is used as the soil temperature at 10 cm.
 	For days 1-10, a 1-10 day running weighted average is used instead.
 	The tail of the running average is weighted linearly from 1 to 11.
-	There are no corrections for snowpack or vegetation cover. 
+	The running average is corrected toward the annual average air 
+	temperature, more strongly when there is a snowpack (see 
+	metcache_init()). There are no corrections for vegetation cover. 
 	*/
-	metv->tsoil = metarr->tavg_ra[metday];
+	if (snowpack)
+	{
+		metv->tsoil = metcache->tsoil_snow[metday];
+		metv->q10_tsoil = metcache->q10_tsoil_snow[metday];
+		metv->t_scalar = metcache->t_scalar_snow[metday];
+	}
+	else
+	{
+		metv->tsoil = metcache->tsoil_bare[metday];
+		metv->q10_tsoil = metcache->q10_tsoil_bare[metday];
+		metv->t_scalar = metcache->t_scalar_bare[metday];
+	}
 
 	/* daylight average vapor pressure deficit (Pa) */
 	metv->vpd = metarr->vpd[metday];
@@ -50,5 +67,15 @@ int daymet(const metarr_struct* metarr, metvar_struct* metv, int metday)
 	/* daylength (s) */
 	metv->dayl = metarr->dayl[metday];
 
+	/* temperature-dependent factors for canopy_et(), maint_resp() and
+	photosynthesis() */
+	metv->gcorr = metcache->gcorr[metday];
+	metv->q10_tday = metcache->q10_tday[metday];
+	metv->q10_tnight = metcache->q10_tnight[metday];
+	metv->q10_tavg = metcache->q10_tavg[metday];
+	metv->Kc = metcache->Kc[metday];
+	metv->Ko = metcache->Ko[metday];
+	metv->act = metcache->act[metday];
+
 	return (!ok);
 }
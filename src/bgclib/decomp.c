@@ -13,13 +13,12 @@ See copyright.txt for Copyright information
 
 #include "bgc.h"
 
-int decomp(double tsoil, const epconst_struct* epc, epvar_struct* epv, 
+int decomp(const metvar_struct* metv, const epconst_struct* epc, epvar_struct* epv, 
 const siteconst_struct* sitec, cstate_struct* cs, cflux_struct* cf,
 nstate_struct* ns, nflux_struct* nf, ntemp_struct* nt)
 {
 	int ok=1;
 	double rate_scalar, t_scalar, w_scalar;
-	double tk;
 	double minpsi, maxpsi;
 	double rfl1s1, rfl2s2,rfl4s3,rfs1s2,rfs2s3,rfs3s4;
 	double kl1_base,kl2_base,kl4_base,ks1_base,ks2_base,ks3_base,ks4_base,kfrag_base;
@@ -33,24 +32,9 @@ nstate_struct* ns, nflux_struct* nf, ntemp_struct* nt)
 	int nlimit;
 	double ratio;
 	
-	/* calculate the rate constant scalar for soil temperature,
-	assuming that the base rate constants are assigned for non-moisture
-	limiting conditions at 25 C. The function used here is taken from
-	Lloyd, J., and J.A. Taylor, 1994. On the temperature dependence of 
-	soil respiration. Functional Ecology, 8:315-323.
-	This equation is a modification of their eqn. 11, changing the base
-	temperature from 10 C to 25 C, since most of the microcosm studies
-	used to get the base decomp rates were controlled at 25 C. */
-	if (tsoil < -10.0)
-	{
-		/* no decomp processes for tsoil < -10.0 C */
-		t_scalar = 0.0;
-	}
-	else
-	{
-		tk = tsoil + 273.15;
-		t_scalar = exp(308.56*((1.0/71.02)-(1.0/(tk-227.13))));
-	}
+	/* rate constant scalar for soil temperature, precomputed for each
+	metday with decomp_t_scalar() (see metcache_init()) */
+	t_scalar = metv->t_scalar;
 	
 	/* calculate the rate constant scalar for soil water content.
 	Uses the log relationship with water potential given in
@@ -248,3 +232,30 @@ nstate_struct* ns, nflux_struct* nf, ntemp_struct* nt)
 	return (!ok);
 }
 
+
+double decomp_t_scalar(double tsoil)
+{
+	double t_scalar;
+	double tk;
+	
+	/* calculate the rate constant scalar for soil temperature,
+	assuming that the base rate constants are assigned for non-moisture
+	limiting conditions at 25 C. The function used here is taken from
+	Lloyd, J., and J.A. Taylor, 1994. On the temperature dependence of 
+	soil respiration. Functional Ecology, 8:315-323.
+	This equation is a modification of their eqn. 11, changing the base
+	temperature from 10 C to 25 C, since most of the microcosm studies
+	used to get the base decomp rates were controlled at 25 C. */
+	if (tsoil < -10.0)
+	{
+		/* no decomp processes for tsoil < -10.0 C */
+		t_scalar = 0.0;
+	}
+	else
+	{
+		tk = tsoil + 273.15;
+		t_scalar = exp(308.56*((1.0/71.02)-(1.0/(tk-227.13))));
+	}
+	
+	return (t_scalar);
+}
@@ -22,8 +22,9 @@ epvar_struct* epv)
 	Ryan, M.G., 1991. Effects of climate change on plant respiration.
 	Ecological Applications, 1(2):157-167.
 	
-	Uses the same value of Q_10 (2.0) for all compartments, leaf, stem, 
-	coarse and fine roots.
+	Uses the same value of Q_10 (MR_Q10 = 2.0) for all compartments, leaf,
+	stem, coarse and fine roots. The temperature factors are taken from the
+	forcing-derivative cache (see metcache_init()).
 	
 	From Ryan's figures and regressions equations, the maintenance respiration
 	in kgC/day per kg of tissue N is:
@@ -37,9 +38,7 @@ epvar_struct* epv)
 	
 	int ok=1;
 	double t1;
-	double q10 = 2.0;
 	double mrpern = 0.218;
-	double exponent;
 	double n_area_sun, n_area_shade, dlmr_area_sun, dlmr_area_shade;
 	
 	/* leaf day and night maintenance respiration when leaves on */
@@ -48,8 +47,7 @@ epvar_struct* epv)
 		t1 = ns->leafn * mrpern;
 		
 		/* leaf, day */
-		exponent = (metv->tday - 20.0) / 10.0;
-		cf->leaf_day_mr = t1 * pow(q10, exponent) * metv->dayl / 86400.0;
+		cf->leaf_day_mr = t1 * metv->q10_tday * metv->dayl / 86400.0;
 
 		/* for day respiration, also determine rates of maintenance respiration
 		per unit of projected leaf area in the sunlit and shaded portions of
@@ -60,16 +58,15 @@ epvar_struct* epv)
 		n_area_shade = 1.0/(epv->shade_proj_sla * epc->leaf_cn);
 		/* convert to respiration flux in kg C/m2 projected area/day, and
 		correct for temperature */
-		dlmr_area_sun   = n_area_sun * mrpern * pow(q10, exponent);
-		dlmr_area_shade = n_area_shade * mrpern * pow(q10, exponent);
+		dlmr_area_sun   = n_area_sun * mrpern * metv->q10_tday;
+		dlmr_area_shade = n_area_shade * mrpern * metv->q10_tday;
 		/* finally, convert from mass to molar units, and from a daily rate to 
 		a rate per second */
 		epv->dlmr_area_sun = dlmr_area_sun/(86400.0 * 12.011e-9);
 		epv->dlmr_area_shade = dlmr_area_shade/(86400.0 * 12.011e-9);
 		
 		/* leaf, night */
-		exponent = (metv->tnight - 20.0) / 10.0;
-		cf->leaf_night_mr = t1 * pow(q10, exponent) * 
+		cf->leaf_night_mr = t1 * metv->q10_tnight * 
 			(86400.0 - metv->dayl) / 86400.0;
 	}
 	else /* no leaves on */
@@ -85,8 +82,7 @@ epvar_struct* epv)
 	to avoid excessive MR with n-loading to fine roots */
 	if (cs->frootc)
 	{
-		exponent = (metv->tsoil - 20.0) / 10.0;
-		t1 = pow(q10, exponent);
+		t1 = metv->q10_tsoil;
 		cf->froot_mr = ns->frootn * mrpern * t1;
 	}
 	else /* no fine roots on */
@@ -96,13 +92,11 @@ epvar_struct* epv)
 	if (epc->woody)
 	{
 		/* live stem maintenance respiration */
-		exponent = (metv->tavg - 20.0) / 10.0;
-		t1 = pow(q10, exponent);
+		t1 = metv->q10_tavg;
 		cf->livestem_mr = ns->livestemn * mrpern * t1;
 
 		/* live coarse root maintenance respiration */
-		exponent = (metv->tsoil - 20.0) / 10.0;
-		t1 = pow(q10, exponent);
+		t1 = metv->q10_tsoil;
 		cf->livecroot_mr = ns->livecrootn * mrpern * t1;
 	}
 	
@@ -0,0 +1,132 @@
+/*
+metcache.c
+Build the forcing-derivative cache, called prior to annual loop in bgc()
+
+Every quantity stored here depends only on the met arrays and the site
+constants, so it is computed once for each metday and then reused each
+time the met record is cycled (hundreds of times during a spinup).
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#include "bgc.h"
+
+int metcache_init(const control_struct* ctrl, const metarr_struct* metarr,
+double tair_avg, double pa, metcache_struct* metcache, arena_struct* arena)
+{
+	int ok=1;
+	int i,ndays;
+	double tmax,tmin,tavg,tday,tsoil,tdiff;
+	double** arr[15];
+	int narr;
+
+	ndays = 365 * ctrl->metyears;
+
+	/* allocate space for the cache arrays */
+	narr = 0;
+	arr[narr++] = &metcache->tday;
+	arr[narr++] = &metcache->tnight;
+	arr[narr++] = &metcache->gcorr;
+	arr[narr++] = &metcache->q10_tday;
+	arr[narr++] = &metcache->q10_tnight;
+	arr[narr++] = &metcache->q10_tavg;
+	arr[narr++] = &metcache->tsoil_bare;
+	arr[narr++] = &metcache->tsoil_snow;
+	arr[narr++] = &metcache->q10_tsoil_bare;
+	arr[narr++] = &metcache->q10_tsoil_snow;
+	arr[narr++] = &metcache->t_scalar_bare;
+	arr[narr++] = &metcache->t_scalar_snow;
+	arr[narr++] = &metcache->Kc;
+	arr[narr++] = &metcache->Ko;
+	arr[narr++] = &metcache->act;
+	for (i=0 ; i<narr ; i++)
+	{
+		*arr[i] = NULL;
+	}
+	for (i=0 ; ok && i<narr ; i++)
+	{
+		if (!(*arr[i] = (double*) arena_alloc(arena, ndays * sizeof(double))))
+		{
+			bgc_printf(BV_ERROR, "Error allocating for metcache array #%d, metcache_init()\n",i);
+			ok=0;
+		}
+	}
+
+	for (i=0 ; ok && i<ndays ; i++)
+	{
+		/* daylight and nighttime air temperatures, as in daymet() */
+		tmax = metarr->tmax[i];
+		tmin = metarr->tmin[i];
+		tavg = metarr->tavg[i];
+		metcache->tday[i] = tday = 0.45 * (tmax - tavg) + tavg;
+		metcache->tnight[i] = (tday + tmin) / 2.0;
+
+		/* temperature and pressure correction factor for conductances,
+		used in canopy_et() */
+		metcache->gcorr[i] = pow((tday+273.15)/293.15, 1.75) * 101300/pa;
+
+		/* maintenance respiration temperature factors, used in maint_resp() */
+		metcache->q10_tday[i] = pow(MR_Q10, (tday - 20.0) / 10.0);
+		metcache->q10_tnight[i] = pow(MR_Q10, (metcache->tnight[i] - 20.0) / 10.0);
+		metcache->q10_tavg[i] = pow(MR_Q10, (tavg - 20.0) / 10.0);
+
+		/* soil temperature correction using difference from
+		annual average tair. The correction is stronger under a
+		snowpack, so both cases are kept. */
+		tsoil = metarr->tavg_ra[i];
+		tdiff = tair_avg - tsoil;
+		metcache->tsoil_snow[i] = tsoil + 0.83 * tdiff;
+		metcache->tsoil_bare[i] = tsoil + 0.2 * tdiff;
+		metcache->q10_tsoil_snow[i] = pow(MR_Q10, (metcache->tsoil_snow[i] - 20.0) / 10.0);
+		metcache->q10_tsoil_bare[i] = pow(MR_Q10, (metcache->tsoil_bare[i] - 20.0) / 10.0);
+
+		/* decomposition rate temperature scalar, used in decomp() */
+		metcache->t_scalar_snow[i] = decomp_t_scalar(metcache->tsoil_snow[i]);
+		metcache->t_scalar_bare[i] = decomp_t_scalar(metcache->tsoil_bare[i]);
+
+		/* temperature-dependent enzyme kinetics, used in photosynthesis() */
+		if (psn_kinetics(tday, &metcache->Kc[i], &metcache->Ko[i], &metcache->act[i]))
+		{
+			bgc_printf(BV_ERROR, "Error in psn_kinetics() from metcache_init()\n");
+			ok=0;
+		}
+	}
+
+	if (!ok)
+	{
+		for (i=0 ; i<narr ; i++)
+		{
+			arena_free(arena, *arr[i]);
+			*arr[i] = NULL;
+		}
+	}
+
+	return (!ok);
+}
+
+int free_metcache(metcache_struct* metcache)
+{
+	int ok=1;
+
+	/* free memory in forcing-derivative cache arrays */
+	free(metcache->tday);
+	free(metcache->tnight);
+	free(metcache->gcorr);
+	free(metcache->q10_tday);
+	free(metcache->q10_tnight);
+	free(metcache->q10_tavg);
+	free(metcache->tsoil_bare);
+	free(metcache->tsoil_snow);
+	free(metcache->q10_tsoil_bare);
+	free(metcache->q10_tsoil_snow);
+	free(metcache->t_scalar_bare);
+	free(metcache->t_scalar_snow);
+	free(metcache->Kc);
+	free(metcache->Ko);
+	free(metcache->act);
+
+	return (!ok);
+}
@@ -0,0 +1,514 @@
+/*
+output_container.c
+multi-site output container: the output files of many sites written
+into one file, with an index to read any one of them back
+
+A container is a sequence of chunks, each an output_chunk_struct header
+and the data of one output stream of one site. The sites of a batch
+write to the container at the same time: each site keeps its output
+files in memory streams, and at the end of every simulation year
+appends the bytes written since the last year as one chunk per stream,
+with a single write() on a descriptor opened for appending. Appends of
+one write() to a local file are not interleaved, so no locking is
+needed and the chunks of the sites only alternate in the file. A chunk
+with the CONT_TRUNC flag starts its stream over, as when an output file
+is opened for writing again; a stopped run that is continued appends to
+its streams.
+
+The index, written to <container>.idx once the writers are done, holds
+the chunks sorted by site, stream and position. A stream of a site is
+read back by copying its chunks in order, from its last CONT_TRUNC
+chunk on, which gives the bytes of the output file the site would have
+written on its own.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#define _POSIX_C_SOURCE 200809L
+#include "bgc.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+/* names of the streams, the suffixes of the output files they replace */
+static const char* stream_names[NCONT] =
+{
+	"site", "dayout", "monavgout", "annavgout", "annout",
+	"dayout.ascii", "monavgout.ascii", "annout.ascii", "ann.txt"
+};
+
+const char* output_container_stream_name(int stream)
+{
+	return ((stream >= 0 && stream < NCONT) ? stream_names[stream] : "unknown");
+}
+
+/* stream of a name, or -1 */
+int output_container_stream_decode(const char* name)
+{
+	int i;
+
+	for (i=0 ; i<NCONT ; i++)
+	{
+		if (!strcmp(name, stream_names[i])) return (i);
+	}
+	return (-1);
+}
+
+/* append one chunk of length bytes to the container */
+static int chunk_write(output_container_struct* cont, int stream, int flags,
+const void* data, size_t length)
+{
+	output_chunk_struct hdr;
+	struct iovec iov[2];
+	ssize_t n;
+
+	memset(&hdr, 0, sizeof(output_chunk_struct));
+	hdr.magic = CONT_MAGIC;
+	hdr.site = cont->site;
+	hdr.stream = stream;
+	hdr.year = cont->year;
+	hdr.flags = flags;
+	hdr.length = (long long) length;
+	iov[0].iov_base = &hdr;
+	iov[0].iov_len = sizeof(output_chunk_struct);
+	iov[1].iov_base = (void*) data;
+	iov[1].iov_len = length;
+
+	n = writev(cont->fd, iov, length ? 2 : 1);
+	if (n != (ssize_t) (sizeof(output_chunk_struct) + length))
+	{
+		bgc_printf(BV_ERROR, "Error writing a chunk of site %d to the output container: %s\n",
+			cont->site, (n < 0) ? strerror(errno) : "short write");
+		return (1);
+	}
+
+	return (0);
+}
+
+/* append what was written to a stream since its last chunk */
+static int stream_flush(output_container_struct* cont, int stream)
+{
+	long pos;
+
+	if (!cont->stream[stream]) return (0);
+	if (fflush(cont->stream[stream]) || (pos = ftell(cont->stream[stream])) < 0)
+	{
+		bgc_printf(BV_ERROR, "Error in the %s memory stream of site %d: %s\n",
+			stream_names[stream], cont->site, strerror(errno));
+		return (1);
+	}
+	if ((pos || cont->trunc[stream]) &&
+		chunk_write(cont, stream, cont->trunc[stream] ? CONT_TRUNC : 0, cont->buf[stream], (size_t) pos))
+	{
+		return (1);
+	}
+	cont->trunc[stream] = 0;
+	rewind(cont->stream[stream]);
+
+	return (0);
+}
+
+/* start writing site id site, with ini file sitename, to the container
+name. The container is created if it does not exist. */
+int output_container_open(output_container_struct* cont, const char* name,
+int site, const char* sitename)
+{
+	memset(cont, 0, sizeof(output_container_struct));
+	cont->site = site;
+	if ((cont->fd = open(name, O_WRONLY | O_APPEND | O_CREAT, 0644)) < 0)
+	{
+		bgc_printf(BV_ERROR, "Error opening output container %s: %s\n",name,strerror(errno));
+		return (1);
+	}
+	if (chunk_write(cont, CONT_SITE, 0, sitename, strlen(sitename)))
+	{
+		close(cont->fd);
+		cont->fd = -1;
+		return (1);
+	}
+
+	return (0);
+}
+
+/* write the output file target to the container, as a memory stream
+left in target->ptr. Unless append is set, the stream starts over, as
+the file would when opened for writing. A stream that is already open is
+kept, after what was written to it so far is appended. */
+int output_container_stream(output_container_struct* cont, int stream,
+file* target, int append)
+{
+	if (cont->stream[stream])
+	{
+		if (stream_flush(cont, stream)) return (1);
+	}
+	else if (!(cont->stream[stream] = open_memstream(&cont->buf[stream], &cont->size[stream])))
+	{
+		bgc_printf(BV_ERROR, "Error opening the %s memory stream of site %d: %s\n",
+			stream_names[stream], cont->site, strerror(errno));
+		return (1);
+	}
+	cont->trunc[stream] = !append;
+	cont->target[stream] = target;
+	target->ptr = cont->stream[stream];
+
+	return (0);
+}
+
+/* append the outputs of simulation year year, at the end of the year.
+Does nothing when cont is NULL. */
+int output_container_year(output_container_struct* cont, int year)
+{
+	int ok=1;
+	int i;
+
+	if (!cont) return (0);
+
+	cont->year = year;
+	for (i=0 ; ok && i<NCONT ; i++)
+	{
+		if (stream_flush(cont, i)) ok=0;
+	}
+	cont->year = year + 1;
+
+	return (!ok);
+}
+
+/* append what is left in the streams and close them, and the container.
+The output files that held the streams are left closed. */
+int output_container_close(output_container_struct* cont)
+{
+	int ok=1;
+	int i;
+
+	for (i=0 ; i<NCONT ; i++)
+	{
+		if (!cont->stream[i]) continue;
+		if (ok && stream_flush(cont, i)) ok=0;
+		fclose(cont->stream[i]);
+		free(cont->buf[i]);
+		cont->stream[i] = NULL;
+		cont->buf[i] = NULL;
+		if (cont->target[i]) cont->target[i]->ptr = NULL;
+	}
+	if (cont->fd >= 0 && close(cont->fd))
+	{
+		bgc_printf(BV_ERROR, "Error closing the output container of site %d: %s\n",
+			cont->site, strerror(errno));
+		ok=0;
+	}
+	cont->fd = -1;
+
+	return (!ok);
+}
+
+/* order of the index: site, stream, then position in the container */
+static int entry_compare(const void* a, const void* b)
+{
+	const output_index_entry_struct* ea = (const output_index_entry_struct*) a;
+	const output_index_entry_struct* eb = (const output_index_entry_struct*) b;
+
+	if (ea->site != eb->site) return ((ea->site < eb->site) ? -1 : 1);
+	if (ea->stream != eb->stream) return ((ea->stream < eb->stream) ? -1 : 1);
+	if (ea->offset != eb->offset) return ((ea->offset < eb->offset) ? -1 : 1);
+	return (0);
+}
+
+/* read the chunk headers of the container into the index */
+static int container_scan(const char* name, output_index_struct* index, long long size)
+{
+	int ok=1;
+	int nalloc = 0;
+	long long offset = 0;
+	output_chunk_struct hdr;
+	output_index_entry_struct* entries;
+
+	while (ok && offset < size)
+	{
+		if (fseeko(index->fp, (off_t) offset, SEEK_SET) ||
+			fread(&hdr, sizeof(output_chunk_struct), 1, index->fp) != 1 ||
+			hdr.magic != CONT_MAGIC || hdr.length < 0 ||
+			hdr.stream < 0 || hdr.stream >= NCONT || hdr.site < 0)
+		{
+			bgc_printf(BV_ERROR, "Error: bad chunk at byte %lld of output container %s\n",offset,name);
+			ok=0;
+		}
+		else if (offset + (long long) sizeof(output_chunk_struct) + hdr.length > size)
+		{
+			bgc_printf(BV_WARN, "Warning: output container %s ends in a partial chunk at byte %lld\n",
+				name,offset);
+			break;
+		}
+		if (ok && index->nentries == nalloc)
+		{
+			nalloc = nalloc ? 2 * nalloc : 1024;
+			if (!(entries = (output_index_entry_struct*) realloc(index->entries,
+				nalloc * sizeof(output_index_entry_struct))))
+			{
+				bgc_printf(BV_ERROR, "Error allocating the index of output container %s\n",name);
+				ok=0;
+			}
+			else index->entries = entries;
+		}
+		if (ok)
+		{
+			entries = &index->entries[index->nentries++];
+			entries->site = hdr.site;
+			entries->stream = hdr.stream;
+			entries->year = hdr.year;
+			entries->flags = hdr.flags;
+			entries->offset = offset + (long long) sizeof(output_chunk_struct);
+			entries->length = hdr.length;
+			offset = entries->offset + hdr.length;
+		}
+	}
+	if (ok && index->nentries)
+	{
+		qsort(index->entries, index->nentries, sizeof(output_index_entry_struct), entry_compare);
+	}
+
+	return (!ok);
+}
+
+/* read the index file of the container, if it is there and the
+container has not grown since it was written */
+static int index_read(const char* idxname, output_index_struct* index, long long size)
+{
+	int ok=0;
+	FILE* fp;
+	output_index_header_struct hdr;
+
+	if (!(fp = fopen(idxname, "rb"))) return (1);
+	if (fread(&hdr, sizeof(output_index_header_struct), 1, fp) == 1 &&
+		hdr.magic == CONT_INDEX_MAGIC && hdr.size == size && hdr.nentries >= 0 &&
+		(index->entries = (output_index_entry_struct*) malloc((hdr.nentries ? hdr.nentries : 1) *
+		sizeof(output_index_entry_struct))) &&
+		fread(index->entries, sizeof(output_index_entry_struct), hdr.nentries, fp) == (size_t) hdr.nentries)
+	{
+		index->nentries = hdr.nentries;
+		ok=1;
+	}
+	fclose(fp);
+	if (!ok)
+	{
+		free(index->entries);
+		index->entries = NULL;
+	}
+
+	return (!ok);
+}
+
+/* the ini file name of each site id, from the site records */
+static int container_sites(const char* name, output_index_struct* index)
+{
+	int ok=1;
+	int i;
+	output_index_entry_struct* e;
+
+	for (i=0 ; i<index->nentries ; i++)
+	{
+		if (index->entries[i].site >= index->nsites) index->nsites = index->entries[i].site + 1;
+	}
+	if (index->nsites && !(index->sites = (char**) calloc(index->nsites, sizeof(char*))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating the sites of output container %s\n",name);
+		ok=0;
+	}
+	for (i=0 ; ok && i<index->nentries ; i++)
+	{
+		e = &index->entries[i];
+		if (e->stream != CONT_SITE) continue;
+		free(index->sites[e->site]);
+		if (!(index->sites[e->site] = (char*) malloc((size_t) e->length + 1)) ||
+			fseeko(index->fp, (off_t) e->offset, SEEK_SET) ||
+			fread(index->sites[e->site], 1, (size_t) e->length, index->fp) != (size_t) e->length)
+		{
+			bgc_printf(BV_ERROR, "Error reading site %d of output container %s\n",e->site,name);
+			ok=0;
+		}
+		else index->sites[e->site][e->length] = '\0';
+	}
+
+	return (!ok);
+}
+
+/* open the container name for reading, with its index. The chunks are
+scanned when there is no up to date index file, or when rescan is set. */
+static int container_read(const char* name, output_index_struct* index,
+int rescan, long long* size)
+{
+	int ok=1;
+	char* idxname = NULL;
+
+	memset(index, 0, sizeof(output_index_struct));
+	if (!(index->fp = fopen(name, "rb")) || fseeko(index->fp, 0, SEEK_END) ||
+		(*size = (long long) ftello(index->fp)) < 0)
+	{
+		bgc_printf(BV_ERROR, "Error opening output container %s: %s\n",name,strerror(errno));
+		ok=0;
+	}
+	if (ok && !(idxname = (char*) malloc(strlen(name) + 5)))
+	{
+		bgc_printf(BV_ERROR, "Error allocating the index name of output container %s\n",name);
+		ok=0;
+	}
+	if (ok)
+	{
+		sprintf(idxname, "%s.idx", name);
+		if ((rescan || index_read(idxname, index, *size)) && container_scan(name, index, *size))
+		{
+			ok=0;
+		}
+	}
+	if (ok && container_sites(name, index))
+	{
+		ok=0;
+	}
+	free(idxname);
+	if (!ok) output_container_free(index);
+
+	return (!ok);
+}
+
+/* open the container name for reading, with its index */
+int output_container_load(const char* name, output_index_struct* index)
+{
+	long long size;
+
+	return (container_read(name, index, 0, &size));
+}
+
+/* write the index file of the container name, once all the sites that
+write to it are done */
+int output_container_index(const char* name)
+{
+	int ok=1;
+	long long size = 0;
+	char* idxname = NULL;
+	FILE* fp = NULL;
+	output_index_struct index;
+	output_index_header_struct hdr;
+
+	if (container_read(name, &index, 1, &size))
+	{
+		bgc_printf(BV_ERROR, "Error reading output container %s: output_container_index()\n",name);
+		return (1);
+	}
+	if (!(idxname = (char*) malloc(strlen(name) + 5)))
+	{
+		bgc_printf(BV_ERROR, "Error allocating the index name of output container %s\n",name);
+		ok=0;
+	}
+	else sprintf(idxname, "%s.idx", name);
+	memset(&hdr, 0, sizeof(output_index_header_struct));
+	hdr.magic = CONT_INDEX_MAGIC;
+	hdr.nentries = index.nentries;
+	hdr.size = size;
+	if (ok && (!(fp = fopen(idxname, "wb")) ||
+		fwrite(&hdr, sizeof(output_index_header_struct), 1, fp) != 1 ||
+		fwrite(index.entries, sizeof(output_index_entry_struct), index.nentries, fp) != (size_t) index.nentries))
+	{
+		bgc_printf(BV_ERROR, "Error writing output container index %s\n",idxname);
+		ok=0;
+	}
+	if (fp && fclose(fp))
+	{
+		bgc_printf(BV_ERROR, "Error closing output container index %s\n",idxname);
+		ok=0;
+	}
+	free(idxname);
+	output_container_free(&index);
+
+	return (!ok);
+}
+
+/* site id of sitename, either the id itself or the ini file of the
+site, or -1 */
+int output_container_site(const output_index_struct* index, const char* sitename)
+{
+	int i;
+	char* end;
+	long id;
+
+	for (i=0 ; i<index->nsites ; i++)
+	{
+		if (index->sites[i] && !strcmp(index->sites[i], sitename)) return (i);
+	}
+	id = strtol(sitename, &end, 10);
+	if (*sitename && !*end && id >= 0 && id < index->nsites && index->sites[id]) return ((int) id);
+
+	return (-1);
+}
+
+/* copy one stream of a site to out, as the output file of the site,
+limited to the chunks of years first to last */
+int output_container_extract(const output_index_struct* index, int site,
+int stream, int first, int last, FILE* out)
+{
+	int ok=1;
+	int lo = 0, hi = index->nentries, mid, start, end, i;
+	long long left;
+	size_t n;
+	char buf[65536];
+	const output_index_entry_struct* e;
+
+	/* the chunks of the stream, from the last one that starts it over */
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		e = &index->entries[mid];
+		if (e->site < site || (e->site == site && e->stream < stream)) lo = mid + 1;
+		else hi = mid;
+	}
+	for (start=lo, end=lo ; end<index->nentries && index->entries[end].site == site &&
+		index->entries[end].stream == stream ; end++)
+	{
+		if (index->entries[end].flags & CONT_TRUNC) start = end;
+	}
+	if (lo == end)
+	{
+		bgc_printf(BV_ERROR, "Error: no %s stream for site %d in the output container\n",
+			output_container_stream_name(stream),site);
+		return (1);
+	}
+
+	for (i=start ; ok && i<end ; i++)
+	{
+		e = &index->entries[i];
+		if (e->year < first || e->year > last) continue;
+		if (fseeko(index->fp, (off_t) e->offset, SEEK_SET))
+		{
+			bgc_printf(BV_ERROR, "Error seeking in the output container: %s\n",strerror(errno));
+			ok=0;
+		}
+		for (left=e->length ; ok && left>0 ; left-=(long long) n)
+		{
+			n = (left < (long long) sizeof(buf)) ? (size_t) left : sizeof(buf);
+			if (fread(buf, 1, n, index->fp) != n || fwrite(buf, 1, n, out) != n)
+			{
+				bgc_printf(BV_ERROR, "Error copying the %s stream of site %d\n",
+					output_container_stream_name(stream),site);
+				ok=0;
+			}
+		}
+	}
+
+	return (!ok);
+}
+
+/* close a container opened by output_container_load() */
+void output_container_free(output_index_struct* index)
+{
+	int i;
+
+	if (index->fp) fclose(index->fp);
+	for (i=0 ; index->sites && i<index->nsites ; i++)
+	{
+		free(index->sites[i]);
+	}
+	free(index->sites);
+	free(index->entries);
+	memset(index, 0, sizeof(output_index_struct));
+}
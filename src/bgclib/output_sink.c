@@ -0,0 +1,253 @@
+/*
+output_sink.c
+output sinks: the simulation hands each daily output record, monthly
+average and year of annual outputs to a chain of sinks, instead of
+writing its files itself
+
+The file sink writes the output files of a bgcout structure, in the
+formats of the .dayout, .monavgout, .annavgout and .annout binary files,
+their .ascii copies and the simple annual text file, and appends each
+year to the output container when the files are written to one. It is
+the sink of every simulation whose bgcout has no sink of its own. The
+memory sink fills arrays provided by the caller, for hosts that use the
+outputs of a run directly (calibration loops, the shared library)
+rather than reading them back from files.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#include "bgc.h"
+
+/* file sink: daily outputs */
+static int file_write_day(output_sink_struct* sink, int year, int yday,
+const float* values)
+{
+	bgcout_struct* bgcout = (bgcout_struct*) sink->data;
+	int n = sink->meta.ndayout;
+
+	if (fwrite(values, sizeof(float), n, bgcout->dayout.ptr) != (size_t)n)
+	{
+		bgc_printf(BV_ERROR, "Error writing to %s: year = %d, yday = %d\n",
+			bgcout->dayout.name,year,yday);
+		return (1);
+	}
+	if (bgcout->bgc_ascii)
+	{
+		output_ascii((float*) values,n,bgcout->dayoutascii.ptr);
+	}
+
+	return (0);
+}
+
+/* file sink: monthly averages of the daily outputs */
+static int file_write_month(output_sink_struct* sink, int year, int month,
+const float* values)
+{
+	bgcout_struct* bgcout = (bgcout_struct*) sink->data;
+	int n = sink->meta.ndayout;
+
+	if (fwrite(values, sizeof(float), n, bgcout->monavgout.ptr) != (size_t)n)
+	{
+		bgc_printf(BV_ERROR, "Error writing to %s: year = %d, month = %d\n",
+			bgcout->monavgout.name,year,month);
+		return (1);
+	}
+	if (bgcout->bgc_ascii)
+	{
+		output_ascii((float*) values,n,bgcout->monoutascii.ptr);
+	}
+
+	return (0);
+}
+
+/* file sink: annual averages, annual outputs and the simple annual text,
+and then the year is appended to the output container */
+static int file_write_year(output_sink_struct* sink, int year,
+const output_year_struct* rec)
+{
+	int ok=1;
+	bgcout_struct* bgcout = (bgcout_struct*) sink->data;
+	int n = sink->meta.ndayout;
+	int nann = sink->meta.nannout;
+
+	if (rec->annavg && fwrite(rec->annavg, sizeof(float), n, bgcout->annavgout.ptr) != (size_t)n)
+	{
+		bgc_printf(BV_ERROR, "Error writing to %s: year = %d\n",
+			bgcout->annavgout.name,year);
+		ok=0;
+	}
+	if (ok && rec->ann)
+	{
+		if (fwrite(rec->ann, sizeof(float), nann, bgcout->annout.ptr) != (size_t)nann)
+		{
+			bgc_printf(BV_ERROR, "Error writing to %s: year = %d\n",
+				bgcout->annout.name,year);
+			ok=0;
+		}
+		if (ok && bgcout->bgc_ascii)
+		{
+			output_ascii((float*) rec->ann,nann,bgcout->annoutascii.ptr);
+		}
+	}
+	if (ok && rec->text && bgcout->bgc_ascii)
+	{
+		fprintf(bgcout->anntext.ptr,"%6d%10.1f%10.1f%10.1f%10.1f%10.1f%10.1f%10.1f\n",
+			year,rec->prcp,rec->tavg,rec->maxlai,rec->et,rec->outflow,rec->npp,rec->nbp);
+	}
+
+	/* append the outputs of the year to the output container */
+	if (ok && output_container_year(bgcout->container, year))
+	{
+		bgc_printf(BV_ERROR, "Error in output_container_year() from file_write_year()\n");
+		ok=0;
+	}
+
+	return (!ok);
+}
+
+/* a sink writing the output files of bgcout, which the caller opens
+and closes */
+int output_file_sink_init(output_sink_struct* sink, bgcout_struct* bgcout)
+{
+	memset(sink, 0, sizeof(output_sink_struct));
+	sink->write_day = file_write_day;
+	sink->write_month = file_write_month;
+	sink->write_year = file_write_year;
+	sink->data = bgcout;
+
+	return (0);
+}
+
+/* memory sink: one record into the next row of an array */
+static int memory_store(float* arr, int* count, int max, const float* values,
+int n, const char* kind, int year)
+{
+	if (!arr) return (0);
+	if (*count >= max)
+	{
+		bgc_printf(BV_ERROR, "Error: no room for the %s outputs of year %d in the memory sink (%d stored)\n",
+			kind,year,*count);
+		return (1);
+	}
+	memcpy(arr + (size_t)(*count) * n, values, n * sizeof(float));
+	(*count)++;
+
+	return (0);
+}
+
+static int memory_write_day(output_sink_struct* sink, int year, int yday,
+const float* values)
+{
+	output_memory_struct* mem = (output_memory_struct*) sink->data;
+
+	(void) yday;
+	return (memory_store(mem->day, &mem->ndays, mem->maxdays, values,
+		sink->meta.ndayout, "daily", year));
+}
+
+static int memory_write_month(output_sink_struct* sink, int year, int month,
+const float* values)
+{
+	output_memory_struct* mem = (output_memory_struct*) sink->data;
+
+	(void) month;
+	return (memory_store(mem->month, &mem->nmonths, mem->maxmonths, values,
+		sink->meta.ndayout, "monthly", year));
+}
+
+static int memory_write_year(output_sink_struct* sink, int year,
+const output_year_struct* rec)
+{
+	output_memory_struct* mem = (output_memory_struct*) sink->data;
+
+	if (!mem->annavg && !mem->ann && !mem->years) return (0);
+	if (mem->nyears >= mem->maxyears)
+	{
+		bgc_printf(BV_ERROR, "Error: no room for the annual outputs of year %d in the memory sink (%d stored)\n",
+			year,mem->nyears);
+		return (1);
+	}
+	if (mem->annavg && rec->annavg)
+	{
+		memcpy(mem->annavg + (size_t)mem->nyears * sink->meta.ndayout, rec->annavg,
+			sink->meta.ndayout * sizeof(float));
+	}
+	if (mem->ann && rec->ann)
+	{
+		memcpy(mem->ann + (size_t)mem->nyears * sink->meta.nannout, rec->ann,
+			sink->meta.nannout * sizeof(float));
+	}
+	if (mem->years) mem->years[mem->nyears] = year;
+	mem->nyears++;
+
+	return (0);
+}
+
+/* a sink filling the arrays of mem */
+int output_memory_sink_init(output_sink_struct* sink, output_memory_struct* mem)
+{
+	memset(sink, 0, sizeof(output_sink_struct));
+	sink->write_day = memory_write_day;
+	sink->write_month = memory_write_month;
+	sink->write_year = memory_write_year;
+	sink->data = mem;
+
+	return (0);
+}
+
+/* the functions below pass an output on to every sink of a chain, and
+stop at the first error */
+int output_sink_open(output_sink_struct* sink, const output_meta_struct* meta)
+{
+	for ( ; sink ; sink=sink->next)
+	{
+		sink->meta = *meta;
+		if (sink->open && sink->open(sink)) return (1);
+	}
+	return (0);
+}
+
+int output_sink_day(output_sink_struct* sink, int year, int yday,
+const float* values)
+{
+	for ( ; sink ; sink=sink->next)
+	{
+		if (sink->write_day && sink->write_day(sink, year, yday, values)) return (1);
+	}
+	return (0);
+}
+
+int output_sink_month(output_sink_struct* sink, int year, int month,
+const float* values)
+{
+	for ( ; sink ; sink=sink->next)
+	{
+		if (sink->write_month && sink->write_month(sink, year, month, values)) return (1);
+	}
+	return (0);
+}
+
+int output_sink_year(output_sink_struct* sink, int year,
+const output_year_struct* rec)
+{
+	for ( ; sink ; sink=sink->next)
+	{
+		if (sink->write_year && sink->write_year(sink, year, rec)) return (1);
+	}
+	return (0);
+}
+
+/* every sink of the chain is closed, even after an error */
+int output_sink_close(output_sink_struct* sink)
+{
+	int ok=1;
+
+	for ( ; sink ; sink=sink->next)
+	{
+		if (sink->close && sink->close(sink)) ok=0;
+	}
+	return (!ok);
+}
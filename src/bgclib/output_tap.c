@@ -0,0 +1,133 @@
+/*
+output_tap.c
+live output tap: a ring of daily and annual output records in a block
+of memory, normally a shared memory segment that other processes read
+while the simulation runs
+
+There is a single writer, the simulation, and it never waits. Each slot
+carries a sequence number that is odd while the slot is written and
+2n+2 once record n is complete in it. A reader copies the slot and
+checks the sequence number before and after the copy: a reader that
+falls more than nslots records behind finds its records overwritten and
+skips them, it does not hold up the simulation. The writer publishes
+nothing while no reader is attached.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#include "bgc.h"
+
+/* round a size up to a multiple of 8 bytes */
+#define TAP_ALIGN(n) (((n) + 7) & ~((size_t)7))
+
+static size_t tap_header_size(int ndayout, int nannout)
+{
+	return (TAP_ALIGN(sizeof(output_tap_struct) + (ndayout + nannout) * sizeof(int)));
+}
+
+static size_t tap_slot_size(int nvalues)
+{
+	return (TAP_ALIGN(sizeof(output_tap_slot_struct) + nvalues * sizeof(float)));
+}
+
+static output_tap_slot_struct* tap_slot(const output_tap_struct* tap, long long n)
+{
+	return ((output_tap_slot_struct*) ((char*) tap +
+		tap_header_size(tap->ndayout, tap->nannout) +
+		(size_t)(n % tap->nslots) * tap->slotsize));
+}
+
+/* bytes needed for a tap of nslots records of ndayout daily and nannout
+annual outputs */
+size_t output_tap_size(int ndayout, int nannout, int nslots)
+{
+	int nvalues = (ndayout > nannout) ? ndayout : nannout;
+
+	return (tap_header_size(ndayout, nannout) + (size_t)nslots * tap_slot_size(nvalues));
+}
+
+/* lay out an empty tap in a block of output_tap_size() bytes. This file
+prints nothing, so that the tap reader can link it alone. */
+int output_tap_init(output_tap_struct* tap, int ndayout, const int* daycodes,
+int nannout, const int* anncodes, int nslots)
+{
+	int i;
+	int* codes;
+
+	if (ndayout < 0 || nannout < 0 || nslots < 1) return (1);
+	memset(tap, 0, output_tap_size(ndayout, nannout, nslots));
+	tap->ndayout = ndayout;
+	tap->nannout = nannout;
+	tap->nvalues = (ndayout > nannout) ? ndayout : nannout;
+	tap->nslots = nslots;
+	tap->slotsize = (int) tap_slot_size(tap->nvalues);
+	codes = (int*) (tap + 1);
+	for (i=0 ; i<ndayout ; i++) codes[i] = daycodes[i];
+	for (i=0 ; i<nannout ; i++) codes[ndayout + i] = anncodes[i];
+
+	/* the magic number last, so that a reader sees a complete header */
+	__sync_synchronize();
+	tap->magic = TAP_MAGIC;
+
+	return (0);
+}
+
+/* output codes of the TAP_DAY or TAP_YEAR records */
+const int* output_tap_codes(const output_tap_struct* tap, int kind)
+{
+	const int* codes = (const int*) (tap + 1);
+
+	return (kind == TAP_DAY ? codes : codes + tap->ndayout);
+}
+
+/* publish one record of n output values as the next in the ring */
+void output_tap_publish(output_tap_struct* tap, int kind, int year, int yday,
+const float* values, int n)
+{
+	long long head = tap->head;
+	output_tap_slot_struct* slot = tap_slot(tap, head);
+
+	if (n > tap->nvalues) n = tap->nvalues;
+	slot->seq = 2 * head + 1;
+	__sync_synchronize();
+	slot->kind = kind;
+	slot->year = year;
+	slot->yday = yday;
+	slot->nvalues = n;
+	memcpy(slot + 1, values, n * sizeof(float));
+	__sync_synchronize();
+	slot->seq = 2 * head + 2;
+	__sync_synchronize();
+	tap->head = head + 1;
+}
+
+/* copy record n of the ring into rec and values, which has room for
+tap->nvalues floats. Returns TAP_READ_OK, TAP_READ_NONE if the record
+has not been published yet, or TAP_READ_LOST if it has been overwritten
+by a later one. */
+int output_tap_read(const output_tap_struct* tap, long long n,
+output_tap_slot_struct* rec, float* values)
+{
+	const output_tap_slot_struct* slot = tap_slot(tap, n);
+	long long seq, want = 2 * n + 2;
+
+	if (n >= tap->head) return (TAP_READ_NONE);
+	__sync_synchronize();
+	seq = slot->seq;
+	if (seq != want) return (seq < want ? TAP_READ_NONE : TAP_READ_LOST);
+	__sync_synchronize();
+	rec->kind = slot->kind;
+	rec->year = slot->year;
+	rec->yday = slot->yday;
+	rec->nvalues = slot->nvalues;
+	if (rec->nvalues < 0 || rec->nvalues > tap->nvalues) rec->nvalues = 0;
+	memcpy(values, slot + 1, rec->nvalues * sizeof(float));
+	__sync_synchronize();
+	if (slot->seq != want) return (TAP_READ_LOST);
+	rec->seq = want;
+
+	return (TAP_READ_OK);
+}
@@ -32,6 +32,10 @@ int total_photosynthesis(const metvar_struct* metv, const epconst_struct* epc,
 	for CO2 vs. water vapor */
 	psn_sun->g = epv->gl_t_wv_sun * 1e6/(1.6*R*(metv->tday+273.15));
 	psn_sun->dlmr = epv->dlmr_area_sun;
+	/* temperature-dependent kinetic constants, from the metcache */
+	psn_sun->Kc = metv->Kc;
+	psn_sun->Ko = metv->Ko;
+	psn_sun->act = metv->act;
 	if (ok && photosynthesis(psn_sun))
 	{
 		bgc_printf(BV_ERROR, "Error in photosynthesis() from bgc()\n");
@@ -61,6 +65,9 @@ int total_photosynthesis(const metvar_struct* metv, const epconst_struct* epc,
 	for CO2 vs. water vapor */
 	psn_shade->g = epv->gl_t_wv_shade * 1e6/(1.6*R*(metv->tday+273.15));
 	psn_shade->dlmr = epv->dlmr_area_shade;
+	psn_shade->Kc = metv->Kc;
+	psn_shade->Ko = metv->Ko;
+	psn_shade->act = metv->act;
 	if (ok && photosynthesis(psn_shade))
 	{
 		bgc_printf(BV_ERROR, "Error in photosynthesis() from bgc()\n");
@@ -95,14 +102,19 @@ int photosynthesis(psn_struct* psn)
 	ppfd       (umol photons/m2/s) PAR flux density, per unit projected LAI
 	g          (umol CO2/m2/s/Pa) leaf-scale conductance to CO2, proj area basis
 	dlmr       (umol CO2/m2/s) day leaf maint resp, on projected leaf area basis
+	Kc         (Pa) MM constant for carboxylation, at temperature t
+	Ko         (Pa) MM constant for oxygenation, at temperature t
+	act        (umol CO2/kgRubisco/s) Rubisco activity, at temperature t
+	
+	Kc, Ko, and act depend only on temperature, and are calculated by
+	psn_kinetics(). In bgc() they are taken from the forcing-derivative
+	cache (see metcache_init()).
 	
 	The following variables in psn struct are defined upon function return:
 	Ci         (Pa) intercellular [CO2]
 	Ca         (Pa) atmospheric [CO2]
 	O2         (Pa) atmospheric [O2]
 	gamma      (Pa) CO2 compensation point, in the absence of maint resp.
-	Kc         (Pa) MM constant for carboxylation
-	Ko         (Pa) MM constant for oxygenation
 	Vmax       (umol CO2/m2/s) max rate of carboxylation
 	Jmax       (umol electrons/m2/s) max rate electron transport
 	J          (umol RuBP/m2/s) rate of RuBP regeneration
@@ -118,31 +130,10 @@ int photosynthesis(psn_struct* psn)
 	Kuehn and McFadden, Biochemistry, 8:2403, 1969 */
 	static double fnr = 7.16;   /* kg Rub/kg NRub */
 	
-	/* the following enzyme kinetic constants are from: 
-	Woodrow, I.E., and J.A. Berry, 1980. Enzymatic regulation of photosynthetic
-	CO2 fixation in C3 plants. Ann. Rev. Plant Physiol. Plant Mol. Biol.,
-	39:533-594.
-	Note that these values are given in the units used in the paper, and that
-	they are converted to units appropriate to the rest of this function before
-	they are used. */
-	/* I've changed the values for Kc and Ko from the Woodrow and Berry
-	reference, and am now using the values from De Pury and Farquhar,
-	1997. Simple scaling of photosynthesis from leaves to canopies
-	without the errors of big-leaf models. Plant, Cell and Env. 20: 537-557. 
-	All other parameters, including the q10's for Kc and Ko are the same
-	as in Woodrow and Berry. */
-	static double Kc25 = 404.0;   /* (ubar) MM const carboxylase, 25 deg C */ 
-	static double q10Kc = 2.1;    /* (DIM) Q_10 for Kc */
-	static double Ko25 = 248.0;   /* (mbar) MM const oxygenase, 25 deg C */
-	static double q10Ko = 1.2;    /* (DIM) Q_10 for Ko */
-	static double act25 = 3.6;    /* (umol/mgRubisco/min) Rubisco activity */
-	static double q10act = 2.4;   /* (DIM) Q_10 for Rubisco activity */
 	static double pabs = 0.85;    /* (DIM) fPAR effectively absorbed by PSII */
 	
 	/* local variables */
 	int ok=1;	
-	double t;      /* (deg C) temperature */
-	double tk;     /* (K) absolute temperature */
 	double Kc;     /* (Pa) MM constant for carboxylase reaction */
 	double Ko;     /* (Pa) MM constant for oxygenase reaction */
 	double act;    /* (umol CO2/kgRubisco/s) Rubisco activity */
@@ -155,9 +146,10 @@ int photosynthesis(psn_struct* psn)
 	
 	/* begin by assigning local variables */
 	g = psn->g;
-	t = psn->t;
-	tk = t + 273.15;
 	Rd = psn->dlmr;
+	Kc = psn->Kc;
+	Ko = psn->Ko;
+	act = psn->act;
 	
 	/* convert atmospheric CO2 from ppm --> Pa */
 	Ca = psn->co2 * psn->pa / 1e6;
@@ -177,22 +169,6 @@ int photosynthesis(psn_struct* psn)
 	/* calculate atmospheric O2 in Pa, assumes 21% O2 by volume */
 	psn->O2 = O2 = 0.21 * psn->pa;
 	
-	/* correct kinetic constants for temperature, and do unit conversions */
-	Ko = Ko25 * pow(q10Ko, (t-25.0)/10.0);
-	psn->Ko = Ko = Ko * 100.0;   /* mbar --> Pa */
-	if (t > 15.0)
-	{
-		Kc = Kc25 * pow(q10Kc, (t-25.0)/10.0);
-		act = act25 * pow(q10act, (t-25.0)/10.0);
-	}
-	else
-	{
-		Kc = Kc25 * pow(1.8*q10Kc, (t-15.0)/10.0) / q10Kc;
-		act = act25 * pow(1.8*q10act, (t-15.0)/10.0) / q10act;
-	}
-	psn->Kc = Kc = Kc * 0.10;   /* ubar --> Pa */
-	act = act * 1e6 / 60.0;     /* umol/mg/min --> umol/kg/s */
-	
 	/* calculate gamma (Pa), assumes Vomax/Vcmax = 0.21 */
 	psn->gamma = gamma = 0.5 * 0.21 * Kc * psn->O2 / Ko;
 	 
@@ -271,3 +247,57 @@ int photosynthesis(psn_struct* psn)
 	return (!ok);
 }	
 
+
+int psn_kinetics(double t, double* Kc_out, double* Ko_out, double* act_out)
+{
+	/*
+	Temperature dependence of the enzyme kinetic constants used in
+	photosynthesis().
+	t          (deg C) air temperature
+	
+	On return:
+	Kc_out     (Pa) MM constant for carboxylation
+	Ko_out     (Pa) MM constant for oxygenation
+	act_out    (umol CO2/kgRubisco/s) Rubisco activity
+	*/
+	
+	/* the following enzyme kinetic constants are from: 
+	Woodrow, I.E., and J.A. Berry, 1980. Enzymatic regulation of photosynthetic
+	CO2 fixation in C3 plants. Ann. Rev. Plant Physiol. Plant Mol. Biol.,
+	39:533-594.
+	Note that these values are given in the units used in the paper, and that
+	they are converted to units appropriate to the rest of this function before
+	they are used. */
+	/* I've changed the values for Kc and Ko from the Woodrow and Berry
+	reference, and am now using the values from De Pury and Farquhar,
+	1997. Simple scaling of photosynthesis from leaves to canopies
+	without the errors of big-leaf models. Plant, Cell and Env. 20: 537-557. 
+	All other parameters, including the q10's for Kc and Ko are the same
+	as in Woodrow and Berry. */
+	static double Kc25 = 404.0;   /* (ubar) MM const carboxylase, 25 deg C */ 
+	static double q10Kc = 2.1;    /* (DIM) Q_10 for Kc */
+	static double Ko25 = 248.0;   /* (mbar) MM const oxygenase, 25 deg C */
+	static double q10Ko = 1.2;    /* (DIM) Q_10 for Ko */
+	static double act25 = 3.6;    /* (umol/mgRubisco/min) Rubisco activity */
+	static double q10act = 2.4;   /* (DIM) Q_10 for Rubisco activity */
+	int ok=1;
+	double Kc, Ko, act;
+	
+	/* correct kinetic constants for temperature, and do unit conversions */
+	Ko = Ko25 * pow(q10Ko, (t-25.0)/10.0);
+	*Ko_out = Ko * 100.0;   /* mbar --> Pa */
+	if (t > 15.0)
+	{
+		Kc = Kc25 * pow(q10Kc, (t-25.0)/10.0);
+		act = act25 * pow(q10act, (t-25.0)/10.0);
+	}
+	else
+	{
+		Kc = Kc25 * pow(1.8*q10Kc, (t-15.0)/10.0) / q10Kc;
+		act = act25 * pow(1.8*q10act, (t-15.0)/10.0) / q10act;
+	}
+	*Kc_out = Kc * 0.10;   /* ubar --> Pa */
+	*act_out = act * 1e6 / 60.0;     /* umol/mg/min --> umol/kg/s */
+	
+	return (!ok);
+}
@@ -1,7 +1,8 @@
 /* 
 precision_control.c
 Detects very low values in state variable structures, and forces them to
-0.0, in order to avoid rounding and overflow errors.
+0.0, in order to avoid rounding and overflow errors. Nonzero values that
+are forced to 0.0 are counted per pool in stats.
 
 *-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
 Biome-BGC version 4.2 (final release)
@@ -11,7 +12,8 @@ See copyright.txt for Copyright information
 
 #include "bgc.h"
 
-int precision_control(wstate_struct* ws, cstate_struct* cs, nstate_struct* ns)
+int precision_control(wstate_struct* ws, cstate_struct* cs, nstate_struct* ns,
+	bgcstats_struct* stats)
 {
 	int ok = 1;
 	
@@ -23,6 +25,7 @@ int precision_control(wstate_struct* ws, cstate_struct* cs, nstate_struct* ns)
 	in radtrans, and so can cause rounding error at larger values. */
 	if (cs->leafc < 1e-7)
 	{
+		if (cs->leafc != 0.0) stats->prec_trunc[PREC_LEAFC]++;
 		cs->litr1c += cs->leafc;
 		ns->litr1n += ns->leafn;
 		cs->leafc = 0.0;
@@ -36,6 +39,7 @@ int precision_control(wstate_struct* ws, cstate_struct* cs, nstate_struct* ns)
 	/* tests for other plant pools. Excess goes to litter 1 */
 	if (cs->livestemc < CRIT_PREC)
 	{
+		if (cs->livestemc != 0.0) stats->prec_trunc[PREC_LIVESTEMC]++;
 		cs->litr1c += cs->livestemc;
 		ns->litr1n += ns->livestemn;
 		cs->livestemc = 0.0;
@@ -43,6 +47,7 @@ int precision_control(wstate_struct* ws, cstate_struct* cs, nstate_struct* ns)
 	}
 	if (cs->deadstemc < CRIT_PREC)
 	{
+		if (cs->deadstemc != 0.0) stats->prec_trunc[PREC_DEADSTEMC]++;
 		cs->litr1c += cs->deadstemc;
 		ns->litr1n += ns->deadstemn;
 		cs->deadstemc = 0.0;
@@ -50,6 +55,7 @@ int precision_control(wstate_struct* ws, cstate_struct* cs, nstate_struct* ns)
 	}
 	if (cs->livecrootc < CRIT_PREC)
 	{
+		if (cs->livecrootc != 0.0) stats->prec_trunc[PREC_LIVECROOTC]++;
 		cs->litr1c += cs->livecrootc;
 		ns->litr1n += ns->livecrootn;
 		cs->livecrootc = 0.0;
@@ -57,6 +63,7 @@ int precision_control(wstate_struct* ws, cstate_struct* cs, nstate_struct* ns)
 	}
 	if (cs->deadcrootc < CRIT_PREC)
 	{
+		if (cs->deadcrootc != 0.0) stats->prec_trunc[PREC_DEADCROOTC]++;
 		cs->litr1c += cs->deadcrootc;
 		ns->litr1n += ns->deadcrootn;
 		cs->deadcrootc = 0.0;
@@ -64,6 +71,7 @@ int precision_control(wstate_struct* ws, cstate_struct* cs, nstate_struct* ns)
 	}
 	if (cs->cwdc < CRIT_PREC)
 	{
+		if (cs->cwdc != 0.0) stats->prec_trunc[PREC_CWDC]++;
 		cs->litr1c += cs->cwdc;
 		ns->litr1n += ns->cwdn;
 		cs->cwdc = 0.0;
@@ -74,6 +82,7 @@ int precision_control(wstate_struct* ws, cstate_struct* cs, nstate_struct* ns)
 	or volatilized sink (N) */
 	if (cs->litr1c < CRIT_PREC)
 	{
+		if (cs->litr1c != 0.0) stats->prec_trunc[PREC_LITR1C]++;
 		cs->litr1_hr_snk += cs->litr1c;
 		ns->nvol_snk += ns->litr1n;
 		cs->litr1c = 0.0;
@@ -81,6 +90,7 @@ int precision_control(wstate_struct* ws, cstate_struct* cs, nstate_struct* ns)
 	}
 	if (cs->litr2c < CRIT_PREC)
 	{
+		if (cs->litr2c != 0.0) stats->prec_trunc[PREC_LITR2C]++;
 		cs->litr2_hr_snk += cs->litr2c;
 		ns->nvol_snk += ns->litr2n;
 		cs->litr2c = 0.0;
@@ -88,6 +98,7 @@ int precision_control(wstate_struct* ws, cstate_struct* cs, nstate_struct* ns)
 	}
 	if (cs->litr3c < CRIT_PREC)
 	{
+		if (cs->litr3c != 0.0) stats->prec_trunc[PREC_LITR3C]++;
 		cs->litr4_hr_snk += cs->litr3c; /* NO LITR3C HR SINK */
 		ns->nvol_snk += ns->litr3n;
 		cs->litr3c = 0.0;
@@ -95,6 +106,7 @@ int precision_control(wstate_struct* ws, cstate_struct* cs, nstate_struct* ns)
 	}
 	if (cs->litr4c < CRIT_PREC)
 	{
+		if (cs->litr4c != 0.0) stats->prec_trunc[PREC_LITR4C]++;
 		cs->litr4_hr_snk += cs->litr4c;
 		ns->nvol_snk += ns->litr4n;
 		cs->litr4c = 0.0;
@@ -102,6 +114,7 @@ int precision_control(wstate_struct* ws, cstate_struct* cs, nstate_struct* ns)
 	}
 	if (cs->soil1c < CRIT_PREC)
 	{
+		if (cs->soil1c != 0.0) stats->prec_trunc[PREC_SOIL1C]++;
 		cs->soil1_hr_snk += cs->soil1c;
 		ns->nvol_snk += ns->soil1n;
 		cs->soil1c = 0.0;
@@ -109,6 +122,7 @@ int precision_control(wstate_struct* ws, cstate_struct* cs, nstate_struct* ns)
 	}
 	if (cs->soil2c < CRIT_PREC)
 	{
+		if (cs->soil2c != 0.0) stats->prec_trunc[PREC_SOIL2C]++;
 		cs->soil2_hr_snk += cs->soil2c;
 		ns->nvol_snk += ns->soil2n;
 		cs->soil2c = 0.0;
@@ -116,6 +130,7 @@ int precision_control(wstate_struct* ws, cstate_struct* cs, nstate_struct* ns)
 	}
 	if (cs->soil3c < CRIT_PREC)
 	{
+		if (cs->soil3c != 0.0) stats->prec_trunc[PREC_SOIL3C]++;
 		cs->soil3_hr_snk += cs->soil3c;
 		ns->nvol_snk += ns->soil3n;
 		cs->soil3c = 0.0;
@@ -123,6 +138,7 @@ int precision_control(wstate_struct* ws, cstate_struct* cs, nstate_struct* ns)
 	}
 	if (cs->soil4c < CRIT_PREC)
 	{
+		if (cs->soil4c != 0.0) stats->prec_trunc[PREC_SOIL4C]++;
 		cs->soil4_hr_snk += cs->soil4c;
 		ns->nvol_snk += ns->soil4n;
 		cs->soil4c = 0.0;
@@ -132,11 +148,13 @@ int precision_control(wstate_struct* ws, cstate_struct* cs, nstate_struct* ns)
 	/* additional tests for soil mineral N and retranslocated N */
 	if (ns->sminn < CRIT_PREC)
 	{
+		if (ns->sminn != 0.0) stats->prec_trunc[PREC_SMINN]++;
 		ns->nvol_snk += ns->sminn;
 		ns->sminn = 0.0;
 	}
 	if (ns->retransn < CRIT_PREC)
 	{
+		if (ns->retransn != 0.0) stats->prec_trunc[PREC_RETRANSN]++;
 		ns->litr1n += ns->retransn;
 		ns->retransn = 0.0;
 	}
@@ -144,16 +162,19 @@ int precision_control(wstate_struct* ws, cstate_struct* cs, nstate_struct* ns)
 	/* WATER STATE VARIABLES */
 	if (ws->soilw < CRIT_PREC)
 	{
+		if (ws->soilw != 0.0) stats->prec_trunc[PREC_SOILW]++;
 		ws->soilevap_snk += ws->soilw;
 		ws->soilw = 0.0;
 	}
 	if (ws->snoww < CRIT_PREC)
 	{
+		if (ws->snoww != 0.0) stats->prec_trunc[PREC_SNOWW]++;
 		ws->snowsubl_snk += ws->snoww;
 		ws->snoww = 0.0;
 	}
 	if (ws->canopyw < CRIT_PREC)
 	{
+		if (ws->canopyw != 0.0) stats->prec_trunc[PREC_CANOPYW]++;
 		ws->canopyevap_snk += ws->canopyw;
 		ws->canopyw = 0.0;
 	}
@@ -12,7 +12,7 @@ See copyright.txt for Copyright information
 
 int prephenology(const control_struct* ctrl, const epconst_struct* epc, 
 const siteconst_struct* sitec, const metarr_struct* metarr,
-phenarray_struct* phen)
+phenarray_struct* phen, arena_struct* arena)
 {
 	int ok=1;
 	int model,woody,evergreen,south;
@@ -62,37 +62,37 @@ phenarray_struct* phen)
 	/* allocate space for phenology arrays */
 	nyears = ctrl->metyears;
 	ndays = 365 * nyears;
-	if (ok && !(phen->remdays_curgrowth = (int*) malloc(ndays*sizeof(int))))
+	if (ok && !(phen->remdays_curgrowth = (int*) arena_alloc(arena, ndays*sizeof(int))))
 	{
 		bgc_printf(BV_ERROR, "Error allocating for phen->curgrowth, prephenology()\n");
 		ok=0;
 	}
-	if (ok && !(phen->remdays_transfer = (int*) malloc(ndays*sizeof(int))))
+	if (ok && !(phen->remdays_transfer = (int*) arena_alloc(arena, ndays*sizeof(int))))
 	{
 		bgc_printf(BV_ERROR, "Error allocating for phen->remdays_transfer, prephenology()\n");
 		ok=0;
 	}
-	if (ok && !(phen->remdays_litfall = (int*) malloc(ndays*sizeof(int))))
+	if (ok && !(phen->remdays_litfall = (int*) arena_alloc(arena, ndays*sizeof(int))))
 	{
 		bgc_printf(BV_ERROR, "Error allocating for phen->remdays_litfall, prephenology()\n");
 		ok=0;
 	}
-	if (ok && !(phen->predays_transfer = (int*) malloc(ndays*sizeof(int))))
+	if (ok && !(phen->predays_transfer = (int*) arena_alloc(arena, ndays*sizeof(int))))
 	{
 		bgc_printf(BV_ERROR, "Error allocating for phen->predays_transfer, prephenology()\n");
 		ok=0;
 	}
-	if (ok && !(phen->predays_litfall = (int*) malloc(ndays*sizeof(int))))
+	if (ok && !(phen->predays_litfall = (int*) arena_alloc(arena, ndays*sizeof(int))))
 	{
 		bgc_printf(BV_ERROR, "Error allocating for phen->predays_litfall, prephenology()\n");
 		ok=0;
 	}
-	if (ok && !(onday_arr = (int*) malloc((nyears+1) * sizeof(int))))
+	if (ok && !(onday_arr = (int*) arena_alloc(arena, (nyears+1) * sizeof(int))))
 	{
 		bgc_printf(BV_ERROR, "Error allocating for onday_arr, prephenology()\n");
 		ok=0;
 	}
-	if (ok && !(offday_arr = (int*) malloc((nyears+1) * sizeof(int))))
+	if (ok && !(offday_arr = (int*) arena_alloc(arena, (nyears+1) * sizeof(int))))
 	{
 		bgc_printf(BV_ERROR, "Error allocating for offday_arr, prephenology()\n");
 		ok=0;
@@ -867,8 +867,8 @@ phenarray_struct* phen)
 	} /* end else phenology model block */
 				
 	/* free the local array memory */
-	free(onday_arr);
-	free(offday_arr);
+	arena_free(arena, onday_arr);
+	arena_free(arena, offday_arr);
 	
 	return (!ok);
 }
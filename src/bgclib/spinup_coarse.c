@@ -0,0 +1,389 @@
+/*
+spinup_coarse.c
+coarse spinup steps for the litter, CWD and soil pools
+
+Late in a spinup the vegetation is close to steady state, and most of
+the years are spent waiting for the slow soil pools (the humus pool
+turns over in thousands of years). In coarse mode a block of daily
+spinup years, a whole number of met cycles, records the totals of the
+decomposition, fragmentation and fire fluxes of each pool, and the
+pools are then advanced by whole years with the first-order rate
+constants, the transfer fractions and the external inputs of the block,
+as yearly means held fixed. Steps with the rates of single years were
+found to pull the pools away from the daily spinup.
+
+Each coarse year is an implicit (backward Euler) step of one year,
+taking the pools from upstream to downstream, so that the fast litter
+pools, which turn over many times in a year, go straight to their
+quasi-steady state instead of oscillating. The vegetation and the water
+state are not changed.
+
+The N of each pool keeps its C:N ratio, and the soil pools have fixed
+C:N ratios, so the soil can only gain C as fast as the ecosystem gains
+N. The mineral N pool is left as it is; instead the N of the pools may
+change in a coarse year no faster than it did in a mean recorded daily
+year, and when the pools would take up more than that (or take up N
+while they were losing it), the changes of all of the pools in that
+year are scaled down. The litter inputs are added to the photosynthesis
+source, and the N change of the pools to the deposition source (or a
+loss to the leaching sink), so that the mass balance checks carry on
+across the coarse years.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#include "bgc.h"
+
+/* pool indices */
+#define CO_CWD   0
+#define CO_LITR1 1
+#define CO_LITR2 2
+#define CO_LITR3 3
+#define CO_LITR4 4
+#define CO_SOIL1 5
+#define CO_SOIL2 6
+#define CO_SOIL3 7
+#define CO_SOIL4 8
+
+/* the pools, each one after all of the pools that feed it */
+static const int coarse_order[NCOARSE] = {CO_CWD, CO_LITR1, CO_LITR3,
+	CO_LITR2, CO_LITR4, CO_SOIL1, CO_SOIL2, CO_SOIL3, CO_SOIL4};
+
+static void coarse_get(const cstate_struct* cs, const nstate_struct* ns,
+double* c, double* n)
+{
+	c[CO_CWD] = cs->cwdc;
+	c[CO_LITR1] = cs->litr1c;
+	c[CO_LITR2] = cs->litr2c;
+	c[CO_LITR3] = cs->litr3c;
+	c[CO_LITR4] = cs->litr4c;
+	c[CO_SOIL1] = cs->soil1c;
+	c[CO_SOIL2] = cs->soil2c;
+	c[CO_SOIL3] = cs->soil3c;
+	c[CO_SOIL4] = cs->soil4c;
+
+	if (n)
+	{
+		n[CO_CWD] = ns->cwdn;
+		n[CO_LITR1] = ns->litr1n;
+		n[CO_LITR2] = ns->litr2n;
+		n[CO_LITR3] = ns->litr3n;
+		n[CO_LITR4] = ns->litr4n;
+		n[CO_SOIL1] = ns->soil1n;
+		n[CO_SOIL2] = ns->soil2n;
+		n[CO_SOIL3] = ns->soil3n;
+		n[CO_SOIL4] = ns->soil4n;
+	}
+}
+
+static void coarse_set(const double* c, const double* n, cstate_struct* cs,
+nstate_struct* ns)
+{
+	cs->cwdc = c[CO_CWD];
+	cs->litr1c = c[CO_LITR1];
+	cs->litr2c = c[CO_LITR2];
+	cs->litr3c = c[CO_LITR3];
+	cs->litr4c = c[CO_LITR4];
+	cs->soil1c = c[CO_SOIL1];
+	cs->soil2c = c[CO_SOIL2];
+	cs->soil3c = c[CO_SOIL3];
+	cs->soil4c = c[CO_SOIL4];
+
+	ns->cwdn = n[CO_CWD];
+	ns->litr1n = n[CO_LITR1];
+	ns->litr2n = n[CO_LITR2];
+	ns->litr3n = n[CO_LITR3];
+	ns->litr4n = n[CO_LITR4];
+	ns->soil1n = n[CO_SOIL1];
+	ns->soil2n = n[CO_SOIL2];
+	ns->soil3n = n[CO_SOIL3];
+	ns->soil4n = n[CO_SOIL4];
+}
+
+/* rate constant (1/yr) of each pool over the recorded days, and the
+fractions of its loss that are respired, burned and passed on to each
+downstream pool */
+static void coarse_rates(const coarse_struct* co, double* k, double* fhr,
+double* ffire, double fxfer[NCOARSE][NCOARSE])
+{
+	int i, j;
+	double loss, mean;
+
+	for (i=0 ; i<NCOARSE ; i++)
+	{
+		loss = co->hr[i] + co->fire[i];
+		for (j=0 ; j<NCOARSE ; j++) loss += co->xfer[i][j];
+		mean = co->csum[i] / (double)co->ndays;
+		k[i] = (mean > 0.0) ? loss * 365.0 / (double)co->ndays / mean : 0.0;
+		fhr[i] = (loss > 0.0) ? co->hr[i] / loss : 0.0;
+		ffire[i] = (loss > 0.0) ? co->fire[i] / loss : 0.0;
+		for (j=0 ; j<NCOARSE ; j++)
+		{
+			fxfer[i][j] = (loss > 0.0) ? co->xfer[i][j] / loss : 0.0;
+		}
+	}
+}
+
+/* start recording a daily year, from the pools at its start */
+int coarse_start(const cstate_struct* cs, const nstate_struct* ns,
+coarse_struct* co)
+{
+	int ok=1;
+
+	double n[NCOARSE];
+	int i;
+
+	memset(co, 0, sizeof(coarse_struct));
+	coarse_get(cs, ns, co->c0, n);
+	for (i=0 ; i<NCOARSE ; i++) co->n0 += n[i];
+
+	return (!ok);
+}
+
+/* add the fluxes of one day, after the daily state updates */
+int coarse_record(const cstate_struct* cs, const nstate_struct* ns,
+const cflux_struct* cf, coarse_struct* co)
+{
+	int ok=1;
+	int i;
+	double c[NCOARSE], n[NCOARSE];
+
+	coarse_get(cs, ns, c, n);
+	for (i=0 ; i<NCOARSE ; i++)
+	{
+		co->csum[i] += c[i];
+		co->nsum[i] += n[i];
+	}
+
+	/* fragmentation and decomposition transfers */
+	co->xfer[CO_CWD][CO_LITR2] += cf->cwdc_to_litr2c;
+	co->xfer[CO_CWD][CO_LITR3] += cf->cwdc_to_litr3c;
+	co->xfer[CO_CWD][CO_LITR4] += cf->cwdc_to_litr4c;
+	co->xfer[CO_LITR1][CO_SOIL1] += cf->litr1c_to_soil1c;
+	co->xfer[CO_LITR2][CO_SOIL2] += cf->litr2c_to_soil2c;
+	co->xfer[CO_LITR3][CO_LITR2] += cf->litr3c_to_litr2c;
+	co->xfer[CO_LITR4][CO_SOIL3] += cf->litr4c_to_soil3c;
+	co->xfer[CO_SOIL1][CO_SOIL2] += cf->soil1c_to_soil2c;
+	co->xfer[CO_SOIL2][CO_SOIL3] += cf->soil2c_to_soil3c;
+	co->xfer[CO_SOIL3][CO_SOIL4] += cf->soil3c_to_soil4c;
+
+	/* heterotrophic respiration */
+	co->hr[CO_LITR1] += cf->litr1_hr;
+	co->hr[CO_LITR2] += cf->litr2_hr;
+	co->hr[CO_LITR4] += cf->litr4_hr;
+	co->hr[CO_SOIL1] += cf->soil1_hr;
+	co->hr[CO_SOIL2] += cf->soil2_hr;
+	co->hr[CO_SOIL3] += cf->soil3_hr;
+	co->hr[CO_SOIL4] += cf->soil4_hr;
+
+	/* fire */
+	co->fire[CO_CWD] += cf->m_cwdc_to_fire;
+	co->fire[CO_LITR1] += cf->m_litr1c_to_fire;
+	co->fire[CO_LITR2] += cf->m_litr2c_to_fire;
+	co->fire[CO_LITR3] += cf->m_litr3c_to_fire;
+	co->fire[CO_LITR4] += cf->m_litr4c_to_fire;
+
+	co->ndays++;
+
+	return (!ok);
+}
+
+/* advance the litter, CWD and soil pools by nyears coarse years, with
+the mean yearly rates of the days recorded in co, which end at the
+current state */
+int coarse_advance(const coarse_struct* co, cstate_struct* cs,
+nstate_struct* ns, int nyears)
+{
+	int ok=1;
+	int i, j, o, y;
+	double c[NCOARSE], c0[NCOARSE], n[NCOARSE], cn[NCOARSE], cprev[NCOARSE];
+	double k[NCOARSE], input[NCOARSE], fhr[NCOARSE], ffire[NCOARSE];
+	double fxfer[NCOARSE][NCOARSE];
+	double hr[NCOARSE], hryr[NCOARSE];
+	double loss, upstream, scale;
+	double ntrend, nchange, f, fire, fireyr;
+
+	if (co->ndays <= 0)
+	{
+		bgc_printf(BV_ERROR, "Error: no daily fluxes recorded for the coarse spinup step: coarse_advance()\n");
+		ok=0;
+	}
+
+	if (ok)
+	{
+		coarse_get(cs, ns, c, n);
+		for (i=0 ; i<NCOARSE ; i++) c0[i] = c[i];
+		scale = 365.0 / (double)co->ndays;
+		ntrend = -co->n0;
+		fire = 0.0;
+		coarse_rates(co, k, fhr, ffire, fxfer);
+
+		for (i=0 ; i<NCOARSE ; i++)
+		{
+			ntrend += n[i];
+
+			/* N:C of each pool, from the recorded mean if it is empty now */
+			if (c[i] > 0.0) cn[i] = n[i] / c[i];
+			else if (co->csum[i] > 0.0) cn[i] = co->nsum[i] / co->csum[i];
+			else cn[i] = 0.0;
+
+			/* inputs from the vegetation: whatever the change of the
+			pool over the record does not owe to the recorded fluxes */
+			loss = co->hr[i] + co->fire[i];
+			upstream = 0.0;
+			for (j=0 ; j<NCOARSE ; j++)
+			{
+				loss += co->xfer[i][j];
+				upstream += co->xfer[j][i];
+			}
+			input[i] = (c[i] - co->c0[i] + loss - upstream) * scale;
+			if (input[i] < 0.0) input[i] = 0.0;
+
+			hr[i] = 0.0;
+		}
+		ntrend *= scale;
+
+		for (y=0 ; y<nyears ; y++)
+		{
+			fireyr = 0.0;
+			for (o=0 ; o<NCOARSE ; o++)
+			{
+				i = coarse_order[o];
+				cprev[i] = c[i];
+				/* transfers from the upstream pools, already at the end
+				of this year */
+				upstream = 0.0;
+				for (j=0 ; j<NCOARSE ; j++) upstream += fxfer[j][i] * k[j] * c[j];
+				c[i] = (c[i] + input[i] + upstream) / (1.0 + k[i]);
+				hryr[i] = fhr[i] * k[i] * c[i];
+				fireyr += ffire[i] * k[i] * c[i];
+			}
+
+			/* the N the pools would gain or lose, against the N trend
+			of the record */
+			nchange = 0.0;
+			for (i=0 ; i<NCOARSE ; i++) nchange += cn[i] * (c[i] - cprev[i]);
+			f = 1.0;
+			if (nchange != 0.0)
+			{
+				f = ntrend / nchange;
+				if (f < 0.0) f = 0.0;
+				if (f > 1.0) f = 1.0;
+			}
+			for (i=0 ; i<NCOARSE ; i++)
+			{
+				c[i] = cprev[i] + f * (c[i] - cprev[i]);
+				hr[i] += f * hryr[i];
+			}
+			fire += f * fireyr;
+		}
+
+		/* the N of each pool follows its C at a fixed C:N. Sinks and
+		sources for the mass balance: the litter inputs come from
+		photosynthesis, and the N gained by the pools from deposition,
+		or the N they lose goes to leaching. */
+		cs->fire_snk += fire;
+		cs->litr1_hr_snk += hr[CO_LITR1];
+		cs->litr2_hr_snk += hr[CO_LITR2];
+		cs->litr4_hr_snk += hr[CO_LITR4];
+		cs->soil1_hr_snk += hr[CO_SOIL1];
+		cs->soil2_hr_snk += hr[CO_SOIL2];
+		cs->soil3_hr_snk += hr[CO_SOIL3];
+		cs->soil4_hr_snk += hr[CO_SOIL4];
+		cs->psnsun_src += fire;
+		nchange = 0.0;
+		for (i=0 ; i<NCOARSE ; i++)
+		{
+			cs->psnsun_src += hr[i] + c[i] - c0[i];
+			nchange -= n[i];
+			n[i] = cn[i] * c[i];
+			nchange += n[i];
+		}
+		if (nchange > 0.0) ns->ndep_src += nchange;
+		else ns->nleached_snk -= nchange;
+		coarse_set(c, n, cs, ns);
+	}
+
+	return (!ok);
+}
+
+/* add to the litter, CWD and soil pools the difference between two
+states (cs_new, ns_new less cs_old, ns_old), carried over nyears years
+with the rates of the year recorded in co, or as it is if co is NULL.
+This is the correction of a parareal step, with the coarse steps
+linearized about the old state. The pools are kept from going negative,
+and the changes go to the photosynthesis and deposition sources (or the
+leaching sink), so that the mass balance checks carry on. */
+int coarse_correct(const coarse_struct* co, int nyears, cstate_struct* cs,
+nstate_struct* ns, const cstate_struct* cs_new, const nstate_struct* ns_new,
+const cstate_struct* cs_old, const nstate_struct* ns_old)
+{
+	int ok=1;
+	int i, j, o, y;
+	double c[NCOARSE], n[NCOARSE], cnew[NCOARSE], nnew[NCOARSE];
+	double cold[NCOARSE], nold[NCOARSE], dc[NCOARSE], dn[NCOARSE];
+	double k[NCOARSE], fhr[NCOARSE], ffire[NCOARSE];
+	double fxfer[NCOARSE][NCOARSE];
+	double upc, upn;
+
+	coarse_get(cs, ns, c, n);
+	coarse_get(cs_new, ns_new, cnew, nnew);
+	coarse_get(cs_old, ns_old, cold, nold);
+	for (i=0 ; i<NCOARSE ; i++)
+	{
+		dc[i] = cnew[i] - cold[i];
+		dn[i] = nnew[i] - nold[i];
+	}
+
+	/* the difference decays and moves downstream as the pools would,
+	with no inputs from the vegetation */
+	if (co && co->ndays > 0)
+	{
+		coarse_rates(co, k, fhr, ffire, fxfer);
+		for (y=0 ; y<nyears ; y++)
+		{
+			for (o=0 ; o<NCOARSE ; o++)
+			{
+				i = coarse_order[o];
+				upc = upn = 0.0;
+				for (j=0 ; j<NCOARSE ; j++)
+				{
+					upc += fxfer[j][i] * k[j] * dc[j];
+					upn += fxfer[j][i] * k[j] * dn[j];
+				}
+				dc[i] = (dc[i] + upc) / (1.0 + k[i]);
+				dn[i] = (dn[i] + upn) / (1.0 + k[i]);
+			}
+		}
+	}
+
+	for (i=0 ; i<NCOARSE ; i++)
+	{
+		if (c[i] + dc[i] < 0.0) dc[i] = -c[i];
+		if (n[i] + dn[i] < 0.0) dn[i] = -n[i];
+		c[i] += dc[i];
+		n[i] += dn[i];
+		cs->psnsun_src += dc[i];
+		if (dn[i] > 0.0) ns->ndep_src += dn[i];
+		else ns->nleached_snk -= dn[i];
+	}
+	coarse_set(c, n, cs, ns);
+
+	return (!ok);
+}
+
+/* total C of the litter, CWD and soil pools */
+double coarse_totalc(const cstate_struct* cs)
+{
+	double c[NCOARSE];
+	double sum = 0.0;
+	int i;
+
+	coarse_get(cs, NULL, c, NULL);
+	for (i=0 ; i<NCOARSE ; i++) sum += c[i];
+
+	return (sum);
+}
@@ -10,7 +10,79 @@ See copyright.txt for Copyright information
 
 #include "bgc.h"
 
-int csummary(cflux_struct* cf, cstate_struct* cs, summary_struct* summary)
+/* the summary terms that feed an output code, or 0 */
+static int summary_code(int code)
+{
+	switch (code)
+	{
+		case 620: return (SUM_NPP);
+		case 621: return (SUM_NEP);
+		case 622: return (SUM_NEE);
+		case 623: return (SUM_GPP);
+		case 624: return (SUM_MR);
+		case 625: return (SUM_GR);
+		case 626: return (SUM_HR);
+		case 627: return (SUM_FIRE);
+		case 628: return (SUM_NPP | SUM_CUM);
+		case 629: return (SUM_NEP | SUM_CUM);
+		case 630: return (SUM_NEE | SUM_CUM);
+		case 631: return (SUM_GPP | SUM_CUM);
+		case 632: return (SUM_MR | SUM_CUM);
+		case 633: return (SUM_GR | SUM_CUM);
+		case 634: return (SUM_HR | SUM_CUM);
+		case 635: return (SUM_FIRE | SUM_CUM);
+		case 636: case 637: case 638: case 639:
+			return (SUM_STOCK);
+		case 640: return (SUM_LITFALL);
+		case 641: case 642: case 643: case 644: case 645: case 646:
+			return (SUM_WATER);
+	}
+	return (0);
+}
+
+/* the summary terms a simulation reads: those of its daily and annual
+output codes, the stock totals for spinup control, and NPP and NEE for the annual text output of a model
+run. Terms that no one reads are not computed. */
+int summary_demand(const control_struct* ctrl, int mode)
+{
+	int outv;
+	int need = 0;
+
+	if (ctrl->dodaily || ctrl->domonavg || ctrl->doannavg)
+	{
+		for (outv=0 ; outv<ctrl->ndayout ; outv++)
+		{
+			need |= summary_code(ctrl->daycodes[outv]);
+		}
+	}
+	if (ctrl->doannual)
+	{
+		for (outv=0 ; outv<ctrl->nannout ; outv++)
+		{
+			need |= summary_code(ctrl->anncodes[outv]);
+		}
+	}
+	if (mode == MODE_SPINUP)
+	{
+		need |= SUM_STOCK;
+	}
+	if (mode == MODE_MODEL)
+	{
+		need |= SUM_NPP | SUM_NEE;
+	}
+
+	/* the terms each derived flux is built from */
+	if (need & SUM_NEE) need |= SUM_NEP | SUM_FIRE;
+	if (need & SUM_NEP) need |= SUM_NPP | SUM_HR;
+	if (need & SUM_NPP) need |= SUM_GPP | SUM_MR | SUM_GR;
+
+	return (need);
+}
+
+/* need is a mask of SUM_* terms, as from summary_demand(). The terms
+not in it keep their previous values. */
+int csummary(cflux_struct* cf, cstate_struct* cs, summary_struct* summary,
+int need)
 {
 	int ok=1;
 	double gpp,mr,gr,hr,fire;
@@ -18,84 +90,113 @@ int csummary(cflux_struct* cf, cstate_struct* cs, summary_struct* summary)
 	
 	/* calculate daily NPP, positive for net growth */
 	/* NPP = Gross PSN - Maintenance Resp - Growth Resp */
-	gpp = cf->psnsun_to_cpool + cf->psnshade_to_cpool;
-	mr = cf->leaf_day_mr + cf->leaf_night_mr + cf->froot_mr + 
-		cf->livestem_mr + cf->livecroot_mr;
-	gr = cf->cpool_leaf_gr + cf->cpool_leaf_storage_gr + cf->transfer_leaf_gr +
-		cf->cpool_froot_gr + cf->cpool_froot_storage_gr + cf->transfer_froot_gr + 
-		cf->cpool_livestem_gr + cf->cpool_livestem_storage_gr + cf->transfer_livestem_gr +
-		cf->cpool_deadstem_gr + cf->cpool_deadstem_storage_gr + cf->transfer_deadstem_gr + 
-		cf->cpool_livecroot_gr + cf->cpool_livecroot_storage_gr + cf->transfer_livecroot_gr + 
-		cf->cpool_deadcroot_gr + cf->cpool_deadcroot_storage_gr + cf->transfer_deadcroot_gr;
-	npp = gpp - mr - gr;
+	if (need & SUM_GPP)
+	{
+		gpp = cf->psnsun_to_cpool + cf->psnshade_to_cpool;
+		summary->daily_gpp = gpp;
+		if (need & SUM_CUM) summary->cum_gpp += gpp;
+	}
+	if (need & SUM_MR)
+	{
+		mr = cf->leaf_day_mr + cf->leaf_night_mr + cf->froot_mr + 
+			cf->livestem_mr + cf->livecroot_mr;
+		summary->daily_mr = mr;
+		if (need & SUM_CUM) summary->cum_mr += mr;
+	}
+	if (need & SUM_GR)
+	{
+		gr = cf->cpool_leaf_gr + cf->cpool_leaf_storage_gr + cf->transfer_leaf_gr +
+			cf->cpool_froot_gr + cf->cpool_froot_storage_gr + cf->transfer_froot_gr + 
+			cf->cpool_livestem_gr + cf->cpool_livestem_storage_gr + cf->transfer_livestem_gr +
+			cf->cpool_deadstem_gr + cf->cpool_deadstem_storage_gr + cf->transfer_deadstem_gr + 
+			cf->cpool_livecroot_gr + cf->cpool_livecroot_storage_gr + cf->transfer_livecroot_gr + 
+			cf->cpool_deadcroot_gr + cf->cpool_deadcroot_storage_gr + cf->transfer_deadcroot_gr;
+		summary->daily_gr = gr;
+		if (need & SUM_CUM) summary->cum_gr += gr;
+	}
+	if (need & SUM_NPP)
+	{
+		npp = summary->daily_gpp - summary->daily_mr - summary->daily_gr;
+		summary->daily_npp = npp;
+		if (need & SUM_CUM) summary->cum_npp += npp;
+	}
 	
 	/* calculate daily NEP, positive for net sink */
 	/* NEP = NPP - Autotrophic Resp */
-	hr = cf->litr1_hr + cf->litr2_hr + cf->litr4_hr + cf->soil1_hr +
-		cf->soil2_hr + cf->soil3_hr + cf->soil4_hr;
-	nep = npp - hr;
+	if (need & SUM_HR)
+	{
+		hr = cf->litr1_hr + cf->litr2_hr + cf->litr4_hr + cf->soil1_hr +
+			cf->soil2_hr + cf->soil3_hr + cf->soil4_hr;
+		summary->daily_hr = hr;
+		if (need & SUM_CUM) summary->cum_hr += hr;
+	}
+	if (need & SUM_NEP)
+	{
+		nep = summary->daily_npp - summary->daily_hr;
+		summary->daily_nep = nep;
+		if (need & SUM_CUM) summary->cum_nep += nep;
+	}
 	
 	/* calculate daily NEE, positive for net sink */
 	/* NEE = NEP - fire losses */
-	fire = cf->m_leafc_to_fire + cf->m_frootc_to_fire + cf->m_leafc_storage_to_fire +
-		cf->m_frootc_storage_to_fire + cf->m_livestemc_storage_to_fire + 
-		cf->m_deadstemc_storage_to_fire + cf->m_livecrootc_storage_to_fire +
-		cf->m_deadcrootc_storage_to_fire + cf->m_leafc_transfer_to_fire +
-		cf->m_frootc_transfer_to_fire +  cf->m_livestemc_transfer_to_fire + 
-		cf->m_deadstemc_transfer_to_fire + cf->m_livecrootc_transfer_to_fire +
-		cf->m_deadcrootc_transfer_to_fire + cf->m_livestemc_to_fire +
-		cf->m_deadstemc_to_fire + cf->m_livecrootc_to_fire + cf->m_deadcrootc_to_fire +
-		cf->m_gresp_storage_to_fire + cf->m_gresp_transfer_to_fire + cf->m_litr1c_to_fire +
-		cf->m_litr2c_to_fire + cf->m_litr3c_to_fire + cf->m_litr4c_to_fire +
-		cf->m_cwdc_to_fire;
-	nee = nep - fire;
-	
-	summary->daily_npp = npp;
-	summary->daily_nep = nep;
-	summary->daily_nee = nee;
-	summary->daily_gpp = gpp;
-	summary->daily_mr = mr;
-	summary->daily_gr = gr;
-	summary->daily_hr = hr;
-	summary->daily_fire = fire;
-	summary->cum_npp += npp;
-	summary->cum_nep += nep;
-	summary->cum_nee += nee;
-	summary->cum_gpp += gpp;
-	summary->cum_mr += mr;
-	summary->cum_gr += gr;
-	summary->cum_hr += hr;
-	summary->cum_fire += fire;
+	if (need & SUM_FIRE)
+	{
+		fire = cf->m_leafc_to_fire + cf->m_frootc_to_fire + cf->m_leafc_storage_to_fire +
+			cf->m_frootc_storage_to_fire + cf->m_livestemc_storage_to_fire + 
+			cf->m_deadstemc_storage_to_fire + cf->m_livecrootc_storage_to_fire +
+			cf->m_deadcrootc_storage_to_fire + cf->m_leafc_transfer_to_fire +
+			cf->m_frootc_transfer_to_fire +  cf->m_livestemc_transfer_to_fire + 
+			cf->m_deadstemc_transfer_to_fire + cf->m_livecrootc_transfer_to_fire +
+			cf->m_deadcrootc_transfer_to_fire + cf->m_livestemc_to_fire +
+			cf->m_deadstemc_to_fire + cf->m_livecrootc_to_fire + cf->m_deadcrootc_to_fire +
+			cf->m_gresp_storage_to_fire + cf->m_gresp_transfer_to_fire + cf->m_litr1c_to_fire +
+			cf->m_litr2c_to_fire + cf->m_litr3c_to_fire + cf->m_litr4c_to_fire +
+			cf->m_cwdc_to_fire;
+		summary->daily_fire = fire;
+		if (need & SUM_CUM) summary->cum_fire += fire;
+	}
+	if (need & SUM_NEE)
+	{
+		nee = summary->daily_nep - summary->daily_fire;
+		summary->daily_nee = nee;
+		if (need & SUM_CUM) summary->cum_nee += nee;
+	}
 	
 	/* other flux summary variables */
-	summary->daily_litfallc = cf->m_leafc_to_litr1c + cf->m_leafc_to_litr2c + 
-		cf->m_leafc_to_litr3c + cf->m_leafc_to_litr4c + cf->m_frootc_to_litr1c +
-		cf->m_frootc_to_litr2c + cf->m_frootc_to_litr3c + cf->m_frootc_to_litr4c +
-		cf->m_leafc_storage_to_litr1c + cf->m_frootc_storage_to_litr1c +
-		cf->m_livestemc_storage_to_litr1c + cf->m_deadstemc_storage_to_litr1c +
-		cf->m_livecrootc_storage_to_litr1c + cf->m_deadcrootc_storage_to_litr1c +
-		cf->m_leafc_transfer_to_litr1c + cf->m_frootc_transfer_to_litr1c +
-		cf->m_livestemc_transfer_to_litr1c + cf->m_deadstemc_transfer_to_litr1c +
-		cf->m_livecrootc_transfer_to_litr1c + cf->m_deadcrootc_transfer_to_litr1c +
-		cf->m_livestemc_to_cwdc + cf->m_deadstemc_to_cwdc + 
-		cf->m_livecrootc_to_cwdc + cf->m_deadcrootc_to_cwdc +
-		cf->m_gresp_storage_to_litr1c + cf->m_gresp_transfer_to_litr1c +
-		cf->leafc_to_litr1c + cf->leafc_to_litr2c + cf->leafc_to_litr3c + 
-		cf->leafc_to_litr4c + cf->frootc_to_litr1c + cf->frootc_to_litr2c +
-		cf->frootc_to_litr3c + cf->frootc_to_litr4c;
+	if (need & SUM_LITFALL)
+	{
+		summary->daily_litfallc = cf->m_leafc_to_litr1c + cf->m_leafc_to_litr2c + 
+			cf->m_leafc_to_litr3c + cf->m_leafc_to_litr4c + cf->m_frootc_to_litr1c +
+			cf->m_frootc_to_litr2c + cf->m_frootc_to_litr3c + cf->m_frootc_to_litr4c +
+			cf->m_leafc_storage_to_litr1c + cf->m_frootc_storage_to_litr1c +
+			cf->m_livestemc_storage_to_litr1c + cf->m_deadstemc_storage_to_litr1c +
+			cf->m_livecrootc_storage_to_litr1c + cf->m_deadcrootc_storage_to_litr1c +
+			cf->m_leafc_transfer_to_litr1c + cf->m_frootc_transfer_to_litr1c +
+			cf->m_livestemc_transfer_to_litr1c + cf->m_deadstemc_transfer_to_litr1c +
+			cf->m_livecrootc_transfer_to_litr1c + cf->m_deadcrootc_transfer_to_litr1c +
+			cf->m_livestemc_to_cwdc + cf->m_deadstemc_to_cwdc + 
+			cf->m_livecrootc_to_cwdc + cf->m_deadcrootc_to_cwdc +
+			cf->m_gresp_storage_to_litr1c + cf->m_gresp_transfer_to_litr1c +
+			cf->leafc_to_litr1c + cf->leafc_to_litr2c + cf->leafc_to_litr3c + 
+			cf->leafc_to_litr4c + cf->frootc_to_litr1c + cf->frootc_to_litr2c +
+			cf->frootc_to_litr3c + cf->frootc_to_litr4c;
+	}
 		
 	/* summarize carbon stocks */
-	summary->vegc = cs->leafc + cs->leafc_storage + cs->leafc_transfer + 
-		cs->frootc + cs->frootc_storage + cs->frootc_transfer +
-		cs->livestemc + cs->livestemc_storage + cs->livestemc_transfer +
-		cs->deadstemc + cs->deadstemc_storage + cs->deadstemc_transfer +
-		cs->livecrootc + cs->livecrootc_storage + cs->livecrootc_transfer +
-		cs->deadcrootc + cs->deadcrootc_storage + cs->deadcrootc_transfer +
-		cs->gresp_storage + cs->gresp_transfer + cs->cpool;
-	summary->litrc = cs->cwdc + cs->litr1c + cs->litr2c + cs->litr3c + 
-		cs->litr4c;
-	summary->soilc = cs->soil1c + cs->soil2c + cs->soil3c + cs->soil4c;
-	summary->totalc = summary->vegc + summary->litrc + summary->soilc;
+	if (need & SUM_STOCK)
+	{
+		summary->vegc = cs->leafc + cs->leafc_storage + cs->leafc_transfer + 
+			cs->frootc + cs->frootc_storage + cs->frootc_transfer +
+			cs->livestemc + cs->livestemc_storage + cs->livestemc_transfer +
+			cs->deadstemc + cs->deadstemc_storage + cs->deadstemc_transfer +
+			cs->livecrootc + cs->livecrootc_storage + cs->livecrootc_transfer +
+			cs->deadcrootc + cs->deadcrootc_storage + cs->deadcrootc_transfer +
+			cs->gresp_storage + cs->gresp_transfer + cs->cpool;
+		summary->litrc = cs->cwdc + cs->litr1c + cs->litr2c + cs->litr3c + 
+			cs->litr4c;
+		summary->soilc = cs->soil1c + cs->soil2c + cs->soil3c + cs->soil4c;
+		summary->totalc = summary->vegc + summary->litrc + summary->soilc;
+	}
 	
 	
 	return(!ok);
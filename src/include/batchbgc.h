@@ -0,0 +1,28 @@
+#ifndef BATCHBGC_H
+#define BATCHBGC_H
+/*
+batchbgc.h
+header file to hold includes needed for batchbgc.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+/* fork(), waitpid() and POSIX shared memory */
+#define _POSIX_C_SOURCE 200809L
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* batchbgc runs each site with point_run() from pointbgc */
+#include "pointbgc.h"
+#include "batchbgc_struct.h"
+#include "batchbgc_func.h"
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef BATCHBGC_FUNC_H
+#define BATCHBGC_FUNC_H
+/*
+batchbgc_func.h
+function prototypes for batchbgc
+for use with batchbgc front-end to BIOME-BGC library
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+int batch_publish(const char* listname, int nworkers, batch_struct* batch);
+int batch_unmap(batch_struct* batch);
+int batch_spawn(batch_struct* batch, int slot);
+int batch_supervise(batch_struct* batch);
+const char* batch_status_name(int status);
+int batch_dashboard(const batch_struct* batch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
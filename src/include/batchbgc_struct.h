@@ -0,0 +1,89 @@
+#ifndef BATCHBGC_STRUCT_H
+#define BATCHBGC_STRUCT_H
+/*
+batchbgc_struct.h
+for use with batchbgc front-end to BIOME-BGC library
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* site status values */
+#define SITE_QUEUED 0
+#define SITE_RUNNING 1
+#define SITE_DONE 2
+#define SITE_FAILED 3
+#define SITE_STOPPED 4           /* stopped early, can be continued with -c */
+
+/* seconds between rewrites of the dashboard file */
+#define BATCH_DASH_INTERVAL 5
+
+/* The shared memory segment holds, in order: the header, the site
+queue, the worker table, the met table, the epc table and the met data.
+The offsets in the header are in bytes from the start of the segment. */
+typedef struct
+{
+	long size;                 /* bytes in the segment */
+	int nsites;                /* entries in the site queue */
+	int nworkers;              /* entries in the worker table */
+	int nmet;                  /* distinct met files */
+	int nepc;                  /* distinct epc files */
+	long next_site;            /* next queue entry, taken atomically */
+	long site_off, worker_off, met_off, epc_off, data_off;
+} batch_header_struct;
+
+/* one site in the queue */
+typedef struct
+{
+	char ini[128];             /* ini file name */
+	int met;                   /* index in the met table */
+	int epc;                   /* index in the epc table, -1 = read file */
+	volatile int status;       /* SITE_* */
+	volatile int worker;       /* worker that ran the site, or -1 */
+	volatile double start;     /* (s) wall clock when the site started, 0 = not yet */
+	volatile double end;       /* (s) wall clock when the site ended, 0 = not yet */
+	spinup_telem_struct telem; /* last spinup telemetry record of the site */
+} batch_site_struct;
+
+/* one worker process */
+typedef struct
+{
+	volatile pid_t pid;        /* process id of the current worker */
+	volatile int site;         /* site being run, or -1 */
+	int nspawn;                /* number of times the worker was started */
+} batch_worker_struct;
+
+/* one met file. The data are six arrays of ndays doubles (tmax, tmin,
+prcp, vpd, swavgfd, dayl) starting at offset doubles into the data. */
+typedef struct
+{
+	char name[128];            /* met file name */
+	int ndays;                 /* days in the file */
+	long offset;               /* first double of tmax in the data */
+} batch_met_struct;
+
+/* supervisor view of the shared segment */
+typedef struct
+{
+	batch_header_struct* hdr;
+	batch_site_struct* sites;
+	batch_worker_struct* workers;
+	batch_met_struct* mets;
+	epconst_struct* epcs;
+	double* data;
+	point_opts_struct opts;    /* options passed to point_run() */
+	const char* dashboard;     /* dashboard file name, or NULL */
+} batch_struct;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
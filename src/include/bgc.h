@@ -19,10 +19,11 @@ Andrew A Neuschwander, andrew@ntsg.umt.edu
 #include <stdarg.h>
 #include <math.h>
 #include <errno.h>
+#include <signal.h>
 
+#include "bgc_constants.h"
 #include "bgc_struct.h"
 #include "bgc_func.h"
-#include "bgc_constants.h"
 #include "ini.h"
 #include "bgc_epclist.h"
 #include "bgc_io.h"
@@ -49,6 +49,7 @@ Iribane, J.V., and W.L. Godson, 1981. Atmospheric Thermodynamics. 2nd
 #define GRPERC      0.3      /* (DIM) growth resp per unit of C grown */
 #define GRPNOW      1.0      /* (DIM) proportion of storage growth resp at fixation */
 #define PPFD50      75.0     /* (umol/m2/s) PPFD for 1/2 stomatal closure */
+#define MR_Q10      2.0      /* (DIM) Q_10 for maintenance respiration */
 #define DENITRIF_PROPORTION  0.01  /* fraction of mineralization to volatile */
 #define MOBILEN_PROPORTION   0.1   /* fraction mineral N avail for leaching */
 
@@ -100,9 +101,112 @@ are set to 0.0 to control rounding and overflow errors */
 #define MODE_MODEL 2
 #define MODE_SPINNGO 3
 
+/* mass balance check modes, see the -b option in USAGE.TXT */
+#define BALANCE_DAILY 0
+#define BALANCE_INTERVAL 1
+#define BALANCE_UNKNOWN -1    /* bgc_balance_decode(): unknown keyword */
+
+/* pools tested in precision_control(), indices into the prec_trunc
+counters of bgcstats_struct */
+#define PREC_LEAFC 0
+#define PREC_LIVESTEMC 1
+#define PREC_DEADSTEMC 2
+#define PREC_LIVECROOTC 3
+#define PREC_DEADCROOTC 4
+#define PREC_CWDC 5
+#define PREC_LITR1C 6
+#define PREC_LITR2C 7
+#define PREC_LITR3C 8
+#define PREC_LITR4C 9
+#define PREC_SOIL1C 10
+#define PREC_SOIL2C 11
+#define PREC_SOIL3C 12
+#define PREC_SOIL4C 13
+#define PREC_SMINN 14
+#define PREC_RETRANSN 15
+#define PREC_SOILW 16
+#define PREC_SNOWW 17
+#define PREC_CANOPYW 18
+#define NPREC 19
+
 /* output control constants */
 #define NMAP 700
 
+/* reasons for a run to stop before the end of the simulation, see the
+-W, -y and -c options in USAGE.TXT */
+#define STOP_NONE 0
+#define STOP_SIGNAL 1          /* SIGTERM or SIGINT */
+#define STOP_WALL 2            /* wall clock budget used up */
+#define STOP_YEARS 3           /* simulated year budget used up */
+
+/* exit status of a run that stopped early and can be continued */
+#define BGC_EXIT_STOPPED 75
+
+/* exit status of a batch that finished with some of its sites failed */
+#define BGC_EXIT_SITES_FAILED 2
+
+/* what went wrong in a point simulation that failed, as returned by
+point_read() and point_run() (see bgc_error_name()). A failed simulation
+has released its memory and files, so that the process can go on with
+other simulations. */
+#define BGC_ERR_INI 1          /* ini file missing or malformed */
+#define BGC_ERR_INPUT 2        /* epc, met, CO2, Ndep or restart input */
+#define BGC_ERR_OUTPUT 3       /* output or restart file not written */
+#define BGC_ERR_MODEL 4        /* error in the simulation itself */
+#define NBGC_ERR 5
+
+/* marks the resume record that follows the restart record of a run
+that stopped early */
+#define RESUME_MAGIC 0x42474352
+
+/* live output tap, a ring of output records in shared memory (see the
+-t option in USAGE.TXT and output_tap.c) */
+#define TAP_MAGIC 0x42474354
+#define TAP_NSLOTS 4096        /* records held in the ring */
+#define TAP_DAY 0              /* record of the daily outputs */
+#define TAP_YEAR 1             /* record of the annual outputs */
+#define TAP_READ_OK 0          /* record read */
+#define TAP_READ_NONE 1        /* record not published yet */
+#define TAP_READ_LOST 2        /* record overwritten before it was read */
+
+/* multi-site output container, the outputs of many sites in one file
+of chunks (see the -C option of batchbgc in USAGE.TXT and
+output_container.c) */
+#define CONT_MAGIC 0x42474343
+#define CONT_INDEX_MAGIC 0x42474349
+#define CONT_SITE 0            /* site record, the name of the ini file */
+#define CONT_DAY 1             /* daily outputs (.dayout) */
+#define CONT_MONAVG 2          /* monthly averages (.monavgout) */
+#define CONT_ANNAVG 3          /* annual averages (.annavgout) */
+#define CONT_ANN 4             /* annual outputs (.annout) */
+#define CONT_DAYASCII 5        /* daily ascii outputs (.dayout.ascii) */
+#define CONT_MONASCII 6        /* monthly ascii outputs (.monavgout.ascii) */
+#define CONT_ANNASCII 7        /* annual ascii outputs (.annout.ascii) */
+#define CONT_ANNTEXT 8         /* simple annual text output (_ann.txt) */
+#define NCONT 9
+#define CONT_TRUNC 1           /* chunk flag: the stream starts over here,
+                               as a file opened for writing */
+
+/* run-scoped arena allocator (see arena.c) */
+#define ARENA_ALIGN 64         /* (bytes) alignment of each allocation */
+#define ARENA_BLOCK 1048576    /* (bytes) default size of the arena blocks */
+
+/* summary terms computed by csummary() and wsummary(), as a demand
+mask built from the output codes by summary_demand() */
+#define SUM_GPP     0x0001     /* daily_gpp */
+#define SUM_MR      0x0002     /* daily_mr */
+#define SUM_GR      0x0004     /* daily_gr */
+#define SUM_HR      0x0008     /* daily_hr */
+#define SUM_FIRE    0x0010     /* daily_fire */
+#define SUM_NPP     0x0020     /* daily_npp (needs GPP, MR and GR) */
+#define SUM_NEP     0x0040     /* daily_nep (needs NPP and HR) */
+#define SUM_NEE     0x0080     /* daily_nee (needs NEP and FIRE) */
+#define SUM_CUM     0x0100     /* cum_* of the flux terms computed */
+#define SUM_LITFALL 0x0200     /* daily_litfallc */
+#define SUM_STOCK   0x0400     /* vegc, litrc, soilc and totalc */
+#define SUM_WATER   0x0800     /* the water summary of wsummary() */
+#define SUM_ALL     0x0fff
+
 /* For modifying summary output as per pan-arctic bgc */
 #define SANE 1
 #define INSANE 0
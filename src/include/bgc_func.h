@@ -25,7 +25,7 @@ nflux_struct* nf);
 int atm_pres(double elev, double* pa);
 int prephenology(const control_struct* ctrl, const epconst_struct* epc, 
 const siteconst_struct* sitec, const metarr_struct* metarr,
-phenarray_struct* phen);
+phenarray_struct* phen, arena_struct* arena);
 int restart_input(control_struct* ctrl, wstate_struct* ws, cstate_struct* cs,
 	nstate_struct* ns, epvar_struct* epv, int* metyr, 
 	restart_data_struct* restart);
@@ -35,10 +35,19 @@ int restart_output(control_struct* ctrl, wstate_struct* ws,cstate_struct* cs,
 int free_phenmem(phenarray_struct* phen);
 int firstday(const epconst_struct* epc, const cinit_struct* cinit,
 epvar_struct* epv, phenarray_struct* phen, cstate_struct* cs, nstate_struct* ns);
-int precision_control(wstate_struct* ws, cstate_struct* cs, nstate_struct* ns);
+int precision_control(wstate_struct* ws, cstate_struct* cs, nstate_struct* ns,
+	bgcstats_struct* stats);
 int zero_srcsnk(cstate_struct* cs, nstate_struct* ns, wstate_struct* ws,
 	summary_struct* summary);
-int daymet(const metarr_struct* metarr, metvar_struct* metv, int metday);
+int metcache_init(const control_struct* ctrl, const metarr_struct* metarr,
+double tair_avg, double pa, metcache_struct* metcache, arena_struct* arena);
+int free_metcache(metcache_struct* metcache);
+void arena_init(arena_struct* arena, size_t blocksize);
+void* arena_alloc(arena_struct* arena, size_t size);
+void arena_free(arena_struct* arena, void* ptr);
+void arena_release(arena_struct* arena);
+int daymet(const metarr_struct* metarr, const metcache_struct* metcache,
+metvar_struct* metv, int metday, int snowpack);
 int dayphen(const phenarray_struct* phenarr, phenology_struct* phen, int metday);
 int phenology(const epconst_struct* epc, const phenology_struct* phen,
 epvar_struct* epv, cstate_struct* cs, cflux_struct* cf, nstate_struct* ns,
@@ -52,24 +61,27 @@ metvar_struct* metv, epvar_struct* epv, double albedo);
 int prcp_route(const metvar_struct* metv, double precip_int_coef,
 double all_lai, wflux_struct* wf); 
 int snowmelt(const metvar_struct* metv, wflux_struct* wf, double snoww);
-int baresoil_evap(const metvar_struct* metv, wflux_struct* wf, double* dsr_ptr);
+int baresoil_evap(const metvar_struct* metv, wflux_struct* wf, double* dsr_ptr,
+bgcstats_struct* stats);
 int soilpsi(const siteconst_struct* sitec, double soilw, double* psi,
 double* vwc_out);
 int maint_resp(const cstate_struct* cs, const nstate_struct* ns,
 const epconst_struct* epc, const metvar_struct* metv, cflux_struct* cf,
 epvar_struct* epv);
 int canopy_et(const metvar_struct* metv, const epconst_struct* epc, 
-epvar_struct* epv, wflux_struct* wf, int verbose);
+epvar_struct* epv, wflux_struct* wf, int verbose, bgcstats_struct* stats);
 int penmon(const pmet_struct* in, int out_flag,	double* et);
 int photosynthesis(psn_struct* psn);
+int psn_kinetics(double t, double* Kc, double* Ko, double* act);
 int total_photosynthesis(const metvar_struct* metv, const epconst_struct* epc, epvar_struct* epv, cflux_struct* cf, psn_struct *psn_sun, psn_struct *psn_shade);
 int outflow(const siteconst_struct* sitec, const wstate_struct* ws, wflux_struct* wf);
-int decomp(double tsoil, const epconst_struct* epc, epvar_struct* epv, 
+int decomp(const metvar_struct* metv, const epconst_struct* epc, epvar_struct* epv, 
 const siteconst_struct* sitec, cstate_struct* cs, cflux_struct* cf,
 nstate_struct* ns, nflux_struct* nf, ntemp_struct* nt);
+double decomp_t_scalar(double tsoil);
 int daily_allocation(cflux_struct* cf, cstate_struct* cs,
 nflux_struct* nf, nstate_struct* ns, epconst_struct* epc, epvar_struct* epv,
-ntemp_struct* nt, double naddfrac, int mode);
+ntemp_struct* nt, double naddfrac, int mode, bgcstats_struct* stats);
 int spinup_daily_allocation(cflux_struct* cf, cstate_struct* cs,
 nflux_struct* nf, nstate_struct* ns, epconst_struct* epc, epvar_struct* epv,
 ntemp_struct* nt, double naddfrac);
@@ -84,12 +96,32 @@ int nleaching(nstate_struct* ns, nflux_struct* nf, wstate_struct* ws,
 wflux_struct* wf);
 int mortality(const epconst_struct* epc, cstate_struct* cs, cflux_struct* cf,
 nstate_struct* ns, nflux_struct* nf);
-int check_water_balance(wstate_struct* ws, int first_balance);
-int check_carbon_balance(cstate_struct* cs, int first_balance);
-int check_nitrogen_balance(nstate_struct* ns, int first_balance);
-int csummary(cflux_struct* cf, cstate_struct* cs, summary_struct* summary);
+int check_water_balance(wstate_struct* ws, balance_struct* bal);
+int check_carbon_balance(cstate_struct* cs, balance_struct* bal);
+int check_nitrogen_balance(nstate_struct* ns, balance_struct* bal);
+int csummary(cflux_struct* cf, cstate_struct* cs, summary_struct* summary,
+	int need);
+int summary_demand(const control_struct* ctrl, int mode);
 int wsummary(wstate_struct* ws,wflux_struct* wf, summary_struct* summary);
 int output_ascii(float arr[],int nvars, FILE *ptr); 
+int coarse_start(const cstate_struct* cs, const nstate_struct* ns,
+coarse_struct* co);
+int coarse_record(const cstate_struct* cs, const nstate_struct* ns,
+const cflux_struct* cf, coarse_struct* co);
+int coarse_advance(const coarse_struct* co, cstate_struct* cs,
+nstate_struct* ns, int nyears);
+int coarse_correct(const coarse_struct* co, int nyears, cstate_struct* cs,
+nstate_struct* ns, const cstate_struct* cs_new, const nstate_struct* ns_new,
+const cstate_struct* cs_old, const nstate_struct* ns_old);
+double coarse_totalc(const cstate_struct* cs);
+size_t output_tap_size(int ndayout, int nannout, int nslots);
+int output_tap_init(output_tap_struct* tap, int ndayout, const int* daycodes,
+int nannout, const int* anncodes, int nslots);
+const int* output_tap_codes(const output_tap_struct* tap, int kind);
+void output_tap_publish(output_tap_struct* tap, int kind, int year, int yday,
+const float* values, int n);
+int output_tap_read(const output_tap_struct* tap, long long n,
+output_tap_slot_struct* rec, float* values);
 double get_co2(co2control_struct * co2,int simyr);		/* Added WMJ 03/16/2005 */
 double get_ndep(ndepcontrol_struct * ndep,int simyr);	/* Added WMJ 03/16/2005 */
 #ifdef __cplusplus
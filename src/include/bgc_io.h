@@ -16,6 +16,50 @@ extern "C"
 {
 #endif
 
+/* copy of the evolving part of a simulation, for bgcsim_get_state() and
+bgcsim_set_state(). Taken between days; the monthly and annual averages
+of daily outputs are not included, so a state restored part way through
+a month or year gives partial averages for that period. */
+typedef struct
+{
+	wstate_struct ws;
+	cstate_struct cs;
+	nstate_struct ns;
+	epvar_struct epv;
+	summary_struct summary;
+	balance_struct bal;
+	bgcstats_struct stats;
+	double co2;             /* (ppm) current atmospheric CO2 */
+	double daily_ndep, daily_nfix;
+	int simyr, yday, metyr, newyear, done;
+	int curmonth;
+	float monmaxlai, annmaxlai, monmaxsnoww;
+	float eomsnoww, eomsoilw;
+	int steady1, steady2, rising, metcycle, spinyears;
+	double tally1, tally1b, tally2, tally2b, t1;
+	double naddfrac;
+	int vegsteady, coarse_rec;
+	coarse_struct coarse;
+	double annmaxplai, annet, annoutflow, annnpp, annnbp, annprcp, anntavg;
+} bgcstate_struct;
+
+/* resume record, written after the restart record of a run that stopped
+early by bgc_stop_check(), so that it can be continued from the day it
+stopped on. Holds the mode of the run, the simulation state and the
+partial monthly and annual averages of the daily outputs. */
+typedef struct
+{
+	int magic;              /* RESUME_MAGIC */
+	int mode;               /* MODE_SPINUP or MODE_MODEL */
+	int reason;             /* why the run stopped (STOP_*) */
+	int ndayout;            /* number of daily outputs */
+	bgcstate_struct state;
+	psn_struct psn_sun, psn_shade; /* last photosynthesis results, which
+	                        are output as they are on days without any */
+	float monavg[NMAP];     /* partial monthly averages of daily outputs */
+	float annavg[NMAP];     /* partial annual averages of daily outputs */
+} restart_resume_struct;
+
 /* structure for passing input parameters to bgc() */
 typedef struct
 {
@@ -31,8 +75,103 @@ typedef struct
 	nstate_struct ns;       /* nitrogen state variables */
 	siteconst_struct sitec; /* site constants */
 	epconst_struct epc;     /* ecophysiological constants */
+	const restart_resume_struct* resume; /* if not NULL, bgc() continues
+	                        the stopped run it was written by */
+	const phenarray_struct* phenarr; /* if not NULL, phenology arrays made
+	                        by prephenology() for these inputs, used by
+	                        bgc() in place of its own */
 } bgcin_struct;
 
+/* writer of the outputs of one site to a multi-site container. Each
+output file of the site is a memory stream, appended to the container as
+a chunk at the end of every simulation year. */
+typedef struct
+{
+	int fd;                 /* container, open for appending */
+	int site;               /* site id */
+	int year;               /* year of the data in the streams */
+	FILE* stream[NCONT];    /* memory stream of each output, or NULL */
+	char* buf[NCONT];       /* buffer of each memory stream */
+	size_t size[NCONT];     /* (bytes) size of each buffer */
+	int trunc[NCONT];       /* (flag) 1=the next chunk starts the stream over */
+	file* target[NCONT];    /* output file that holds the memory stream */
+} output_container_struct;
+
+/* output codes and switches of a simulation, given to its output sinks
+when it starts */
+typedef struct
+{
+	int mode;               /* MODE_SPINUP or MODE_MODEL */
+	int simstartyear;       /* first simulation year */
+	int dodaily;            /* (flag) 1=daily outputs are written */
+	int domonavg;           /* (flag) 1=monthly averages are written */
+	int doannavg;           /* (flag) 1=annual averages are written */
+	int doannual;           /* (flag) 1=annual outputs are written */
+	int ndayout;            /* number of daily outputs, and of values in
+	                        each daily, monthly and annual average record */
+	const int* daycodes;    /* output codes of the daily outputs */
+	int nannout;            /* number of annual outputs */
+	const int* anncodes;    /* output codes of the annual outputs */
+} output_meta_struct;
+
+/* the outputs of one simulation year */
+typedef struct
+{
+	const float* annavg;    /* annual averages of the daily outputs, or NULL */
+	const float* ann;       /* annual outputs, or NULL */
+	int text;               /* (flag) 1=the simple annual values are set,
+	                        in model runs */
+	double prcp;            /* (mm/yr) annual total precipitation */
+	double tavg;            /* (deg C) annual average air temperature */
+	double maxlai;          /* (m2/m2) annual maximum projected LAI */
+	double et;              /* (mm/yr) annual total evapotranspiration */
+	double outflow;         /* (mm/yr) annual total outflow */
+	double npp;             /* (gC/m2/yr) annual total NPP */
+	double nbp;             /* (gC/m2/yr) annual total NBP */
+} output_year_struct;
+
+/* output sink: where a simulation sends its daily, monthly and annual
+outputs. year is the simulation year, or the spinup year in a spinup;
+month is 0-11 and yday 0-364. Each function returns 0 on success, and
+may be NULL to ignore that kind of output. Sinks are chained through
+next, and each one gets every output. See output_sink.c for the file
+sink (the output files of bgcout) and the memory sink. */
+typedef struct output_sink_struct
+{
+	int (*open)(struct output_sink_struct* sink);
+	int (*write_day)(struct output_sink_struct* sink, int year, int yday,
+		const float* values);
+	int (*write_month)(struct output_sink_struct* sink, int year, int month,
+		const float* values);
+	int (*write_year)(struct output_sink_struct* sink, int year,
+		const output_year_struct* rec);
+	int (*close)(struct output_sink_struct* sink);
+	void* data;             /* the state of the sink */
+	output_meta_struct meta; /* set before open() is called */
+	struct output_sink_struct* next; /* next sink in the chain, or NULL */
+} output_sink_struct;
+
+/* caller-provided arrays filled by the memory sink. Each record is
+stored at the next free row, ndayout (or nannout) floats long; a record
+that does not fit is an error. Arrays left NULL are not filled, and the
+counts are left where they are by open(), so a caller that runs the same
+arrays again sets them back to 0 first. */
+typedef struct
+{
+	float* day;             /* daily outputs, maxdays rows */
+	int maxdays;            /* (count) room for days */
+	int ndays;              /* (count) days stored */
+	float* month;           /* monthly averages, maxmonths rows */
+	int maxmonths;          /* (count) room for months */
+	int nmonths;            /* (count) months stored */
+	float* annavg;          /* annual averages of the daily outputs,
+	                        maxyears rows */
+	float* ann;             /* annual outputs, maxyears rows */
+	int* years;             /* year of each annual record, maxyears long */
+	int maxyears;           /* (count) room for years */
+	int nyears;             /* (count) years stored */
+} output_memory_struct;
+
 /* structure for output handling from bgc() */
 typedef struct
 {
@@ -46,14 +185,201 @@ typedef struct
 	file monoutascii;	/* file containing monthly ascii output */
 	file annoutascii;	/* file containing annual ascii output */
 	
+	bgcstats_struct stats;  /* model-internal event counters for the run */
 	double spinup_resid_trend; /* kgC/m2/yr remaining trend after spinup */
 	int spinup_years;       /* number of years before reaching steady-state */
 	unsigned char bgc_ascii;	/* ASCII output flag */
+	FILE* telemetry;        /* open spinup telemetry file, or NULL */
+	const char* site;       /* site name for the telemetry records */
+	spinup_telem_struct* telem_last; /* if not NULL, gets a copy of each
+	                        telemetry record */
+	int stopped;            /* why bgc() stopped early (STOP_*), or STOP_NONE */
+	restart_resume_struct resume; /* resume record, when stopped early */
+	output_tap_struct* tap; /* live output tap, or NULL */
+	output_container_struct* container; /* multi-site output container
+	                        the output files are written to, or NULL */
+	output_sink_struct* sink; /* sinks of the outputs, or NULL for the
+	                        output files above */
 } bgcout_struct;
 
+/* persistent simulation object, used by bgc() and by host programs that
+need to advance the model one day or one year at a time. The output map
+holds pointers to members of this structure, so it must stay at the same
+address between bgcsim_init() and bgcsim_free(). */
+typedef struct
+{
+	bgcin_struct* bgcin;    /* input structure given to bgcsim_init() */
+	bgcout_struct* bgcout;  /* output structure given to bgcsim_init() */
+	int mode;               /* MODE_SPINUP or MODE_MODEL */
+	int done;               /* (flag) 1=simulation has finished */
+	
+	/* iofiles and program control variables */
+	control_struct ctrl;
+	
+	/* meteorological variables */
+	metarr_struct metarr;
+	metvar_struct metv;
+	metcache_struct metcache;
+	co2control_struct co2;
+	ramp_ndep_struct ramp_ndep;
+	
+	/* state and flux variables for water, carbon, and nitrogen */
+	wstate_struct ws;
+	wflux_struct wf, zero_wf;
+	cinit_struct cinit;
+	cstate_struct cs;
+	cflux_struct cf, zero_cf;
+	nstate_struct ns;
+	nflux_struct nf, zero_nf;
+	
+	/* primary ecophysiological variables */
+	epvar_struct epv;
+	
+	/* site physical constants */
+	siteconst_struct sitec;
+	
+	/* phenological data */
+	phenarray_struct phenarr;
+	int phen_shared;        /* (flag) 1=phenarr belongs to the caller */
+	phenology_struct phen;
+	
+	/* ecophysiological constants */
+	epconst_struct epc;
+	
+	/* photosynthesis constructs */
+	psn_struct psn_sun, psn_shade;
+	
+	/* temporary nitrogen variables for decomposition and allocation */
+	ntemp_struct nt;
+	
+	/* summary variable structure, and the SUM_* terms of it that are
+	read by the outputs or the simulation control */
+	summary_struct summary;
+	int sum_need;
+	
+	/* output mapping (array of pointers to double) */
+	double** output_map;
+	
+	/* local storage for daily and annual output variables */
+	float *dayarr, *monavgarr, *annavgarr, *annarr;
+	int dayout;             /* (flag) 1=daily output array is needed */
+	
+	/* output sinks: bgcout->sink, or the file sink of bgcout */
+	output_sink_struct filesink;
+	output_sink_struct* sink;
+	int sink_open;          /* (flag) 1=the sinks were opened */
+	
+	/* arena of the arrays above, released by bgcsim_free() */
+	arena_struct arena;
+	
+	/* model-internal event counters */
+	bgcstats_struct stats;
+	
+	/* mass balance check state, and the copies of the state variables
+	saved at the last good check for replay in interval mode */
+	balance_struct bal, bal_snap;
+	bgcstats_struct bal_stats;
+	wstate_struct bal_ws;
+	cstate_struct bal_cs;
+	nstate_struct bal_ns;
+	epvar_struct bal_epv;
+	summary_struct bal_summary;
+	int bal_days;           /* days since the last balance check */
+	int bal_yday;           /* yday of the last good check, -1=previous year */
+	int replay_yday;        /* yday of the failed check being replayed, or -1 */
+	
+	/* simulation position */
+	int simyr;              /* year within the current block of years */
+	int yday;               /* next day of the year to simulate (0-364) */
+	int metyr;              /* current year of the met record */
+	int nyears;             /* years in a block (simyears, or spinup nblock) */
+	int newyear;            /* (flag) 1=annual setup due before next day */
+	
+	/* annual CO2 and N deposition handling */
+	double daily_ndep, daily_nfix;
+	
+	/* variables used for monthly average output */
+	int curmonth;
+	float monmaxlai, annmaxlai, monmaxsnoww;
+	float eomsnoww, eomsoilw;
+	
+	/* mode == MODE_SPINUP only */
+	/* spinup control */
+	int nblock;
+	int steady1, steady2, rising, metcycle, spinyears;
+	double tally1, tally1b, tally2, tally2b, t1;
+	double naddfrac;
+	/* coarse spinup steps */
+	int vegsteady;          /* (flag) 1=vegetation and litter C at steady state */
+	int coarse_rec;         /* (flag) 1=this block is recorded for a coarse step */
+	coarse_struct coarse;
+	/* convergence telemetry */
+	double telem_start;     /* (s) wall clock at bgcsim_init() */
+	int telem_years;        /* spinyears at the last record */
+	double telem_soilc, telem_totalc; /* soil and total C at the last record */
+	int telem_n;            /* records made */
+	double telem_trend[4];  /* soil C trends of the last records, newest
+	                        first */
+	
+	/* mode == MODE_MODEL only */
+	/* simple annual variables for text output */
+	double annmaxplai, annet, annoutflow, annnpp, annnbp, annprcp, anntavg;
+} bgcsim_struct;
+
+
 /* function prototypes for calling bgc */
 int bgc(bgcin_struct* bgcin, bgcout_struct* bgcout, int mode);
 
+/* early stop of bgc() on a signal or a budget */
+extern volatile sig_atomic_t bgc_stop_signal;
+void bgc_stop_handler(int sig);
+int bgc_catch_signals(void);
+int bgc_stop_check(const control_struct* ctrl, int years);
+const char* bgc_stop_name(int reason);
+const char* bgc_error_name(int err);
+
+/* function prototypes for the simulation object */
+int bgcsim_spinup_block(int metyears);
+int bgcsim_init(bgcsim_struct* sim, bgcin_struct* bgcin, bgcout_struct* bgcout,
+	int mode);
+int bgcsim_step_day(bgcsim_struct* sim);
+int bgcsim_step_year(bgcsim_struct* sim);
+int bgcsim_get_state(const bgcsim_struct* sim, bgcstate_struct* state);
+int bgcsim_set_state(bgcsim_struct* sim, const bgcstate_struct* state);
+int bgcsim_get_resume(const bgcsim_struct* sim, int reason,
+	restart_resume_struct* resume);
+int bgcsim_set_resume(bgcsim_struct* sim, const restart_resume_struct* resume);
+int bgcsim_finish(bgcsim_struct* sim);
+int bgcsim_free(bgcsim_struct* sim);
+
+/* function prototypes for the output sinks */
+int output_file_sink_init(output_sink_struct* sink, bgcout_struct* bgcout);
+int output_memory_sink_init(output_sink_struct* sink, output_memory_struct* mem);
+int output_sink_open(output_sink_struct* sink, const output_meta_struct* meta);
+int output_sink_day(output_sink_struct* sink, int year, int yday,
+	const float* values);
+int output_sink_month(output_sink_struct* sink, int year, int month,
+	const float* values);
+int output_sink_year(output_sink_struct* sink, int year,
+	const output_year_struct* rec);
+int output_sink_close(output_sink_struct* sink);
+
+/* function prototypes for the multi-site output container */
+int output_container_open(output_container_struct* cont, const char* name,
+	int site, const char* sitename);
+int output_container_stream(output_container_struct* cont, int stream,
+	file* target, int append);
+int output_container_year(output_container_struct* cont, int year);
+int output_container_close(output_container_struct* cont);
+int output_container_index(const char* name);
+int output_container_load(const char* name, output_index_struct* index);
+int output_container_site(const output_index_struct* index, const char* sitename);
+int output_container_extract(const output_index_struct* index, int site,
+	int stream, int first, int last, FILE* out);
+void output_container_free(output_index_struct* index);
+const char* output_container_stream_name(int stream);
+int output_container_stream_decode(const char* name);
+
 /* Verbosity sensitive printf for BiomeBGC.*/
 #ifdef __USE_ISOC99
 int _bgc_printf(const char *file, int line, signed char verbosity, const char *format, ...);
@@ -62,6 +388,14 @@ int _bgc_printf(const char *file, int line, signed char verbosity, const char *f
 int bgc_printf(signed char verbosity, const char *format, ...);
 #endif
 signed char bgc_verbosity_decode(char *keyword);
+int bgc_balance_decode(char *keyword, int *interval);
+int bgc_stats_header(FILE *fp);
+int bgc_stats_write(FILE *fp, const char *site, const char *mode,
+	const bgcstats_struct *stats);
+const char* bgc_phase_name(int phase);
+int bgc_telemetry_header(FILE *fp);
+int bgc_telemetry_write(FILE *fp, const char *site,
+	const spinup_telem_struct *rec);
 void bgc_print_usage(void);
 int bgc_logfile_setup(char *logfile);
 int bgc_logfile_finish(void);
@@ -73,6 +407,7 @@ int bgc_logfile_finish(void);
 #define BV_PROGRESS 2
 #define BV_DETAIL 3
 #define BV_DIAG 4
+#define BV_UNKNOWN -2   /* bgc_verbosity_decode(): unknown keyword */
 
 #ifdef __cplusplus
 }
@@ -36,6 +36,11 @@ typedef struct
 	int write_restart;     /* flag to write restart file */
 	int keep_metyr;        /* (flag) 1=retain restart metyr, 0=reset metyr */
 	int onscreen;          /* (flag) 1=show progress on-screen 0=don't */
+	int balance_mode;      /* mass balance check mode (BALANCE_*) */
+	int balance_interval;  /* (days) between checks, BALANCE_INTERVAL mode */
+	int spincoarse;        /* coarse spinup years per daily year, 0=off */
+	double stop_time;      /* (s) wall clock time to stop early at, 0=none */
+	int stop_years;        /* simulated years to stop early after, 0=none */
 } control_struct;
 
 /* a structure to hold information about ramped N-deposition scenario */
@@ -108,8 +113,43 @@ typedef struct
 	double pa;             /* (Pa)    atmospheric pressure */
 	double co2;            /* (ppm)   atmospheric concentration of CO2 */
 	double dayl;           /* (s)     daylength */
+	/* daily values taken from the forcing-derivative cache (metcache) */
+	double gcorr;          /* (DIM)   T and P correction for conductances */
+	double q10_tday;       /* (DIM)   maint. resp. Q10 factor for tday */
+	double q10_tnight;     /* (DIM)   maint. resp. Q10 factor for tnight */
+	double q10_tavg;       /* (DIM)   maint. resp. Q10 factor for tavg */
+	double q10_tsoil;      /* (DIM)   maint. resp. Q10 factor for tsoil */
+	double t_scalar;       /* (DIM)   decomp temperature scalar for tsoil */
+	double Kc;             /* (Pa)    MM constant carboxylation at tday */
+	double Ko;             /* (Pa)    MM constant oxygenation at tday */
+	double act;            /* (umol/kgRubisco/s) Rubisco activity at tday */
 } metvar_struct;
 
+/* forcing-derivative cache */
+/* quantities that depend only on the met arrays and the site constants,
+computed once for every metday before the daily model loop and reused on
+every pass through the met record. The soil temperature correction depends
+on the presence of a snowpack, so the soil temperature terms are kept for
+both cases. */
+typedef struct
+{
+	double* tday;          /* (deg C) daylight average air temperature */
+	double* tnight;        /* (deg C) nightime average air temperature */
+	double* gcorr;         /* (DIM)   T and P correction for conductances */
+	double* q10_tday;      /* (DIM)   maint. resp. Q10 factor for tday */
+	double* q10_tnight;    /* (DIM)   maint. resp. Q10 factor for tnight */
+	double* q10_tavg;      /* (DIM)   maint. resp. Q10 factor for tavg */
+	double* tsoil_bare;    /* (deg C) corrected soil temperature, no snow */
+	double* tsoil_snow;    /* (deg C) corrected soil temperature, snowpack */
+	double* q10_tsoil_bare; /* (DIM)  Q10 factor for tsoil, no snow */
+	double* q10_tsoil_snow; /* (DIM)  Q10 factor for tsoil, snowpack */
+	double* t_scalar_bare; /* (DIM)   decomp temperature scalar, no snow */
+	double* t_scalar_snow; /* (DIM)   decomp temperature scalar, snowpack */
+	double* Kc;            /* (Pa)    MM constant carboxylation at tday */
+	double* Ko;            /* (Pa)    MM constant oxygenation at tday */
+	double* act;           /* (umol/kgRubisco/s) Rubisco activity at tday */
+} metcache_struct;
+
 /* water state variables (including sums for sources and sinks) */
 typedef struct
 {
@@ -709,6 +749,7 @@ typedef struct
 	double gamma;           /* (Pa) CO2 compensation point, no Rd */
 	double Kc;              /* (Pa) MM constant carboxylation */
 	double Ko;              /* (Pa) MM constant oxygenation */
+	double act;             /* (umol/kgRubisco/s) Rubisco activity */
 	double Vmax;            /* (umol/m2/s) max rate carboxylation */
 	double Jmax;            /* (umol/m2/s) max rate electron transport */
 	double J;               /* (umol/m2/s) rate of RuBP regeneration */
@@ -758,6 +799,170 @@ typedef struct
 	double totalc;         /* kgC/m2  total of vegc, litrc, and soilc */
 } summary_struct;
 
+/* model-internal event counters for one simulation, reported as run
+statistics (see the -S option in USAGE.TXT) */
+typedef struct
+{
+	long days;             /* (count) days simulated */
+	long psn_days;         /* (count) days with photosynthesis */
+	long snow_days;        /* (count) days with a snowpack */
+	long penmon_calls;     /* (count) calls to penmon() */
+	long nlimit_days;      /* (count) N-limited days in daily_allocation() */
+	long cpool_deficit_days; /* (count) days starting with cpool < 0 */
+	long prec_trunc[NPREC]; /* (count) nonzero values set to 0.0 by
+	                          precision_control(), per pool (PREC_*) */
+	int spinup_switch;     /* (count) spinup switches to steady1 */
+	int spinup_switchback; /* (count) spinup switches back to rising */
+	int spinup_coarse;     /* (count) spinup years taken as coarse steps */
+} bgcstats_struct;
+
+/* spinup phases, for the convergence telemetry */
+#define SPINUP_PHASE_NADD   0  /* supplemental N on (steady1 = 0) */
+#define SPINUP_PHASE_STEADY 1  /* supplemental N off (steady1 = 1) */
+#define SPINUP_PHASE_DONE   2  /* spinup finished */
+
+/* spinup convergence record, made at the end of each spinup block (see
+the -T option in USAGE.TXT) */
+typedef struct
+{
+	int spinyears;         /* (count) spinup years so far */
+	int metcycle;          /* (count) metcycle of the block just ended */
+	int phase;             /* SPINUP_PHASE_* after the block */
+	double soilc;          /* (kgC/m2) soil C at the end of the block */
+	double totalc;         /* (kgC/m2) total C at the end of the block */
+	double soilc_trend;    /* (kgC/m2/yr) soil C change over the block */
+	double totalc_trend;   /* (kgC/m2/yr) total C change over the block */
+	double test_trend;     /* (kgC/m2/yr) trend of the steady state test,
+	                          if the block ended with one, or 0.0 */
+	int tested;            /* (flag) 1=the block ended with a test */
+	double wall;           /* (s) wall time since the start of the run */
+	double forecast;       /* (yr) estimated spinup years left, or -1.0
+	                          when there is no estimate yet */
+} spinup_telem_struct;
+
+/* header of a live output tap segment. It is followed by the daily and
+then the annual output codes, and then by nslots slots, each an
+output_tap_slot_struct and room for nvalues floats. The simulation is
+the only writer: it fills the slot of record n (n % nslots) and then
+moves head on to n+1, without ever waiting for the readers. */
+typedef struct
+{
+	int magic;             /* TAP_MAGIC */
+	int ndayout;           /* (count) daily output variables */
+	int nannout;           /* (count) annual output variables */
+	int nvalues;           /* (count) room for values in each slot */
+	int nslots;            /* (count) slots in the ring */
+	int slotsize;          /* (bytes) size of each slot */
+	volatile int readers;  /* (count) attached readers, records are only
+	                          published while this is not 0 */
+	volatile int done;     /* (flag) 1=the simulation has finished */
+	int writer;            /* process id of the simulation, or 0 */
+	volatile long long head; /* (count) records published so far */
+} output_tap_struct;
+
+/* one record in the ring. seq is odd while the record is written, and
+2n+2 once record n is complete in the slot. */
+typedef struct
+{
+	volatile long long seq; /* sequence of the record in the slot */
+	int kind;              /* TAP_DAY or TAP_YEAR */
+	int year;              /* simulation year, or spinup year */
+	int yday;              /* day of the year, 0-364 (364 for TAP_YEAR) */
+	int nvalues;           /* (count) values in the record */
+} output_tap_slot_struct;
+
+/* header of a chunk of a multi-site output container, followed by
+length bytes of one output stream of one site. Chunks are appended to
+the container in one write each, so the chunks of concurrent writers
+never mix. */
+typedef struct
+{
+	int magic;             /* CONT_MAGIC */
+	int site;              /* site id */
+	int stream;            /* CONT_* stream of the data */
+	int year;              /* simulation year of the data, or spinup year */
+	int flags;             /* CONT_TRUNC, or 0 */
+	int pad;
+	long long length;      /* (bytes) data after the header */
+} output_chunk_struct;
+
+/* one chunk in the index of a container */
+typedef struct
+{
+	int site;              /* site id */
+	int stream;            /* CONT_* stream of the data */
+	int year;              /* simulation year of the data, or spinup year */
+	int flags;             /* CONT_TRUNC, or 0 */
+	long long offset;      /* (bytes) position of the data in the container */
+	long long length;      /* (bytes) data in the chunk */
+} output_index_entry_struct;
+
+/* index of a container, sorted by site, stream and offset. The index
+file <container>.idx holds the header and then the entries. */
+typedef struct
+{
+	int magic;             /* CONT_INDEX_MAGIC */
+	int nentries;          /* (count) chunks in the container */
+	long long size;        /* (bytes) size of the container when indexed */
+} output_index_header_struct;
+
+/* an open container and its index, for reading */
+typedef struct
+{
+	FILE* fp;              /* the container */
+	int nentries;          /* (count) chunks */
+	output_index_entry_struct* entries;
+	int nsites;            /* (count) site ids, the largest id + 1 */
+	char** sites;          /* ini file of each site id, or NULL */
+} output_index_struct;
+
+/* one block of an arena, followed by its memory */
+typedef struct arena_block_struct
+{
+	struct arena_block_struct* next;
+	char* base;            /* first ARENA_ALIGN-aligned byte of the block */
+	size_t size;           /* (bytes) room from base */
+	size_t used;           /* (bytes) handed out from base */
+} arena_block_struct;
+
+/* run-scoped arena: the arrays of one run are carved from a few large
+blocks and released together by arena_release() */
+typedef struct
+{
+	arena_block_struct* blocks; /* newest block first */
+	size_t blocksize;      /* (bytes) size of the shared blocks */
+	size_t bytes;          /* (bytes) handed out so far */
+} arena_struct;
+
+/* litter, CWD and soil pools advanced by the coarse spinup steps */
+#define NCOARSE 9
+
+/* totals of the litter, CWD and soil pools over recorded daily spinup
+years, for the coarse spinup steps (see spinup_coarse.c) */
+typedef struct
+{
+	int ndays;                 /* (count) days recorded */
+	double c0[NCOARSE];        /* (kgC/m2) pools at the start of the record */
+	double n0;                 /* (kgN/m2) total N of the pools at the start */
+	double csum[NCOARSE];      /* (kgC/m2) sum of the daily pools */
+	double nsum[NCOARSE];      /* (kgN/m2) sum of the daily pool N */
+	double hr[NCOARSE];        /* (kgC/m2) heterotrophic respiration */
+	double fire[NCOARSE];      /* (kgC/m2) fire losses */
+	double xfer[NCOARSE][NCOARSE]; /* (kgC/m2) transfers, [from][to] */
+} coarse_struct;
+
+/* mass balance check state, carried between calls to the check_*_balance()
+routines so that it can be saved and restored along with the state
+variables when a failed check is replayed */
+typedef struct
+{
+	double old_wbal;       /* (kgH2O/m2) water balance at the last check */
+	double old_cbal;       /* (kgC/m2) carbon balance at the last check */
+	double old_nbal;       /* (kgN/m2) nitrogen balance at the last check */
+	int first;             /* (flag) 1=no previous check to compare with */
+	int quiet;             /* (flag) 1=report failures as diagnostics only */
+} balance_struct;
+
 /* restart data structure */
 typedef struct
 {
@@ -0,0 +1,71 @@
+#ifndef BIOMEBGC_H
+#define BIOMEBGC_H
+
+/*
+biomebgc.h
+public header of the Biome-BGC shared library (libbiomebgc), for
+programs that run the model in process rather than through the bgc
+executable and its files
+
+The library holds the core science library (bgc(), the bgcsim_*()
+stepping functions) and the pointbgc ini file readers (point_read(),
+point_run(), point_close() and the *_init() readers). The readers
+allocate from the arena they are given (arena_init(), arena_release()),
+or with malloc() when it is NULL, and then metarr_free(), co2_free(),
+ndep_free() and output_codes_free() free their arrays. The structures
+are those of bgc_struct.h, bgc_io.h and pointbgc_struct.h. The outputs
+of a run go to its output files, or to the sinks set in bgcout.sink: a
+program that uses the outputs directly gives a memory sink
+(output_memory_sink_init()) with arrays to fill, in place of reading
+them back from the files. BIOMEBGC_API is raised whenever a structure or
+a function of this header changes in a way that needs the programs built
+against it to be rebuilt; the library reports the value it was built
+with from biomebgc_api(), and carries it as its soname major.
+
+Build with 'make shared' and install with 'make install' from src/
+(see USAGE.TXT). pkg-config --cflags --libs biomebgc gives the flags.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#define BIOMEBGC_VERSION_MAJOR 4
+#define BIOMEBGC_VERSION_MINOR 2
+#define BIOMEBGC_API 5
+
+#include <time.h>
+#include "bgc.h"
+#include "pointbgc_struct.h"
+#include "pointbgc_func.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* version of the library, and the BIOMEBGC_API it was built with. A
+program should check that biomebgc_api() == BIOMEBGC_API. */
+int biomebgc_version(int* major, int* minor);
+int biomebgc_api(void);
+
+/* settings that the bgc executable takes from its command line: the
+verbosity level (BV_*, see bgc_io.h) and the run mode (MODE_INI to
+follow the ini files, or MODE_SPINUP, MODE_MODEL or MODE_SPINNGO) */
+void biomebgc_set_verbosity(int level);
+void biomebgc_set_mode(int mode);
+
+/* point simulations and their options, allocated by the library for
+callers that do not see the structure sizes (C FFI bindings) */
+point_input_struct* biomebgc_point_alloc(void);
+void biomebgc_point_free(point_input_struct* pin);
+void biomebgc_opts_init(point_opts_struct* opts);
+point_opts_struct* biomebgc_opts_alloc(void);
+void biomebgc_opts_free(point_opts_struct* opts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -30,6 +30,7 @@ typedef struct
 
 /* function prototypes */
 int file_open (file *target, char mode);
+int file_close (file *target);
 int scan_value (file ini, void *var, char mode);
 int scan_open (file ini,file *target,char mode);
 
@@ -20,19 +20,64 @@ int met_init(file init, point_struct* point);
 int restart_init(file init, restart_ctrl_struct* restart);
 int time_init(file init, control_struct *ctrl);
 int scc_init(file init, climchange_struct* scc);
-int co2_init(file init, co2control_struct* co2, int simyears);
-int ndep_init(file ndepfile, ndepcontrol_struct* ndepctrl);
+int co2_init(file init, co2control_struct* co2, int simyears, arena_struct* arena);
+int co2_file_init(file init, co2control_struct* co2, file* co2f);
+int co2_read(file temp, co2control_struct* co2, arena_struct* arena);
+void co2_free(co2control_struct* co2);
+int ndep_init(file ndepfile, ndepcontrol_struct* ndepctrl, arena_struct* arena);
+void ndep_free(ndepcontrol_struct* ndepctrl);
 int sitec_init(file init, siteconst_struct* sitec);
+int sitec_soil_init(siteconst_struct* sitec, double sand, double silt,
+double clay);
 int ramp_ndep_init(file init, ramp_ndep_struct* ramp_ndep);
 int epc_init(file init, epconst_struct* epc);
+int epc_file_init(file init, file* epcf);
+int epc_read(file temp, epconst_struct* epc);
 int wstate_init(file init, const siteconst_struct* sitec, wstate_struct* ws);
 int cnstate_init(file init, const epconst_struct* epc, cstate_struct* cs,
 cinit_struct* cinit, nstate_struct* ns);
-int output_ctrl(file init, output_struct* output);
+int output_ctrl(file init, output_struct* output, arena_struct* arena);
+void output_codes_free(output_struct* output);
 int output_init(output_struct* output);
 int end_init(file init);
-int metarr_init(file metf, metarr_struct* metarr, const climchange_struct* scc,
-int nyears);
+int met_parse(file metf, int nhead, int ndays, metdata_struct* md);
+void metdata_free(metdata_struct* md);
+int metarr_init(file metf, int nhead, metarr_struct* metarr,
+const climchange_struct* scc, int nyears, arena_struct* arena);
+int metarr_shared_init(const point_shared_struct* shared, metarr_struct* metarr,
+const climchange_struct* scc, int nyears, arena_struct* arena);
+int metarr_alloc(metarr_struct* metarr, int nyears, arena_struct* arena);
+int metarr_derive(const metarr_struct* base, metarr_struct* metarr,
+const climchange_struct* scc, int nyears, arena_struct* arena);
+void metarr_free(metarr_struct* metarr, const metarr_struct* base);
+int met_represent(const metarr_struct* metarr, int metyears, int nrep,
+metarr_struct* rep, int* years, arena_struct* arena);
+int metarr_set_day(metarr_struct* metarr, int i, const climchange_struct* scc,
+double tmax, double tmin, double prcp, double vpd, double swavgfd, double dayl);
+int point_read(char* ininame, const point_opts_struct* opts,
+const point_shared_struct* shared, point_input_struct* pin);
+int point_run(char* ininame, const point_opts_struct* opts,
+const point_shared_struct* shared);
+int point_close(point_input_struct* pin);
+int point_branch(char* ininame, int branchyear, int nscen, char** scenini,
+int nthreads, const point_opts_struct* opts);
+int point_serve(const char* sockname, int nthreads, const point_opts_struct* opts);
+point_cache_struct* point_cache_new(void);
+void point_cache_delete(point_cache_struct* cache);
+int point_cache_epc(point_cache_struct* cache, const char* name, epconst_struct* epc);
+int point_cache_met(point_cache_struct* cache, file metf, int nhead, int metyears,
+const metarr_struct** metarr);
+int point_cache_co2(point_cache_struct* cache, const char* name, co2control_struct* co2);
+int point_cache_ndep(point_cache_struct* cache, file ndepfile, ndepcontrol_struct* ndepctrl);
+int point_cache_phen(point_cache_struct* cache, const control_struct* ctrl,
+const epconst_struct* epc, const siteconst_struct* sitec,
+const metarr_struct* metarr, const metarr_struct* base,
+const phenarray_struct** phenarr);
+void point_cache_report(point_cache_struct* cache, char* line, int size);
+int output_tap_open(const char* name, const output_struct* output,
+output_tap_struct** tap);
+int output_tap_close(const char* name, output_tap_struct* tap);
+int spinup_parareal(bgcin_struct* bgcin, bgcout_struct* bgcout, int nslices);
 int presim_state_init(wstate_struct* ws, cstate_struct* cs, nstate_struct* ns,
 cinit_struct* cinit);
 
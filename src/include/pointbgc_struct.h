@@ -21,6 +21,7 @@ typedef struct
     char header[100];      /* header string, written to all output files */
 	char systime[100];     /* system time at start of simulation */ 
 	file metf;             /* met data file (ASCII) *//* simulation restart control variables */
+	int nhead;             /* number of met file header lines */
 } point_struct;
 
 typedef struct
@@ -30,6 +31,10 @@ typedef struct
 	int keep_metyr;        /* (flag) 1=retain restart metyr, 0=reset metyr */
 	file in_restart;       /* input restart file */
 	file out_restart;      /* output restart file */
+	int resume;            /* (flag) 1=continue from a resume record in the
+	                       output restart file, if there is one */
+	int resumed;           /* (flag) 1=resume_data was read */
+	restart_resume_struct resume_data; /* resume record of a stopped run */
 } restart_ctrl_struct;
 
 /* a structure to hold scalar climate change scenario information */
@@ -63,8 +68,104 @@ typedef struct
 	file monoutascii;	/* ASCII monthly output file */
 	file annoutascii;	/* ASCII annual output file */
 	unsigned char bgc_ascii;	
+	int append;            /* (flag) 1=append to the files of a stopped run */
+	output_container_struct* container; /* multi-site output container the
+	                       files are written to in place of their own
+	                       files, or NULL */
 } output_struct;
 
+/* command line options that apply to each point simulation, see
+point_run() */
+typedef struct
+{
+	unsigned char bgc_ascii;   /* (flag) 1=write ascii output files */
+	int readndepfile;          /* (flag) 1=read annual Ndep from ndep_file */
+	file ndep_file;            /* annual nitrogen deposition file */
+	int balance_mode;          /* mass balance check mode */
+	int balance_interval;      /* days between checks in interval mode */
+	FILE* stats;               /* open run statistics file, or NULL */
+	FILE* telemetry;           /* open spinup telemetry file, or NULL */
+	spinup_telem_struct* telem_last; /* if not NULL, gets each spinup
+	                           telemetry record */
+	int repyears;              /* spinup on this many representative met
+	                           years, 0 = on the whole met record */
+	int spincoarse;            /* coarse spinup years per daily year, 0 = off */
+	int parareal;              /* slices for a parareal spinup, 0 = off */
+	int stop_wall;             /* (s) wall clock budget of each run, 0 = none */
+	int stop_years;            /* simulated year budget of each call to bgc(),
+	                           0 = none */
+	int resume;                /* (flag) 1=continue stopped runs */
+	const char* tap;           /* shared memory name of the live output
+	                           tap, or NULL for none */
+	const char* container;     /* multi-site output container the output
+	                           files are written to, or NULL for none */
+	int container_site;        /* site id of the run in the container */
+} point_opts_struct;
+
+/* the daily values of a met file, as read by met_parse() */
+typedef struct
+{
+	int ndays;                 /* days in each array */
+	double* tmax;              /* (deg C) daily maximum temperature */
+	double* tmin;              /* (deg C) daily minimum temperature */
+	double* prcp;              /* (cm) daily total precipitation */
+	double* vpd;               /* (Pa) daylight average VPD */
+	double* swavgfd;           /* (W/m2) daylight average shortwave flux */
+	double* dayl;              /* (s) daylength */
+} metdata_struct;
+
+/* warm cache of parsed input files, see point_cache.c */
+typedef struct point_cache_struct point_cache_struct;
+
+/* met and epc data already read by a host program, used by point_run()
+in place of reading the met and epc files named in the ini file. The met
+arrays hold the unperturbed daily values of the met file, in order.
+Alternatively, metarr holds the met arrays already built from the met
+file metname with no climate change, for metyears years; they are used
+by any ini file that names the same met file and number of met years,
+and the met arrays above are then not needed. With a cache, every epc,
+met, CO2 and Ndep file and the phenology arrays are taken from the
+cache, which reads each of them once. */
+typedef struct
+{
+	int ndays;                 /* days in each met array */
+	const double* tmax;        /* (deg C) daily maximum temperature */
+	const double* tmin;        /* (deg C) daily minimum temperature */
+	const double* prcp;        /* (cm) daily total precipitation */
+	const double* vpd;         /* (Pa) daylight average VPD */
+	const double* swavgfd;     /* (W/m2) daylight average shortwave flux */
+	const double* dayl;        /* (s) daylength */
+	const epconst_struct* epc; /* ecophysiological constants, or NULL */
+	const metarr_struct* metarr; /* unperturbed met arrays, or NULL */
+	const char* metname;       /* met file the metarr arrays were built from */
+	int metyears;              /* years in the metarr arrays */
+	point_cache_struct* cache; /* cache of input files, or NULL */
+	const char* initext;       /* text of the ini file, read in place of
+	                           the file named by point_read(), or NULL */
+} point_shared_struct;
+
+/* one point simulation as read from its ini file by point_read(), with
+its output and restart files open, ready to run */
+typedef struct
+{
+	file init;                 /* ini file, closed after reading */
+	file epcf;                 /* epc file named in the ini file */
+	point_struct point;
+	restart_ctrl_struct restart;
+	climchange_struct scc;
+	output_struct output;
+	bgcin_struct bgcin;
+	bgcout_struct bgcout;
+	metarr_struct metbase;     /* met arrays with no climate change, which
+	                           bgcin.metarr shares where CLIM_CHANGE leaves
+	                           a variable unchanged */
+	arena_struct arena;        /* the arrays read for this simulation, all
+	                           released by point_close(). Shared and cached
+	                           arrays are not in it. */
+	output_container_struct container; /* writer of the output files to
+	                           the container of opts->container */
+} point_input_struct;
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,24 @@
+#ifndef REGIONBGC_H
+#define REGIONBGC_H
+/*
+regionbgc.h
+header file to hold includes needed for regionbgc.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+/* pthreads and sysconf() */
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <unistd.h>
+
+/* regionbgc uses the pointbgc ini file readers */
+#include "pointbgc.h"
+#include "regionbgc_struct.h"
+#include "regionbgc_func.h"
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef REGIONBGC_FUNC_H
+#define REGIONBGC_FUNC_H
+/*
+regionbgc_func.h
+function prototypes for regionbgc
+for use with regionbgc front-end to BIOME-BGC library
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+int grid_init(file init, grid_struct* grid);
+int metrast_init(file init, region_struct* region);
+int siterast_init(file init, region_struct* region);
+int epcrast_init(file init, region_struct* region);
+int region_wstate_init(file init, region_struct* region);
+int region_ctrl(file init, region_struct* region);
+int region_output_init(region_struct* region);
+int raster_read(const char* name, const grid_struct* grid, float* arr);
+int raster_read_span(FILE* fp, const grid_struct* grid, int band,
+long start, long n, float* arr);
+int raster_write_span(FILE* fp, const grid_struct* grid, int band,
+long start, long n, const float* arr);
+int region_tiles(region_struct* region);
+void* region_worker(void* arg);
+int region_free(region_struct* region);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef REGIONBGC_STRUCT_H
+#define REGIONBGC_STRUCT_H
+/*
+regionbgc_struct.h
+for use with regionbgc front-end to BIOME-BGC library
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* daily met variables, one raster stack per variable per year */
+#define MET_TMAX 0
+#define MET_TMIN 1
+#define MET_PRCP 2
+#define MET_VPD 3
+#define MET_SRAD 4
+#define MET_DAYL 5
+#define NMETVAR 6
+
+/* site constant layers, in the order of the SITE_RASTERS block */
+#define SITE_DEPTH 0
+#define SITE_SAND 1
+#define SITE_SILT 2
+#define SITE_CLAY 3
+#define SITE_ELEV 4
+#define SITE_LAT 5
+#define SITE_ALBEDO 6
+#define SITE_NDEP 7
+#define SITE_NFIX 8
+#define NSITELAYER 9
+
+/* raster grid description. All rasters are headerless, row-major,
+native-endian 32-bit floats, with the bands of a stack one after the
+other. */
+typedef struct
+{
+	int ncols;             /* number of columns */
+	int nrows;             /* number of rows */
+	long ncells;           /* ncols * nrows */
+	float nodata;          /* value for cells with no data */
+} grid_struct;
+
+/* regional simulation control and input layers */
+typedef struct
+{
+	char header[100];      /* header string from the region ini file */
+	grid_struct grid;      /* raster grid description */
+
+	/* met raster stacks, <metprefix>_<var>_<year>.flt with 365 bands */
+	char metprefix[100];   /* met raster filename prefix */
+	int metfirstyr;        /* year of the first met raster */
+	climchange_struct scc; /* scalar climate change scenario */
+
+	/* site constant and epc index layers */
+	float* site[NSITELAYER];
+	float* epcidx;         /* index into epc[] for each cell */
+	unsigned char* land;   /* (flag) 1=cell has all inputs and is run */
+	int nepc;              /* number of epc files */
+	epconst_struct* epc;   /* ecophysiological constants for each index */
+
+	/* initial water state, soilw is set per cell from psat */
+	double snoww;          /* (kg/m2) water stored in snowpack */
+	double psat;           /* (DIM) soil water as a proportion of saturation */
+
+	/* template for the per-cell bgc input, holding everything that is
+	the same for all cells (control, CO2, N deposition, initial C and N) */
+	bgcin_struct tmpl;
+
+	/* output control */
+	char outprefix[100];   /* output raster filename prefix */
+	int nannout;           /* number of annual output variables */
+	int* anncodes;         /* output map indices for annual outputs */
+	file* annout;          /* one raster stack per annual output code */
+
+	/* tiling and threads */
+	int nthreads;          /* number of worker threads */
+	int cachekb;           /* (kB) target size of the met for one tile */
+	long tilecells;        /* land cells in a full tile */
+	long ntiles;           /* number of tiles */
+	long* tile_start;      /* first cell of each tile, ntiles+1 entries */
+	long maxspan;          /* most cells spanned by a single tile */
+	long nland;            /* number of land cells */
+
+	/* shared by the worker threads */
+	pthread_mutex_t lock;  /* guards next_tile, the counters and annout */
+	long next_tile;        /* next tile to hand to a worker */
+	long ndone;            /* land cells finished */
+	long nfail;            /* land cells that failed */
+	int ok;                /* cleared on an error that stops the run */
+} region_struct;
+
+/* worker thread working storage */
+typedef struct
+{
+	region_struct* region;
+	int id;                /* worker number */
+	float* span;           /* one band of the cells spanned by a tile */
+	float* met;            /* tile met, [land cell][var][day] */
+	float* out;            /* tile outputs, [code][year][spanned cell] */
+	metarr_struct metarr;  /* met arrays for the current cell */
+} region_worker_struct;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
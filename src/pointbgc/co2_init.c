@@ -10,15 +10,42 @@ See copyright.txt for Copyright information
 
 #include "pointbgc.h"
 
-int co2_init(file init, co2control_struct* co2, int simyears)
+int co2_init(file init, co2control_struct* co2, int simyears, arena_struct* arena)
+{
+	int ok = 1;
+	file temp;
+
+	if (co2_file_init(init, co2, &temp))
+	{
+		bgc_printf(BV_ERROR, "Error in call to co2_file_init() from co2_init()\n");
+		ok=0;
+	}
+
+	/* if using variable CO2 file, read it */
+	if (ok && co2->varco2)
+	{
+		if (file_open(&temp,'r'))
+		{
+			bgc_printf(BV_ERROR, "Error opening annual CO2 file\n");
+			ok=0;
+		}
+		if (ok)
+		{
+			if (co2_read(temp, co2, arena)) ok=0;
+			fclose(temp.ptr);
+		}
+	}
+
+	return (!ok);
+}
+
+/* read the CO2_CONTROL block, leaving the name of the annual CO2 file
+in co2f->name without opening it */
+int co2_file_init(file init, co2control_struct* co2, file* co2f)
 {
 	int ok = 1;
-	int i;
 	char key1[] = "CO2_CONTROL";
 	char keyword[80];
-	char junk[80];
-	file temp;
-	int reccount = 0;
 	/********************************************************************
 	**                                                                 **
 	** Begin reading initialization file block starting with keyword:  **
@@ -49,75 +76,85 @@ int co2_init(file init, co2control_struct* co2, int simyears)
 		bgc_printf(BV_ERROR, "Error reading constant CO2 value: co2_init()\n");
 		ok=0;
 	}
-	/* if using variable CO2 file, open it, otherwise
-	discard the next line of the ini file */
-	if (ok && co2->varco2)
+	/* the annual CO2 file, only used with the variable CO2 flag */
+	if (ok && scan_value(init, co2f->name, 's'))
 	{
-    	if (scan_open(init,&temp,'r')) 
-		{
-			bgc_printf(BV_ERROR, "Error opening annual CO2 file\n");
-			ok=0;
-		}
+		bgc_printf(BV_ERROR, "Error scanning annual co2 filename\n");
+		ok=0;
+	}
+	
+	if (ok && co2->co2ppm < 0.0)
+	{
+		bgc_printf(BV_ERROR, "Error in co2_init(): co2 (ppm) must be positive\n");
+		ok=0;
+	}
 
-		/* Find the number of lines in the file*/
-		/* Then use that number to malloc the appropriate arrays */
-		while(fscanf(temp.ptr,"%*lf%*lf") != EOF)
-		{
-			reccount++;
-		}
-		rewind(temp.ptr);
+	return (!ok);
+}
 
-		/* Store the total number of CO2 records found in the co2vals variable */
-		co2->co2vals = reccount;
-		bgc_printf(BV_DIAG,"Found: %i CO2 records in co2_init()\n",reccount);
-		
-		/* allocate space for the annual CO2 array */
-		if (ok && !(co2->co2ppm_array = (double*) malloc(reccount *
-			sizeof(double))))
-		{
-			bgc_printf(BV_ERROR, "Error allocating for annual CO2 array, co2_init()\n");
-			ok=0;
-		}
-		if (ok && !(co2->co2year_array = (int*) malloc(reccount *
-			sizeof(int))))
+/* read the annual CO2 records from an open CO2 file, allocating the
+arrays of co2 from arena (with malloc() when it is NULL) */
+int co2_read(file temp, co2control_struct* co2, arena_struct* arena)
+{
+	int ok = 1;
+	int i;
+	int reccount = 0;
+
+	/* Find the number of lines in the file*/
+	/* Then use that number to malloc the appropriate arrays */
+	while(fscanf(temp.ptr,"%*lf%*lf") != EOF)
+	{
+		reccount++;
+	}
+	rewind(temp.ptr);
+
+	/* Store the total number of CO2 records found in the co2vals variable */
+	co2->co2vals = reccount;
+	bgc_printf(BV_DIAG,"Found: %i CO2 records in co2_init()\n",reccount);
+	
+	/* allocate space for the annual CO2 array */
+	if (ok && !(co2->co2ppm_array = (double*) arena_alloc(arena, reccount *
+		sizeof(double))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating for annual CO2 array, co2_init()\n");
+		ok=0;
+	}
+	if (ok && !(co2->co2year_array = (int*) arena_alloc(arena, reccount *
+		sizeof(int))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating for annual CO2 year array, co2_init()\n");
+		ok=0;
+	}
+	/* read year and co2 concentration for each simyear */
+	for (i=0 ; ok && i<reccount ; i++)
+	{
+		if (fscanf(temp.ptr,"%i%lf",
+			&(co2->co2year_array[i]),&(co2->co2ppm_array[i]))==EOF)
 		{
-			bgc_printf(BV_ERROR, "Error allocating for annual CO2 year array, co2_init()\n");
+			bgc_printf(BV_ERROR, "Error reading annual CO2 array, ctrl_init()\n");
+			bgc_printf(BV_ERROR, "Note: file must contain a pair of values for each\n");
+			bgc_printf(BV_ERROR, "simyear: year and CO2.\n");
 			ok=0;
 		}
-		/* read year and co2 concentration for each simyear */
-		for (i=0 ; ok && i<reccount ; i++)
+		/* printf("CO2 value read: %i %lf\n",co2->co2year_array[i],co2->co2ppm_array[i]); */
+		if (co2->co2ppm_array[i] < 0.0)
 		{
-			if (fscanf(temp.ptr,"%i%lf",
-				&(co2->co2year_array[i]),&(co2->co2ppm_array[i]))==EOF)
-			{
-				bgc_printf(BV_ERROR, "Error reading annual CO2 array, ctrl_init()\n");
-				bgc_printf(BV_ERROR, "Note: file must contain a pair of values for each\n");
-				bgc_printf(BV_ERROR, "simyear: year and CO2.\n");
-				ok=0;
-			}
-			/* printf("CO2 value read: %i %lf\n",co2->co2year_array[i],co2->co2ppm_array[i]); */
-			if (co2->co2ppm_array[i] < 0.0)
-			{
-				bgc_printf(BV_ERROR, "Error in co2_init(): co2 (ppm) must be positive\n");
-				ok=0;
-			}
-		}
-		fclose(temp.ptr);
-	}
-	else
-	{
-		if (scan_value(init, junk, 's'))
-		{
-			bgc_printf(BV_ERROR, "Error scanning annual co2 filename\n");
+			bgc_printf(BV_ERROR, "Error in co2_init(): co2 (ppm) must be positive\n");
 			ok=0;
 		}
 	}
-	
-	if (co2->co2ppm < 0.0)
-	{
-		bgc_printf(BV_ERROR, "Error in co2_init(): co2 (ppm) must be positive\n");
-		ok=0;
-	}
 
 	return (!ok);
 }
+
+/* free the annual CO2 arrays read by co2_init() without an arena */
+void co2_free(co2control_struct* co2)
+{
+	if (co2->varco2)
+	{
+		free(co2->co2ppm_array);
+		free(co2->co2year_array);
+		co2->co2ppm_array = NULL;
+		co2->co2year_array = NULL;
+	}
+}
@@ -0,0 +1,139 @@
+/*
+container_get.c
+tool that reads the multi-site output container written by batchbgc
+with -C: lists the sites and their output streams, or copies one output
+stream of one site to the standard output, byte for byte the output
+file the site would have written on its own
+
+The site is given by its id in the container (its line in the site
+list, from 0) or by its ini file name, and the stream by the suffix of
+the output file it replaces (dayout, monavgout, annavgout, annout,
+dayout.ascii, monavgout.ascii, annout.ascii or ann.txt). With -y only
+the records of the years first to last are copied. The index file
+<container>.idx is used when it is up to date, otherwise the container
+is scanned, and -i writes a new index file (for a container whose batch
+did not finish).
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#define _POSIX_C_SOURCE 200809L
+#include "bgc.h"
+#include <limits.h>
+#include <unistd.h>
+
+/* the messages of the container functions go through bgc_printf() */
+char *argv_zero = NULL;
+
+static void container_usage(const char* argv0)
+{
+	fprintf(stderr, "usage: %s [-i] [-y <first>:<last>] <container> [<site> <stream>]\n", argv0);
+	fprintf(stderr, "  lists the sites and streams of the container, or copies one stream of one\n");
+	fprintf(stderr, "  site to the standard output\n");
+	fprintf(stderr, "  -i  write the index file of the container first\n");
+	fprintf(stderr, "  -y  copy only the records of the years first to last\n");
+}
+
+/* print each site with the size of each of its streams */
+static void container_list(const output_index_struct* index)
+{
+	int i, s;
+	long long bytes;
+	const output_index_entry_struct* e;
+
+	/* the size of a stream counts from the chunk that last started it
+	over */
+	printf("site\tini\tstream\tbytes\tchunks\n");
+	for (i=0 ; i<index->nentries ; )
+	{
+		e = &index->entries[i];
+		s = i;
+		for (bytes=0 ; i<index->nentries && index->entries[i].site == e->site &&
+			index->entries[i].stream == e->stream ; i++)
+		{
+			if (index->entries[i].flags & CONT_TRUNC)
+			{
+				bytes = 0;
+				s = i;
+			}
+			bytes += index->entries[i].length;
+		}
+		if (e->stream != CONT_SITE)
+		{
+			printf("%d\t%s\t%s\t%lld\t%d\n", e->site,
+				index->sites[e->site] ? index->sites[e->site] : "-",
+				output_container_stream_name(e->stream), bytes, i - s);
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int c, site, stream, rc = 0, reindex = 0;
+	int first = INT_MIN, last = INT_MAX;
+	output_index_struct index;
+
+	argv_zero = argv[0];
+	while ((c = getopt(argc, argv, "iy:")) != -1)
+	{
+		switch (c)
+		{
+			case 'i':
+				reindex = 1;
+				break;
+			case 'y':
+				if (sscanf(optarg, "%d:%d", &first, &last) != 2)
+				{
+					container_usage(argv[0]);
+					return (EXIT_FAILURE);
+				}
+				break;
+			default:
+				container_usage(argv[0]);
+				return (EXIT_FAILURE);
+		}
+	}
+	if (optind != argc - 1 && optind != argc - 3)
+	{
+		container_usage(argv[0]);
+		return (EXIT_FAILURE);
+	}
+
+	if (reindex && output_container_index(argv[optind]))
+	{
+		fprintf(stderr, "%s: could not index %s\n", argv[0], argv[optind]);
+		return (EXIT_FAILURE);
+	}
+	if (output_container_load(argv[optind], &index))
+	{
+		fprintf(stderr, "%s: could not read %s\n", argv[0], argv[optind]);
+		return (EXIT_FAILURE);
+	}
+
+	if (optind == argc - 1)
+	{
+		container_list(&index);
+	}
+	else if ((site = output_container_site(&index, argv[optind+1])) < 0)
+	{
+		fprintf(stderr, "%s: no site %s in %s\n", argv[0], argv[optind+1], argv[optind]);
+		rc = 1;
+	}
+	else if ((stream = output_container_stream_decode(argv[optind+2])) <= CONT_SITE)
+	{
+		fprintf(stderr, "%s: unknown stream %s\n", argv[0], argv[optind+2]);
+		rc = 1;
+	}
+	else if (output_container_extract(&index, site, stream, first, last, stdout) || fflush(stdout))
+	{
+		fprintf(stderr, "%s: could not copy the %s stream of site %s\n", argv[0],
+			argv[optind+2], argv[optind+1]);
+		rc = 1;
+	}
+
+	output_container_free(&index);
+	return (rc ? EXIT_FAILURE : EXIT_SUCCESS);
+}
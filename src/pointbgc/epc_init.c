@@ -14,10 +14,42 @@ See copyright.txt for Copyright information
 int epc_init(file init, epconst_struct* epc)
 {
 	int ok = 1;
-	double t1,t2,t3,t4,r1;
 	file temp;
+
+	/* read the EPC_FILE block */
+	if (ok && epc_file_init(init, &temp))
+	{
+		bgc_printf(BV_ERROR, "Error in call to epc_file_init() from epc_init()\n");
+		ok=0;
+	}
+
+	/* open file  */
+	if (ok && file_open(&temp,'r')) 
+	{
+		bgc_printf(BV_ERROR, "Error opening epconst file, epc_init()\n");
+		ok=0;
+	}
+	
+	/* read the constants from the epc file */
+	if (ok)
+	{
+		if (epc_read(temp, epc))
+		{
+			bgc_printf(BV_ERROR, "Error reading epconst file %s, epc_init()\n",temp.name);
+			ok=0;
+		}
+		fclose(temp.ptr);
+	}
+		
+	return (!ok);
+}
+
+/* read the EPC_FILE block, leaving the name of the epc file in
+epcf->name without opening it */
+int epc_file_init(file init, file* epcf)
+{
+	int ok = 1;
 	char key1[] = "EPC_FILE";
-	char key2[] = "ECOPHYS";
 	char keyword[80];
 
 	/********************************************************************
@@ -39,13 +71,26 @@ int epc_init(file init, epconst_struct* epc)
 		ok=0;
 	}
 
-	/* open file  */
-	if (ok && scan_open(init,&temp,'r')) 
+	/* epc filename */
+	if (ok && scan_value(init, epcf->name, 's'))
 	{
-		bgc_printf(BV_ERROR, "Error opening epconst file, epc_init()\n");
+		bgc_printf(BV_ERROR, "Error reading epconst filename, epc_file_init()\n");
 		ok=0;
 	}
 	
+	return (!ok);
+}
+
+/* read the ecophysiological constants from an open epc file, starting
+with the ECOPHYS keyword. Used by epc_init(), and by front-ends that read
+more than one epc file. */
+int epc_read(file temp, epconst_struct* epc)
+{
+	int ok = 1;
+	double t1,t2,t3,t4,r1;
+	char key2[] = "ECOPHYS";
+	char keyword[80];
+	
 	/* first scan epc keyword to ensure proper *.init format */
 	if (ok && scan_value(temp, keyword, 's'))
 	{
@@ -54,7 +99,7 @@ int epc_init(file init, epconst_struct* epc)
 	}
 	if (ok && strcmp(keyword,key2))
 	{
-		bgc_printf(BV_ERROR, "Expecting keyword --> %s in %s\n",key2,init.name);
+		bgc_printf(BV_ERROR, "Expecting keyword --> %s in %s\n",key2,temp.name);
 		ok=0;
 	}
 	
@@ -393,7 +438,5 @@ int epc_init(file init, epconst_struct* epc)
 		ok=0;
 	}
 	
-	fclose(temp.ptr);
-		
 	return (!ok);
 }
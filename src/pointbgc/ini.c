@@ -18,6 +18,8 @@ int file_open (file *target, char mode)
     'i' for read ascii
     'w' for write binary
     'o' for write ascii
+    'a' for append binary
+    'e' for append ascii
 */
 {
 	int ok=1;
@@ -26,7 +28,7 @@ int file_open (file *target, char mode)
         case 'r':
             if ((target->ptr = fopen(target->name,"rb")) == NULL)
             {
-                bgc_printf(BV_ERROR, "Can't open %s for binary read ... Exiting\n",target->name);
+                bgc_printf(BV_ERROR, "Can't open %s for binary read\n",target->name);
                 ok=0;
             }
             break;
@@ -34,7 +36,7 @@ int file_open (file *target, char mode)
         case 'i':
             if ((target->ptr = fopen(target->name,"r")) == NULL)
             {
-                bgc_printf(BV_ERROR, "Can't open %s for ascii read ... Exiting\n",target->name);
+                bgc_printf(BV_ERROR, "Can't open %s for ascii read\n",target->name);
                 ok=0;
             }
             break;
@@ -42,7 +44,7 @@ int file_open (file *target, char mode)
         case 'w':
             if ((target->ptr = fopen(target->name,"wb")) == NULL)
             {
-                bgc_printf(BV_ERROR, "Can't open %s for binary write ... Exiting\n",target->name);
+                bgc_printf(BV_ERROR, "Can't open %s for binary write\n",target->name);
                 ok=0;
             }
             break;
@@ -50,18 +52,48 @@ int file_open (file *target, char mode)
         case 'o':
             if ((target->ptr = fopen(target->name,"w")) == NULL)
             {
-                bgc_printf(BV_ERROR, "Can't open %s for ascii write ... Exiting\n",target->name);
+                bgc_printf(BV_ERROR, "Can't open %s for ascii write\n",target->name);
+                ok=0;
+            }
+            break;
+
+        case 'a':
+            if ((target->ptr = fopen(target->name,"ab")) == NULL)
+            {
+                bgc_printf(BV_ERROR, "Can't open %s for binary append\n",target->name);
+                ok=0;
+            }
+            break;
+
+        case 'e':
+            if ((target->ptr = fopen(target->name,"a")) == NULL)
+            {
+                bgc_printf(BV_ERROR, "Can't open %s for ascii append\n",target->name);
                 ok=0;
             }
             break;
 
         default:
-            bgc_printf(BV_ERROR, "Invalid mode specification for file_open ... Exiting\n");
+            bgc_printf(BV_ERROR, "Invalid mode specification for file_open\n");
             ok=0;
     }
     return(!ok);
 }
 
+/* file_close() closes a file opened with file_open() or scan_open(), if it
+is open, and marks it closed. Returns non-zero if fclose() fails. */
+int file_close (file *target)
+{
+    int rc = 0;
+
+    if (target->ptr)
+    {
+        rc = fclose(target->ptr);
+        target->ptr = NULL;
+    }
+    return(rc);
+}
+
 /* scan_value is the generic ascii input function for use with text
 initialization files. Reads the first whitespace delimited word on a line,
 and discards the remainder of the line. Returns a pointer to value depending
@@ -107,7 +139,7 @@ int scan_value (file ini, void *var, char type)
             break;
 
         default:
-            bgc_printf(BV_ERROR, "Invalid type specifier for scan_value ... Exiting\n");
+            bgc_printf(BV_ERROR, "Invalid type specifier for scan_value\n");
             ok=0;
     }
     return(!ok);
@@ -127,7 +159,7 @@ int scan_open (file ini,file *target,char mode)
 
 	if (scan_value(ini,target->name,'s'))
 	{
-		bgc_printf(BV_ERROR, "Error reading filename from %s... Exiting\n",ini.name);
+		bgc_printf(BV_ERROR, "Error reading filename from %s\n",ini.name);
 		ok=0;
 	}
 	if (ok)
@@ -1,6 +1,6 @@
 /* 
 met_init.c
-open met file for input, scan through header lines
+open met file for input, read the number of header lines
 
 *-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
 Biome-BGC version 4.2 (final release)
@@ -13,10 +13,8 @@ See copyright.txt for Copyright information
 int met_init(file init, point_struct* point)
 {
 	int ok = 1;
-	int nhead,i;
 	char key1[] = "MET_INPUT";
 	char keyword[80];
-	char junk_head[1024];
 
 	/********************************************************************
 	**                                                                 **
@@ -44,22 +42,13 @@ int met_init(file init, point_struct* point)
 		ok=0;
 	}
 	
-	/* get number of metfile header lines */
-	if (ok && scan_value(init, &nhead, 'i'))
+	/* get number of metfile header lines, which are skipped when the
+	met file is read by met_parse() */
+	if (ok && scan_value(init, &point->nhead, 'i'))
 	{
 		bgc_printf(BV_ERROR, "Error reading number of met file header lines: met_init()\n");
 		ok=0;
 	}
-	
-	/* read header lines from input met data file and discard */
-	for (i=0 ; ok && i<nhead ; i++)
-	{
-		if (scan_value(point->metf, junk_head, 's'))
-		{
-			bgc_printf(BV_ERROR, "Error reading met file header line #%d\n",i+1);
-			ok=0;
-		}
-	}
 
 	return (!ok);
 }
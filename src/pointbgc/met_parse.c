@@ -0,0 +1,399 @@
+/*
+met_parse.c
+read the daily values of an MTCLIM text met file
+
+The whole file is read into memory and parsed line by line, with a
+number parser that handles the plain decimal numbers of MTCLIM output
+directly and passes anything else to strtod(). Files of more than a few
+MB are split into chunks of whole lines that are parsed on separate
+threads. Each data line has the nine MTCLIM v4.1 / v4.3 columns:
+
+year  yday  Tmax  Tmin  Tday  prcp  VPD  srad  daylen
+
+Blank lines are skipped. An error gives the line and column in the file.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
+#include <unistd.h>
+#include "pointbgc.h"
+
+/* fields on each data line */
+#define MET_NFIELDS 9
+/* smallest part of a file worth a thread of its own (bytes) */
+#define MET_CHUNK_MIN (1L << 20)
+
+/* parse errors */
+#define MET_ERR_NONE    0
+#define MET_ERR_NUMBER  1       /* field is not a number */
+#define MET_ERR_FEW     2       /* fewer than MET_NFIELDS fields */
+#define MET_ERR_MANY    3       /* more than MET_NFIELDS fields */
+
+/* one chunk of whole lines, parsed by one thread */
+typedef struct
+{
+	const char* start;         /* first byte of the chunk */
+	const char* end;           /* byte after the chunk */
+	int nlines;                /* lines in the chunk, including blank ones */
+	int ndata;                 /* data lines in the chunk */
+	int line0;                 /* file line number of the first line */
+	int day0;                  /* day index of the first data line */
+	metdata_struct* md;        /* where the days go */
+	int err;                   /* first error in the chunk */
+	int errline;               /* file line number of the error */
+	int errcol;                /* column of the error */
+} met_chunk_struct;
+
+/* exact powers of ten, for the direct conversion */
+static const double met_pow10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* parse the number in s, up to end, which is the end of its field.
+Plain decimal numbers with up to 19 significant digits and a small
+enough exponent are converted directly: the digits make an exact
+integer below 2^53 and the power of ten is exact, so one multiply or
+divide gives the correctly rounded value, the same as strtod().
+Everything else goes to strtod(). */
+static int met_number(const char* s, const char* end, double* v)
+{
+	const char* p = s;
+	unsigned long long mant = 0;
+	int ndig = 0, nfrac = 0, nseen = 0, exp10 = 0, expv = 0, expneg = 0;
+	int neg = 0, fast = 1;
+	char tok[64];
+	char* tend;
+
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		neg = (*p == '-');
+		p++;
+	}
+	while (p < end && *p >= '0' && *p <= '9')
+	{
+		if (mant || *p != '0')
+		{
+			if (ndig < 19) mant = mant * 10 + (*p - '0');
+			else fast = 0;
+			ndig++;
+		}
+		nseen++;
+		p++;
+	}
+	if (p < end && *p == '.')
+	{
+		p++;
+		while (p < end && *p >= '0' && *p <= '9')
+		{
+			if (mant || *p != '0')
+			{
+				if (ndig < 19) mant = mant * 10 + (*p - '0');
+				else fast = 0;
+				ndig++;
+			}
+			nfrac++;
+			nseen++;
+			p++;
+		}
+	}
+	/* at least one digit before the exponent */
+	if (!nseen) fast = 0;
+	if (fast && p < end && (*p == 'e' || *p == 'E'))
+	{
+		p++;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			expneg = (*p == '-');
+			p++;
+		}
+		if (p == end || *p < '0' || *p > '9') fast = 0;
+		while (fast && p < end && *p >= '0' && *p <= '9')
+		{
+			if (expv < 10000) expv = expv * 10 + (*p - '0');
+			p++;
+		}
+		if (expneg) expv = -expv;
+	}
+	exp10 = expv - nfrac;
+
+	if (fast && p == end && mant < (1ULL << 53) && exp10 >= -22 && exp10 <= 22)
+	{
+		if (exp10 >= 0) *v = (double) mant * met_pow10[exp10];
+		else *v = (double) mant / met_pow10[-exp10];
+		if (neg) *v = -*v;
+		return (0);
+	}
+
+	/* anything else: the whole field must be a number to strtod() */
+	if (end - s >= (long) sizeof(tok)) return (1);
+	memcpy(tok, s, end - s);
+	tok[end - s] = '\0';
+	*v = strtod(tok, &tend);
+	return (tend == tok || *tend != '\0');
+}
+
+/* true for the blanks between fields */
+#define MET_BLANK(c) ((c) == ' ' || (c) == '\t' || (c) == '\r' || (c) == '\v' || (c) == '\f')
+
+/* count the lines and the data lines of a chunk */
+static void met_count(met_chunk_struct* ch)
+{
+	const char* p = ch->start;
+	int data;
+
+	ch->nlines = 0;
+	ch->ndata = 0;
+	while (p < ch->end)
+	{
+		data = 0;
+		while (p < ch->end && *p != '\n')
+		{
+			if (!data && !MET_BLANK(*p)) data = 1;
+			p++;
+		}
+		if (p < ch->end) p++;
+		ch->nlines++;
+		ch->ndata += data;
+	}
+}
+
+/* parse the data lines of a chunk, up to day md->ndays */
+static void met_chunk_parse(met_chunk_struct* ch)
+{
+	const char* p = ch->start;
+	const char* line;
+	const char* f;
+	int nline = ch->line0;
+	int day = ch->day0;
+	int nf;
+	double v[MET_NFIELDS];
+	metdata_struct* md = ch->md;
+
+	ch->err = MET_ERR_NONE;
+	while (p < ch->end && day < md->ndays)
+	{
+		line = p;
+		nf = 0;
+		while (p < ch->end && *p != '\n')
+		{
+			while (p < ch->end && MET_BLANK(*p)) p++;
+			if (p == ch->end || *p == '\n') break;
+			f = p;
+			while (p < ch->end && *p != '\n' && !MET_BLANK(*p)) p++;
+			if (nf == MET_NFIELDS)
+			{
+				ch->err = MET_ERR_MANY;
+				ch->errcol = (int)(f - line) + 1;
+				break;
+			}
+			if (met_number(f, p, &v[nf]))
+			{
+				ch->err = MET_ERR_NUMBER;
+				ch->errcol = (int)(f - line) + 1;
+				break;
+			}
+			nf++;
+		}
+		if (!ch->err && nf && nf < MET_NFIELDS)
+		{
+			ch->err = MET_ERR_FEW;
+			ch->errcol = (int)(p - line) + 1;
+		}
+		if (ch->err)
+		{
+			ch->errline = nline;
+			return;
+		}
+		if (nf)
+		{
+			/* year, yday and Tday are not used */
+			md->tmax[day] = v[2];
+			md->tmin[day] = v[3];
+			md->prcp[day] = v[5];
+			md->vpd[day] = v[6];
+			md->swavgfd[day] = v[7];
+			md->dayl[day] = v[8];
+			day++;
+		}
+		if (p < ch->end) p++;
+		nline++;
+	}
+}
+
+static void* met_count_thread(void* arg)
+{
+	met_count((met_chunk_struct*) arg);
+	return NULL;
+}
+
+static void* met_parse_thread(void* arg)
+{
+	met_chunk_parse((met_chunk_struct*) arg);
+	return NULL;
+}
+
+/* run fn on each chunk, on a thread each when there is more than one.
+The first chunk runs here, and so do the rest in turn if a thread
+cannot be started. */
+static void met_chunks_run(met_chunk_struct* ch, int nch, void* (*fn)(void*))
+{
+	int i, nstart = 0;
+	pthread_t threads[64];
+
+	for (i=1 ; i<nch ; i++)
+	{
+		if (pthread_create(&threads[i], NULL, fn, &ch[i])) break;
+		nstart++;
+	}
+	fn(&ch[0]);
+	for (i=1 ; i<=nstart ; i++) pthread_join(threads[i], NULL);
+	for (i=nstart+1 ; i<nch ; i++) fn(&ch[i]);
+}
+
+/* read the met file metf, open and positioned at its start, skipping
+nhead header lines. With ndays > 0 the first ndays days are read, and a
+file with fewer is an error; with ndays 0 all of the days are read. The
+arrays in md are allocated here, and freed with metdata_free(). */
+int met_parse(file metf, int nhead, int ndays, metdata_struct* md)
+{
+	int ok = 1;
+	int i, nch = 0, nhdr, line0, ndata;
+	long size = 0, nthreads;
+	char* buf = NULL;
+	const char* p;
+	const char* end;
+	met_chunk_struct ch[64];
+	met_chunk_struct* ech = NULL;
+
+	memset(md, 0, sizeof(metdata_struct));
+
+	/* the whole file */
+	if (fseek(metf.ptr, 0L, SEEK_END) || (size = ftell(metf.ptr)) < 0 ||
+		fseek(metf.ptr, 0L, SEEK_SET))
+	{
+		bgc_printf(BV_ERROR, "Error finding the size of met file %s: met_parse()\n",metf.name);
+		ok=0;
+	}
+	if (ok && !(buf = (char*) malloc(size + 1)))
+	{
+		bgc_printf(BV_ERROR, "Error allocating %ld bytes for met file %s: met_parse()\n",size+1,metf.name);
+		ok=0;
+	}
+	if (ok && (long) fread(buf, 1, size, metf.ptr) != size)
+	{
+		bgc_printf(BV_ERROR, "Error reading met file %s: met_parse()\n",metf.name);
+		ok=0;
+	}
+	if (ok) buf[size] = '\0';
+
+	/* header lines. As when they were read with scan_value(), blank
+	lines do not count. */
+	p = buf;
+	end = buf + size;
+	line0 = 1;
+	for (nhdr=0 ; ok && nhdr<nhead ; )
+	{
+		while (p < end && MET_BLANK(*p)) p++;
+		if (p == end)
+		{
+			bgc_printf(BV_ERROR, "Error reading met file header line #%d\n",nhdr+1);
+			ok=0;
+			break;
+		}
+		if (*p != '\n') nhdr++;
+		while (p < end && *p != '\n') p++;
+		if (p < end) p++;
+		line0++;
+	}
+
+	/* split the rest into chunks of whole lines, one per thread */
+	if (ok)
+	{
+		nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+		if (nthreads > (end - p) / MET_CHUNK_MIN) nthreads = (end - p) / MET_CHUNK_MIN;
+		if (nthreads > 64) nthreads = 64;
+		if (nthreads < 1) nthreads = 1;
+		nch = (int) nthreads;
+		for (i=0 ; i<nch ; i++)
+		{
+			ch[i].start = (i == 0) ? p : ch[i-1].end;
+			if (i == nch - 1) ch[i].end = end;
+			else
+			{
+				ch[i].end = p + (end - p) * (i + 1) / nch;
+				if (ch[i].end < ch[i].start) ch[i].end = ch[i].start;
+				while (ch[i].end < end && ch[i].end[-1] != '\n') ch[i].end++;
+			}
+			ch[i].md = md;
+		}
+
+		/* count the days in each chunk, to place them in the arrays */
+		met_chunks_run(ch, nch, met_count_thread);
+		ndata = 0;
+		for (i=0 ; i<nch ; i++)
+		{
+			ch[i].line0 = line0;
+			ch[i].day0 = ndata;
+			line0 += ch[i].nlines;
+			ndata += ch[i].ndata;
+		}
+		if (ndays > 0 && ndata < ndays)
+		{
+			bgc_printf(BV_ERROR, "Error: met file %s has %d days, %d needed: met_parse()\n",
+				metf.name, ndata, ndays);
+			ok=0;
+		}
+		md->ndays = (ndays > 0) ? ndays : ndata;
+	}
+
+	if (ok && (!(md->tmax = (double*) malloc(md->ndays * sizeof(double))) ||
+		!(md->tmin = (double*) malloc(md->ndays * sizeof(double))) ||
+		!(md->prcp = (double*) malloc(md->ndays * sizeof(double))) ||
+		!(md->vpd = (double*) malloc(md->ndays * sizeof(double))) ||
+		!(md->swavgfd = (double*) malloc(md->ndays * sizeof(double))) ||
+		!(md->dayl = (double*) malloc(md->ndays * sizeof(double)))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating for %d days of met file %s: met_parse()\n",
+			md->ndays, metf.name);
+		ok=0;
+	}
+
+	/* parse, and report the first error in the file */
+	if (ok) met_chunks_run(ch, nch, met_parse_thread);
+	for (i=0 ; ok && i<nch && !ech ; i++)
+	{
+		if (ch[i].err) ech = &ch[i];
+	}
+	if (ech)
+	{
+		bgc_printf(BV_ERROR, "Error in met file %s, line %d, column %d: %s\n",
+			metf.name, ech->errline, ech->errcol,
+			ech->err == MET_ERR_NUMBER ? "expected a number" :
+			ech->err == MET_ERR_FEW ? "too few fields, expected 9" :
+			"too many fields, expected 9");
+		ok=0;
+	}
+
+	free(buf);
+	if (!ok) metdata_free(md);
+
+	return (!ok);
+}
+
+/* free the arrays of a metdata_struct */
+void metdata_free(metdata_struct* md)
+{
+	free(md->tmax);
+	free(md->tmin);
+	free(md->prcp);
+	free(md->vpd);
+	free(md->swavgfd);
+	free(md->dayl);
+	memset(md, 0, sizeof(metdata_struct));
+}
@@ -0,0 +1,236 @@
+/*
+met_represent.c
+pick a small weighted set of representative years from the met record,
+for a fast spinup that cycles through them instead of the whole record
+
+Each met year is described by the mean air temperature, VPD and
+shortwave radiation and the total precipitation of each quarter of the
+year, the drivers of productivity and decomposition and their timing.
+The set is a multiset of nrep years, so a year that stands for several
+others appears several times (its weight). It is chosen to match the mean and the standard deviation
+across years of each driver in the full record: a greedy start from the
+year nearest the mean, then swaps of single years while they improve
+the match.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#include "pointbgc.h"
+
+/* drivers, for each quarter of the year */
+#define NREPQ 4
+#define NREPVAR (4 * NREPQ)
+static const char* repvar_names[4] = {
+	"Tavg (deg C)", "prcp (cm)", "VPD (Pa)", "srad (W/m2)"
+};
+
+/* most passes of single-year swaps */
+#define REP_MAXPASS 100
+
+/* mismatch of the standardized drivers of the years in set[0..n-1]
+to the full record, which has mean 0 and sd 1 for each driver */
+static double rep_mismatch(const double* z, const int* set, int n)
+{
+	int i, j;
+	double sum, sumsq, mean, sd, e = 0.0;
+
+	for (j=0 ; j<NREPVAR ; j++)
+	{
+		sum = sumsq = 0.0;
+		for (i=0 ; i<n ; i++)
+		{
+			sum += z[set[i]*NREPVAR + j];
+			sumsq += z[set[i]*NREPVAR + j] * z[set[i]*NREPVAR + j];
+		}
+		mean = sum / n;
+		sd = sumsq / n - mean * mean;
+		sd = (sd > 0.0) ? sqrt(sd) : 0.0;
+		e += mean * mean + (sd - 1.0) * (sd - 1.0);
+	}
+
+	return (e);
+}
+
+static int rep_compare(const void* a, const void* b)
+{
+	return (*(const int*)a - *(const int*)b);
+}
+
+/* build in rep the met arrays of nrep representative years of the
+metyears years in metarr, in the order they have in the record. years,
+if not NULL, gets the index in the record of each of them. The arrays
+of rep are allocated here from arena or, if it is NULL, with malloc(),
+and then freed with metarr_free(rep, NULL). */
+int met_represent(const metarr_struct* metarr, int metyears, int nrep,
+metarr_struct* rep, int* years, arena_struct* arena)
+{
+	int ok = 1;
+	int i, j, q, y, d, pass, best, changed, nsame;
+	int qstart[NREPQ+1] = {0, 91, 182, 273, 365};
+	int* set = NULL;
+	double* f = NULL;
+	double* z = NULL;
+	double mean[NREPVAR], sd[NREPVAR], rmean, rsd;
+	double e, ebest, ecur;
+
+	if (nrep < 1 || nrep > metyears)
+	{
+		bgc_printf(BV_ERROR, "Error: %d representative years asked for, the met record has %d: met_represent()\n",
+			nrep, metyears);
+		ok=0;
+	}
+	if (ok && (!(set = (int*) malloc(nrep * sizeof(int))) ||
+		!(f = (double*) calloc(metyears * NREPVAR, sizeof(double))) ||
+		!(z = (double*) malloc(metyears * NREPVAR * sizeof(double)))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating for representative years: met_represent()\n");
+		ok=0;
+	}
+
+	/* quarterly drivers of each year, and their mean and sd across
+	years */
+	for (y=0 ; ok && y<metyears ; y++)
+	{
+		for (q=0 ; q<NREPQ ; q++)
+		{
+			for (d=y*365+qstart[q] ; d<y*365+qstart[q+1] ; d++)
+			{
+				f[y*NREPVAR + 4*q + 0] += metarr->tavg[d];
+				f[y*NREPVAR + 4*q + 1] += metarr->prcp[d];
+				f[y*NREPVAR + 4*q + 2] += metarr->vpd[d];
+				f[y*NREPVAR + 4*q + 3] += metarr->swavgfd[d];
+			}
+			f[y*NREPVAR + 4*q + 0] /= qstart[q+1] - qstart[q];
+			f[y*NREPVAR + 4*q + 2] /= qstart[q+1] - qstart[q];
+			f[y*NREPVAR + 4*q + 3] /= qstart[q+1] - qstart[q];
+		}
+	}
+	for (j=0 ; ok && j<NREPVAR ; j++)
+	{
+		mean[j] = sd[j] = 0.0;
+		for (y=0 ; y<metyears ; y++) mean[j] += f[y*NREPVAR + j] / metyears;
+		for (y=0 ; y<metyears ; y++)
+		{
+			sd[j] += (f[y*NREPVAR + j] - mean[j]) * (f[y*NREPVAR + j] - mean[j]) / metyears;
+		}
+		sd[j] = sqrt(sd[j]);
+		/* a driver that is the same every year has nothing to match */
+		for (y=0 ; y<metyears ; y++)
+		{
+			z[y*NREPVAR + j] = (sd[j] > 0.0) ? (f[y*NREPVAR + j] - mean[j]) / sd[j] : 0.0;
+		}
+	}
+
+	/* greedy start: each year in turn is the one that best matches the
+	record together with those already chosen */
+	for (i=0 ; ok && i<nrep ; i++)
+	{
+		best = 0;
+		ebest = 0.0;
+		for (y=0 ; y<metyears ; y++)
+		{
+			set[i] = y;
+			e = rep_mismatch(z, set, i+1);
+			if (y == 0 || e < ebest)
+			{
+				best = y;
+				ebest = e;
+			}
+		}
+		set[i] = best;
+	}
+
+	/* swap single years while the match improves */
+	ecur = ok ? rep_mismatch(z, set, nrep) : 0.0;
+	for (pass=0, changed=1 ; ok && changed && pass<REP_MAXPASS ; pass++)
+	{
+		changed = 0;
+		for (i=0 ; i<nrep ; i++)
+		{
+			best = set[i];
+			ebest = ecur;
+			for (y=0 ; y<metyears ; y++)
+			{
+				set[i] = y;
+				e = rep_mismatch(z, set, nrep);
+				if (e < ebest - 1e-12)
+				{
+					best = y;
+					ebest = e;
+				}
+			}
+			set[i] = best;
+			if (ebest < ecur)
+			{
+				ecur = ebest;
+				changed = 1;
+			}
+		}
+	}
+
+	/* the met arrays of the chosen years, in record order */
+	if (ok)
+	{
+		qsort(set, nrep, sizeof(int), rep_compare);
+		if (metarr_alloc(rep, nrep, arena))
+		{
+			bgc_printf(BV_ERROR, "Error in call to metarr_alloc() from met_represent()\n");
+			ok=0;
+		}
+	}
+	for (i=0 ; ok && i<nrep ; i++)
+	{
+		for (d=0 ; d<365 ; d++)
+		{
+			rep->tmax[i*365 + d] = metarr->tmax[set[i]*365 + d];
+			rep->tmin[i*365 + d] = metarr->tmin[set[i]*365 + d];
+			rep->prcp[i*365 + d] = metarr->prcp[set[i]*365 + d];
+			rep->vpd[i*365 + d] = metarr->vpd[set[i]*365 + d];
+			rep->swavgfd[i*365 + d] = metarr->swavgfd[set[i]*365 + d];
+			rep->par[i*365 + d] = metarr->par[set[i]*365 + d];
+			rep->dayl[i*365 + d] = metarr->dayl[set[i]*365 + d];
+			rep->tavg[i*365 + d] = metarr->tavg[set[i]*365 + d];
+		}
+		if (years) years[i] = set[i];
+	}
+	if (ok && run_avg(rep->tavg, rep->tavg_ra, nrep*365, 11, 1))
+	{
+		bgc_printf(BV_ERROR, "Error: run_avg() in met_represent()\n");
+		ok=0;
+	}
+
+	/* report the chosen years with their weights, and how well each
+	driver is matched */
+	if (ok)
+	{
+		bgc_printf(BV_PROGRESS, "Spinup on %d representative met years of %d (record year, weight):\n",
+			nrep, metyears);
+		for (i=0 ; i<nrep ; i+=nsame)
+		{
+			for (nsame=1 ; i+nsame<nrep && set[i+nsame]==set[i] ; nsame++);
+			bgc_printf(BV_PROGRESS, "  %d x%d\n", set[i]+1, nsame);
+		}
+		bgc_printf(BV_PROGRESS, "%-17s %10s %10s %10s %10s\n", "driver", "mean", "rep mean", "sd", "rep sd");
+		for (j=0 ; j<NREPVAR ; j++)
+		{
+			rmean = rsd = 0.0;
+			for (i=0 ; i<nrep ; i++) rmean += f[set[i]*NREPVAR + j] / nrep;
+			for (i=0 ; i<nrep ; i++)
+			{
+				rsd += (f[set[i]*NREPVAR + j] - rmean) * (f[set[i]*NREPVAR + j] - rmean) / nrep;
+			}
+			rsd = sqrt(rsd);
+			bgc_printf(BV_PROGRESS, "Q%d %-14s %10.3f %10.3f %10.3f %10.3f\n", j/4+1, repvar_names[j%4],
+				mean[j], rmean, sd[j], rsd);
+		}
+	}
+
+	free(set);
+	free(f);
+	free(z);
+
+	return (!ok);
+}
@@ -29,123 +29,282 @@ daylength   s      (daylight duration)
 
 */
 
-int metarr_init(file metf, metarr_struct* metarr, const climchange_struct* scc,
-int nyears) 
+int metarr_init(file metf, int nhead, metarr_struct* metarr,
+const climchange_struct* scc, int nyears, arena_struct* arena)
 {
 	int ok = 1;
 	int i;
 	int ndays;
-	int year;
-	double tmax,tmin,prcp,vpd,swavgfd,dayl;
+	metdata_struct md;
+	
+	ndays = 365 * nyears;
+
+	/* read the met file */
+	if (met_parse(metf, nhead, ndays, &md))
+	{
+		bgc_printf(BV_ERROR, "Error in call to met_parse() from metarr_init()\n");
+		ok=0;
+	}
+
+	/* allocate space for the metv arrays */
+	if (ok && metarr_alloc(metarr, nyears, arena))
+	{
+		bgc_printf(BV_ERROR, "Error in call to metarr_alloc() from metarr_init()\n");
+		ok=0;
+	}
+	
+	/* store the days, with the climate change scenario applied */
+	for (i=0 ; ok && i<ndays ; i++)
+	{
+		metarr_set_day(metarr, i, scc, md.tmax[i], md.tmin[i], md.prcp[i],
+			md.vpd[i], md.swavgfd[i], md.dayl[i]);
+	}
+	metdata_free(&md);
+
+	/* perform running averages of daily average temperature for 
+	use in soil temperature routine. 
+
+	This implementation uses a linearly ramped 11-day running average 
+	of daily mean air temperature, with days 1-10 based on a 1-10 day
+	running average, respectively. 
+	*/
+	
+	if (ok && run_avg(metarr->tavg, metarr->tavg_ra, ndays, 11, 1))
+	{
+		bgc_printf(BV_ERROR, "Error: run_avg() in metv_init.c \n");
+		ok = 0;
+	}
+	
+	return (!ok);
+}
+
+/* allocate the metarr arrays for nyears of daily data, from arena or,
+if it is NULL, with malloc() */
+int metarr_alloc(metarr_struct* metarr, int nyears, arena_struct* arena)
+{
+	int ok = 1;
+	int ndays;
 	
 	ndays = 365 * nyears;
 
 	/* allocate space for the metv arrays */
-	if (ok && !(metarr->tmax = (double*) malloc(ndays * sizeof(double))))
+	if (ok && !(metarr->tmax = (double*) arena_alloc(arena, ndays * sizeof(double))))
 	{
 		bgc_printf(BV_ERROR, "Error allocating for tmax array\n");
 		ok=0;
 	}
-	if (ok && !(metarr->tmin = (double*) malloc(ndays * sizeof(double))))
+	if (ok && !(metarr->tmin = (double*) arena_alloc(arena, ndays * sizeof(double))))
 	{
 		bgc_printf(BV_ERROR, "Error allocating for tmin array\n");
 		ok=0;
 	}
-	if (ok && !(metarr->prcp = (double*) malloc(ndays * sizeof(double))))
+	if (ok && !(metarr->prcp = (double*) arena_alloc(arena, ndays * sizeof(double))))
 	{
 		bgc_printf(BV_ERROR, "Error allocating for prcp array\n");
 		ok=0;
 	}
-	if (ok && !(metarr->vpd = (double*) malloc(ndays * sizeof(double))))
+	if (ok && !(metarr->vpd = (double*) arena_alloc(arena, ndays * sizeof(double))))
 	{
 		bgc_printf(BV_ERROR, "Error allocating for vpd array\n");
 		ok=0;
 	}
-	if (ok && !(metarr->tavg = (double*) malloc(ndays * sizeof(double))))
+	if (ok && !(metarr->tavg = (double*) arena_alloc(arena, ndays * sizeof(double))))
 	{
 		bgc_printf(BV_ERROR, "Error allocating for tavg array\n");
 		ok=0;
 	}
-	if (ok && !(metarr->tavg_ra = (double*) malloc(ndays * sizeof(double))))
+	if (ok && !(metarr->tavg_ra = (double*) arena_alloc(arena, ndays * sizeof(double))))
 	{
 		bgc_printf(BV_ERROR, "Error allocating for tavg_ra array\n");
 		ok=0;
 	}
-	if (ok && !(metarr->swavgfd = (double*) malloc(ndays * sizeof(double))))
+	if (ok && !(metarr->swavgfd = (double*) arena_alloc(arena, ndays * sizeof(double))))
 	{
 		bgc_printf(BV_ERROR, "Error allocating for swavgfd array\n");
 		ok=0;
 	}
-	if (ok && !(metarr->par = (double*) malloc(ndays * sizeof(double))))
+	if (ok && !(metarr->par = (double*) arena_alloc(arena, ndays * sizeof(double))))
 	{
 		bgc_printf(BV_ERROR, "Error allocating for par array\n");
 		ok=0;
 	}
-	if (ok && !(metarr->dayl = (double*) malloc(ndays * sizeof(double))))
+	if (ok && !(metarr->dayl = (double*) arena_alloc(arena, ndays * sizeof(double))))
 	{
 		bgc_printf(BV_ERROR, "Error allocating for dayl array\n");
 		ok=0;
 	}
 	
-	/* begin daily loop: read input file, generate array values */
+	return (!ok);
+}
+
+/* store one day of basic met data in element i of the metarr arrays,
+applying the climate change scenario and deriving tavg and par. The
+running average tavg_ra is left to the caller, once all days are set. */
+int metarr_set_day(metarr_struct* metarr, int i, const climchange_struct* scc,
+double tmax, double tmin, double prcp, double vpd, double swavgfd, double dayl)
+{
+	/* Fixed 02/05/04 */
+	if( swavgfd < 0.0 )
+	{
+		swavgfd = 0.0;
+	}
+
+	if( dayl < 0.0 )
+	{
+		dayl = 0.0;
+	}
+	
+	/* apply the climate change scenario and store */
+	metarr->tmax[i] = tmax + scc->s_tmax;
+	metarr->tmin[i] = tmin + scc->s_tmin;
+	metarr->prcp[i] = prcp * scc->s_prcp;
+	metarr->vpd[i] = vpd * scc->s_vpd;
+	metarr->swavgfd[i] = swavgfd * scc->s_swavgfd;
+	metarr->par[i] = swavgfd * RAD2PAR * scc->s_swavgfd;
+	metarr->dayl[i] = dayl;
+	metarr->tavg[i] = (metarr->tmax[i] + metarr->tmin[i]) / 2.0;
+
+	return (0);
+}
+
+/* build the metarr arrays from met data that a host program has already
+read, in the same way as metarr_init() builds them from the met file */
+int metarr_shared_init(const point_shared_struct* shared, metarr_struct* metarr,
+const climchange_struct* scc, int nyears, arena_struct* arena)
+{
+	int ok = 1;
+	int i;
+	int ndays;
+	
+	ndays = 365 * nyears;
+	
+	if (shared->ndays < ndays)
+	{
+		bgc_printf(BV_ERROR, "Error: shared met has %d days, %d needed: metarr_shared_init()\n",
+			shared->ndays, ndays);
+		ok=0;
+	}
+	if (ok && metarr_alloc(metarr, nyears, arena))
+	{
+		bgc_printf(BV_ERROR, "Error in call to metarr_alloc() from metarr_shared_init()\n");
+		ok=0;
+	}
 	for (i=0 ; ok && i<ndays ; i++)
 	{
-		/* read year field  */
-		if (fscanf(metf.ptr,"%d",&year)==EOF)
+		metarr_set_day(metarr, i, scc, shared->tmax[i], shared->tmin[i],
+			shared->prcp[i], shared->vpd[i], shared->swavgfd[i], shared->dayl[i]);
+	}
+	if (ok && run_avg(metarr->tavg, metarr->tavg_ra, ndays, 11, 1))
+	{
+		bgc_printf(BV_ERROR, "Error: run_avg() in metarr_shared_init()\n");
+		ok = 0;
+	}
+	
+	return (!ok);
+}
+
+/* build the metarr arrays of a climate change scenario from unperturbed
+arrays in base (built with no change). A variable that the scenario
+leaves as it is shares the array in base, and only the changed variables
+get arrays of their own. tavg and tavg_ra are computed again only when
+one of the temperatures changes. Without an arena, release with
+metarr_free(metarr, base). */
+int metarr_derive(const metarr_struct* base, metarr_struct* metarr,
+const climchange_struct* scc, int nyears, arena_struct* arena)
+{
+	int ok = 1;
+	int i;
+	int ndays;
+	
+	ndays = 365 * nyears;
+
+	/* start with every array shared */
+	*metarr = *base;
+
+	if (scc->s_tmax != 0.0)
+	{
+		if (!(metarr->tmax = (double*) arena_alloc(arena, ndays * sizeof(double))))
 		{
-			bgc_printf(BV_ERROR, "Error reading year field: metarr_init()\n");
+			bgc_printf(BV_ERROR, "Error allocating for tmax array: metarr_derive()\n");
 			ok=0;
 		}
-		/* read tmax, tmin, prcp, vpd, and srad */
-		/* the following scan statement discards the tday field in the
-		standard MTCLIM version 3.1 input file */
-		if (ok && fscanf(metf.ptr,"%*d%lf%lf%*lf%lf%lf%lf",&tmax,&tmin,&prcp,&vpd,&swavgfd)==EOF)
+		for (i=0 ; ok && i<ndays ; i++) metarr->tmax[i] = base->tmax[i] + scc->s_tmax;
+	}
+	if (ok && scc->s_tmin != 0.0)
+	{
+		if (!(metarr->tmin = (double*) arena_alloc(arena, ndays * sizeof(double))))
 		{
-			bgc_printf(BV_ERROR, "Error reading met file, metarr_init()\n");
+			bgc_printf(BV_ERROR, "Error allocating for tmin array: metarr_derive()\n");
 			ok=0;
 		}
-		/* read daylength */
-		if (ok && fscanf(metf.ptr,"%lf",&dayl)==EOF)
+		for (i=0 ; ok && i<ndays ; i++) metarr->tmin[i] = base->tmin[i] + scc->s_tmin;
+	}
+	if (ok && scc->s_prcp != 1.0)
+	{
+		if (!(metarr->prcp = (double*) arena_alloc(arena, ndays * sizeof(double))))
 		{
-			bgc_printf(BV_ERROR, "Error reading met file, metv_init()\n");
+			bgc_printf(BV_ERROR, "Error allocating for prcp array: metarr_derive()\n");
 			ok=0;
 		}
-
-		/* Fixed 02/05/04 */
-		if( swavgfd < 0.0 )
+		for (i=0 ; ok && i<ndays ; i++) metarr->prcp[i] = base->prcp[i] * scc->s_prcp;
+	}
+	if (ok && scc->s_vpd != 1.0)
+	{
+		if (!(metarr->vpd = (double*) arena_alloc(arena, ndays * sizeof(double))))
 		{
-			swavgfd = 0.0;
+			bgc_printf(BV_ERROR, "Error allocating for vpd array: metarr_derive()\n");
+			ok=0;
 		}
-
-		if( dayl < 0.0 )
+		for (i=0 ; ok && i<ndays ; i++) metarr->vpd[i] = base->vpd[i] * scc->s_vpd;
+	}
+	if (ok && scc->s_swavgfd != 1.0)
+	{
+		if (!(metarr->swavgfd = (double*) arena_alloc(arena, ndays * sizeof(double))) ||
+			!(metarr->par = (double*) arena_alloc(arena, ndays * sizeof(double))))
 		{
-			dayl = 0.0;
+			bgc_printf(BV_ERROR, "Error allocating for swavgfd and par arrays: metarr_derive()\n");
+			ok=0;
+		}
+		for (i=0 ; ok && i<ndays ; i++)
+		{
+			metarr->swavgfd[i] = base->swavgfd[i] * scc->s_swavgfd;
+			metarr->par[i] = base->par[i] * scc->s_swavgfd;
 		}
-		
-		/* apply the climate change scenario and store */
-		metarr->tmax[i] = tmax + scc->s_tmax;
-		metarr->tmin[i] = tmin + scc->s_tmin;
-		metarr->prcp[i] = prcp * scc->s_prcp;
-		metarr->vpd[i] = vpd * scc->s_vpd;
-		metarr->swavgfd[i] = swavgfd * scc->s_swavgfd;
-		metarr->par[i] = swavgfd * RAD2PAR * scc->s_swavgfd;
-		metarr->dayl[i] = dayl;
-		metarr->tavg[i] = (metarr->tmax[i] + metarr->tmin[i]) / 2.0;
 	}
-
-	/* perform running averages of daily average temperature for 
-	use in soil temperature routine. 
-
-	This implementation uses a linearly ramped 11-day running average 
-	of daily mean air temperature, with days 1-10 based on a 1-10 day
-	running average, respectively. 
-	*/
-	
-	if (ok && run_avg(metarr->tavg, metarr->tavg_ra, ndays, 11, 1))
+	if (ok && (metarr->tmax != base->tmax || metarr->tmin != base->tmin))
 	{
-		bgc_printf(BV_ERROR, "Error: run_avg() in metv_init.c \n");
-		ok = 0;
+		if (!(metarr->tavg = (double*) arena_alloc(arena, ndays * sizeof(double))) ||
+			!(metarr->tavg_ra = (double*) arena_alloc(arena, ndays * sizeof(double))))
+		{
+			bgc_printf(BV_ERROR, "Error allocating for tavg and tavg_ra arrays: metarr_derive()\n");
+			ok=0;
+		}
+		for (i=0 ; ok && i<ndays ; i++)
+		{
+			metarr->tavg[i] = (metarr->tmax[i] + metarr->tmin[i]) / 2.0;
+		}
+		if (ok && run_avg(metarr->tavg, metarr->tavg_ra, ndays, 11, 1))
+		{
+			bgc_printf(BV_ERROR, "Error: run_avg() in metarr_derive()\n");
+			ok = 0;
+		}
 	}
 	
 	return (!ok);
 }
+
+/* free the metarr arrays that are not shared with base, when they were
+allocated without an arena. With base NULL all of the arrays are
+freed. */
+void metarr_free(metarr_struct* metarr, const metarr_struct* base)
+{
+	if (!base || metarr->tmax != base->tmax) free(metarr->tmax);
+	if (!base || metarr->tmin != base->tmin) free(metarr->tmin);
+	if (!base || metarr->prcp != base->prcp) free(metarr->prcp);
+	if (!base || metarr->vpd != base->vpd) free(metarr->vpd);
+	if (!base || metarr->tavg != base->tavg) free(metarr->tavg);
+	if (!base || metarr->tavg_ra != base->tavg_ra) free(metarr->tavg_ra);
+	if (!base || metarr->swavgfd != base->swavgfd) free(metarr->swavgfd);
+	if (!base || metarr->par != base->par) free(metarr->par);
+	if (!base || metarr->dayl != base->dayl) free(metarr->dayl);
+}
@@ -10,7 +10,7 @@ See copyright.txt for Copyright information
 
 #include "pointbgc.h"
 
-int ndep_init(file ndepfile, ndepcontrol_struct* ndepctrl)
+int ndep_init(file ndepfile, ndepcontrol_struct* ndepctrl, arena_struct* arena)
 {
 	int ok = 1,i = 0,reccount = 0;
 	
@@ -18,8 +18,8 @@ int ndep_init(file ndepfile, ndepcontrol_struct* ndepctrl)
 	discard the next line of the ini file */
 	if (file_open(&ndepfile,'r')) 
 	{
-		bgc_printf(BV_ERROR, "Error opening annual NDEP file: %s\n",ndepfile);
-		ok=0;
+		bgc_printf(BV_ERROR, "Error opening annual NDEP file: %s\n",ndepfile.name);
+		return (1);
 	}
 
 	/* Find the number of lines in the file*/
@@ -33,12 +33,12 @@ int ndep_init(file ndepfile, ndepcontrol_struct* ndepctrl)
 	bgc_printf(BV_DIAG,"Found: %i NDEP records in co2_init()\n",reccount);
 	
 	/* allocate space for the annual CO2 array */
-	if (ok && !(ndepctrl->ndep_array = (double*) malloc(reccount * sizeof(double))))
+	if (ok && !(ndepctrl->ndep_array = (double*) arena_alloc(arena, reccount * sizeof(double))))
 	{
 		bgc_printf(BV_ERROR, "Error allocating for annual ndep array, ndep_init()\n");
 		ok=0;
 	}
-	if (ok && !(ndepctrl->ndepyear_array = (int*) malloc(reccount * sizeof(int))))
+	if (ok && !(ndepctrl->ndepyear_array = (int*) arena_alloc(arena, reccount * sizeof(int))))
 	{
 		bgc_printf(BV_ERROR, "Error allocating for annual ndep year array, co2_init()\n");
 		ok=0;
@@ -60,3 +60,15 @@ int ndep_init(file ndepfile, ndepcontrol_struct* ndepctrl)
 	
 	return (!ok);
 }
+
+/* free the annual Ndep arrays read by ndep_init() without an arena */
+void ndep_free(ndepcontrol_struct* ndepctrl)
+{
+	if (ndepctrl->varndep)
+	{
+		free(ndepctrl->ndepyear_array);
+		free(ndepctrl->ndep_array);
+		ndepctrl->ndepyear_array = NULL;
+		ndepctrl->ndep_array = NULL;
+	}
+}
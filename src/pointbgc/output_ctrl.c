@@ -19,7 +19,7 @@ units for annual precipitation as cm/year - the real units are mm/yr.
 
 #include "pointbgc.h"
 
-int output_ctrl(file init, output_struct* output)
+int output_ctrl(file init, output_struct* output, arena_struct* arena)
 {
 	int ok = 1;
 	int i;
@@ -135,7 +135,7 @@ int output_ctrl(file init, output_struct* output)
 		ok=0;
 	}
 	/* allocate space for the daily output variable indices */
-	if (ok && output->ndayout && !(output->daycodes = (int*) malloc(output->ndayout * sizeof(int))))
+	if (ok && output->ndayout && !(output->daycodes = (int*) arena_alloc(arena, output->ndayout * sizeof(int))))
 	{
 		bgc_printf(BV_ERROR, "Error allocating for daycodes array: output_ctrl()\n");
 		ok=0;
@@ -182,7 +182,7 @@ int output_ctrl(file init, output_struct* output)
 		ok=0;
 	}
 	/* allocate space for the annual output variable indices */
-	if (ok && output->nannout && !(output->anncodes = (int*) malloc(output->nannout * sizeof(int))))
+	if (ok && output->nannout && !(output->anncodes = (int*) arena_alloc(arena, output->nannout * sizeof(int))))
 	{
 		bgc_printf(BV_ERROR, "Error allocating for anncodes array: output_ctrl()\n");
 		ok=0;
@@ -199,3 +199,12 @@ int output_ctrl(file init, output_struct* output)
 	
 	return (!ok);
 }
+
+/* free the output code arrays read by output_ctrl() without an arena */
+void output_codes_free(output_struct* output)
+{
+	free(output->daycodes);
+	free(output->anncodes);
+	output->daycodes = NULL;
+	output->anncodes = NULL;
+}
@@ -0,0 +1,412 @@
+/*
+output_diff.c
+tool used to compare the binary outputs of two runs of Biome-BGC, variable
+by variable
+
+Reads the DAILY_OUTPUT or ANNUAL_OUTPUT codes and the first simulation
+year from the ini file that produced the outputs, maps the two output
+files into memory, and reports for each output variable the largest and
+RMS differences, overall and year by year, and the first day on which
+the difference is over tolerance. The tolerances are the same for every
+variable, or are read per variable from a tolerance file. The kind of output is taken from the
+file name:
+	.dayout      daily variables, 365 records per year
+	.monavgout   daily variables, 12 records per year
+	.annavgout   daily variables, 1 record per year
+	.annout      annual variables, 1 record per year
+
+The exit status is 0 when no value is over tolerance, 1 when some are,
+and 2 when the inputs cannot be read.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#define _POSIX_C_SOURCE 200809L
+#include "bgc.h"
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define VARLABEL 40
+
+/* one output variable, with its statistics */
+typedef struct
+{
+	int code;
+	char label[VARLABEL];
+	double maxabs;
+	double maxrel;
+	double sumsq;
+	long nover;
+	long first;                 /* first record over tolerance, -1 = none */
+	double abstol;
+	double reltol;
+	double* ymax;               /* per year largest difference */
+	double* ysumsq;             /* per year sum of squared differences */
+} diffvar_struct;
+
+typedef struct
+{
+	int nvar;
+	int peryear;                /* records per year */
+	int firstyear;
+	diffvar_struct* var;
+} diffout_struct;
+
+/* read the first word of each line of the ini file until keyword is
+found, leaving the file at the next line */
+static int diff_find(FILE* fp, const char* keyword)
+{
+	char line[256], word[128];
+
+	rewind(fp);
+	while (fgets(line, sizeof(line), fp))
+	{
+		if (sscanf(line, "%127s", word) == 1 && !strcmp(word, keyword)) return 0;
+	}
+	return 1;
+}
+
+/* read the output codes of one block of the ini file. The rest of each
+line, less the column index that the shipped ini files put first, is
+used as the variable label. */
+static int diff_codes(FILE* fp, const char* keyword, diffout_struct* out)
+{
+	int ok = 1;
+	int i, n, idx;
+	char line[256];
+	char* p;
+
+	if (diff_find(fp, keyword) || !fgets(line, sizeof(line), fp) ||
+		sscanf(line, "%d", &out->nvar) != 1 || out->nvar <= 0)
+	{
+		printf("Can't read the number of variables in the %s block\n", keyword);
+		ok=0;
+	}
+	if (ok && !(out->var = (diffvar_struct*) calloc(out->nvar, sizeof(diffvar_struct))))
+	{
+		printf("Error allocating for %d variables\n", out->nvar);
+		ok=0;
+	}
+	for (i=0 ; ok && i<out->nvar ; i++)
+	{
+		if (!fgets(line, sizeof(line), fp) || sscanf(line, "%d%n", &out->var[i].code, &n) != 1)
+		{
+			printf("Can't read output code %d in the %s block\n", i, keyword);
+			ok=0;
+		}
+		else
+		{
+			p = line + n;
+			if (sscanf(p, "%d%n", &idx, &n) == 1 && idx == i) p += n;
+			p += strspn(p, " \t");
+			p[strcspn(p, "\r\n")] = '\0';
+			if (*p) snprintf(out->var[i].label, VARLABEL, "%s", p);
+			else snprintf(out->var[i].label, VARLABEL, "code %d", out->var[i].code);
+		}
+	}
+
+	return (!ok);
+}
+
+/* read per variable tolerances. Each line is an output code, or * for
+the codes not listed, followed by the absolute and relative tolerances.
+Lines that start with anything else are skipped, so one file can also
+hold the tolerances of other tools. */
+static int diff_tolerance(const char* name, diffout_struct* out)
+{
+	int ok = 1;
+	int i, code, star = 0;
+	int* set = NULL;
+	double abstol, reltol, starabs = 0.0, starrel = 0.0;
+	char line[256], word[128];
+	FILE* fp;
+
+	if (!(fp = fopen(name, "r")))
+	{
+		printf("Can't open %s for ascii read\n", name);
+		ok=0;
+	}
+	if (ok && !(set = (int*) calloc(out->nvar, sizeof(int))))
+	{
+		printf("Error allocating for tolerances\n");
+		ok=0;
+	}
+	while (ok && fgets(line, sizeof(line), fp))
+	{
+		if (sscanf(line, "%127s%lf%lf", word, &abstol, &reltol) != 3) continue;
+		if (!strcmp(word, "*"))
+		{
+			star = 1;
+			starabs = abstol;
+			starrel = reltol;
+		}
+		else if (sscanf(word, "%d", &code) == 1)
+		{
+			for (i=0 ; i<out->nvar ; i++)
+			{
+				if (out->var[i].code != code) continue;
+				out->var[i].abstol = abstol;
+				out->var[i].reltol = reltol;
+				set[i] = 1;
+			}
+		}
+	}
+	for (i=0 ; ok && star && i<out->nvar ; i++)
+	{
+		if (set[i]) continue;
+		out->var[i].abstol = starabs;
+		out->var[i].reltol = starrel;
+	}
+	if (fp) fclose(fp);
+	free(set);
+
+	return (!ok);
+}
+
+/* map an output file read-only */
+static const float* diff_map(const char* name, long* nval)
+{
+	int fd;
+	struct stat st;
+	void* p = MAP_FAILED;
+
+	if ((fd = open(name, O_RDONLY)) < 0 || fstat(fd, &st))
+	{
+		printf("Can't open %s for binary read\n", name);
+	}
+	else if (st.st_size == 0)
+	{
+		printf("%s is empty\n", name);
+	}
+	else if ((p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+	{
+		printf("Can't map %s: %s\n", name, strerror(errno));
+	}
+	if (fd >= 0) close(fd);
+	*nval = (p == MAP_FAILED) ? 0 : (long)(st.st_size / sizeof(float));
+
+	return (p == MAP_FAILED) ? NULL : (const float*) p;
+}
+
+/* when a record falls in its year, as text */
+static void diff_when(const diffout_struct* out, long rec, char* s, size_t n)
+{
+	long year = out->firstyear + rec / out->peryear;
+	long r = rec % out->peryear;
+
+	if (rec < 0) snprintf(s, n, "-");
+	else if (out->peryear == 365) snprintf(s, n, "%ld day %ld", year, r+1);
+	else if (out->peryear == 12) snprintf(s, n, "%ld month %ld", year, r+1);
+	else snprintf(s, n, "%ld", year);
+}
+
+static void diff_print_usage(const char* argv0)
+{
+	printf("usage: %s {-a <abstol>} {-r <reltol>} {-t <tolfile>} {-y} {-q} <ini file> <output 1> <output 2>\n\n", argv0);
+	printf("       -a <abstol> absolute tolerance, default 0\n");
+	printf("       -r <reltol> relative tolerance, default 0\n");
+	printf("       -t <tolfile> per variable tolerances, see USAGE.TXT\n");
+	printf("       -y also list the differences year by year\n");
+	printf("       -q only list the variables that differ\n");
+	printf("The outputs are .dayout, .monavgout, .annavgout or .annout files.\n");
+	printf("A value is over tolerance when its difference is more than both\n");
+	printf("the absolute tolerance and the relative tolerance times the larger\n");
+	printf("of the two values.\n");
+}
+
+int main(int argc, char *argv[])
+{
+	diffout_struct out;
+	diffvar_struct* v;
+	FILE* ini;
+	const float *f1 = NULL, *f2 = NULL;
+	const char* ext;
+	const char* tolfile = NULL;
+	long n1, n2, nrec, rec, nyrec, nover = 0;
+	int c, i, y, nyears, ok = 1;
+	int yearly = 0, quiet = 0, annual = 0;
+	double abstol = 0.0, reltol = 0.0;
+	double a, b, d, rel, scale;
+	char when[64], line[256];
+	extern int optind, opterr;
+	extern char *optarg;
+
+	memset(&out, 0, sizeof(diffout_struct));
+
+	opterr = 0;
+	while ((c = getopt(argc, argv, "a:r:t:yq")) != -1)
+	{
+		switch (c)
+		{
+			case 'a':
+				abstol = atof(optarg);
+				break;
+			case 'r':
+				reltol = atof(optarg);
+				break;
+			case 't':
+				tolfile = optarg;
+				break;
+			case 'y':
+				yearly = 1;
+				break;
+			case 'q':
+				quiet = 1;
+				break;
+			default:
+				diff_print_usage(argv[0]);
+				exit(2);
+		}
+	}
+	if (argc - optind != 3)
+	{
+		diff_print_usage(argv[0]);
+		exit(2);
+	}
+
+	/* the kind of output, from the name of the first file */
+	ext = strrchr(argv[optind+1], '.');
+	if (ext && !strcmp(ext, ".dayout")) out.peryear = 365;
+	else if (ext && !strcmp(ext, ".monavgout")) out.peryear = 12;
+	else if (ext && !strcmp(ext, ".annavgout")) out.peryear = 1;
+	else if (ext && !strcmp(ext, ".annout"))
+	{
+		out.peryear = 1;
+		annual = 1;
+	}
+	else
+	{
+		printf("Can't tell the kind of output from the name %s\n", argv[optind+1]);
+		exit(2);
+	}
+
+	/* the first simulation year and the output codes */
+	if (!(ini = fopen(argv[optind], "r")))
+	{
+		printf("Can't open %s for ascii read\n", argv[optind]);
+		exit(2);
+	}
+	if (diff_find(ini, "TIME_DEFINE") || !fgets(line, sizeof(line), ini) ||
+		!fgets(line, sizeof(line), ini) || !fgets(line, sizeof(line), ini) ||
+		sscanf(line, "%d", &out.firstyear) != 1)
+	{
+		printf("Can't read the first simulation year from TIME_DEFINE in %s\n", argv[optind]);
+		ok=0;
+	}
+	if (ok) ok = !diff_codes(ini, annual ? "ANNUAL_OUTPUT" : "DAILY_OUTPUT", &out);
+	fclose(ini);
+	for (i=0 ; ok && i<out.nvar ; i++)
+	{
+		out.var[i].abstol = abstol;
+		out.var[i].reltol = reltol;
+	}
+	if (ok && tolfile) ok = !diff_tolerance(tolfile, &out);
+	if (!ok) exit(2);
+
+	/* map the outputs, which must hold the same whole number of records */
+	f1 = diff_map(argv[optind+1], &n1);
+	f2 = diff_map(argv[optind+2], &n2);
+	if (!f1 || !f2) exit(2);
+	if (n1 % out.nvar || n2 % out.nvar)
+	{
+		printf("The outputs are not a whole number of records of %d variables\n", out.nvar);
+		exit(2);
+	}
+	if (n1 != n2)
+	{
+		printf("%s has %ld records and %s has %ld\n", argv[optind+1], n1/out.nvar,
+			argv[optind+2], n2/out.nvar);
+		exit(2);
+	}
+	nrec = n1 / out.nvar;
+	nyears = (int)((nrec + out.peryear - 1) / out.peryear);
+
+	for (i=0 ; i<out.nvar ; i++)
+	{
+		out.var[i].first = -1;
+		if (!(out.var[i].ymax = (double*) calloc(nyears, sizeof(double))) ||
+			!(out.var[i].ysumsq = (double*) calloc(nyears, sizeof(double))))
+		{
+			printf("Error allocating for %d years\n", nyears);
+			exit(2);
+		}
+	}
+
+	/* the records are read in file order, so the maps are walked once.
+	NaN in one output and not the other counts as an infinite difference,
+	NaN in both as none. */
+	for (rec=0 ; rec<nrec ; rec++)
+	{
+		y = (int)(rec / out.peryear);
+		for (i=0 ; i<out.nvar ; i++)
+		{
+			a = f1[rec*out.nvar + i];
+			b = f2[rec*out.nvar + i];
+			if (a == b || (isnan(a) && isnan(b))) continue;
+			v = &out.var[i];
+			d = (isnan(a) || isnan(b)) ? INFINITY : fabs(a - b);
+			scale = fabs(a) > fabs(b) ? fabs(a) : fabs(b);
+			rel = (scale > 0.0 && isfinite(d)) ? d / scale : INFINITY;
+
+			if (d > v->maxabs) v->maxabs = d;
+			if (rel > v->maxrel) v->maxrel = rel;
+			if (d > v->ymax[y]) v->ymax[y] = d;
+			v->sumsq += d*d;
+			v->ysumsq[y] += d*d;
+			if (d > v->abstol && rel > v->reltol)
+			{
+				if (v->first < 0) v->first = rec;
+				v->nover++;
+			}
+		}
+	}
+
+	printf("\nCompared %ld records of %d variables, %d years from %d\n", nrec, out.nvar,
+		nyears, out.firstyear);
+	if (tolfile) printf("Tolerance: per variable from %s\n\n", tolfile);
+	else printf("Tolerance: absolute %g, relative %g\n\n", abstol, reltol);
+	printf("%-5s %-34s %13s %13s %13s %9s %-16s\n", "Code", "Variable", "Max abs diff",
+		"RMS diff", "Max rel diff", "Over tol", "First over");
+	for (i=0 ; i<out.nvar ; i++)
+	{
+		v = &out.var[i];
+		nover += v->nover;
+		if (quiet && v->maxabs == 0.0) continue;
+		diff_when(&out, v->first, when, sizeof(when));
+		printf("%-5d %-34.34s %13.6e %13.6e %13.6e %9ld %-16s\n", v->code, v->label,
+			v->maxabs, sqrt(v->sumsq / nrec), v->maxrel, v->nover, when);
+	}
+
+	/* year by year, for the variables that differ */
+	if (yearly)
+	{
+		for (i=0 ; i<out.nvar ; i++)
+		{
+			v = &out.var[i];
+			if (v->maxabs == 0.0) continue;
+			printf("\n%d %s\n%-6s %13s %13s\n", v->code, v->label, "Year", "Max abs diff", "RMS diff");
+			for (y=0 ; y<nyears ; y++)
+			{
+				nyrec = (y == nyears-1) ? nrec - (long)y*out.peryear : out.peryear;
+				printf("%-6d %13.6e %13.6e\n", out.firstyear + y, v->ymax[y], sqrt(v->ysumsq[y] / nyrec));
+			}
+		}
+	}
+	printf("\n%ld values over tolerance\n", nover);
+
+	munmap((void*)f1, n1 * sizeof(float));
+	munmap((void*)f2, n2 * sizeof(float));
+	for (i=0 ; i<out.nvar ; i++)
+	{
+		free(out.var[i].ymax);
+		free(out.var[i].ysumsq);
+	}
+	free(out.var);
+
+	return (nover ? 1 : 0);
+}
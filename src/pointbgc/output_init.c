@@ -19,16 +19,27 @@ units for annual precipitation as cm/year - the real units are mm/yr.
 
 #include "pointbgc.h"
 
+/* open an output file, or its memory stream in the output container */
+static int output_open(output_struct* output, file* target, int stream, char mode)
+{
+	if (output->container)
+	{
+		return (output_container_stream(output->container, stream, target, output->append));
+	}
+	return (file_open(target, mode));
+}
+
 int output_init(output_struct* output)
 {
   int ok = 1;
 	
-	/* open outfiles if specified */
+	/* open outfiles if specified. A stopped run that is continued
+	appends to the files it wrote. */
 	if (ok && output->dodaily)
 	{
 		strcpy(output->dayout.name,output->outprefix);
 		strcat(output->dayout.name,".dayout");
-		if (file_open(&(output->dayout),'w'))
+		if (output_open(output, &(output->dayout), CONT_DAY, output->append ? 'a' : 'w'))
 		{
 			bgc_printf(BV_ERROR, "Error opening daily outfile (%s) in output_ctrl()\n",output->dayout.name);
 			ok=0;
@@ -43,7 +54,7 @@ int output_init(output_struct* output)
 	{
 		strcpy(output->monavgout.name,output->outprefix);
 		strcat(output->monavgout.name,".monavgout");
-		if (file_open(&(output->monavgout),'w'))
+		if (output_open(output, &(output->monavgout), CONT_MONAVG, output->append ? 'a' : 'w'))
 		{
 			bgc_printf(BV_ERROR, "Error opening monthly average outfile (%s) in output_ctrl()\n",output->monavgout.name);
 			ok=0;
@@ -53,7 +64,7 @@ int output_init(output_struct* output)
 	{
 		strcpy(output->annavgout.name,output->outprefix);
 		strcat(output->annavgout.name,".annavgout");
-		if (file_open(&(output->annavgout),'w'))
+		if (output_open(output, &(output->annavgout), CONT_ANNAVG, output->append ? 'a' : 'w'))
 		{
 			bgc_printf(BV_ERROR, "Error opening annual average outfile (%s) in output_ctrl()\n",output->annavgout.name);
 			ok=0;
@@ -63,7 +74,7 @@ int output_init(output_struct* output)
 	{
 		strcpy(output->annout.name,output->outprefix);
 		strcat(output->annout.name,".annout");
-		if (file_open(&(output->annout),'w'))
+		if (output_open(output, &(output->annout), CONT_ANN, output->append ? 'a' : 'w'))
 		{
 			bgc_printf(BV_ERROR, "Error opening annual outfile (%s) in output_ctrl()\n",output->annout.name);
 			ok=0;
@@ -80,7 +91,7 @@ int output_init(output_struct* output)
 	{
 		strcpy(output->dayoutascii.name,output->outprefix);
 		strcat(output->dayoutascii.name,".dayout.ascii");
-		if (file_open(&(output->dayoutascii),'o'))
+		if (output_open(output, &(output->dayoutascii), CONT_DAYASCII, output->append ? 'e' : 'o'))
 		{
 			bgc_printf(BV_ERROR, "Error opening daily ascii outfile (%s) in output_ctrl()\n",output->dayoutascii.name);
 			ok=0;
@@ -91,7 +102,7 @@ int output_init(output_struct* output)
 	{
 		strcpy(output->monoutascii.name,output->outprefix);
 		strcat(output->monoutascii.name,".monavgout.ascii");
-		if (file_open(&(output->monoutascii),'o'))
+		if (output_open(output, &(output->monoutascii), CONT_MONASCII, output->append ? 'e' : 'o'))
 		{
 			bgc_printf(BV_ERROR, "Error opening monthly ascii outfile (%s) in output_ctrl()\n",output->monoutascii.name);
 			ok=0;
@@ -101,7 +112,7 @@ int output_init(output_struct* output)
 	{
 		strcpy(output->annoutascii.name,output->outprefix);
 		strcat(output->annoutascii.name,".annout.ascii");
-		if (file_open(&(output->annoutascii),'o'))
+		if (output_open(output, &(output->annoutascii), CONT_ANNASCII, output->append ? 'e' : 'o'))
 		{
 			bgc_printf(BV_ERROR, "Error opening annual ascii outfile (%s) in output_ctrl()\n",output->annoutascii.name);
 			ok=0;
@@ -121,12 +132,16 @@ int output_init(output_struct* output)
 		/* simple text output */
 		strcpy(output->anntext.name,output->outprefix);
 		strcat(output->anntext.name,"_ann.txt");
-		if (file_open(&(output->anntext),'o'))
+		if (output_open(output, &(output->anntext), CONT_ANNTEXT, output->append ? 'e' : 'o'))
 		{
 			bgc_printf(BV_ERROR, "Error opening annual text file (%s) in output_ctrl()\n",output->anntext.name);
 			ok=0;
 		}
-		/* write the header info for simple text file */
+	}
+	/* write the header info for simple text file, unless continuing a
+	stopped run */
+	if (ok && output->bgc_ascii && output->doannual && !output->append)
+	{
 		fprintf(output->anntext.ptr,"Annual summary output from Biome-BGC version %s\n",VERS);
 		fprintf(output->anntext.ptr,"ann PRCP = annual total precipitation (mm/yr)\n");
 		fprintf(output->anntext.ptr,"ann Tavg = annual average air temperature (deg C)\n");
@@ -0,0 +1,314 @@
+/*
+point_branch.c
+run the shared history of a set of scenarios once, and branch it into
+each scenario at a given year
+
+The base ini file is run from its first simulation year up to the start
+of the branch year, writing its outputs for those years, and the
+complete simulation state is taken there. Each scenario ini file is then
+run from that state to the end of the simulation on a pool of threads,
+writing its own outputs (from the branch year on) and restart file. The
+scenarios can differ from the base in anything that is read per year or
+per day: the met file and CLIM_CHANGE, CO2_CONTROL, the N deposition
+settings and the output control. They must have the same first year and
+number of simulation years as the base. With the branch year set to the
+first simulation year there is no history, and the scenarios are a
+sweep from the initial state of the base.
+
+The met file of the base is parsed once. A scenario that names the same
+met file uses the base met arrays, with its own copies only of the
+variables that its CLIM_CHANGE block changes.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
+#include <unistd.h>
+#include "pointbgc.h"
+
+/* the scenarios, shared by the worker threads */
+typedef struct
+{
+	int nscen;
+	point_input_struct* scen;
+	int* ok;                        /* per scenario, 1 = ran to the end */
+	const bgcstate_struct* state;   /* state at the start of the branch year */
+	int next;                       /* next scenario to run */
+} branch_struct;
+
+/* run one scenario from the branch state to the end of its simulation */
+static int branch_run(point_input_struct* pin, const bgcstate_struct* state)
+{
+	int ok=1;
+	bgcsim_struct* sim;
+
+	if (!(sim = (bgcsim_struct*) malloc(sizeof(bgcsim_struct))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating simulation for %s: branch_run()\n",pin->init.name);
+		return (1);
+	}
+	if (bgcsim_init(sim, &pin->bgcin, &pin->bgcout, MODE_MODEL))
+	{
+		bgc_printf(BV_ERROR, "Error in call to bgcsim_init() for %s: branch_run()\n",pin->init.name);
+		ok=0;
+	}
+	if (ok && bgcsim_set_state(sim, state))
+	{
+		bgc_printf(BV_ERROR, "Error in call to bgcsim_set_state() for %s: branch_run()\n",pin->init.name);
+		ok=0;
+	}
+	while (ok && !sim->done)
+	{
+		if (bgcsim_step_year(sim))
+		{
+			bgc_printf(BV_ERROR, "Error in call to bgcsim_step_year() for %s at year %d: branch_run()\n",
+				pin->init.name, sim->simyr);
+			ok=0;
+		}
+	}
+	if (ok && bgcsim_finish(sim))
+	{
+		bgc_printf(BV_ERROR, "Error in call to bgcsim_finish() for %s: branch_run()\n",pin->init.name);
+		ok=0;
+	}
+	if (ok && pin->restart.write_restart)
+	{
+		fwrite(&(pin->bgcout.restart_output),sizeof(restart_data_struct),1,
+			pin->restart.out_restart.ptr);
+	}
+	bgcsim_free(sim);
+	free(sim);
+
+	return (!ok);
+}
+
+static void* branch_worker(void* arg)
+{
+	branch_struct* br = (branch_struct*) arg;
+	int i;
+
+	while ((i = __sync_fetch_and_add(&br->next, 1)) < br->nscen)
+	{
+		br->ok[i] = !branch_run(&br->scen[i], br->state);
+	}
+
+	return NULL;
+}
+
+/* run the history in ininame up to branchyear, then the nscen scenario
+ini files in scenini from there on nthreads threads (0 = one per
+processor) */
+int point_branch(char* ininame, int branchyear, int nscen, char** scenini,
+int nthreads, const point_opts_struct* opts)
+{
+	int ok=1;
+	int i, nread = 0, nfail = 0, nhist = 0;
+	int baseread = 0, siminit = 0;
+	point_input_struct* base = NULL;
+	bgcsim_struct* sim = NULL;
+	bgcstate_struct state;
+	point_shared_struct shared;
+	branch_struct br;
+	pthread_t* threads = NULL;
+	extern signed char cli_mode;
+
+	memset(&br, 0, sizeof(branch_struct));
+
+	/* the history and the scenarios are model runs. Spin up first, and
+	start the base from the spinup restart file. */
+	if (cli_mode == MODE_SPINUP || cli_mode == MODE_SPINNGO)
+	{
+		bgc_printf(BV_ERROR, "Error: branching needs model runs, not spinup or spin and go: point_branch()\n");
+		ok=0;
+	}
+	if (ok && (!(base = (point_input_struct*) malloc(sizeof(point_input_struct))) ||
+		!(sim = (bgcsim_struct*) malloc(sizeof(bgcsim_struct))) ||
+		!(br.scen = (point_input_struct*) malloc(nscen * sizeof(point_input_struct))) ||
+		!(br.ok = (int*) calloc(nscen, sizeof(int)))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating for %d scenarios: point_branch()\n",nscen);
+		ok=0;
+	}
+
+	/******************************
+	**                           **
+	**  SHARED HISTORY           **
+	**                           **
+	******************************/
+
+	if (ok && point_read(ininame, opts, NULL, base))
+	{
+		bgc_printf(BV_ERROR, "Error in call to point_read() for %s: point_branch()\n",ininame);
+		ok=0;
+	}
+	baseread = ok;
+	if (ok && base->bgcin.ctrl.spinup)
+	{
+		bgc_printf(BV_ERROR, "Error: %s is a spinup simulation, branching needs a model run: point_branch()\n",ininame);
+		ok=0;
+	}
+	if (ok)
+	{
+		nhist = branchyear - base->bgcin.ctrl.simstartyear;
+		if (nhist < 0 || nhist >= base->bgcin.ctrl.simyears)
+		{
+			bgc_printf(BV_ERROR, "Error: branch year %d is not between the first and the last simulation year of %s: point_branch()\n",
+				branchyear, ininame);
+			ok=0;
+		}
+	}
+	if (ok)
+	{
+		siminit = 1;
+		if (bgcsim_init(sim, &base->bgcin, &base->bgcout, MODE_MODEL))
+		{
+			bgc_printf(BV_ERROR, "Error in call to bgcsim_init() for %s: point_branch()\n",ininame);
+			ok=0;
+		}
+	}
+	while (ok && sim->simyr < nhist)
+	{
+		if (bgcsim_step_year(sim))
+		{
+			bgc_printf(BV_ERROR, "Error in call to bgcsim_step_year() for %s at year %d: point_branch()\n",
+				ininame, sim->simyr);
+			ok=0;
+		}
+	}
+	if (ok && bgcsim_get_state(sim, &state))
+	{
+		bgc_printf(BV_ERROR, "Error in call to bgcsim_get_state() for %s: point_branch()\n",ininame);
+		ok=0;
+	}
+	/* the restart file of the base, if any, gets the branch state */
+	if (ok && bgcsim_finish(sim))
+	{
+		bgc_printf(BV_ERROR, "Error in call to bgcsim_finish() for %s: point_branch()\n",ininame);
+		ok=0;
+	}
+	if (ok && base->restart.write_restart)
+	{
+		fwrite(&(base->bgcout.restart_output),sizeof(restart_data_struct),1,
+			base->restart.out_restart.ptr);
+	}
+	if (ok && opts->stats) bgc_stats_write(opts->stats, ininame, "history", &sim->stats);
+	if (siminit) bgcsim_free(sim);
+	if (ok)
+	{
+		bgc_printf(BV_PROGRESS, "Ran %d years of shared history from %s, branching at %d\n",
+			nhist, ininame, branchyear);
+	}
+
+	/******************************
+	**                           **
+	**  SCENARIOS                **
+	**                           **
+	******************************/
+
+	/* the scenario ini files are read in turn, and must cover the same
+	years as the base. Their own restart input is not used, they start
+	from the branch state. The met arrays of the base are kept until the
+	scenarios are done. */
+	if (ok)
+	{
+		memset(&shared, 0, sizeof(point_shared_struct));
+		shared.metarr = &base->metbase;
+		shared.metname = base->point.metf.name;
+		shared.metyears = base->bgcin.ctrl.metyears;
+	}
+	for (i=0 ; ok && i<nscen ; i++)
+	{
+		if (point_read(scenini[i], opts, &shared, &br.scen[i]))
+		{
+			bgc_printf(BV_ERROR, "Error in call to point_read() for %s: point_branch()\n",scenini[i]);
+			ok=0;
+			break;
+		}
+		nread++;
+		if (br.scen[i].bgcin.ctrl.spinup ||
+			br.scen[i].bgcin.ctrl.simstartyear != base->bgcin.ctrl.simstartyear ||
+			br.scen[i].bgcin.ctrl.simyears != base->bgcin.ctrl.simyears)
+		{
+			bgc_printf(BV_ERROR, "Error: %s is not a model run over the same years as %s: point_branch()\n",
+				scenini[i], ininame);
+			ok=0;
+		}
+		br.scen[i].bgcin.ctrl.read_restart = 0;
+	}
+
+	/* number of worker threads, 0 = one per processor */
+	if (nthreads <= 0) nthreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	if (nthreads <= 0) nthreads = 1;
+	if (nthreads > nscen) nthreads = nscen;
+	if (ok && !(threads = (pthread_t*) malloc(nthreads * sizeof(pthread_t))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating for %d threads: point_branch()\n",nthreads);
+		ok=0;
+	}
+
+	if (ok)
+	{
+		br.nscen = nscen;
+		br.state = &state;
+		br.next = 0;
+		for (i=0 ; i<nthreads ; i++)
+		{
+			if (pthread_create(&threads[i], NULL, branch_worker, &br))
+			{
+				bgc_printf(BV_WARN, "Warning: error starting worker thread %d: point_branch()\n",i);
+				break;
+			}
+		}
+		/* the threads that did start take all of the scenarios, and
+		with none started they are run here */
+		nthreads = i;
+		if (!nthreads) branch_worker(&br);
+		for (i=0 ; i<nthreads ; i++)
+		{
+			pthread_join(threads[i], NULL);
+		}
+
+		/* statistics are written after the threads finish, so that the
+		lines are in scenario order */
+		for (i=0 ; i<nscen ; i++)
+		{
+			if (!br.ok[i])
+			{
+				bgc_printf(BV_ERROR, "Error: scenario %s failed\n",scenini[i]);
+				nfail++;
+			}
+			else if (opts->stats)
+			{
+				bgc_stats_write(opts->stats, scenini[i], "branch", &br.scen[i].bgcout.stats);
+			}
+		}
+		if (nfail) ok=0;
+		bgc_printf(BV_PROGRESS, "Ran %d of %d scenarios from %d on %d threads\n",
+			nscen - nfail, nscen, branchyear, nthreads);
+	}
+
+	for (i=0 ; i<nread ; i++)
+	{
+		if (point_close(&br.scen[i]))
+		{
+			bgc_printf(BV_ERROR, "Error in call to point_close() for %s: point_branch()\n",scenini[i]);
+			ok=0;
+		}
+	}
+	if (baseread && point_close(base))
+	{
+		bgc_printf(BV_ERROR, "Error in call to point_close() for %s: point_branch()\n",ininame);
+		ok=0;
+	}
+	free(threads);
+	free(br.scen);
+	free(br.ok);
+	free(sim);
+	free(base);
+
+	return (!ok);
+}
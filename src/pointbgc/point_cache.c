@@ -0,0 +1,368 @@
+/*
+point_cache.c
+warm cache of the inputs that point_read() parses, shared by the jobs
+of the job server (see point_serve.c)
+
+Each epc, met, CO2 and Ndep file is read once, the first time a job
+names it, and kept until the cache is deleted: later jobs copy the epc
+constants and share the met and CO2/Ndep arrays. The phenology arrays
+of prephenology() are kept for each set of met arrays, met years and
+the epc and site values they depend on. The cached arrays are never
+changed once made, so any number of simulations can run on them at
+once. Files are looked up by name, so a file that is changed on disk
+while the cache holds it is not read again. The arrays of all entries
+are allocated from one arena, released when the cache is deleted.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
+#include "pointbgc.h"
+
+/* kinds of cache entries */
+#define CACHE_EPC 0
+#define CACHE_MET 1
+#define CACHE_CO2 2
+#define CACHE_NDEP 3
+#define CACHE_PHEN 4
+#define NCACHE 5
+static const char* cache_names[NCACHE] = {"epc", "met", "co2", "ndep", "phen"};
+
+/* epc and site values that prephenology() depends on */
+#define NPHENKEY 9
+
+/* no climate change, for the cached met arrays */
+static const climchange_struct cache_scc_none = {0.0, 0.0, 1.0, 1.0, 1.0};
+
+typedef struct cache_entry_struct
+{
+	struct cache_entry_struct* next;
+	int kind;                  /* CACHE_* */
+	char name[128];            /* epc, met, CO2 or Ndep file */
+	int nhead;                 /* met: header lines of the met file */
+	int years;                 /* met, phenology: met years */
+	const metarr_struct* met;  /* phenology: met arrays it was made from */
+	double phenkey[NPHENKEY];  /* phenology: epc and site values */
+	epconst_struct epc;
+	metarr_struct metarr;
+	co2control_struct co2;
+	ndepcontrol_struct ndep;
+	phenarray_struct phenarr;
+} cache_entry_struct;
+
+struct point_cache_struct
+{
+	pthread_mutex_t lock;
+	cache_entry_struct* entries;
+	arena_struct arena;        /* arrays of the entries */
+	long hits[NCACHE];
+	long misses[NCACHE];
+};
+
+point_cache_struct* point_cache_new(void)
+{
+	point_cache_struct* cache;
+
+	if (!(cache = (point_cache_struct*) calloc(1, sizeof(point_cache_struct))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating input cache: point_cache_new()\n");
+		return (NULL);
+	}
+	if (pthread_mutex_init(&cache->lock, NULL))
+	{
+		bgc_printf(BV_ERROR, "Error creating input cache lock: point_cache_new()\n");
+		free(cache);
+		return (NULL);
+	}
+	arena_init(&cache->arena, 0);
+
+	return (cache);
+}
+
+void point_cache_delete(point_cache_struct* cache)
+{
+	cache_entry_struct *e, *next;
+
+	if (!cache) return;
+	for (e=cache->entries ; e ; e=next)
+	{
+		next = e->next;
+		free(e);
+	}
+	arena_release(&cache->arena);
+	pthread_mutex_destroy(&cache->lock);
+	free(cache);
+}
+
+/* the entry of a kind for a file name (and for met, its header lines
+and years), or NULL. Called with the lock held. */
+static cache_entry_struct* cache_find(point_cache_struct* cache, int kind,
+const char* name, int nhead, int years)
+{
+	cache_entry_struct* e;
+
+	for (e=cache->entries ; e ; e=e->next)
+	{
+		if (e->kind == kind && !strcmp(e->name, name) &&
+			(kind != CACHE_MET || (e->nhead == nhead && e->years == years)))
+		{
+			cache->hits[kind]++;
+			return (e);
+		}
+	}
+	cache->misses[kind]++;
+
+	return (NULL);
+}
+
+/* a new entry, to be filled in and then added with cache_add() */
+static cache_entry_struct* cache_entry(int kind, const char* name)
+{
+	cache_entry_struct* e;
+
+	/* a name that does not fit is not cached, rather than cut short to
+	share the entry of another file */
+	if (strlen(name) >= sizeof(e->name))
+	{
+		bgc_printf(BV_ERROR, "Error: input cache key too long (%d characters max): %s\n",
+			(int)sizeof(e->name) - 1,name);
+		return (NULL);
+	}
+	if (!(e = (cache_entry_struct*) calloc(1, sizeof(cache_entry_struct))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating input cache entry for %s\n",name);
+		return (NULL);
+	}
+	e->kind = kind;
+	strcpy(e->name, name);
+
+	return (e);
+}
+
+static void cache_add(point_cache_struct* cache, cache_entry_struct* e)
+{
+	e->next = cache->entries;
+	cache->entries = e;
+}
+
+/* the ecophysiological constants of the epc file name, copied to epc */
+int point_cache_epc(point_cache_struct* cache, const char* name, epconst_struct* epc)
+{
+	int ok=1;
+	cache_entry_struct* e;
+	file epcf;
+
+	pthread_mutex_lock(&cache->lock);
+	if (!(e = cache_find(cache, CACHE_EPC, name, 0, 0)))
+	{
+		if (!(e = cache_entry(CACHE_EPC, name))) ok=0;
+		if (ok)
+		{
+			strcpy(epcf.name, e->name);
+			if (file_open(&epcf, 'r'))
+			{
+				bgc_printf(BV_ERROR, "Error opening epc file %s: point_cache_epc()\n",name);
+				ok=0;
+			}
+			else
+			{
+				if (epc_read(epcf, &e->epc))
+				{
+					bgc_printf(BV_ERROR, "Error in call to epc_read() for %s: point_cache_epc()\n",name);
+					ok=0;
+				}
+				fclose(epcf.ptr);
+			}
+		}
+		if (ok) cache_add(cache, e);
+		else free(e);
+	}
+	if (ok) *epc = e->epc;
+	pthread_mutex_unlock(&cache->lock);
+
+	return (!ok);
+}
+
+/* the met arrays of the open met file metf, with nhead header lines,
+for metyears years and with no climate change. They belong to the cache. */
+int point_cache_met(point_cache_struct* cache, file metf, int nhead, int metyears,
+const metarr_struct** metarr)
+{
+	int ok=1;
+	cache_entry_struct* e;
+
+	pthread_mutex_lock(&cache->lock);
+	if (!(e = cache_find(cache, CACHE_MET, metf.name, nhead, metyears)))
+	{
+		if (!(e = cache_entry(CACHE_MET, metf.name))) ok=0;
+		if (ok && metarr_init(metf, nhead, &e->metarr, &cache_scc_none, metyears, &cache->arena))
+		{
+			bgc_printf(BV_ERROR, "Error in call to metarr_init() for %s: point_cache_met()\n",metf.name);
+			ok=0;
+		}
+		if (ok)
+		{
+			e->nhead = nhead;
+			e->years = metyears;
+			cache_add(cache, e);
+		}
+		else free(e);
+	}
+	if (ok) *metarr = &e->metarr;
+	pthread_mutex_unlock(&cache->lock);
+
+	return (!ok);
+}
+
+/* the annual CO2 arrays of the CO2 file name, shared into co2 */
+int point_cache_co2(point_cache_struct* cache, const char* name, co2control_struct* co2)
+{
+	int ok=1;
+	cache_entry_struct* e;
+	file co2f;
+
+	pthread_mutex_lock(&cache->lock);
+	if (!(e = cache_find(cache, CACHE_CO2, name, 0, 0)))
+	{
+		if (!(e = cache_entry(CACHE_CO2, name))) ok=0;
+		if (ok)
+		{
+			strcpy(co2f.name, e->name);
+			if (file_open(&co2f, 'r'))
+			{
+				bgc_printf(BV_ERROR, "Error opening annual CO2 file %s: point_cache_co2()\n",name);
+				ok=0;
+			}
+			else
+			{
+				e->co2.varco2 = 1;
+				if (co2_read(co2f, &e->co2, &cache->arena))
+				{
+					bgc_printf(BV_ERROR, "Error in call to co2_read() for %s: point_cache_co2()\n",name);
+					ok=0;
+				}
+				fclose(co2f.ptr);
+			}
+		}
+		if (ok) cache_add(cache, e);
+		else free(e);
+	}
+	if (ok)
+	{
+		co2->co2ppm_array = e->co2.co2ppm_array;
+		co2->co2year_array = e->co2.co2year_array;
+		co2->co2vals = e->co2.co2vals;
+	}
+	pthread_mutex_unlock(&cache->lock);
+
+	return (!ok);
+}
+
+/* the annual Ndep arrays of the Ndep file ndepfile, shared into ndepctrl */
+int point_cache_ndep(point_cache_struct* cache, file ndepfile, ndepcontrol_struct* ndepctrl)
+{
+	int ok=1;
+	cache_entry_struct* e;
+
+	pthread_mutex_lock(&cache->lock);
+	if (!(e = cache_find(cache, CACHE_NDEP, ndepfile.name, 0, 0)))
+	{
+		if (!(e = cache_entry(CACHE_NDEP, ndepfile.name))) ok=0;
+		if (ok)
+		{
+			e->ndep.varndep = 1;
+			if (ndep_init(ndepfile, &e->ndep, &cache->arena))
+			{
+				bgc_printf(BV_ERROR, "Error in call to ndep_init() for %s: point_cache_ndep()\n",ndepfile.name);
+				ok=0;
+			}
+		}
+		if (ok) cache_add(cache, e);
+		else free(e);
+	}
+	if (ok)
+	{
+		ndepctrl->ndep_array = e->ndep.ndep_array;
+		ndepctrl->ndepyear_array = e->ndep.ndepyear_array;
+		ndepctrl->ndepvals = e->ndep.ndepvals;
+	}
+	pthread_mutex_unlock(&cache->lock);
+
+	return (!ok);
+}
+
+/* the phenology arrays of prephenology() for the met arrays metarr,
+which must use the cached met arrays base for every variable that
+prephenology() reads. They belong to the cache. */
+int point_cache_phen(point_cache_struct* cache, const control_struct* ctrl,
+const epconst_struct* epc, const siteconst_struct* sitec,
+const metarr_struct* metarr, const metarr_struct* base,
+const phenarray_struct** phenarr)
+{
+	int ok=1;
+	int i;
+	cache_entry_struct* e;
+	double key[NPHENKEY];
+
+	key[0] = epc->phenology_flag;
+	key[1] = epc->woody;
+	key[2] = epc->evergreen;
+	key[3] = epc->onday;
+	key[4] = epc->offday;
+	key[5] = epc->transfer_pdays;
+	key[6] = epc->litfall_pdays;
+	key[7] = sitec->lat;
+	key[8] = ctrl->metyears;
+
+	pthread_mutex_lock(&cache->lock);
+	for (e=cache->entries ; e ; e=e->next)
+	{
+		if (e->kind != CACHE_PHEN || e->met != base) continue;
+		for (i=0 ; i<NPHENKEY && e->phenkey[i] == key[i] ; i++);
+		if (i == NPHENKEY) break;
+	}
+	if (e) cache->hits[CACHE_PHEN]++;
+	else
+	{
+		cache->misses[CACHE_PHEN]++;
+		if (!(e = cache_entry(CACHE_PHEN, "phenology"))) ok=0;
+		if (ok && prephenology(ctrl, epc, sitec, metarr, &e->phenarr, &cache->arena))
+		{
+			bgc_printf(BV_ERROR, "Error in call to prephenology() from point_cache_phen()\n");
+			ok=0;
+		}
+		if (ok)
+		{
+			e->met = base;
+			for (i=0 ; i<NPHENKEY ; i++) e->phenkey[i] = key[i];
+			cache_add(cache, e);
+		}
+		else free(e);
+	}
+	if (ok) *phenarr = &e->phenarr;
+	pthread_mutex_unlock(&cache->lock);
+
+	return (!ok);
+}
+
+/* one line of entries, hits and misses of each kind of input */
+void point_cache_report(point_cache_struct* cache, char* line, int size)
+{
+	int k, n, len = 0;
+	int count[NCACHE] = {0};
+	cache_entry_struct* e;
+
+	pthread_mutex_lock(&cache->lock);
+	for (e=cache->entries ; e ; e=e->next) count[e->kind]++;
+	for (k=0 ; k<NCACHE && len<size ; k++)
+	{
+		n = snprintf(line + len, size - len, "%s%s %d %ld %ld", k ? " " : "",
+			cache_names[k], count[k], cache->hits[k], cache->misses[k]);
+		if (n > 0) len += n;
+	}
+	pthread_mutex_unlock(&cache->lock);
+}
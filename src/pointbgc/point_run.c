@@ -0,0 +1,662 @@
+/*
+point_run.c
+read and run one point simulation from its ini file, for pointbgc and for
+other front-ends that run many sites
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#define _POSIX_C_SOURCE 200809L
+#include "pointbgc.h"
+
+/* no climate change, for the met arrays that scenarios are built from */
+static const climchange_struct scc_none = {0.0, 0.0, 1.0, 1.0, 1.0};
+
+/* read the ini file of one point simulation into pin, opening its output
+and restart files and building its met arrays, ready to run. opts holds
+the command line options. shared, if not NULL, holds met and epc data
+already in memory, used in place of reading the met data and epc files
+named in the ini file, or a cache of the input files and the text of the
+ini file. Returns 0, or a BGC_ERR_* code once everything that was read
+has been released. */
+int point_read(char* ininame, const point_opts_struct* opts,
+const point_shared_struct* shared, point_input_struct* pin)
+{
+	int err = 0;
+	/* system time variables */
+	struct tm tm_buf;
+	time_t lt;
+	/* input files taken from the cache */
+	point_cache_struct* cache = shared ? shared->cache : NULL;
+	const metarr_struct* cachemet = NULL;
+	const phenarray_struct* phenarr;
+	file co2f;
+
+	/* start from zero, so that the padding in the restart record written
+	from pin->bgcout is the same from run to run */
+	memset(pin, 0, sizeof(point_input_struct));
+	arena_init(&pin->arena, 0);
+	pin->bgcin.ndepctrl.varndep = opts->readndepfile;
+
+	/* get the system time at start of simulation */
+	lt = time(NULL);
+	/* the reentrant forms, since the job server reads ini files on
+	several threads at once */
+	asctime_r(localtime_r(&lt, &tm_buf), pin->point.systime);
+	pin->output.anncodes = NULL;
+	pin->output.daycodes = NULL;
+	pin->output.bgc_ascii = opts->bgc_ascii;
+	
+	/* initialize the bgcin state variable structures before filling with
+	values from ini file */
+	if (presim_state_init(&pin->bgcin.ws, &pin->bgcin.cs, &pin->bgcin.ns, &pin->bgcin.cinit))
+	{
+		bgc_printf(BV_ERROR, "Error in call to presim_state_init() from point_read()\n");
+		err = BGC_ERR_INI;
+	}
+
+	/******************************
+	**                           **
+	**  BEGIN READING INIT FILE  **
+	**                           **
+	******************************/
+
+	strcpy(pin->init.name, ininame);
+	
+	/* open the main init file for ascii read and check for errors. The
+	text of an ini file sent to the job server is read from memory. */
+	if (!err && shared && shared->initext)
+	{
+		if (!(pin->init.ptr = fmemopen((void*) shared->initext, strlen(shared->initext), "r")))
+		{
+			bgc_printf(BV_ERROR, "Error opening init text of %s: point_read()\n",ininame);
+			err = BGC_ERR_INI;
+		}
+	}
+	else if (!err && file_open(&pin->init,'i'))
+	{
+		bgc_printf(BV_ERROR, "Error opening init file: point_read()\n");
+		err = BGC_ERR_INI;
+	}
+
+	/* read the header string from the init file */
+	if (!err && fgets(pin->point.header, 100, pin->init.ptr)==NULL)
+	{
+		bgc_printf(BV_ERROR, "Error reading header string: point_read()\n");
+		err = BGC_ERR_INI;
+	}
+
+	/* open met file, read number of header lines */
+	if (!err && met_init(pin->init, &pin->point))
+	{
+		bgc_printf(BV_ERROR, "Error in call to met_init() from point_read()\n");
+		err = BGC_ERR_INPUT;
+	}
+
+	/* read restart control parameters */
+	pin->restart.resume = opts->resume;
+	if (!err && restart_init(pin->init, &pin->restart))
+	{
+		bgc_printf(BV_ERROR, "Error in call to restart_init() from point_read()\n");
+		err = BGC_ERR_INI;
+	}
+	if (!err && pin->restart.resumed)
+	{
+		bgc_printf(BV_PROGRESS, "Continuing a run stopped on the %s, from %s\n",
+			bgc_stop_name(pin->restart.resume_data.reason), pin->restart.out_restart.name);
+		pin->output.append = 1;
+	}
+
+	/* read simulation timing control parameters */
+	if (!err && time_init(pin->init, &(pin->bgcin.ctrl)))
+	{
+		bgc_printf(BV_ERROR, "Error in call to time_init() from point_read()\n");
+		err = BGC_ERR_INI;
+	}
+	
+	/* read scalar climate change parameters */
+	if (!err && scc_init(pin->init, &pin->scc))
+	{
+		bgc_printf(BV_ERROR, "Error in call to scc_init() from point_read()\n");
+		err = BGC_ERR_INI;
+	}
+	
+	/* read CO2 control parameters, with the annual CO2 file from the
+	cache */
+	if (!err && cache)
+	{
+		if (co2_file_init(pin->init, &(pin->bgcin.co2), &co2f))
+		{
+			bgc_printf(BV_ERROR, "Error in call to co2_file_init() from point_read()\n");
+			err = BGC_ERR_INI;
+		}
+		else if (pin->bgcin.co2.varco2 && point_cache_co2(cache, co2f.name, &(pin->bgcin.co2)))
+		{
+			bgc_printf(BV_ERROR, "Error in call to point_cache_co2() from point_read()\n");
+			err = BGC_ERR_INPUT;
+		}
+	}
+	else if (!err && co2_init(pin->init, &(pin->bgcin.co2), pin->bgcin.ctrl.simyears, &pin->arena))
+	{
+		bgc_printf(BV_ERROR, "Error in call to co2_init() from point_read()\n");
+		err = BGC_ERR_INPUT;
+	}
+	if (!err && opts->readndepfile && cache)
+	{
+		if (point_cache_ndep(cache, opts->ndep_file, &(pin->bgcin.ndepctrl)))
+		{
+			bgc_printf(BV_ERROR, "Error in call to point_cache_ndep() from point_read()\n");
+			err = BGC_ERR_INPUT;
+		}
+	}
+	else if (!err && opts->readndepfile)
+	{
+		if (ndep_init(opts->ndep_file, &(pin->bgcin.ndepctrl), &pin->arena))
+		{
+			bgc_printf(BV_ERROR, "Error in call to ndep_init() from point_read()\n");
+			err = BGC_ERR_INPUT;
+		}
+	}
+	/* read site constants */
+	if (!err && sitec_init(pin->init, &pin->bgcin.sitec))
+	{
+		bgc_printf(BV_ERROR, "Error in call to sitec_init() from point_read()\n");
+		err = BGC_ERR_INI;
+	}
+	
+	/* read ramped nitrogen deposition block */
+	if (!err && ramp_ndep_init(pin->init, &pin->bgcin.ramp_ndep))
+	{
+		bgc_printf(BV_ERROR, "Error in call to ramp_ndep_init() from point_read()\n");
+		err = BGC_ERR_INI;
+	}
+	
+	/* read ecophysiological constants, or use the shared copy */
+	if (!err && cache)
+	{
+		if (epc_file_init(pin->init, &pin->epcf) ||
+			point_cache_epc(cache, pin->epcf.name, &pin->bgcin.epc))
+		{
+			bgc_printf(BV_ERROR, "Error in call to point_cache_epc() from point_read()\n");
+			err = BGC_ERR_INPUT;
+		}
+	}
+	else if (!err && shared && shared->epc)
+	{
+		if (epc_file_init(pin->init, &pin->epcf))
+		{
+			bgc_printf(BV_ERROR, "Error in call to epc_file_init() from point_read()\n");
+			err = BGC_ERR_INI;
+		}
+		pin->bgcin.epc = *shared->epc;
+	}
+	else if (!err && epc_init(pin->init, &pin->bgcin.epc))
+	{
+		bgc_printf(BV_ERROR, "Error in call to epc_init() from point_read()\n");
+		err = BGC_ERR_INPUT;
+	}
+
+	/* initialize water state structure */
+	if (!err && wstate_init(pin->init, &pin->bgcin.sitec, &pin->bgcin.ws))
+	{
+		bgc_printf(BV_ERROR, "Error in call to wstate_init() from point_read()\n");
+		err = BGC_ERR_INI;
+	}
+
+	/* initialize carbon and nitrogen state structures */
+	if (!err && cnstate_init(pin->init, &pin->bgcin.epc, &pin->bgcin.cs, &pin->bgcin.cinit,
+		&pin->bgcin.ns))
+	{
+		bgc_printf(BV_ERROR, "Error in call to cnstate_init() from point_read()\n");
+		err = BGC_ERR_INI;
+	}
+
+	/* read the output control information */
+	if (!err && output_ctrl(pin->init, &pin->output, &pin->arena))
+	{
+		bgc_printf(BV_ERROR, "Error in call to output_ctrl() from point_read()\n");
+		err = BGC_ERR_INI;
+	}
+	
+	/* write the output files to the multi-site output container */
+	if (!err && opts->container)
+	{
+		if (output_container_open(&pin->container, opts->container, opts->container_site, ininame))
+		{
+			bgc_printf(BV_ERROR, "Error in call to output_container_open() from point_read()\n");
+			err = BGC_ERR_OUTPUT;
+		}
+		else pin->output.container = &pin->container;
+	}
+
+	/* initialize output files. Does nothing in spinup mode*/
+	if (!err && output_init(&pin->output))
+	{
+		bgc_printf(BV_ERROR, "Error in call to output_init() from point_read()\n");
+		err = BGC_ERR_OUTPUT;
+	}
+	
+	/* read final line out of init file to test for proper file structure */
+	if (!err && end_init(pin->init))
+	{
+		bgc_printf(BV_ERROR, "Error in call to end_init() from point_read()\n");
+		err = BGC_ERR_INI;
+	}
+	file_close(&pin->init);
+
+	/* read meteorology file, build metarr arrays with no climate change,
+	compute running avgs. With shared met the arrays are built from the
+	shared copy instead, or taken as they are if they were built from
+	the same met file, or taken from the cache. */
+	if (!err && cache)
+	{
+		if (point_cache_met(cache, pin->point.metf, pin->point.nhead, pin->bgcin.ctrl.metyears, &cachemet))
+		{
+			bgc_printf(BV_ERROR, "Error in call to point_cache_met() from point_read()\n");
+			err = BGC_ERR_INPUT;
+		}
+		else pin->metbase = *cachemet;
+	}
+	else if (!err && shared && shared->metarr && shared->metyears == pin->bgcin.ctrl.metyears &&
+		!strcmp(shared->metname, pin->point.metf.name))
+	{
+		pin->metbase = *shared->metarr;
+	}
+	else if (!err && shared && shared->tmax)
+	{
+		if (metarr_shared_init(shared, &pin->metbase, &scc_none, pin->bgcin.ctrl.metyears, &pin->arena))
+		{
+			bgc_printf(BV_ERROR, "Error in call to metarr_shared_init() from point_read()\n");
+			err = BGC_ERR_INPUT;
+		}
+	}
+	else if (!err && metarr_init(pin->point.metf, pin->point.nhead, &pin->metbase, &scc_none, pin->bgcin.ctrl.metyears, &pin->arena))
+	{
+		bgc_printf(BV_ERROR, "Error in call to metarr_init() from point_read()\n");
+		err = BGC_ERR_INPUT;
+	}
+	file_close(&pin->point.metf);
+
+	/* apply the climate change scenario, sharing the unchanged arrays */
+	if (!err && metarr_derive(&pin->metbase, &pin->bgcin.metarr, &pin->scc, pin->bgcin.ctrl.metyears, &pin->arena))
+	{
+		bgc_printf(BV_ERROR, "Error in call to metarr_derive() from point_read()\n");
+		err = BGC_ERR_INPUT;
+	}
+	
+	/* a simulation that could not be read is closed here, with all of
+	the memory and files it had */
+	if (err)
+	{
+		point_close(pin);
+		return (err);
+	}
+
+	/* copy some of the info from input structure to bgc simulation control
+	structure */
+	pin->bgcin.ctrl.onscreen = pin->output.onscreen;
+	pin->bgcin.ctrl.dodaily = pin->output.dodaily;
+	pin->bgcin.ctrl.domonavg = pin->output.domonavg;
+	pin->bgcin.ctrl.doannavg = pin->output.doannavg;
+	pin->bgcin.ctrl.doannual = pin->output.doannual;
+	pin->bgcin.ctrl.ndayout = pin->output.ndayout;
+	pin->bgcin.ctrl.nannout = pin->output.nannout;
+	pin->bgcin.ctrl.daycodes = pin->output.daycodes;
+	pin->bgcin.ctrl.anncodes = pin->output.anncodes;
+	pin->bgcin.ctrl.read_restart = pin->restart.read_restart;
+	pin->bgcin.ctrl.write_restart = pin->restart.write_restart;
+	pin->bgcin.ctrl.keep_metyr = pin->restart.keep_metyr;
+	pin->bgcin.ctrl.balance_mode = opts->balance_mode;
+	pin->bgcin.ctrl.balance_interval = opts->balance_interval;
+	pin->bgcin.ctrl.spincoarse = opts->spincoarse;
+	pin->bgcin.ctrl.stop_time = opts->stop_wall ? (double)time(NULL) + opts->stop_wall : 0.0;
+	pin->bgcin.ctrl.stop_years = opts->stop_years;
+	if (pin->restart.resumed) pin->bgcin.resume = &pin->restart.resume_data;
+	
+	/* copy the output file structures into bgcout */
+	if (pin->output.dodaily) pin->bgcout.dayout = pin->output.dayout;
+	if (pin->output.domonavg) pin->bgcout.monavgout = pin->output.monavgout;
+	if (pin->output.doannavg) pin->bgcout.annavgout = pin->output.annavgout;
+	if (pin->output.doannual) pin->bgcout.annout = pin->output.annout;
+	if (pin->output.bgc_ascii && pin->output.dodaily) pin->bgcout.dayoutascii = pin->output.dayoutascii;
+	if (pin->output.bgc_ascii && pin->output.domonavg) pin->bgcout.monoutascii = pin->output.monoutascii;
+	if (pin->output.bgc_ascii && pin->output.doannual) pin->bgcout.annoutascii = pin->output.annoutascii;
+	pin->bgcout.anntext = pin->output.anntext;
+	pin->bgcout.bgc_ascii = opts->bgc_ascii;
+	pin->bgcout.telemetry = opts->telemetry;
+	pin->bgcout.site = pin->init.name;
+	pin->bgcout.telem_last = opts->telem_last;
+	pin->bgcout.container = pin->output.container;
+	
+	/* the phenology arrays from the cache, when the climate change
+	scenario leaves the met variables they are made from unchanged */
+	if (cachemet && pin->bgcin.metarr.tmax == cachemet->tmax &&
+		pin->bgcin.metarr.tmin == cachemet->tmin &&
+		pin->bgcin.metarr.prcp == cachemet->prcp &&
+		pin->bgcin.metarr.dayl == cachemet->dayl &&
+		pin->bgcin.metarr.tavg == cachemet->tavg &&
+		pin->bgcin.metarr.tavg_ra == cachemet->tavg_ra)
+	{
+		if (point_cache_phen(cache, &pin->bgcin.ctrl, &pin->bgcin.epc, &pin->bgcin.sitec,
+			&pin->bgcin.metarr, cachemet, &phenarr))
+		{
+			bgc_printf(BV_ERROR, "Error in call to point_cache_phen() from point_read()\n");
+			err = BGC_ERR_INPUT;
+		}
+		else pin->bgcin.phenarr = phenarr;
+	}
+	
+	/* if using ramped Ndep, copy preindustrial Ndep into ramp_ndep struct */
+	if (pin->bgcin.ramp_ndep.doramp)
+	{
+		pin->bgcin.ramp_ndep.preind_ndep = pin->bgcin.sitec.ndep;
+	}
+	
+	/* if using an input restart file, read a record */
+	if (!err && pin->restart.read_restart)
+	{
+		/* 02/06/04
+		 * The if statement gaurds against core dump on bad restart file.
+		 * If spinup exits with error then the norm trys to use the restart,
+		 * that has nothing in it, a seg fault occurs. Amac */
+		if( fread(&(pin->bgcin.restart_input),sizeof(restart_data_struct),1,pin->restart.in_restart.ptr) == 0)
+		{
+			bgc_printf(BV_ERROR, "Error reading restart file! 0 bytes read.\n");
+			err = BGC_ERR_INPUT;
+		}
+	}
+
+	if (err) point_close(pin);
+
+	return (err);
+}
+
+/* write the restart record at the end of a run, followed by the resume
+record if the run stopped early. The file of a continued run is only
+overwritten here, so that its resume record is kept until then. */
+static int restart_write(point_input_struct* pin)
+{
+	int ok=1;
+	bgcout_struct* bgcout = &pin->bgcout;
+
+	if (!pin->restart.write_restart)
+	{
+		if (bgcout->stopped)
+		{
+			bgc_printf(BV_WARN, "Warning: no output restart file, the stopped run of %s cannot be continued\n",
+				pin->init.name);
+		}
+		return (0);
+	}
+	if (pin->restart.resumed)
+	{
+		fclose(pin->restart.out_restart.ptr);
+		if (file_open(&pin->restart.out_restart,'w'))
+		{
+			bgc_printf(BV_ERROR, "Error opening output restart file: restart_write()\n");
+			return (1);
+		}
+	}
+	if (fwrite(&(bgcout->restart_output),sizeof(restart_data_struct),1,
+		pin->restart.out_restart.ptr) != 1)
+	{
+		ok=0;
+	}
+	if (ok && bgcout->stopped && fwrite(&(bgcout->resume),sizeof(restart_resume_struct),1,
+		pin->restart.out_restart.ptr) != 1)
+	{
+		ok=0;
+	}
+	if (!ok)
+	{
+		bgc_printf(BV_ERROR, "Error writing restart file %s: %s\n",pin->restart.out_restart.name,strerror(errno));
+	}
+
+	return (!ok);
+}
+
+/* run one point simulation from its ini file. Returns BGC_EXIT_STOPPED
+if the run stopped early, with its outputs flushed and its state in the
+output restart file to be continued from, or a BGC_ERR_* code if the run
+failed, with its memory and files released. */
+int point_run(char* ininame, const point_opts_struct* opts,
+const point_shared_struct* shared)
+{
+	int err = 0;
+	/* the simulation as read from the ini file */
+	point_input_struct pin;
+	/* the whole met record, while the spinup runs on representative years */
+	metarr_struct fullmet;
+	int fullyears = 0;
+
+	extern signed char cli_mode; /* What cli requested mode to run in.*/
+
+	if ((err = point_read(ininame, opts, shared, &pin)))
+	{
+		bgc_printf(BV_ERROR, "Error in call to point_read() for %s: point_run()\n",ininame);
+		return (err);
+	}
+
+	/* publish the outputs to the live output tap */
+	if (opts->tap && output_tap_open(opts->tap, &pin.output, &pin.bgcout.tap))
+	{
+		bgc_printf(BV_ERROR, "Error in call to output_tap_open() from point_run()\n");
+		err = BGC_ERR_OUTPUT;
+	}
+
+	/*********************
+	**                  **
+	**  CALL BIOME-BGC  **
+	**                  **
+	*********************/
+
+	/* all initialization complete, call model */
+	/* either call the spinup code or the normal simulation code */
+	if (!err && pin.bgcin.ctrl.spinup)
+	{
+		/* for a fast spinup, cycle through a few representative met
+		years instead of the whole record */
+		if (opts->repyears && opts->repyears < pin.bgcin.ctrl.metyears &&
+			bgcsim_spinup_block(opts->repyears) >= bgcsim_spinup_block(pin.bgcin.ctrl.metyears))
+		{
+			/* the spinup runs in blocks of about 100 years, so a set
+			whose block is not shorter than that of the record would
+			only make the spinup longer */
+			bgc_printf(BV_ERROR, "Error: -Y %d saves no spinup years on a record of %d met years (spinup blocks of %d and %d years)\n",
+				opts->repyears,pin.bgcin.ctrl.metyears,bgcsim_spinup_block(opts->repyears),
+				bgcsim_spinup_block(pin.bgcin.ctrl.metyears));
+			err = BGC_ERR_INI;
+		}
+		else if (opts->repyears && opts->repyears < pin.bgcin.ctrl.metyears)
+		{
+			fullmet = pin.bgcin.metarr;
+			fullyears = pin.bgcin.ctrl.metyears;
+			if (met_represent(&fullmet, fullyears, opts->repyears, &pin.bgcin.metarr, NULL, &pin.arena))
+			{
+				bgc_printf(BV_ERROR, "Error in call to met_represent() from point_run()\n");
+				err = BGC_ERR_INPUT;
+			}
+			pin.bgcin.ctrl.metyears = opts->repyears;
+			pin.bgcin.phenarr = NULL;
+		}
+		if (!err && opts->parareal && pin.bgcin.resume)
+		{
+			bgc_printf(BV_ERROR, "Error: a parareal spinup cannot continue a stopped run\n");
+			err = BGC_ERR_INI;
+		}
+		if (!err && opts->parareal)
+		{
+			if (spinup_parareal(&pin.bgcin, &pin.bgcout, opts->parareal))
+			{
+				bgc_printf(BV_ERROR, "Error in call to spinup_parareal()\n");
+				err = BGC_ERR_MODEL;
+			}
+		}
+		else if (!err && bgc(&pin.bgcin, &pin.bgcout,MODE_SPINUP))
+		{
+			bgc_printf(BV_ERROR, "Error in call to bgc()\n");
+			err = BGC_ERR_MODEL;
+		}
+		if (!err && pin.bgcout.stopped)
+		{
+			bgc_printf(BV_PROGRESS, "SPINUP: stopped early after %d years\n",pin.bgcout.spinup_years);
+		}
+		else if (!err)
+		{
+			bgc_printf(BV_PROGRESS, "SPINUP: residual trend  = %.6lf\n",pin.bgcout.spinup_resid_trend);
+			bgc_printf(BV_PROGRESS, "SPINUP: number of years = %d\n",pin.bgcout.spinup_years);
+		}
+		if (!err && opts->spincoarse) bgc_printf(BV_PROGRESS, "SPINUP: coarse years    = %d\n",pin.bgcout.stats.spinup_coarse);
+		if (fullyears)
+		{
+			/* back to the whole record. The spinup ends at the end of a
+			cycle, and the model starts at the first year of the record.
+			The representative years stay in the arena until the end. */
+			pin.bgcin.metarr = fullmet;
+			pin.bgcin.ctrl.metyears = fullyears;
+			pin.bgcout.restart_output.metyr = 0;
+		}
+		if (!err && opts->stats) bgc_stats_write(opts->stats, pin.init.name, "spinup", &pin.bgcout.stats);
+	}
+	else if (!err)
+	{
+		if (bgc(&pin.bgcin, &pin.bgcout, MODE_MODEL))
+		{
+			bgc_printf(BV_ERROR, "Error in call to bgc()\n");
+			err = BGC_ERR_MODEL;
+		}
+		else if (opts->stats) bgc_stats_write(opts->stats, pin.init.name, "model", &pin.bgcout.stats);
+	}
+		
+
+	/* if using an output restart file, write a record */
+	if (!err && restart_write(&pin))
+	{
+		bgc_printf(BV_ERROR, "Error in call to restart_write() from point_run()\n");
+		err = BGC_ERR_OUTPUT;
+	}
+	
+	/* Now do the Model part of Spin & Go. */
+	if (!err && cli_mode == MODE_SPINNGO && !pin.bgcout.stopped)
+	{
+		bgc_printf(BV_PROGRESS, "Finished Spinup for Spin 'n Go. Now starting Model run ('Go' part of Spin'n Go)\n");
+			
+		bgc_printf(BV_PROGRESS, "Assigned bgcout struct to bgcin for spinngo model run\n");
+		
+		pin.bgcin.ctrl.spinup = 0;
+		pin.output.doannavg = 1;
+		pin.output.doannual = 1;
+		pin.output.dodaily = 1;
+		pin.output.domonavg = 1;
+		
+		if (output_init(&pin.output))
+		{
+			bgc_printf(BV_ERROR, "Error in call to output_init() from point_run()\n");
+			err = BGC_ERR_OUTPUT;
+		}
+		
+		/* copy some of the info from input structure to bgc simulation control structure */
+		pin.bgcin.ctrl.dodaily = pin.output.dodaily;
+		pin.bgcin.ctrl.domonavg = pin.output.domonavg;
+		pin.bgcin.ctrl.doannavg = pin.output.doannavg;
+		pin.bgcin.ctrl.doannual = pin.output.doannual;
+	
+		/* copy the output file structures into bgcout */
+		if (pin.output.dodaily) pin.bgcout.dayout = pin.output.dayout;
+		if (pin.output.domonavg) pin.bgcout.monavgout = pin.output.monavgout;
+		if (pin.output.doannavg) pin.bgcout.annavgout = pin.output.annavgout;
+		if (pin.output.doannual) pin.bgcout.annout = pin.output.annout;
+		if (pin.output.bgc_ascii && pin.output.dodaily) pin.bgcout.dayoutascii = pin.output.dayoutascii;
+		if (pin.output.bgc_ascii && pin.output.domonavg) pin.bgcout.monoutascii = pin.output.monoutascii;
+		if (pin.output.bgc_ascii && pin.output.doannual) pin.bgcout.annoutascii = pin.output.annoutascii;
+		if (pin.output.bgc_ascii && pin.output.doannual) pin.bgcout.anntext = pin.output.anntext;
+		
+		/* initialize output files. Does nothing in spinup mode*/
+		
+		
+		pin.bgcin.ctrl.read_restart = 1;
+		pin.bgcin.restart_input = pin.bgcout.restart_output;
+		pin.bgcin.resume = NULL;
+		
+		if (!err && bgc(&pin.bgcin, &pin.bgcout, MODE_MODEL))
+		{
+			bgc_printf(BV_ERROR, "Error in call to bgc()\n");
+			err = BGC_ERR_MODEL;
+		}
+		if (!err && opts->stats) bgc_stats_write(opts->stats, pin.init.name, "model", &pin.bgcout.stats);
+		if (!err && pin.bgcout.stopped)
+		{
+			bgc_printf(BV_WARN, "Warning: the stopped model run of spin and go cannot be continued\n");
+		}
+		pin.restart.read_restart = 0;
+		pin.bgcin.ctrl.read_restart = 0;
+
+		if (!err) bgc_printf(BV_WARN, "Finished the bgc() Model call in spinngo\n");
+		
+	}
+
+	/* post-processing output handling, if any, goes here */
+
+	output_tap_close(opts->tap, pin.bgcout.tap);
+
+	if (point_close(&pin))
+	{
+		bgc_printf(BV_ERROR, "Error in call to point_close() from point_run()\n");
+		if (!err) err = BGC_ERR_OUTPUT;
+	}
+
+	if (err)
+	{
+		bgc_printf(BV_ERROR, "Error running %s (%s error)\n",ininame,bgc_error_name(err));
+		return (err);
+	}
+
+	return (pin.bgcout.stopped ? BGC_EXIT_STOPPED : 0);
+}
+
+/* release the memory and close the files of a simulation read by
+point_read() */
+int point_close(point_input_struct* pin)
+{
+	int ok=1;
+	
+	/* free memory: everything point_read() allocated is in the arena,
+	while shared and cached arrays belong to the caller */
+	arena_release(&pin->arena);
+	
+	/* close files. Only the files that are open are closed, so that a
+	simulation that point_read() could not finish is closed here too. */
+	file_close(&pin->init);
+	file_close(&pin->point.metf);
+	file_close(&pin->restart.in_restart);
+	if (file_close(&pin->restart.out_restart))
+	{
+		bgc_printf(BV_WARN, "Warning, error closing restart file after write: %s\n", strerror(errno));
+	}
+	/* the output files written to a container are memory streams, closed
+	with it after their last chunks are appended */
+	if (pin->output.container && output_container_close(pin->output.container))
+	{
+		bgc_printf(BV_ERROR, "Error in call to output_container_close() from point_close()\n");
+		ok=0;
+	}
+	pin->output.container = NULL;
+	file_close(&pin->output.dayout);
+	file_close(&pin->output.monavgout);
+	file_close(&pin->output.annavgout);
+	file_close(&pin->output.annout);
+	/* Close the ASCII output files */
+	file_close(&pin->output.dayoutascii);
+	file_close(&pin->output.monoutascii);
+	file_close(&pin->output.annoutascii);
+	
+	if (file_close(&pin->output.anntext))
+	{
+		bgc_printf(BV_WARN, "Warning, error closing ascii annual output file: %s\n", strerror(errno));
+	}
+	
+	return (!ok);
+}
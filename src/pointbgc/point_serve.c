@@ -0,0 +1,569 @@
+/*
+point_serve.c
+job server: a long-running bgc that takes point simulations to run from
+its standard input or from the clients of a UNIX domain socket, and runs
+them on a pool of threads
+
+Each job is an ini file, named by its path or sent inline, and is run as
+by bgc with the command line options the server was started with. The
+epc, met, CO2 and Ndep files and the phenology arrays are kept in a warm
+cache (point_cache.c) between jobs, so a job that uses the same inputs
+as an earlier one skips reading and parsing them. The protocol is one
+request per line:
+
+	<id> <ini file>      run the ini file
+	<id> -               run the ini file text on the following lines,
+	                     up to a line holding only '.'
+	stats                cache entries, hits and misses, and job counts
+	quit                 run the queued jobs, then end the server
+
+and one reply line per job when it finishes: '<id> done <seconds>',
+'<id> stopped <seconds>' for a job that stopped early (SIGTERM),
+'<id> error <seconds> <kind>' for a job that failed (see
+bgc_error_name()), or '<id> error <message>'. The ids are the client's own and are only echoed
+back. Replies are written in the order the jobs finish.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "pointbgc.h"
+
+/* longest request line and inline ini file */
+#define SERVE_LINE 1024
+#define SERVE_INIMAX (1 << 20)
+
+/* time between checks for a stop while waiting for clients */
+#define SERVE_POLL_MS 200
+
+/* a client: the requests are read from in, and the replies written to
+out. It is freed when it has hung up and its last job has finished. */
+typedef struct serve_client_struct
+{
+	struct serve_client_struct* next; /* clients being read from */
+	FILE* in;
+	FILE* out;
+	pthread_mutex_t lock;       /* for out and refs */
+	int refs;                   /* the reader, and each queued or running job */
+	int owned;                  /* (flag) 1=close in and out when freed */
+} serve_client_struct;
+
+typedef struct serve_job_struct
+{
+	struct serve_job_struct* next;
+	char id[64];
+	char ini[128];              /* ini file, or the id for inline text */
+	char* text;                 /* inline ini text, or NULL */
+	serve_client_struct* client;
+} serve_job_struct;
+
+/* the server, shared by the reader and worker threads */
+typedef struct
+{
+	const point_opts_struct* opts;
+	point_cache_struct* cache;
+	pthread_mutex_t lock;       /* for the queue, the counts and quit */
+	pthread_cond_t ready;       /* a job was queued, or quit was set */
+	pthread_cond_t idle;        /* a reader ended */
+	serve_job_struct *head, *tail;
+	serve_client_struct* clients; /* clients with a reader */
+	int readers;
+	int quit;                   /* (flag) 1=no more jobs are taken */
+	long queued, running, done, stopped;
+} serve_struct;
+
+static void client_reply(serve_client_struct* client, const char* format, ...)
+{
+	va_list ap;
+
+	pthread_mutex_lock(&client->lock);
+	va_start(ap, format);
+	vfprintf(client->out, format, ap);
+	va_end(ap);
+	fflush(client->out);
+	pthread_mutex_unlock(&client->lock);
+}
+
+static void client_release(serve_client_struct* client)
+{
+	int refs;
+
+	pthread_mutex_lock(&client->lock);
+	refs = --client->refs;
+	pthread_mutex_unlock(&client->lock);
+	if (refs) return;
+	if (client->owned)
+	{
+		fclose(client->in);
+		fclose(client->out);
+	}
+	pthread_mutex_destroy(&client->lock);
+	free(client);
+}
+
+static void job_free(serve_job_struct* job)
+{
+	client_release(job->client);
+	free(job->text);
+	free(job);
+}
+
+/* queue a job, or refuse it once the server is ending */
+static int serve_queue(serve_struct* srv, serve_job_struct* job)
+{
+	int ok=1;
+
+	pthread_mutex_lock(&srv->lock);
+	if (srv->quit || bgc_stop_signal) ok=0;
+	else
+	{
+		pthread_mutex_lock(&job->client->lock);
+		job->client->refs++;
+		pthread_mutex_unlock(&job->client->lock);
+		job->next = NULL;
+		if (srv->tail) srv->tail->next = job;
+		else srv->head = job;
+		srv->tail = job;
+		srv->queued++;
+		pthread_cond_signal(&srv->ready);
+	}
+	pthread_mutex_unlock(&srv->lock);
+
+	return (!ok);
+}
+
+static void serve_quit(serve_struct* srv)
+{
+	pthread_mutex_lock(&srv->lock);
+	srv->quit = 1;
+	pthread_cond_broadcast(&srv->ready);
+	pthread_mutex_unlock(&srv->lock);
+}
+
+static void* serve_worker(void* arg)
+{
+	serve_struct* srv = (serve_struct*) arg;
+	serve_job_struct* job;
+	point_shared_struct shared;
+	struct timespec t0, t1;
+	int rc;
+
+	memset(&shared, 0, sizeof(point_shared_struct));
+	shared.cache = srv->cache;
+	for (;;)
+	{
+		pthread_mutex_lock(&srv->lock);
+		while (!srv->head && !srv->quit) pthread_cond_wait(&srv->ready, &srv->lock);
+		if (!(job = srv->head))
+		{
+			pthread_mutex_unlock(&srv->lock);
+			break;
+		}
+		if (!(srv->head = job->next)) srv->tail = NULL;
+		srv->queued--;
+		srv->running++;
+		pthread_mutex_unlock(&srv->lock);
+
+		/* after a SIGTERM the queued jobs are not started */
+		if (bgc_stop_signal)
+		{
+			client_reply(job->client, "%s error not run, the server is stopping\n", job->id);
+			rc = -1;
+		}
+		else
+		{
+			shared.initext = job->text;
+			clock_gettime(CLOCK_MONOTONIC, &t0);
+			rc = point_run(job->ini, srv->opts, &shared);
+			clock_gettime(CLOCK_MONOTONIC, &t1);
+			client_reply(job->client, "%s %s %.3f%s%s\n", job->id,
+				(rc == BGC_EXIT_STOPPED) ? "stopped" : (rc ? "error" : "done"),
+				(t1.tv_sec - t0.tv_sec) + 1e-9 * (t1.tv_nsec - t0.tv_nsec),
+				(rc && rc != BGC_EXIT_STOPPED) ? " " : "",
+				(rc && rc != BGC_EXIT_STOPPED) ? bgc_error_name(rc) : "");
+		}
+
+		pthread_mutex_lock(&srv->lock);
+		srv->running--;
+		if (rc == BGC_EXIT_STOPPED) srv->stopped++;
+		else if (!rc) srv->done++;
+		pthread_mutex_unlock(&srv->lock);
+		job_free(job);
+	}
+
+	return NULL;
+}
+
+/* take a client off the list of clients with a reader, when its reader
+ends, and drop the reference of the reader */
+static void client_detach(serve_struct* srv, serve_client_struct* client)
+{
+	serve_client_struct** c;
+
+	pthread_mutex_lock(&srv->lock);
+	for (c=&srv->clients ; *c != client ; c=&(*c)->next);
+	*c = client->next;
+	srv->readers--;
+	pthread_cond_broadcast(&srv->idle);
+	pthread_mutex_unlock(&srv->lock);
+	client_release(client);
+}
+
+/* read the inline ini text of a job, up to a line holding only '.' */
+static char* read_initext(FILE* in)
+{
+	char line[SERVE_LINE];
+	char *text, *more;
+	size_t len = 0, n;
+	int ok=1;
+
+	if (!(text = (char*) calloc(1, 1))) return (NULL);
+	while (ok && fgets(line, sizeof(line), in))
+	{
+		if (!strcmp(line, ".\n") || !strcmp(line, ".\r\n") || !strcmp(line, ".")) return (text);
+		n = strlen(line);
+		if (len + n >= SERVE_INIMAX || !(more = (char*) realloc(text, len + n + 1))) ok=0;
+		else
+		{
+			text = more;
+			memcpy(text + len, line, n + 1);
+			len += n;
+		}
+	}
+	free(text);
+
+	return (NULL);
+}
+
+/* read and queue the requests of one client until it hangs up or asks
+the server to quit */
+static void* serve_reader(void* arg)
+{
+	serve_client_struct* client = (serve_client_struct*) ((void**) arg)[0];
+	serve_struct* srv = (serve_struct*) ((void**) arg)[1];
+	char line[SERVE_LINE], id[64], ini[128], report[256];
+	int id0, id1, ini0, ini1, c;
+	size_t n;
+	serve_job_struct* job;
+
+	free(arg);
+	while (fgets(line, sizeof(line), client->in))
+	{
+		/* start and end of the id and of the ini file name, so that a
+		token too long for the job is refused instead of cut short */
+		id0 = id1 = ini0 = ini1 = 0;
+		sscanf(line, " %n%*s%n %n%*s%n", &id0, &id1, &ini0, &ini1);
+		/* the rest of a line that does not fit is dropped, rather than
+		read as the next request */
+		n = strlen(line);
+		if (n == sizeof(line) - 1 && line[n-1] != '\n')
+		{
+			while ((c = fgetc(client->in)) != EOF && c != '\n');
+			if (line[0] != '#') client_reply(client, "%.*s error request longer than %d characters\n",
+				id1 - id0, line + id0, SERVE_LINE - 2);
+			continue;
+		}
+		if (line[0] == '#' || id1 == 0) continue;
+		if (id1 - id0 >= (int) sizeof(id))
+		{
+			client_reply(client, "%.*s error id longer than %d characters\n",
+				id1 - id0, line + id0, (int) sizeof(id) - 1);
+			continue;
+		}
+		memcpy(id, line + id0, id1 - id0);
+		id[id1 - id0] = '\0';
+		if (!strcmp(id, "quit"))
+		{
+			client_reply(client, "quit ok\n");
+			serve_quit(srv);
+			break;
+		}
+		if (!strcmp(id, "stats"))
+		{
+			point_cache_report(srv->cache, report, sizeof(report));
+			pthread_mutex_lock(&srv->lock);
+			client_reply(client, "stats %s jobs %ld %ld %ld %ld\n", report,
+				srv->queued, srv->running, srv->done, srv->stopped);
+			pthread_mutex_unlock(&srv->lock);
+			continue;
+		}
+		if (ini1 == 0)
+		{
+			client_reply(client, "%s error expecting '<id> <ini file>' or '<id> -'\n", id);
+			continue;
+		}
+		if (ini1 - ini0 >= (int) sizeof(ini))
+		{
+			client_reply(client, "%s error ini file name longer than %d characters\n",
+				id, (int) sizeof(ini) - 1);
+			continue;
+		}
+		memcpy(ini, line + ini0, ini1 - ini0);
+		ini[ini1 - ini0] = '\0';
+		if (!(job = (serve_job_struct*) calloc(1, sizeof(serve_job_struct))))
+		{
+			client_reply(client, "%s error out of memory\n", id);
+			continue;
+		}
+		strcpy(job->id, id);
+		job->client = client;
+		if (!strcmp(ini, "-"))
+		{
+			/* the id names the inline ini file in the messages */
+			strcpy(job->ini, id);
+			if (!(job->text = read_initext(client->in)))
+			{
+				client_reply(client, "%s error reading the ini text\n", id);
+				free(job);
+				continue;
+			}
+		}
+		else strcpy(job->ini, ini);
+		if (serve_queue(srv, job))
+		{
+			client_reply(client, "%s error not run, the server is stopping\n", id);
+			free(job->text);
+			free(job);
+		}
+	}
+	client_detach(srv, client);
+
+	return NULL;
+}
+
+/* a client for the streams in and out, with one reference held by its
+reader, and the argument of serve_reader() for it */
+static void** client_new(serve_struct* srv, FILE* in, FILE* out, int owned)
+{
+	serve_client_struct* client;
+	void** arg;
+
+	if (!(client = (serve_client_struct*) calloc(1, sizeof(serve_client_struct))) ||
+		!(arg = (void**) malloc(2 * sizeof(void*))))
+	{
+		free(client);
+		bgc_printf(BV_ERROR, "Error allocating a client: point_serve()\n");
+		return (NULL);
+	}
+	client->in = in;
+	client->out = out;
+	client->owned = owned;
+	client->refs = 1;
+	pthread_mutex_init(&client->lock, NULL);
+	arg[0] = client;
+	arg[1] = srv;
+	pthread_mutex_lock(&srv->lock);
+	client->next = srv->clients;
+	srv->clients = client;
+	srv->readers++;
+	pthread_mutex_unlock(&srv->lock);
+
+	return (arg);
+}
+
+/* accept clients on the UNIX domain socket sockname until a client
+asks the server to quit, or a signal stops it. Each client has its own
+reader thread. */
+static int serve_socket(serve_struct* srv, const char* sockname)
+{
+	int ok=1;
+	int fd, cfd, cfd2;
+	int quit = 0;
+	struct sockaddr_un addr;
+	struct pollfd pfd;
+	FILE *in, *out;
+	void** arg;
+	pthread_t reader;
+	pthread_attr_t attr;
+	serve_client_struct* client;
+
+	if (strlen(sockname) >= sizeof(addr.sun_path))
+	{
+		bgc_printf(BV_ERROR, "Error: socket name %s is too long: point_serve()\n",sockname);
+		return (1);
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, sockname);
+	unlink(sockname);
+	if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+		bind(fd, (struct sockaddr*) &addr, sizeof(addr)) || listen(fd, 16))
+	{
+		bgc_printf(BV_ERROR, "Error listening on socket %s: %s\n",sockname,strerror(errno));
+		if (fd >= 0) close(fd);
+		return (1);
+	}
+	bgc_printf(BV_PROGRESS, "Serving jobs on socket %s\n",sockname);
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	while (ok && !quit && !bgc_stop_signal)
+	{
+		if (poll(&pfd, 1, SERVE_POLL_MS) <= 0 || !(pfd.revents & POLLIN))
+		{
+			pthread_mutex_lock(&srv->lock);
+			quit = srv->quit;
+			pthread_mutex_unlock(&srv->lock);
+			continue;
+		}
+		if ((cfd = accept(fd, NULL, NULL)) < 0) continue;
+		cfd2 = dup(cfd);
+		in = fdopen(cfd, "r");
+		out = (cfd2 >= 0) ? fdopen(cfd2, "w") : NULL;
+		if (!in || !out)
+		{
+			bgc_printf(BV_WARN, "Warning: error opening client streams: %s\n",strerror(errno));
+			if (in) fclose(in);
+			else close(cfd);
+			if (out) fclose(out);
+			else if (cfd2 >= 0) close(cfd2);
+			continue;
+		}
+		if (!(arg = client_new(srv, in, out, 1)))
+		{
+			fclose(in);
+			fclose(out);
+			ok=0;
+		}
+		else if (pthread_create(&reader, &attr, serve_reader, arg))
+		{
+			bgc_printf(BV_ERROR, "Error starting a client reader thread: point_serve()\n");
+			client_detach(srv, (serve_client_struct*) arg[0]);
+			free(arg);
+			ok=0;
+		}
+	}
+	pthread_attr_destroy(&attr);
+	close(fd);
+	unlink(sockname);
+
+	/* hang up on the clients that are still connected, and wait for
+	their readers to end */
+	pthread_mutex_lock(&srv->lock);
+	while (srv->readers)
+	{
+		for (client=srv->clients ; client ; client=client->next)
+		{
+			shutdown(fileno(client->in), SHUT_RDWR);
+		}
+		pthread_cond_wait(&srv->idle, &srv->lock);
+	}
+	pthread_mutex_unlock(&srv->lock);
+
+	return (!ok);
+}
+
+/* run the job server on the UNIX domain socket sockname, or on the
+standard input and output when sockname is NULL, with nthreads workers
+(0 = one per processor). Returns when a client sends quit, at the end of
+the standard input, or on SIGTERM or SIGINT, which stop the running jobs
+early as they would stop bgc. */
+int point_serve(const char* sockname, int nthreads, const point_opts_struct* opts)
+{
+	int ok=1;
+	int i, nstarted = 0, fd;
+	serve_struct srv;
+	pthread_t* threads = NULL;
+	struct sigaction sa;
+	FILE* out = NULL;
+	void** arg;
+
+	memset(&srv, 0, sizeof(serve_struct));
+	srv.opts = opts;
+	if (!(srv.cache = point_cache_new()))
+	{
+		bgc_printf(BV_ERROR, "Error in call to point_cache_new() from point_serve()\n");
+		return (1);
+	}
+	pthread_mutex_init(&srv.lock, NULL);
+	pthread_cond_init(&srv.ready, NULL);
+	pthread_cond_init(&srv.idle, NULL);
+
+	/* stop the running jobs on SIGTERM and SIGINT, without restarting
+	the reads and polls of the server, so that it notices. A client that
+	hangs up is seen as the end of its requests, not as SIGPIPE. */
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = bgc_stop_handler;
+	sigemptyset(&sa.sa_mask);
+	if (sigaction(SIGTERM, &sa, NULL) || sigaction(SIGINT, &sa, NULL))
+	{
+		bgc_printf(BV_ERROR, "Error setting the signal handlers: point_serve()\n");
+		ok=0;
+	}
+	sa.sa_handler = SIG_IGN;
+	sigaction(SIGPIPE, &sa, NULL);
+
+	if (nthreads <= 0) nthreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	if (nthreads <= 0) nthreads = 1;
+	if (ok && !(threads = (pthread_t*) malloc(nthreads * sizeof(pthread_t))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating for %d threads: point_serve()\n",nthreads);
+		ok=0;
+	}
+	for (i=0 ; ok && i<nthreads ; i++)
+	{
+		if (pthread_create(&threads[i], NULL, serve_worker, &srv))
+		{
+			bgc_printf(BV_ERROR, "Error starting worker thread %d: point_serve()\n",i);
+			ok=0;
+		}
+		else nstarted++;
+	}
+
+	if (ok && sockname)
+	{
+		if (serve_socket(&srv, sockname))
+		{
+			bgc_printf(BV_ERROR, "Error in call to serve_socket() from point_serve()\n");
+			ok=0;
+		}
+	}
+	else if (ok)
+	{
+		/* the replies get the standard output to themselves, and the
+		messages of the jobs go to the standard error */
+		if ((fd = dup(STDOUT_FILENO)) < 0 || !(out = fdopen(fd, "w")) ||
+			dup2(STDERR_FILENO, STDOUT_FILENO) < 0)
+		{
+			bgc_printf(BV_ERROR, "Error redirecting the standard output: point_serve()\n");
+			ok=0;
+		}
+		else if (!(arg = client_new(&srv, stdin, out, 0)))
+		{
+			ok=0;
+		}
+		else
+		{
+			bgc_printf(BV_PROGRESS, "Serving jobs on the standard input with %d threads\n",nthreads);
+			serve_reader(arg);
+		}
+	}
+
+	/* run the queued jobs, then end the workers */
+	serve_quit(&srv);
+	for (i=0 ; i<nstarted ; i++)
+	{
+		pthread_join(threads[i], NULL);
+	}
+	bgc_printf(BV_PROGRESS, "Ran %ld jobs (%ld stopped early) on %d threads\n",
+		srv.done + srv.stopped, srv.stopped, nthreads);
+
+	if (out) fclose(out);
+	pthread_cond_destroy(&srv.ready);
+	pthread_cond_destroy(&srv.idle);
+	pthread_mutex_destroy(&srv.lock);
+	point_cache_delete(srv.cache);
+	free(threads);
+
+	return (!ok);
+}
@@ -16,23 +16,13 @@ signed char cli_mode = MODE_INI;
 
 int main(int argc, char *argv[])
 {
-	/* bgc input and output structures */
-	bgcin_struct bgcin;
-	bgcout_struct bgcout;
-
-	/* local control information */
-	point_struct point;
-	restart_ctrl_struct restart;
-	climchange_struct scc;
-	output_struct output;
+	/* options for the simulation */
+	point_opts_struct opts;
 	
-	/* initialization file */
-	file init;
+	/* ndep and run statistics files */
 	file ndep_file;
-
-	/* system time variables */
-	struct tm *tm_ptr;
-	time_t lt;
+	file stats_file;
+	file telem_file;
 
 	extern signed char summary_sanity;
 
@@ -43,15 +33,45 @@ int main(int argc, char *argv[])
 	extern char *optarg;
 	extern signed char cli_mode; /* What cli requested mode to run in.*/
 	int readndepfile = 0;		/* Flag to tell the program to read an external NDEP file passed using getpopt -n */
+	int balance_mode = BALANCE_DAILY;	/* mass balance check mode, set with -b */
+	int balance_interval = 1;
+	int writestats = 0;		/* Flag to write run statistics to the file passed using -S */
+	int writetelem = 0;		/* Flag to write spinup telemetry to the file passed using -T */
+	int branchyear = 0;		/* Year to branch into the scenario ini files, set with -B */
+	int nthreads = 0;		/* Threads for the scenarios, set with -j, 0 = one per processor */
+	int repyears = 0;		/* Representative met years for the spinup, set with -Y, 0 = whole record */
+	int spincoarse = 0;		/* Coarse spinup years per daily year, set with -K, 0 = off */
+	int parareal = 0;		/* Slices for a parareal spinup, set with -P, 0 = off */
+	int stop_wall = 0;		/* Wall clock budget in seconds, set with -W, 0 = none */
+	int stop_years = 0;		/* Simulated year budget, set with -y, 0 = none */
+	int resume = 0;			/* Flag to continue a stopped run, set with -c */
+	char* tap = NULL;		/* Shared memory name of the live output tap, set with -t */
+	int serve = 0;			/* Flag to run the job server, set with --serve */
+	char* sockname = NULL;		/* Socket of the job server, set with --serve=<socket> */
+	int i;
+	int rc = 0;
 	
-	bgcin.ndepctrl.varndep = 0;
 	/* Store command name for use by bgc_print_usage() */
 	argv_zero = (char *)malloc(strlen(argv[0])+1);
 	strncpy(argv_zero, argv[0], strlen(argv[0])+1);
 
+	/* take out the long option --serve{=<socket>} before getopt sees it */
+	for (i=1 ; i<argc ; i++)
+	{
+		if (!strcmp(argv[i], "--")) break;
+		if (!strcmp(argv[i], "--serve") || !strncmp(argv[i], "--serve=", 8))
+		{
+			serve = 1;
+			sockname = (argv[i][7] == '=' && argv[i][8]) ? argv[i] + 8 : NULL;
+			memmove(&argv[i], &argv[i+1], (argc - i) * sizeof(char*));
+			argc--;
+			i--;
+		}
+	}
+
 	/* Process command line arguments */
 	opterr = 0;
-	while((c = getopt(argc, argv, "pVsl:v:ugmn:a")) != -1)
+	while((c = getopt(argc, argv, "pVsl:v:ugmn:ab:S:T:B:j:Y:K:P:W:y:ct:")) != -1)
 	{
 		switch(c)
 		{
@@ -64,9 +84,10 @@ int main(int argc, char *argv[])
 				break;
 			case 'v':
 				bgc_verbosity = bgc_verbosity_decode(optarg);
+				if (bgc_verbosity == BV_UNKNOWN) exit(EXIT_FAILURE);
 				break;
 			case 'l':
-				bgc_logfile_setup(optarg);
+				if (bgc_logfile_setup(optarg)) exit(EXIT_FAILURE);
 				bgc_printf(BV_DIAG, "Using logfile for output.\n");
 				break;
 			case 'p':
@@ -88,7 +109,47 @@ int main(int argc, char *argv[])
 				strcpy(ndep_file.name,optarg);
 				bgc_printf(BV_DIAG,"Using annual NDEP file: %s\n",ndep_file.name);
 				readndepfile = 1;
-				bgcin.ndepctrl.varndep = 1;
+				break;
+			case 'b':  /* mass balance check mode */
+				balance_mode = bgc_balance_decode(optarg, &balance_interval);
+				if (balance_mode == BALANCE_UNKNOWN) exit(EXIT_FAILURE);
+				break;
+			case 'S':  /* run statistics file */
+				strcpy(stats_file.name,optarg);
+				bgc_printf(BV_DIAG,"Writing run statistics to: %s\n",stats_file.name);
+				writestats = 1;
+				break;
+			case 'T':  /* spinup telemetry file */
+				strcpy(telem_file.name,optarg);
+				bgc_printf(BV_DIAG,"Writing spinup telemetry to: %s\n",telem_file.name);
+				writetelem = 1;
+				break;
+			case 'B':  /* branch year, the scenario ini files follow the ini file */
+				branchyear = atoi(optarg);
+				break;
+			case 'j':  /* threads for the scenarios */
+				nthreads = atoi(optarg);
+				break;
+			case 'Y':  /* spinup on representative met years */
+				repyears = atoi(optarg);
+				break;
+			case 'K':  /* coarse spinup steps */
+				spincoarse = atoi(optarg);
+				break;
+			case 'P':  /* parareal spinup */
+				parareal = atoi(optarg);
+				break;
+			case 'W':  /* wall clock budget */
+				stop_wall = atoi(optarg);
+				break;
+			case 'y':  /* simulated year budget */
+				stop_years = atoi(optarg);
+				break;
+			case 'c':  /* continue a stopped run */
+				resume = 1;
+				break;
+			case 't':  /* live output tap */
+				tap = optarg;
 				break;
 				
 			case '?':
@@ -116,338 +177,115 @@ int main(int argc, char *argv[])
 		
 	bgc_printf(BV_DIAG, "Done processing CLI arguments.\n");
 
-	/* get the system time at start of simulation */
-	lt = time(NULL);
-	tm_ptr = localtime(&lt);
-	strcpy(point.systime,asctime(tm_ptr));
-	/* Andrew tried this, you shouldn't. localtime returns a global extern. */
-	/* free(tm_ptr); */
-	output.anncodes = NULL;
-	output.daycodes = NULL;
-	output.bgc_ascii = bgc_ascii;
-	
-	/* initialize the bgcin state variable structures before filling with
-	values from ini file */
-	if (presim_state_init(&bgcin.ws, &bgcin.cs, &bgcin.ns, &bgcin.cinit))
-	{
-		bgc_printf(BV_ERROR, "Error in call to presim_state_init() from pointbgc()\n");
-		exit(EXIT_FAILURE);
-	}
-
-	/******************************
-	**                           **
-	**  BEGIN READING INIT FILE  **
-	**                           **
-	******************************/
-
-	/* read the name of the main init file from the command line
-	and store as init.name */
-	if (optind >= argc )
+	/* read the name of the main init file from the command line */
+	if (optind >= argc && !serve)
 	{
 		bgc_print_usage();
 		exit(EXIT_FAILURE);
 	}
-	strcpy(init.name, argv[optind]);
 	
-	/* open the main init file for ascii read and check for errors */
-	if (file_open(&init,'i'))
-	{
-		bgc_printf(BV_ERROR, "Error opening init file, pointbgc.c\n");
-		exit(EXIT_FAILURE);
-	}
-
-	/* read the header string from the init file */
-	if (fgets(point.header, 100, init.ptr)==NULL)
-	{
-		bgc_printf(BV_ERROR, "Error reading header string: pointbgc.c\n");
-		exit(EXIT_FAILURE);
-	}
-
-	/* open met file, discard header lines */
-	if (met_init(init, &point))
-	{
-		bgc_printf(BV_ERROR, "Error in call to met_init() from pointbgc.c... Exiting\n");
-		exit(EXIT_FAILURE);
-	}
-
-	/* read restart control parameters */
-	if (restart_init(init, &restart))
-	{
-		bgc_printf(BV_ERROR, "Error in call to restart_init() from pointbgc.c... Exiting\n");
-		exit(EXIT_FAILURE);
-	}
-
-	/* read simulation timing control parameters */
-	if (time_init(init, &(bgcin.ctrl)))
-	{
-		bgc_printf(BV_ERROR, "Error in call to epclist_init() from pointbgc.c... Exiting\n");
-		exit(EXIT_FAILURE);
-	}
-	
-	/* read scalar climate change parameters */
-	if (scc_init(init, &scc))
-	{
-		bgc_printf(BV_ERROR, "Error in call to scc_init() from pointbgc.c... Exiting\n");
-		exit(EXIT_FAILURE);
-	}
+	/* options that apply to the simulation */
+	opts.bgc_ascii = bgc_ascii;
+	opts.readndepfile = readndepfile;
+	opts.ndep_file = ndep_file;
+	opts.balance_mode = balance_mode;
+	opts.balance_interval = balance_interval;
+	opts.stats = NULL;
+	opts.telemetry = NULL;
+	opts.telem_last = NULL;
+	opts.repyears = repyears;
+	opts.spincoarse = spincoarse;
+	opts.parareal = parareal;
+	/* the scenarios do not stop early */
+	opts.stop_wall = branchyear ? 0 : stop_wall;
+	opts.stop_years = branchyear ? 0 : stop_years;
+	opts.resume = branchyear ? 0 : resume;
+	/* the scenarios and the jobs of the server are not tapped */
+	opts.tap = (branchyear || serve) ? NULL : tap;
+	opts.container = NULL;
+	opts.container_site = 0;
 	
-	/* read CO2 control parameters */
-	if (co2_init(init, &(bgcin.co2), bgcin.ctrl.simyears))
-	{
-		bgc_printf(BV_ERROR, "Error in call to co2_init() from pointbgc.c... Exiting\n");
-		exit(EXIT_FAILURE);
-	}
-	if(readndepfile)
+	/* run the job server until it is told to quit */
+	if (serve)
 	{
-		if (ndep_init(ndep_file, &(bgcin.ndepctrl)))
+		if (writestats || writetelem || branchyear)
+		{
+			bgc_printf(BV_WARN, "Warning: -S, -T and -B are not used with --serve\n");
+		}
+		if (point_serve(sockname, nthreads, &opts))
 		{
-			bgc_printf(BV_ERROR, "Error in call to ndep_init() from pointbgc.c... Exiting\n");
+			bgc_printf(BV_ERROR, "Error in call to point_serve() from pointbgc.c... Exiting\n");
 			exit(EXIT_FAILURE);
 		}
-	}
-	/* read site constants */
-	if (sitec_init(init, &bgcin.sitec))
-	{
-		bgc_printf(BV_ERROR, "Error in call to sitec_init() from pointbgc.c... Exiting\n");
-		exit(EXIT_FAILURE);
+		bgc_logfile_finish();
+		free(argv_zero);
+		return EXIT_SUCCESS;
 	}
 	
-	/* read ramped nitrogen deposition block */
-	if (ramp_ndep_init(init, &bgcin.ramp_ndep))
+	/* stop cleanly on SIGTERM and SIGINT. The parareal spinup and the
+	scenarios do not stop early, so a signal ends them at once. */
+	if (!branchyear && !parareal && bgc_catch_signals())
 	{
-		bgc_printf(BV_ERROR, "Error in call to ramp_ndep_init() from pointbgc.c... Exiting\n");
+		bgc_printf(BV_ERROR, "Error in call to bgc_catch_signals() from pointbgc.c... Exiting\n");
 		exit(EXIT_FAILURE);
 	}
 	
-	/* read ecophysiological constants */
-	if (epc_init(init, &bgcin.epc))
+	/* open the run statistics file and write the column names. A
+	continued run adds to the file of the stopped run. */
+	if (writestats)
 	{
-		bgc_printf(BV_ERROR, "Error in call to epc_init() from pointbgc.c... Exiting\n");
-		exit(EXIT_FAILURE);
-	}
-
-	/* initialize water state structure */
-	if (wstate_init(init, &bgcin.sitec, &bgcin.ws))
-	{
-		bgc_printf(BV_ERROR, "Error in call to wstate_init() from pointbgc.c... Exiting\n");
-		exit(EXIT_FAILURE);
-	}
-
-	/* initialize carbon and nitrogen state structures */
-	if (cnstate_init(init, &bgcin.epc, &bgcin.cs, &bgcin.cinit,
-		&bgcin.ns))
-	{
-		bgc_printf(BV_ERROR, "Error in call to cstate_init() from pointbgc.c... Exiting\n");
-		exit(EXIT_FAILURE);
-	}
-
-	/* read the output control information */
-	if (output_ctrl(init, &output))
-	{
-		bgc_printf(BV_ERROR, "Error in call to output_ctrl() from pointbgc.c... Exiting\n");
-		exit(EXIT_FAILURE);
-	}
-	
-	/* initialize output files. Does nothing in spinup mode*/
-	if (output_init(&output))
-	{
-		bgc_printf(BV_ERROR, "Error in call to output_init() from pointbgc.c... Exiting\n");
-		exit(EXIT_FAILURE);
-	}
-	
-	/* read final line out of init file to test for proper file structure */
-	if (end_init(init))
-	{
-		bgc_printf(BV_ERROR, "Error in call to end_init() from pointbgc.c... exiting\n");
-		exit(EXIT_FAILURE);
-	}
-	fclose(init.ptr);
-
-	/* read meteorology file, build metarr arrays, compute running avgs */
-	if (metarr_init(point.metf, &bgcin.metarr, &scc, bgcin.ctrl.metyears))
-	{
-		bgc_printf(BV_ERROR, "Error in call to metarr_init() from pointbgc.c... Exiting\n");
-		exit(EXIT_FAILURE);
-	}
-	fclose(point.metf.ptr);
-
-	/* copy some of the info from input structure to bgc simulation control
-	structure */
-	bgcin.ctrl.onscreen = output.onscreen;
-	bgcin.ctrl.dodaily = output.dodaily;
-	bgcin.ctrl.domonavg = output.domonavg;
-	bgcin.ctrl.doannavg = output.doannavg;
-	bgcin.ctrl.doannual = output.doannual;
-	bgcin.ctrl.ndayout = output.ndayout;
-	bgcin.ctrl.nannout = output.nannout;
-	bgcin.ctrl.daycodes = output.daycodes;
-	bgcin.ctrl.anncodes = output.anncodes;
-	bgcin.ctrl.read_restart = restart.read_restart;
-	bgcin.ctrl.write_restart = restart.write_restart;
-	bgcin.ctrl.keep_metyr = restart.keep_metyr;
-	
-	/* copy the output file structures into bgcout */
-	if (output.dodaily) bgcout.dayout = output.dayout;
-	if (output.domonavg) bgcout.monavgout = output.monavgout;
-	if (output.doannavg) bgcout.annavgout = output.annavgout;
-	if (output.doannual) bgcout.annout = output.annout;
-	if (output.bgc_ascii && output.dodaily) bgcout.dayoutascii = output.dayoutascii;
-	if (output.bgc_ascii && output.domonavg) bgcout.monoutascii = output.monoutascii;
-	if (output.bgc_ascii && output.doannual) bgcout.annoutascii = output.annoutascii;
-	bgcout.anntext = output.anntext;
-	bgcout.bgc_ascii = bgc_ascii;
-	
-	/* if using ramped Ndep, copy preindustrial Ndep into ramp_ndep struct */
-	if (bgcin.ramp_ndep.doramp)
-	{
-		bgcin.ramp_ndep.preind_ndep = bgcin.sitec.ndep;
-	}
-	
-	/* if using an input restart file, read a record */
-	if (restart.read_restart)
-	{
-		/* 02/06/04
-		 * The if statement gaurds against core dump on bad restart file.
-		 * If spinup exits with error then the norm trys to use the restart,
-		 * that has nothing in it, a seg fault occurs. Amac */
-		if( fread(&(bgcin.restart_input),sizeof(restart_data_struct),1,restart.in_restart.ptr) == 0)
+		if (file_open(&stats_file,resume ? 'e' : 'o') ||
+			(ftell(stats_file.ptr) == 0 && bgc_stats_header(stats_file.ptr)))
 		{
-			bgc_printf(BV_ERROR, "Error reading restart file! 0 bytes read. Aborting..\n");
+			bgc_printf(BV_ERROR, "Error opening run statistics file, pointbgc.c\n");
 			exit(EXIT_FAILURE);
 		}
+		opts.stats = stats_file.ptr;
 	}
 
-	/*********************
-	**                  **
-	**  CALL BIOME-BGC  **
-	**                  **
-	*********************/
-
-	/* all initialization complete, call model */
-	/* either call the spinup code or the normal simulation code */
-	if (bgcin.ctrl.spinup)
-	{
-		if (bgc(&bgcin, &bgcout,MODE_SPINUP))
-		{
-			bgc_printf(BV_ERROR, "Error in call to bgc()\n");
-			exit(EXIT_FAILURE);
-		}
-		bgc_printf(BV_PROGRESS, "SPINUP: residual trend  = %.6lf\n",bgcout.spinup_resid_trend);
-		bgc_printf(BV_PROGRESS, "SPINUP: number of years = %d\n",bgcout.spinup_years);
-	}
-	else
+	/* open the spinup telemetry file and write the column names */
+	if (writetelem)
 	{
-		if (bgc(&bgcin, &bgcout, MODE_MODEL))
+		if (file_open(&telem_file,resume ? 'e' : 'o') ||
+			(ftell(telem_file.ptr) == 0 && bgc_telemetry_header(telem_file.ptr)))
 		{
-			bgc_printf(BV_ERROR, "Error in call to bgc()\n");
+			bgc_printf(BV_ERROR, "Error opening spinup telemetry file, pointbgc.c\n");
 			exit(EXIT_FAILURE);
 		}
-	}
-		
-
-	/* if using an output restart file, write a record */
-	if (restart.write_restart)
-	{
-		fwrite(&(bgcout.restart_output),sizeof(restart_data_struct),1,
-			restart.out_restart.ptr);
+		opts.telemetry = telem_file.ptr;
 	}
 	
-	/* Now do the Model part of Spin & Go. */
-	if (cli_mode == MODE_SPINNGO)
+	/* read the init file and run the simulation, or with -B run it up to
+	the branch year and run each scenario ini file from there */
+	if (branchyear)
 	{
-		bgc_printf(BV_PROGRESS, "Finished Spinup for Spin 'n Go. Now starting Model run ('Go' part of Spin'n Go)\n");
-			
-		bgc_printf(BV_PROGRESS, "Assigned bgcout struct to bgcin for spinngo model run\n");
-		
-		bgcin.ctrl.spinup = 0;
-		output.doannavg = 1;
-		output.doannual = 1;
-		output.dodaily = 1;
-		output.domonavg = 1;
-		
-		if (output_init(&output))
+		if (optind + 1 >= argc)
 		{
-			bgc_printf(BV_ERROR, "Error in call to output_init() from pointbgc.c... Exiting\n");
+			bgc_print_usage();
 			exit(EXIT_FAILURE);
 		}
-		
-		/* copy some of the info from input structure to bgc simulation control structure */
-		bgcin.ctrl.dodaily = output.dodaily;
-		bgcin.ctrl.domonavg = output.domonavg;
-		bgcin.ctrl.doannavg = output.doannavg;
-		bgcin.ctrl.doannual = output.doannual;
-	
-		/* copy the output file structures into bgcout */
-		if (output.dodaily) bgcout.dayout = output.dayout;
-		if (output.domonavg) bgcout.monavgout = output.monavgout;
-		if (output.doannavg) bgcout.annavgout = output.annavgout;
-		if (output.doannual) bgcout.annout = output.annout;
-		if (output.bgc_ascii && output.dodaily) bgcout.dayoutascii = output.dayoutascii;
-		if (output.bgc_ascii && output.domonavg) bgcout.monoutascii = output.monoutascii;
-		if (output.bgc_ascii && output.doannual) bgcout.annoutascii = output.annoutascii;
-		if (output.bgc_ascii && output.doannual) bgcout.anntext = output.anntext;
-		
-		/* initialize output files. Does nothing in spinup mode*/
-		
-		
-		bgcin.ctrl.read_restart = 1;
-		bgcin.restart_input = bgcout.restart_output;
-		
-		if (bgc(&bgcin, &bgcout, MODE_MODEL))
+		if (point_branch(argv[optind], branchyear, argc - optind - 1, &argv[optind+1],
+			nthreads, &opts))
 		{
-			bgc_printf(BV_ERROR, "Error in call to bgc()\n");
+			bgc_printf(BV_ERROR, "Error in call to point_branch() from pointbgc.c... Exiting\n");
 			exit(EXIT_FAILURE);
 		}
-		restart.read_restart = 0;
-		bgcin.ctrl.read_restart = 0;
-
-		bgc_printf(BV_WARN, "Finished the bgc() Model call in spinngo\n");
-		
 	}
-
-	/* post-processing output handling, if any, goes here */
-	
-	/* free memory */
-	free(bgcin.metarr.tmax);
-	free(bgcin.metarr.tmin);
-	free(bgcin.metarr.prcp);
-	free(bgcin.metarr.vpd);
-	free(bgcin.metarr.tavg);
-	free(bgcin.metarr.tavg_ra);
-	free(bgcin.metarr.swavgfd);
-	free(bgcin.metarr.par);
-	free(bgcin.metarr.dayl);
-	if (bgcin.co2.varco2) free(bgcin.co2.co2ppm_array);
-	if (bgcin.co2.varco2) free(bgcin.co2.co2year_array);
-	if (bgcin.ndepctrl.varndep) free(bgcin.ndepctrl.ndepyear_array);
-	if (bgcin.ndepctrl.varndep) free(bgcin.ndepctrl.ndep_array);
-	if (output.anncodes != NULL) free(output.anncodes);
-	if (output.daycodes != NULL) free(output.daycodes);
-	
-	/* close files */
-	if (restart.read_restart) fclose(restart.in_restart.ptr);
-	if (restart.write_restart) {
-		if (fclose(restart.out_restart.ptr) != 0)
-		{
-			bgc_printf(BV_WARN, "Warning, error closing restart file after write: %s\n", strerror(errno));
-		}
-	}
-	if (output.dodaily) fclose(output.dayout.ptr);
-	if (output.domonavg) fclose(output.monavgout.ptr);
-	if (output.doannavg) fclose(output.annavgout.ptr);
-	if (output.doannual) fclose(output.annout.ptr);
-	/* Close the ASCII output files */
-	if (output.bgc_ascii && output.dodaily) fclose(output.dayoutascii.ptr);
-	if (output.bgc_ascii && output.domonavg) fclose(output.monoutascii.ptr);
-	if (output.bgc_ascii && output.doannual) fclose(output.annoutascii.ptr);
-	
-	if ( output.bgc_ascii && output.doannual && (fclose(output.anntext.ptr) != 0))
+	else if ((rc = point_run(argv[optind], &opts, NULL)) != 0 && rc != BGC_EXIT_STOPPED)
 	{
-		bgc_printf(BV_WARN, "Warning, error closing ascii annual output file: %s\n", strerror(errno));
+		bgc_printf(BV_ERROR, "Error in call to point_run() from pointbgc.c... Exiting\n");
+		exit(EXIT_FAILURE);
 	}
-
+	
+	if (writestats) fclose(stats_file.ptr);
+	if (writetelem) fclose(telem_file.ptr);
+	
 	bgc_logfile_finish();
 	free(argv_zero);
+	
+	/* a run that stopped early has its own exit status, so that a job
+	script can tell it from an error and continue it with -c */
+	if (rc == BGC_EXIT_STOPPED) return BGC_EXIT_STOPPED;
 	return EXIT_SUCCESS;
 } /* end of main */
 	
@@ -0,0 +1,489 @@
+/*
+restart_cmp.c
+tool used to compare many pairs of restart files at once, for checking a
+new build of Biome-BGC against the restart files of a reference build
+
+Compares either two directories of restart files, pairing the files with
+the same name, or two restart bundles, pairing the records in order. A
+bundle is a file of restart records written one after the other, for
+example the restart files of a set of sites joined with cat. The pairs
+are compared on a pool of threads, and for each field of the restart
+record the tool reports the largest absolute and relative differences,
+the site holding each, and the number of sites over tolerance.
+
+The exit status is 0 when no site is over tolerance, 1 when some are,
+and 2 when the inputs cannot be read.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#define _POSIX_C_SOURCE 200809L
+#include "bgc.h"
+#include <stddef.h>
+#include <limits.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* the double fields of the restart record, in file order */
+#define RFIELD(f) { #f, offsetof(restart_data_struct, f) }
+static const struct
+{
+	const char* name;
+	size_t offset;
+} rfield[] =
+{
+	RFIELD(soilw), RFIELD(snoww), RFIELD(canopyw),
+	RFIELD(leafc), RFIELD(leafc_storage), RFIELD(leafc_transfer),
+	RFIELD(frootc), RFIELD(frootc_storage), RFIELD(frootc_transfer),
+	RFIELD(livestemc), RFIELD(livestemc_storage), RFIELD(livestemc_transfer),
+	RFIELD(deadstemc), RFIELD(deadstemc_storage), RFIELD(deadstemc_transfer),
+	RFIELD(livecrootc), RFIELD(livecrootc_storage), RFIELD(livecrootc_transfer),
+	RFIELD(deadcrootc), RFIELD(deadcrootc_storage), RFIELD(deadcrootc_transfer),
+	RFIELD(gresp_storage), RFIELD(gresp_transfer),
+	RFIELD(cwdc), RFIELD(litr1c), RFIELD(litr2c), RFIELD(litr3c), RFIELD(litr4c),
+	RFIELD(soil1c), RFIELD(soil2c), RFIELD(soil3c), RFIELD(soil4c),
+	RFIELD(cpool),
+	RFIELD(leafn), RFIELD(leafn_storage), RFIELD(leafn_transfer),
+	RFIELD(frootn), RFIELD(frootn_storage), RFIELD(frootn_transfer),
+	RFIELD(livestemn), RFIELD(livestemn_storage), RFIELD(livestemn_transfer),
+	RFIELD(deadstemn), RFIELD(deadstemn_storage), RFIELD(deadstemn_transfer),
+	RFIELD(livecrootn), RFIELD(livecrootn_storage), RFIELD(livecrootn_transfer),
+	RFIELD(deadcrootn), RFIELD(deadcrootn_storage), RFIELD(deadcrootn_transfer),
+	RFIELD(cwdn), RFIELD(litr1n), RFIELD(litr2n), RFIELD(litr3n), RFIELD(litr4n),
+	RFIELD(soil1n), RFIELD(soil2n), RFIELD(soil3n), RFIELD(soil4n),
+	RFIELD(sminn), RFIELD(retransn), RFIELD(npool),
+	RFIELD(day_leafc_litfall_increment), RFIELD(day_frootc_litfall_increment),
+	RFIELD(day_livestemc_turnover_increment), RFIELD(day_livecrootc_turnover_increment),
+	RFIELD(annmax_leafc), RFIELD(annmax_frootc), RFIELD(annmax_livestemc),
+	RFIELD(annmax_livecrootc),
+	RFIELD(dsr)
+};
+#define NRFIELD ((int)(sizeof(rfield)/sizeof(rfield[0])))
+/* metyr is kept in the last slot of the statistics arrays */
+#define NSTAT (NRFIELD+1)
+
+/* per-field statistics, one set per thread, merged at the end */
+typedef struct
+{
+	double maxabs[NSTAT];
+	double maxrel[NSTAT];
+	long absite[NSTAT];
+	long relsite[NSTAT];
+	long nover[NSTAT];
+	long nsiteover;             /* sites with any field over tolerance */
+	long nbad;                  /* sites that could not be read */
+} cmpstat_struct;
+
+typedef struct
+{
+	int bundle;                 /* 1 = two bundles, 0 = two directories */
+	const char* path[2];
+	long nsites;
+	char** names;               /* directory mode: file names in both */
+	restart_data_struct* rec[2];/* bundle mode: all records of each bundle */
+	double abstol;
+	double reltol;
+	long next_site;
+	cmpstat_struct* stat;
+} cmp_struct;
+
+typedef struct
+{
+	cmp_struct* cmp;
+	int id;
+} cmp_worker_struct;
+
+static int cmp_names(const void* a, const void* b)
+{
+	return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+/* list the regular files of dir1 that are also in dir2 */
+static int cmp_dir_init(cmp_struct* cmp)
+{
+	int ok = 1;
+	long max = 0;
+	long nonly = 0;
+	DIR* dir;
+	struct dirent* ent;
+	struct stat st;
+	char path[PATH_MAX];
+
+	if (!(dir = opendir(cmp->path[0])))
+	{
+		printf("Can't open directory %s: %s\n", cmp->path[0], strerror(errno));
+		ok=0;
+	}
+	while (ok && (ent = readdir(dir)))
+	{
+		snprintf(path, sizeof(path), "%s/%s", cmp->path[0], ent->d_name);
+		if (stat(path, &st) || !S_ISREG(st.st_mode)) continue;
+		snprintf(path, sizeof(path), "%s/%s", cmp->path[1], ent->d_name);
+		if (stat(path, &st) || !S_ISREG(st.st_mode))
+		{
+			printf("Only in %s: %s\n", cmp->path[0], ent->d_name);
+			nonly++;
+			continue;
+		}
+		if (cmp->nsites == max)
+		{
+			max = max ? 2*max : 256;
+			if (!(cmp->names = (char**) realloc(cmp->names, max * sizeof(char*))))
+			{
+				printf("Error allocating for file list\n");
+				ok=0;
+			}
+		}
+		if (ok && !(cmp->names[cmp->nsites++] = strdup(ent->d_name)))
+		{
+			printf("Error allocating for file list\n");
+			ok=0;
+		}
+	}
+	if (dir) closedir(dir);
+
+	/* sorted, so the sites holding the maxima do not depend on the order
+	the directory happens to be listed in */
+	if (ok && cmp->nsites)
+	{
+		qsort(cmp->names, cmp->nsites, sizeof(char*), cmp_names);
+	}
+	if (ok && nonly)
+	{
+		printf("%ld files of %s have no pair in %s\n", nonly, cmp->path[0], cmp->path[1]);
+	}
+
+	return (!ok);
+}
+
+/* read all of the records of a bundle */
+static int cmp_bundle_read(const char* name, restart_data_struct** rec, long* nrec)
+{
+	int ok = 1;
+	FILE* fp;
+	struct stat st;
+
+	if (!(fp = fopen(name, "rb")) || fstat(fileno(fp), &st))
+	{
+		printf("Can't open %s for binary read\n", name);
+		ok=0;
+	}
+	if (ok && st.st_size % sizeof(restart_data_struct))
+	{
+		printf("%s is not a whole number of restart records (%ld bytes, %ld per record)\n",
+			name, (long)st.st_size, (long)sizeof(restart_data_struct));
+		ok=0;
+	}
+	if (ok)
+	{
+		*nrec = (long)(st.st_size / sizeof(restart_data_struct));
+		if (!(*rec = (restart_data_struct*) malloc(st.st_size + 1)))
+		{
+			printf("Error allocating for %s\n", name);
+			ok=0;
+		}
+	}
+	if (ok && fread(*rec, sizeof(restart_data_struct), *nrec, fp) != (size_t)*nrec)
+	{
+		printf("Error reading %s\n", name);
+		ok=0;
+	}
+	if (fp) fclose(fp);
+
+	return (!ok);
+}
+
+/* read one restart record, which must be the whole file */
+static int cmp_file_read(const char* dir, const char* name, restart_data_struct* rec)
+{
+	int ok = 1;
+	char path[PATH_MAX];
+	FILE* fp;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	if (!(fp = fopen(path, "rb")))
+	{
+		ok=0;
+	}
+	else
+	{
+		if (fread(rec, sizeof(restart_data_struct), 1, fp) != 1 || fgetc(fp) != EOF)
+		{
+			ok=0;
+		}
+		fclose(fp);
+	}
+
+	return (!ok);
+}
+
+static void cmp_site(cmp_struct* cmp, cmpstat_struct* stat, long site,
+const restart_data_struct* r1, const restart_data_struct* r2)
+{
+	int i, over = 0;
+	double v1, v2, d, rel, scale;
+
+	for (i=0 ; i<NSTAT ; i++)
+	{
+		if (i < NRFIELD)
+		{
+			v1 = *(const double*)((const char*)r1 + rfield[i].offset);
+			v2 = *(const double*)((const char*)r2 + rfield[i].offset);
+		}
+		else
+		{
+			v1 = r1->metyr;
+			v2 = r2->metyr;
+		}
+
+		/* NaN in one file and not the other counts as an infinite
+		difference, NaN in both as none */
+		if (v1 == v2 || (isnan(v1) && isnan(v2))) continue;
+		d = (isnan(v1) || isnan(v2)) ? INFINITY : fabs(v1 - v2);
+		scale = fabs(v1) > fabs(v2) ? fabs(v1) : fabs(v2);
+		rel = (scale > 0.0 && isfinite(d)) ? d / scale : INFINITY;
+
+		if (d > stat->maxabs[i])
+		{
+			stat->maxabs[i] = d;
+			stat->absite[i] = site;
+		}
+		if (rel > stat->maxrel[i])
+		{
+			stat->maxrel[i] = rel;
+			stat->relsite[i] = site;
+		}
+		if (d > cmp->abstol && rel > cmp->reltol)
+		{
+			stat->nover[i]++;
+			over = 1;
+		}
+	}
+	stat->nsiteover += over;
+}
+
+static void* cmp_worker(void* arg)
+{
+	cmp_worker_struct* w = (cmp_worker_struct*) arg;
+	cmp_struct* cmp = w->cmp;
+	cmpstat_struct* stat = &cmp->stat[w->id];
+	restart_data_struct r1, r2;
+	long site;
+
+	while ((site = __sync_fetch_and_add(&cmp->next_site, 1)) < cmp->nsites)
+	{
+		if (cmp->bundle)
+		{
+			cmp_site(cmp, stat, site, &cmp->rec[0][site], &cmp->rec[1][site]);
+		}
+		else if (cmp_file_read(cmp->path[0], cmp->names[site], &r1) ||
+			cmp_file_read(cmp->path[1], cmp->names[site], &r2))
+		{
+			printf("Can't read a restart record from %s in both directories\n", cmp->names[site]);
+			stat->nbad++;
+		}
+		else
+		{
+			cmp_site(cmp, stat, site, &r1, &r2);
+		}
+	}
+
+	return NULL;
+}
+
+static void cmp_site_name(const cmp_struct* cmp, long site, char* name, size_t n)
+{
+	if (site < 0) snprintf(name, n, "-");
+	else if (cmp->bundle) snprintf(name, n, "#%ld", site);
+	else snprintf(name, n, "%s", cmp->names[site]);
+}
+
+static void cmp_print_usage(const char* argv0)
+{
+	printf("usage: %s {-j <threads>} {-a <abstol>} {-r <reltol>} {-q} <dir 1> <dir 2>\n", argv0);
+	printf("       %s {-j <threads>} {-a <abstol>} {-r <reltol>} {-q} <bundle 1> <bundle 2>\n\n", argv0);
+	printf("       -j <threads> number of threads, default one per processor\n");
+	printf("       -a <abstol> absolute tolerance, default 0\n");
+	printf("       -r <reltol> relative tolerance, default 0\n");
+	printf("       -q only list the fields that differ\n");
+	printf("A value is over tolerance when its difference is more than both\n");
+	printf("the absolute tolerance and the relative tolerance times the larger\n");
+	printf("of the two values.\n");
+}
+
+int main(int argc, char *argv[])
+{
+	cmp_struct cmp;
+	cmpstat_struct total;
+	cmp_worker_struct* workers = NULL;
+	pthread_t* threads = NULL;
+	struct stat st[2];
+	long nrec[2];
+	int c, i, k, ok = 1;
+	int nthreads = 0, quiet = 0;
+	char absname[PATH_MAX], relname[PATH_MAX];
+	extern int optind, opterr;
+	extern char *optarg;
+
+	memset(&cmp, 0, sizeof(cmp_struct));
+	memset(&total, 0, sizeof(cmpstat_struct));
+
+	opterr = 0;
+	while ((c = getopt(argc, argv, "j:a:r:q")) != -1)
+	{
+		switch (c)
+		{
+			case 'j':
+				nthreads = atoi(optarg);
+				break;
+			case 'a':
+				cmp.abstol = atof(optarg);
+				break;
+			case 'r':
+				cmp.reltol = atof(optarg);
+				break;
+			case 'q':
+				quiet = 1;
+				break;
+			default:
+				cmp_print_usage(argv[0]);
+				exit(2);
+		}
+	}
+	if (argc - optind != 2)
+	{
+		cmp_print_usage(argv[0]);
+		exit(2);
+	}
+	cmp.path[0] = argv[optind];
+	cmp.path[1] = argv[optind+1];
+
+	/* two directories or two bundles */
+	for (k=0 ; ok && k<2 ; k++)
+	{
+		if (stat(cmp.path[k], &st[k]))
+		{
+			printf("Can't open %s: %s\n", cmp.path[k], strerror(errno));
+			ok=0;
+		}
+	}
+	if (ok && S_ISDIR(st[0].st_mode) != S_ISDIR(st[1].st_mode))
+	{
+		printf("Compare two directories or two bundles, not one of each\n");
+		ok=0;
+	}
+	if (ok && S_ISDIR(st[0].st_mode))
+	{
+		ok = !cmp_dir_init(&cmp);
+	}
+	else if (ok)
+	{
+		cmp.bundle = 1;
+		for (k=0 ; ok && k<2 ; k++)
+		{
+			ok = !cmp_bundle_read(cmp.path[k], &cmp.rec[k], &nrec[k]);
+		}
+		if (ok && nrec[0] != nrec[1])
+		{
+			printf("%s has %ld records and %s has %ld\n", cmp.path[0], nrec[0], cmp.path[1], nrec[1]);
+			ok=0;
+		}
+		if (ok) cmp.nsites = nrec[0];
+	}
+	if (!ok) exit(2);
+
+	/* number of threads, 0 = one per processor */
+	if (nthreads <= 0) nthreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	if (nthreads <= 0) nthreads = 1;
+	if (nthreads > cmp.nsites) nthreads = cmp.nsites ? (int) cmp.nsites : 1;
+
+	if (!(workers = (cmp_worker_struct*) malloc(nthreads * sizeof(cmp_worker_struct))) ||
+		!(threads = (pthread_t*) malloc(nthreads * sizeof(pthread_t))) ||
+		!(cmp.stat = (cmpstat_struct*) calloc(nthreads, sizeof(cmpstat_struct))))
+	{
+		printf("Error allocating for %d threads\n", nthreads);
+		exit(2);
+	}
+	for (i=0 ; i<nthreads ; i++)
+	{
+		for (k=0 ; k<NSTAT ; k++)
+		{
+			cmp.stat[i].absite[k] = cmp.stat[i].relsite[k] = -1;
+		}
+		workers[i].cmp = &cmp;
+		workers[i].id = i;
+		if (pthread_create(&threads[i], NULL, cmp_worker, &workers[i]))
+		{
+			printf("Error starting thread %d\n", i);
+			exit(2);
+		}
+	}
+	for (i=0 ; i<nthreads ; i++)
+	{
+		pthread_join(threads[i], NULL);
+	}
+
+	/* merge the threads. Ties go to the lower site number, so the report
+	is the same for any number of threads. */
+	for (k=0 ; k<NSTAT ; k++)
+	{
+		total.absite[k] = total.relsite[k] = -1;
+	}
+	for (i=0 ; i<nthreads ; i++)
+	{
+		for (k=0 ; k<NSTAT ; k++)
+		{
+			if (cmp.stat[i].absite[k] >= 0 && (cmp.stat[i].maxabs[k] > total.maxabs[k] ||
+				(cmp.stat[i].maxabs[k] == total.maxabs[k] && cmp.stat[i].absite[k] < total.absite[k])))
+			{
+				total.maxabs[k] = cmp.stat[i].maxabs[k];
+				total.absite[k] = cmp.stat[i].absite[k];
+			}
+			if (cmp.stat[i].relsite[k] >= 0 && (cmp.stat[i].maxrel[k] > total.maxrel[k] ||
+				(cmp.stat[i].maxrel[k] == total.maxrel[k] && cmp.stat[i].relsite[k] < total.relsite[k])))
+			{
+				total.maxrel[k] = cmp.stat[i].maxrel[k];
+				total.relsite[k] = cmp.stat[i].relsite[k];
+			}
+			total.nover[k] += cmp.stat[i].nover[k];
+		}
+		total.nsiteover += cmp.stat[i].nsiteover;
+		total.nbad += cmp.stat[i].nbad;
+	}
+
+	printf("\nCompared %ld sites of %s and %s on %d threads\n", cmp.nsites - total.nbad,
+		cmp.path[0], cmp.path[1], nthreads);
+	printf("Tolerance: absolute %g, relative %g\n\n", cmp.abstol, cmp.reltol);
+	printf("%-34s %14s %-20s %14s %-20s %8s\n", "Variable", "Max abs diff", "Site",
+		"Max rel diff", "Site", "Over tol");
+	for (k=0 ; k<NSTAT ; k++)
+	{
+		if (quiet && total.absite[k] < 0) continue;
+		cmp_site_name(&cmp, total.absite[k], absname, sizeof(absname));
+		cmp_site_name(&cmp, total.relsite[k], relname, sizeof(relname));
+		printf("%-34s %14.6e %-20s %14.6e %-20s %8ld\n", k < NRFIELD ? rfield[k].name : "metyr",
+			total.maxabs[k], absname, total.maxrel[k], relname, total.nover[k]);
+	}
+	printf("\n%ld of %ld sites over tolerance", total.nsiteover, cmp.nsites - total.nbad);
+	if (total.nbad) printf(", %ld sites could not be read", total.nbad);
+	printf("\n");
+
+	for (i=0 ; i<cmp.nsites && !cmp.bundle ; i++)
+	{
+		free(cmp.names[i]);
+	}
+	free(cmp.names);
+	free(cmp.rec[0]);
+	free(cmp.rec[1]);
+	free(cmp.stat);
+	free(workers);
+	free(threads);
+
+	if (total.nbad) return 2;
+	return (total.nsiteover ? 1 : 0);
+}
@@ -10,6 +10,25 @@ See copyright.txt for Copyright information
 
 #include "pointbgc.h"
 
+/* read the resume record after the restart record in the file name, as
+written by a run that stopped early. Returns 1 if there is one. */
+static int resume_read(const char* name, restart_resume_struct* resume)
+{
+	int found = 0;
+	FILE* fp;
+	restart_data_struct restart;
+
+	if ((fp = fopen(name, "rb")) != NULL)
+	{
+		found = (fread(&restart, sizeof(restart_data_struct), 1, fp) == 1 &&
+			fread(resume, sizeof(restart_resume_struct), 1, fp) == 1 &&
+			resume->magic == RESUME_MAGIC);
+		fclose(fp);
+	}
+
+	return (found);
+}
+
 int restart_init(file init, restart_ctrl_struct* restart)
 {
 	int ok = 1;
@@ -86,10 +105,21 @@ int restart_init(file init, restart_ctrl_struct* restart)
 		}
 	}
 	/* if using an output restart file, open it, otherwise
-	discard the next line of the ini file */
+	discard the next line of the ini file. To continue a stopped run,
+	its resume record is read from the file, which is then kept as it is
+	until the run writes its own restart record: see restart_write(). */
 	if (ok && restart->write_restart)
 	{
-    	if (scan_open(init,&(restart->out_restart),'w')) 
+		if (scan_value(init, restart->out_restart.name, 's'))
+		{
+			bgc_printf(BV_ERROR, "Error scanning output restart filename\n");
+			ok=0;
+		}
+		if (ok && restart->resume)
+		{
+			restart->resumed = resume_read(restart->out_restart.name, &restart->resume_data);
+		}
+		if (ok && file_open(&(restart->out_restart),restart->resumed ? 'a' : 'w'))
 		{
 			bgc_printf(BV_ERROR, "Error opening output restart file\n");
 			ok=0;
@@ -79,6 +79,23 @@ int sitec_init(file init, siteconst_struct* sitec)
 		ok=0;
 	}
 	
+	/* soil pressure-volume coefficients and water holding capacity */
+	if (ok && sitec_soil_init(sitec, sand, silt, clay))
+	{
+		bgc_printf(BV_ERROR, "Error in call to sitec_soil_init() from sitec_init()\n");
+		ok=0;
+	}
+	
+	return (!ok);
+}
+
+/* set the soil constants in sitec that are derived from the soil depth
+and texture. sitec->soil_depth must already be set. */
+int sitec_soil_init(siteconst_struct* sitec, double sand, double silt,
+double clay)
+{
+	int ok=1;
+	
 	/* calculate the soil pressure-volume coefficients from texture data */
 	/* Uses the multivariate regressions from Cosby et al., 1984 */
 	/* first check that the percentages add to 100.0 */
@@ -0,0 +1,316 @@
+/*
+spinup_parareal.c
+parallel-in-time (parareal) spinup on a pool of threads
+
+The spinup is cut into slices of three blocks of years, one pass through
+metcycles 0, 1 and 2, so that a slice always starts with the spinup
+control between tests. The fine propagator F runs a slice with the
+daily model, as the ordinary spinup does, and records the fluxes of its
+first year for the coarse steps of spinup_coarse.c. The coarse
+propagator G is those coarse steps linearized about the start that F
+was run on: a change of the litter, CWD and soil pools at the start of
+a slice decays and moves downstream over the slice with the rate
+constants of the recorded year.
+
+A window of nslices slices is run at once, one per thread. Each
+iteration runs F on all of them and corrects the start of each slice in
+turn:
+
+	U'[n+1] = F(U[n]) + G(U'[n] - U[n])
+
+where U' is the corrected start and U the one F was run on. The
+correction is made on the litter, CWD and soil pools, the slow part of
+the state; the rest of the state (vegetation, water, spinup control) is
+that of F. The first slice of the window starts from an exact state, so
+each iteration takes the spinup at least one slice further, and a slice
+whose start moved by less than PARAREAL_TOL since the last iteration is
+taken as final as well. The window then moves on past the final slices,
+and each new slice at its end is first guessed to start from the same
+state as the one before it. The spinup ends where F on a slice with a
+final start passes the steady state test (or reaches maxspinyears).
+
+Slices taken as final within the tolerance make the result differ
+slightly from that of the ordinary spinup. Several times the work of the
+ordinary spinup is done, for a run time of the number of iterations
+rather than of the number of slices.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
+#include "pointbgc.h"
+
+/* largest relative change of the litter, CWD and soil C at the start of
+a slice between iterations for the slice to be taken as final */
+#define PARAREAL_TOL 0.001
+
+/* one fine slice, run by a worker thread */
+typedef struct
+{
+	bgcsim_struct* sim;
+	const bgcstate_struct* in;
+	bgcstate_struct* out;
+	coarse_struct* co;
+	int ok;
+} parareal_slice_struct;
+
+/* fine propagator: the daily spinup over one slice from in, recording
+in co the fluxes of its first year for the correction */
+static int parareal_fine(bgcsim_struct* sim, const bgcstate_struct* in,
+bgcstate_struct* out, coarse_struct* co)
+{
+	int ok=1;
+	int y, nyears = 3 * sim->nblock;
+
+	memset(co, 0, sizeof(coarse_struct));
+	if (in->done)
+	{
+		*out = *in;
+		return (0);
+	}
+	if (bgcsim_set_state(sim, in))
+	{
+		bgc_printf(BV_ERROR, "Error in call to bgcsim_set_state() from parareal_fine()\n");
+		ok=0;
+	}
+	if (ok && coarse_start(&sim->cs, &sim->ns, co))
+	{
+		bgc_printf(BV_ERROR, "Error in call to coarse_start() from parareal_fine()\n");
+		ok=0;
+	}
+	do
+	{
+		if (bgcsim_step_day(sim) || coarse_record(&sim->cs, &sim->ns, &sim->cf, co))
+		{
+			bgc_printf(BV_ERROR, "Error stepping the daily model in parareal_fine()\n");
+			ok=0;
+		}
+	} while (ok && !sim->done && !sim->newyear);
+	for (y=1 ; ok && y<nyears && !sim->done ; y++)
+	{
+		if (bgcsim_step_year(sim))
+		{
+			bgc_printf(BV_ERROR, "Error in call to bgcsim_step_year() from parareal_fine()\n");
+			ok=0;
+		}
+	}
+	if (ok && bgcsim_get_state(sim, out))
+	{
+		bgc_printf(BV_ERROR, "Error in call to bgcsim_get_state() from parareal_fine()\n");
+		ok=0;
+	}
+
+	return (!ok);
+}
+
+static void* parareal_worker(void* arg)
+{
+	parareal_slice_struct* sl = (parareal_slice_struct*) arg;
+
+	sl->ok = !parareal_fine(sl->sim, sl->in, sl->out, sl->co);
+
+	return NULL;
+}
+
+/* first guess of the start of the slice after the one that starts at
+in, before F has been run on it: the same state, nyears on */
+static void parareal_predict(const bgcstate_struct* in, bgcstate_struct* out,
+int nyears)
+{
+	*out = *in;
+	if (!out->done) out->spinyears += nyears;
+}
+
+/* true when two slice starts differ by less than the tolerance */
+static int parareal_same(const bgcstate_struct* a, const bgcstate_struct* b)
+{
+	return (a->done == b->done && a->steady1 == b->steady1 &&
+		a->steady2 == b->steady2 && a->rising == b->rising &&
+		fabs(coarse_totalc(&a->cs) - coarse_totalc(&b->cs)) <
+		PARAREAL_TOL * coarse_totalc(&b->cs));
+}
+
+/* drop-in for bgc(bgcin, bgcout, MODE_SPINUP), with nslices slices in
+the window, each run on its own thread. The spinup writes no daily or
+annual outputs. */
+int spinup_parareal(bgcin_struct* bgcin, bgcout_struct* bgcout, int nslices)
+{
+	int ok=1;
+	int i, n, fin, nshift, nyears, nsim = 0, nstarted, finished = 0;
+	int iters = 0, fineyears = 0;
+	bgcsim_struct sim;
+	bgcsim_struct* sims = NULL;
+	bgcin_struct* simin = NULL;
+	bgcout_struct* simout = NULL;
+	bgcstate_struct *u = NULL, *unew = NULL, *fo = NULL;
+	coarse_struct* co = NULL;
+	parareal_slice_struct* sl = NULL;
+	pthread_t* threads = NULL;
+
+	if (nslices < 2)
+	{
+		bgc_printf(BV_ERROR, "Error: parareal spinup needs at least 2 slices, got %d: spinup_parareal()\n",
+			nslices);
+		return (1);
+	}
+	if (bgcsim_init(&sim, bgcin, bgcout, MODE_SPINUP))
+	{
+		bgc_printf(BV_ERROR, "Error in call to bgcsim_init() from spinup_parareal()\n");
+		ok=0;
+	}
+	nyears = 3 * sim.nblock;
+
+	/* a simulation for each slice, without outputs */
+	if (ok && (!(sims = (bgcsim_struct*) malloc(nslices * sizeof(bgcsim_struct))) ||
+		!(simin = (bgcin_struct*) malloc(nslices * sizeof(bgcin_struct))) ||
+		!(simout = (bgcout_struct*) calloc(nslices, sizeof(bgcout_struct))) ||
+		!(u = (bgcstate_struct*) malloc((nslices+1) * sizeof(bgcstate_struct))) ||
+		!(unew = (bgcstate_struct*) malloc((nslices+1) * sizeof(bgcstate_struct))) ||
+		!(fo = (bgcstate_struct*) malloc(nslices * sizeof(bgcstate_struct))) ||
+		!(co = (coarse_struct*) malloc(nslices * sizeof(coarse_struct))) ||
+		!(sl = (parareal_slice_struct*) malloc(nslices * sizeof(parareal_slice_struct))) ||
+		!(threads = (pthread_t*) malloc(nslices * sizeof(pthread_t)))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating for %d parareal slices: spinup_parareal()\n",nslices);
+		ok=0;
+	}
+	for (i=0 ; ok && i<nslices ; i++)
+	{
+		simin[i] = *bgcin;
+		simin[i].ctrl.dodaily = 0;
+		simin[i].ctrl.domonavg = 0;
+		simin[i].ctrl.doannavg = 0;
+		simin[i].ctrl.doannual = 0;
+		simin[i].ctrl.onscreen = 0;
+		simout[i].bgc_ascii = 0;
+		if (bgcsim_init(&sims[i], &simin[i], &simout[i], MODE_SPINUP))
+		{
+			bgc_printf(BV_ERROR, "Error in call to bgcsim_init() from spinup_parareal()\n");
+			ok=0;
+		}
+		nsim++;
+	}
+
+	/* the first window */
+	if (ok && bgcsim_get_state(&sim, &u[0]))
+	{
+		bgc_printf(BV_ERROR, "Error in call to bgcsim_get_state() from spinup_parareal()\n");
+		ok=0;
+	}
+	finished = ok && u[0].done;
+	for (n=0 ; ok && n<nslices ; n++) parareal_predict(&u[n], &u[n+1], nyears);
+
+	while (ok && !finished)
+	{
+		/* F on every slice of the window at once */
+		for (n=0 ; n<nslices ; n++)
+		{
+			sl[n].sim = &sims[n];
+			sl[n].in = &u[n];
+			sl[n].out = &fo[n];
+			sl[n].co = &co[n];
+			sl[n].ok = 0;
+			if (pthread_create(&threads[n], NULL, parareal_worker, &sl[n]))
+			{
+				bgc_printf(BV_ERROR, "Error starting parareal thread %d: spinup_parareal()\n",n);
+				ok=0;
+				break;
+			}
+		}
+		/* wait for the threads that did start */
+		nstarted = n;
+		for (n=0 ; n<nstarted ; n++)
+		{
+			pthread_join(threads[n], NULL);
+			if (!sl[n].ok) ok=0;
+			if (!u[n].done) fineyears += nyears;
+		}
+		if (!ok)
+		{
+			bgc_printf(BV_ERROR, "Error in the fine spinup of a parareal slice: spinup_parareal()\n");
+			break;
+		}
+		iters++;
+
+		/* corrected slice starts. The slices up to fin start from
+		final states that F was run on, and the start of the slice
+		after each of them is final: it is the F of that slice. Past
+		them, the change of the start of a slice since the last
+		iteration is carried over the slice by the linearized coarse
+		steps, and added to F. */
+		unew[0] = u[0];
+		fin = 0;
+		for (n=0 ; ok && n<nslices ; n++)
+		{
+			unew[n+1] = fo[n];
+			if (n <= fin)
+			{
+				if (fo[n].done)
+				{
+					/* the spinup ends in this slice */
+					if (bgcsim_set_state(&sim, &fo[n]))
+					{
+						bgc_printf(BV_ERROR, "Error in call to bgcsim_set_state() from spinup_parareal()\n");
+						ok=0;
+					}
+					finished = 1;
+					break;
+				}
+				/* F of the next slice holds for its final start if
+				that did not move */
+				if (n+1 < nslices && parareal_same(&unew[n+1], &u[n+1])) fin = n + 1;
+			}
+			else if (coarse_correct(&co[n], nyears, &unew[n+1].cs, &unew[n+1].ns,
+				&unew[n].cs, &unew[n].ns, &u[n].cs, &u[n].ns))
+			{
+				bgc_printf(BV_ERROR, "Error in call to coarse_correct() from spinup_parareal()\n");
+				ok=0;
+			}
+		}
+		if (!ok || finished) break;
+
+		/* move the window on to the first final start that F has not
+		been run on, and make first guesses for the new slices at its
+		end */
+		nshift = fin + 1;
+		bgc_printf(BV_DETAIL, "parareal iteration %d: spinup years %d, window moved %d of %d slices\n",
+			iters, unew[nshift].spinyears, nshift, nslices);
+		for (n=0 ; n+nshift<=nslices ; n++) u[n] = unew[n+nshift];
+		for (n=nslices-nshift ; n<nslices ; n++) parareal_predict(&u[n], &u[n+1], nyears);
+	}
+
+	if (ok)
+	{
+		bgc_printf(BV_PROGRESS, "Parareal spinup: %d iterations of %d slices, %d daily years\n",
+			iters, nslices, fineyears);
+	}
+
+	/* spinup status and restart data */
+	if (ok && bgcsim_finish(&sim))
+	{
+		bgc_printf(BV_ERROR, "Error in call to bgcsim_finish() from spinup_parareal()\n");
+		ok=0;
+	}
+
+	for (i=0 ; i<nsim ; i++) bgcsim_free(&sims[i]);
+	if (bgcsim_free(&sim))
+	{
+		bgc_printf(BV_ERROR, "Error in call to bgcsim_free() from spinup_parareal()\n");
+		ok=0;
+	}
+	free(sims);
+	free(simin);
+	free(simout);
+	free(u);
+	free(unew);
+	free(fo);
+	free(co);
+	free(sl);
+	free(threads);
+
+	return (!ok);
+}
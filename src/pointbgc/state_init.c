@@ -90,7 +90,10 @@ cinit_struct* cinit, nstate_struct* ns)
 		bgc_printf(BV_ERROR, "Error reading coarse woody debris carbon, cstate_init()\n");
 		ok=0;
 	}
-	if (ok) ns->cwdn = cs->cwdc/epc->deadwood_cn;
+	/* non-woody types have a dead wood C:N of 0 (and no CWD), which
+	would start the N volatilization sink as NaN and hide any N balance
+	error from the daily check */
+	if (ok) ns->cwdn = (epc->deadwood_cn > 0.0) ? cs->cwdc/epc->deadwood_cn : 0.0;
 	/* read the litter carbon pool initial values */
 	if (ok && scan_value(init, &cs->litr1c, 'd'))
 	{
@@ -0,0 +1,91 @@
+/*
+tap_init.c
+create and remove the named POSIX shared memory segment of the live
+output tap (see output_tap.c and the -t option in USAGE.TXT)
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#define _POSIX_C_SOURCE 200112L
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "pointbgc.h"
+
+/* shared memory object name of a tap, with the leading '/' added if it
+is missing */
+static void tap_shmname(const char* name, char* shmname, size_t size)
+{
+	snprintf(shmname, size, "%s%s", (name[0] == '/') ? "" : "/", name);
+}
+
+/* create the tap segment name for the daily and annual outputs of
+output, replacing a segment of that name left by an earlier run */
+int output_tap_open(const char* name, const output_struct* output,
+output_tap_struct** tap)
+{
+	int ok=1;
+	int fd = -1;
+	char shmname[136];
+	size_t size = output_tap_size(output->ndayout, output->nannout, TAP_NSLOTS);
+	void* seg = MAP_FAILED;
+
+	*tap = NULL;
+	tap_shmname(name, shmname, sizeof(shmname));
+	shm_unlink(shmname);
+	if ((fd = shm_open(shmname, O_CREAT | O_EXCL | O_RDWR, 0600)) < 0)
+	{
+		bgc_printf(BV_ERROR, "Error creating output tap %s: %s\n",shmname,strerror(errno));
+		ok=0;
+	}
+	if (ok && (ftruncate(fd, (off_t) size) ||
+		(seg = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED))
+	{
+		bgc_printf(BV_ERROR, "Error mapping output tap %s: %s\n",shmname,strerror(errno));
+		ok=0;
+	}
+	if (fd >= 0) close(fd);
+	if (ok && output_tap_init((output_tap_struct*) seg, output->ndayout, output->daycodes,
+		output->nannout, output->anncodes, TAP_NSLOTS))
+	{
+		bgc_printf(BV_ERROR, "Error in call to output_tap_init() from output_tap_open()\n");
+		ok=0;
+	}
+	if (ok)
+	{
+		/* so that readers can tell when the run ended without closing
+		the tap */
+		((output_tap_struct*) seg)->writer = (int) getpid();
+		*tap = (output_tap_struct*) seg;
+		bgc_printf(BV_PROGRESS, "Publishing outputs to the output tap %s\n",shmname);
+	}
+	else
+	{
+		if (seg != MAP_FAILED) munmap(seg, size);
+		if (fd >= 0) shm_unlink(shmname);
+	}
+
+	return (!ok);
+}
+
+/* mark the tap finished for its readers, and remove its name. Readers
+that are attached keep their mapping until they detach. */
+int output_tap_close(const char* name, output_tap_struct* tap)
+{
+	char shmname[136];
+
+	if (!tap) return (0);
+	tap_shmname(name, shmname, sizeof(shmname));
+	__sync_synchronize();
+	tap->done = 1;
+	munmap(tap, output_tap_size(tap->ndayout, tap->nannout, tap->nslots));
+	if (shm_unlink(shmname))
+	{
+		bgc_printf(BV_WARN, "Warning: error removing output tap %s: %s\n",shmname,strerror(errno));
+	}
+
+	return (0);
+}
@@ -0,0 +1,171 @@
+/*
+tap_read.c
+tool that attaches to the live output tap of a running simulation (the
+-t option of bgc) and prints its daily and annual output records as
+text while the simulation runs
+
+Each record is printed on one line: the kind of record (day or year),
+the simulation year (the spinup year in a spinup), the day of the year
+and the output values, in the order of the DAILY_OUTPUT or
+ANNUAL_OUTPUT codes listed at the top. The simulation does not wait for
+the reader: a reader that falls more than the size of the ring behind
+loses records, and reports how many it skipped. The tool exits when the
+simulation ends, or on SIGINT or SIGTERM.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#define _POSIX_C_SOURCE 200809L
+#include "bgc.h"
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* time between polls of an idle tap */
+#define TAP_POLL_NS 10000000L
+
+static volatile sig_atomic_t tap_stop = 0;
+
+static void tap_handler(int sig)
+{
+	(void) sig;
+	tap_stop = 1;
+}
+
+static void tap_usage(const char* argv0)
+{
+	fprintf(stderr, "usage: %s [-o] [-w] <tap name>\n", argv0);
+	fprintf(stderr, "  -o  start from the oldest record still in the ring, not the next one\n");
+	fprintf(stderr, "  -w  wait for the simulation to create the tap\n");
+}
+
+int main(int argc, char* argv[])
+{
+	int i, c, fd, r, oldest = 0, wait = 0, rc = 0;
+	char shmname[136];
+	struct stat st;
+	struct sigaction sa;
+	struct timespec poll = {0, TAP_POLL_NS};
+	output_tap_struct* tap = MAP_FAILED;
+	output_tap_slot_struct rec;
+	const int* codes;
+	float* values = NULL;
+	long long n, next, head, lost = 0;
+
+	while ((c = getopt(argc, argv, "ow")) != -1)
+	{
+		if (c == 'o') oldest = 1;
+		else if (c == 'w') wait = 1;
+		else
+		{
+			tap_usage(argv[0]);
+			return (2);
+		}
+	}
+	if (optind != argc - 1)
+	{
+		tap_usage(argv[0]);
+		return (2);
+	}
+	snprintf(shmname, sizeof(shmname), "%s%s", (argv[optind][0] == '/') ? "" : "/", argv[optind]);
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = tap_handler;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	sigaction(SIGPIPE, &sa, NULL);
+
+	/* attach to the tap, once the simulation has laid it out */
+	while ((fd = shm_open(shmname, O_RDWR, 0)) < 0 && errno == ENOENT && wait && !tap_stop)
+	{
+		nanosleep(&poll, NULL);
+	}
+	while (fd >= 0 && wait && !tap_stop && !fstat(fd, &st) &&
+		((size_t) st.st_size < sizeof(output_tap_struct) ||
+		pread(fd, &c, sizeof(int), 0) != sizeof(int) || c != TAP_MAGIC))
+	{
+		nanosleep(&poll, NULL);
+	}
+	if (fd < 0 || fstat(fd, &st) ||
+		(size_t) st.st_size < sizeof(output_tap_struct) ||
+		(tap = (output_tap_struct*) mmap(NULL, st.st_size, PROT_READ | PROT_WRITE,
+		MAP_SHARED, fd, 0)) == MAP_FAILED)
+	{
+		fprintf(stderr, "Error opening output tap %s: %s\n", shmname, strerror(errno));
+		return (2);
+	}
+	close(fd);
+	if (tap->magic != TAP_MAGIC ||
+		(size_t) st.st_size < output_tap_size(tap->ndayout, tap->nannout, tap->nslots) ||
+		!(values = (float*) malloc((tap->nvalues + 1) * sizeof(float))))
+	{
+		fprintf(stderr, "Error: %s is not an output tap\n", shmname);
+		munmap(tap, st.st_size);
+		return (2);
+	}
+
+	/* the simulation publishes only while someone reads */
+	__sync_fetch_and_add(&tap->readers, 1);
+	head = tap->head;
+	n = (oldest && head > tap->nslots) ? head - tap->nslots : (oldest ? 0 : head);
+
+	printf("# output tap %s: %d daily and %d annual outputs\n", shmname, tap->ndayout, tap->nannout);
+	printf("# day codes:");
+	codes = output_tap_codes(tap, TAP_DAY);
+	for (i=0 ; i<tap->ndayout ; i++) printf(" %d", codes[i]);
+	printf("\n# year codes:");
+	codes = output_tap_codes(tap, TAP_YEAR);
+	for (i=0 ; i<tap->nannout ; i++) printf(" %d", codes[i]);
+	printf("\n");
+
+	while (!tap_stop)
+	{
+		r = output_tap_read(tap, n, &rec, values);
+		if (r == TAP_READ_OK)
+		{
+			printf("%s %d %d", (rec.kind == TAP_YEAR) ? "year" : "day", rec.year, rec.yday);
+			for (i=0 ; i<rec.nvalues ; i++) printf(" %.8g", values[i]);
+			printf("\n");
+			n++;
+		}
+		else if (r == TAP_READ_LOST)
+		{
+			/* overwritten while this reader was behind: go on from the
+			oldest record still in the ring */
+			next = tap->head - tap->nslots + 1;
+			if (next <= n) next = n + 1;
+			printf("# skipped %lld records\n", next - n);
+			lost += next - n;
+			n = next;
+		}
+		else if (tap->done && n >= tap->head)
+		{
+			break;
+		}
+		else if (tap->writer && kill(tap->writer, 0) && errno == ESRCH)
+		{
+			fprintf(stderr, "Error: the simulation ended without closing the output tap\n");
+			rc = 1;
+			break;
+		}
+		else
+		{
+			if (fflush(stdout)) break;
+			nanosleep(&poll, NULL);
+		}
+	}
+	fflush(stdout);
+	if (lost) fprintf(stderr, "%lld records lost\n", lost);
+
+	__sync_fetch_and_sub(&tap->readers, 1);
+	munmap(tap, st.st_size);
+	free(values);
+
+	return (rc);
+}
@@ -0,0 +1,92 @@
+/*
+raster_io.c
+read and write headerless binary rasters and raster stacks
+
+Rasters are row-major 32-bit floats in native byte order, with no
+header. A stack is a sequence of bands of grid->ncells values each, so
+cell c of band b is at float offset b*ncells + c.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#include "regionbgc.h"
+
+/* read a single band raster into arr, checking that it is the size of
+the grid */
+int raster_read(const char* name, const grid_struct* grid, float* arr)
+{
+	int ok = 1;
+	file rast;
+
+	strcpy(rast.name, name);
+	if (file_open(&rast, 'r'))
+	{
+		bgc_printf(BV_ERROR, "Error opening raster %s: raster_read()\n",name);
+		ok=0;
+	}
+	if (ok)
+	{
+		if (fread(arr, sizeof(float), grid->ncells, rast.ptr) != (size_t)grid->ncells)
+		{
+			bgc_printf(BV_ERROR, "Error: raster %s has fewer than %ld cells: raster_read()\n",name,grid->ncells);
+			ok=0;
+		}
+		else if (fgetc(rast.ptr) != EOF)
+		{
+			bgc_printf(BV_ERROR, "Error: raster %s has more than %ld cells: raster_read()\n",name,grid->ncells);
+			ok=0;
+		}
+		fclose(rast.ptr);
+	}
+
+	return (!ok);
+}
+
+/* read n cells starting at cell start from one band of an open stack */
+int raster_read_span(FILE* fp, const grid_struct* grid, int band,
+long start, long n, float* arr)
+{
+	int ok = 1;
+	long offset;
+
+	offset = ((long)band * grid->ncells + start) * (long)sizeof(float);
+	if (fseek(fp, offset, SEEK_SET))
+	{
+		bgc_printf(BV_ERROR, "Error seeking to band %d: raster_read_span()\n",band);
+		ok=0;
+	}
+	if (ok && fread(arr, sizeof(float), n, fp) != (size_t)n)
+	{
+		bgc_printf(BV_ERROR, "Error reading band %d, cells %ld to %ld: raster_read_span()\n",
+			band,start,start+n-1);
+		ok=0;
+	}
+
+	return (!ok);
+}
+
+/* write n cells starting at cell start into one band of an open stack */
+int raster_write_span(FILE* fp, const grid_struct* grid, int band,
+long start, long n, const float* arr)
+{
+	int ok = 1;
+	long offset;
+
+	offset = ((long)band * grid->ncells + start) * (long)sizeof(float);
+	if (fseek(fp, offset, SEEK_SET))
+	{
+		bgc_printf(BV_ERROR, "Error seeking to band %d: raster_write_span()\n",band);
+		ok=0;
+	}
+	if (ok && fwrite(arr, sizeof(float), n, fp) != (size_t)n)
+	{
+		bgc_printf(BV_ERROR, "Error writing band %d, cells %ld to %ld: raster_write_span()\n",
+			band,start,start+n-1);
+		ok=0;
+	}
+
+	return (!ok);
+}
@@ -0,0 +1,422 @@
+/*
+region_init.c
+read the regional blocks of the regionbgc initialization file, and the
+site constant and epc layers they name
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#include "regionbgc.h"
+
+int grid_init(file init, grid_struct* grid)
+{
+	int ok = 1;
+	char key1[] = "RASTER_GRID";
+	char keyword[80];
+	double nodata;
+
+	/********************************************************************
+	**                                                                 **
+	** Begin reading initialization file block starting with keyword:  **
+	** RASTER_GRID                                                     **
+	**                                                                 **
+	********************************************************************/
+
+	/* scan for the raster grid keyword, exit if not next */
+	if (ok && scan_value(init, keyword, 's'))
+	{
+		bgc_printf(BV_ERROR, "Error reading keyword for raster grid: grid_init()\n");
+		ok=0;
+	}
+	if (ok && strcmp(keyword, key1))
+	{
+		bgc_printf(BV_ERROR, "Expecting keyword --> %s in file %s\n",key1,init.name);
+		ok=0;
+	}
+	if (ok && scan_value(init, &grid->ncols, 'i'))
+	{
+		bgc_printf(BV_ERROR, "Error reading number of columns: grid_init()\n");
+		ok=0;
+	}
+	if (ok && scan_value(init, &grid->nrows, 'i'))
+	{
+		bgc_printf(BV_ERROR, "Error reading number of rows: grid_init()\n");
+		ok=0;
+	}
+	if (ok && scan_value(init, &nodata, 'd'))
+	{
+		bgc_printf(BV_ERROR, "Error reading nodata value: grid_init()\n");
+		ok=0;
+	}
+	if (ok && (grid->ncols < 1 || grid->nrows < 1))
+	{
+		bgc_printf(BV_ERROR, "Error: raster grid must have at least one row and column\n");
+		ok=0;
+	}
+	if (ok)
+	{
+		grid->ncells = (long)grid->ncols * (long)grid->nrows;
+		grid->nodata = (float)nodata;
+	}
+
+	return (!ok);
+}
+
+int metrast_init(file init, region_struct* region)
+{
+	int ok = 1;
+	char key1[] = "MET_RASTERS";
+	char keyword[80];
+
+	/********************************************************************
+	**                                                                 **
+	** Begin reading initialization file block starting with keyword:  **
+	** MET_RASTERS                                                     **
+	**                                                                 **
+	********************************************************************/
+
+	/* scan for the met raster keyword, exit if not next */
+	if (ok && scan_value(init, keyword, 's'))
+	{
+		bgc_printf(BV_ERROR, "Error reading keyword for met rasters: metrast_init()\n");
+		ok=0;
+	}
+	if (ok && strcmp(keyword, key1))
+	{
+		bgc_printf(BV_ERROR, "Expecting keyword --> %s in file %s\n",key1,init.name);
+		ok=0;
+	}
+
+	/* met raster filename prefix, and the year of the first rasters */
+	if (ok && scan_value(init, region->metprefix, 's'))
+	{
+		bgc_printf(BV_ERROR, "Error reading met raster prefix: metrast_init()\n");
+		ok=0;
+	}
+	if (ok && scan_value(init, &region->metfirstyr, 'i'))
+	{
+		bgc_printf(BV_ERROR, "Error reading first met raster year: metrast_init()\n");
+		ok=0;
+	}
+
+	return (!ok);
+}
+
+int siterast_init(file init, region_struct* region)
+{
+	int ok = 1;
+	int i;
+	char key1[] = "SITE_RASTERS";
+	char keyword[80];
+	char name[128];
+
+	/********************************************************************
+	**                                                                 **
+	** Begin reading initialization file block starting with keyword:  **
+	** SITE_RASTERS                                                    **
+	**                                                                 **
+	********************************************************************/
+
+	/* scan for the site raster keyword, exit if not next */
+	if (ok && scan_value(init, keyword, 's'))
+	{
+		bgc_printf(BV_ERROR, "Error reading keyword for site rasters: siterast_init()\n");
+		ok=0;
+	}
+	if (ok && strcmp(keyword, key1))
+	{
+		bgc_printf(BV_ERROR, "Expecting keyword --> %s in file %s\n",key1,init.name);
+		ok=0;
+	}
+
+	/* one layer for each of the site constants, in SITE_* order */
+	for (i=0 ; ok && i<NSITELAYER ; i++)
+	{
+		if (scan_value(init, name, 's'))
+		{
+			bgc_printf(BV_ERROR, "Error reading site raster filename #%d: siterast_init()\n",i+1);
+			ok=0;
+		}
+		if (ok && !(region->site[i] = (float*) malloc(region->grid.ncells * sizeof(float))))
+		{
+			bgc_printf(BV_ERROR, "Error allocating for site raster #%d: siterast_init()\n",i+1);
+			ok=0;
+		}
+		if (ok && raster_read(name, &region->grid, region->site[i]))
+		{
+			bgc_printf(BV_ERROR, "Error reading site raster %s: siterast_init()\n",name);
+			ok=0;
+		}
+	}
+
+	return (!ok);
+}
+
+int epcrast_init(file init, region_struct* region)
+{
+	int ok = 1;
+	int i;
+	file temp;
+	char key1[] = "EPC_RASTER";
+	char keyword[80];
+	char name[128];
+
+	/********************************************************************
+	**                                                                 **
+	** Begin reading initialization file block starting with keyword:  **
+	** EPC_RASTER                                                      **
+	**                                                                 **
+	********************************************************************/
+
+	/* scan for the epc raster keyword, exit if not next */
+	if (ok && scan_value(init, keyword, 's'))
+	{
+		bgc_printf(BV_ERROR, "Error reading keyword for epc raster: epcrast_init()\n");
+		ok=0;
+	}
+	if (ok && strcmp(keyword, key1))
+	{
+		bgc_printf(BV_ERROR, "Expecting keyword --> %s in file %s\n",key1,init.name);
+		ok=0;
+	}
+
+	/* epc index layer */
+	if (ok && scan_value(init, name, 's'))
+	{
+		bgc_printf(BV_ERROR, "Error reading epc index raster filename: epcrast_init()\n");
+		ok=0;
+	}
+	if (ok && !(region->epcidx = (float*) malloc(region->grid.ncells * sizeof(float))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating for epc index raster: epcrast_init()\n");
+		ok=0;
+	}
+	if (ok && raster_read(name, &region->grid, region->epcidx))
+	{
+		bgc_printf(BV_ERROR, "Error reading epc index raster %s: epcrast_init()\n",name);
+		ok=0;
+	}
+
+	/* the epc files, in index order */
+	if (ok && scan_value(init, &region->nepc, 'i'))
+	{
+		bgc_printf(BV_ERROR, "Error reading number of epc files: epcrast_init()\n");
+		ok=0;
+	}
+	if (ok && region->nepc < 1)
+	{
+		bgc_printf(BV_ERROR, "Error: at least one epc file is needed: epcrast_init()\n");
+		ok=0;
+	}
+	if (ok && !(region->epc = (epconst_struct*) malloc(region->nepc * sizeof(epconst_struct))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating for epc array: epcrast_init()\n");
+		ok=0;
+	}
+	for (i=0 ; ok && i<region->nepc ; i++)
+	{
+		if (scan_open(init, &temp, 'r'))
+		{
+			bgc_printf(BV_ERROR, "Error opening epc file #%d: epcrast_init()\n",i);
+			ok=0;
+		}
+		if (ok)
+		{
+			if (epc_read(temp, &region->epc[i]))
+			{
+				bgc_printf(BV_ERROR, "Error reading epc file %s: epcrast_init()\n",temp.name);
+				ok=0;
+			}
+			fclose(temp.ptr);
+		}
+	}
+
+	return (!ok);
+}
+
+/* read the W_STATE block. The initial soil water depends on the soil
+constants of each cell, so only the proportion of saturation is kept
+here. */
+int region_wstate_init(file init, region_struct* region)
+{
+	int ok = 1;
+	char key[] = "W_STATE";
+	char keyword[80];
+
+	if (ok && scan_value(init, keyword, 's'))
+	{
+		bgc_printf(BV_ERROR, "Error reading keyword, region_wstate_init()\n");
+		ok=0;
+	}
+	if (ok && strcmp(keyword,key))
+	{
+		bgc_printf(BV_ERROR, "Expecting keyword --> %s in %s\n",key,init.name);
+		ok=0;
+	}
+	if (ok && scan_value(init, &region->snoww, 'd'))
+	{
+		bgc_printf(BV_ERROR, "Error reading snowpack, region_wstate_init()\n");
+		ok=0;
+	}
+	if (ok && scan_value(init, &region->psat, 'd'))
+	{
+		bgc_printf(BV_ERROR, "Error reading soilwater, region_wstate_init()\n");
+		ok=0;
+	}
+
+	/* check that psat is an acceptable proportion  */
+	if (ok && (region->psat < 0.0 || region->psat > 1.0))
+	{
+		bgc_printf(BV_ERROR, "Error: initial soil water proportion must be >= 0.0 and <= 1.0\n");
+		ok=0;
+	}
+
+	return (!ok);
+}
+
+int region_ctrl(file init, region_struct* region)
+{
+	int ok = 1;
+	int i;
+	char key1[] = "REGION_CONTROL";
+	char key2[] = "ANNUAL_OUTPUT";
+	char keyword[80];
+
+	/********************************************************************
+	**                                                                 **
+	** Begin reading initialization file block starting with keyword:  **
+	** REGION_CONTROL                                                  **
+	**                                                                 **
+	********************************************************************/
+
+	/* scan for the region control keyword, exit if not next */
+	if (ok && scan_value(init, keyword, 's'))
+	{
+		bgc_printf(BV_ERROR, "Error reading keyword for region control: region_ctrl()\n");
+		ok=0;
+	}
+	if (ok && strcmp(keyword, key1))
+	{
+		bgc_printf(BV_ERROR, "Expecting keyword --> %s in file %s\n",key1,init.name);
+		ok=0;
+	}
+	if (ok && scan_value(init, region->outprefix, 's'))
+	{
+		bgc_printf(BV_ERROR, "Error reading output raster prefix: region_ctrl()\n");
+		ok=0;
+	}
+	if (ok && scan_value(init, &region->nthreads, 'i'))
+	{
+		bgc_printf(BV_ERROR, "Error reading number of threads: region_ctrl()\n");
+		ok=0;
+	}
+	if (ok && scan_value(init, &region->cachekb, 'i'))
+	{
+		bgc_printf(BV_ERROR, "Error reading tile met cache size: region_ctrl()\n");
+		ok=0;
+	}
+
+	/********************************************************************
+	**                                                                 **
+	** Begin reading initialization file block starting with keyword:  **
+	** ANNUAL_OUTPUT                                                   **
+	**                                                                 **
+	********************************************************************/
+
+	/* scan for the output file block keyword, exit if not next */
+	if (ok && scan_value(init, keyword, 's'))
+	{
+		bgc_printf(BV_ERROR, "Error reading keyword for output file data\n");
+		ok=0;
+	}
+	if (ok && strcmp(keyword, key2))
+	{
+		bgc_printf(BV_ERROR, "Expecting keyword --> %s in file %s\n",key2,init.name);
+		ok=0;
+	}
+
+	/* read the number of annual output variables */
+	if (ok && scan_value(init, &region->nannout, 'i'))
+	{
+		bgc_printf(BV_ERROR, "Error reading number of annual outputs: region_ctrl()\n");
+		ok=0;
+	}
+	if (ok && region->nannout < 1)
+	{
+		bgc_printf(BV_ERROR, "ERROR! You are trying to run the model with no output variables. Please add some output variables to your ini file.\n");
+		ok=0;
+	}
+	/* allocate space for the annual output variable indices */
+	if (ok && !(region->anncodes = (int*) malloc(region->nannout * sizeof(int))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating for anncodes array: region_ctrl()\n");
+		ok=0;
+	}
+	/* begin loop to read in the annual output variable indices */
+	for (i=0 ; ok && i<region->nannout ; i++)
+	{
+		if (scan_value(init, &(region->anncodes[i]), 'i'))
+		{
+			bgc_printf(BV_ERROR, "Error reading annual output #%d: region_ctrl()\n",i);
+			ok=0;
+		}
+		if (ok && (region->anncodes[i] < 0 || region->anncodes[i] >= NMAP))
+		{
+			bgc_printf(BV_ERROR, "Error: annual output code %d out of range: region_ctrl()\n",region->anncodes[i]);
+			ok=0;
+		}
+	}
+
+	return (!ok);
+}
+
+/* open one output raster stack for each annual output code, and write a
+text description of the grid and stacks alongside them */
+int region_output_init(region_struct* region)
+{
+	int ok = 1;
+	int i;
+	file desc;
+
+	if (!(region->annout = (file*) malloc(region->nannout * sizeof(file))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating for output files: region_output_init()\n");
+		ok=0;
+	}
+	for (i=0 ; ok && i<region->nannout ; i++)
+	{
+		sprintf(region->annout[i].name, "%s_%d.flt", region->outprefix, region->anncodes[i]);
+		if (file_open(&region->annout[i], 'w'))
+		{
+			bgc_printf(BV_ERROR, "Error opening output raster %s: region_output_init()\n",region->annout[i].name);
+			ok=0;
+		}
+	}
+
+	sprintf(desc.name, "%s.txt", region->outprefix);
+	if (ok && file_open(&desc, 'o'))
+	{
+		bgc_printf(BV_ERROR, "Error opening output description %s: region_output_init()\n",desc.name);
+		ok=0;
+	}
+	if (ok)
+	{
+		fprintf(desc.ptr, "%s", region->header);
+		fprintf(desc.ptr, "columns  %d\n", region->grid.ncols);
+		fprintf(desc.ptr, "rows     %d\n", region->grid.nrows);
+		fprintf(desc.ptr, "nodata   %g\n", region->grid.nodata);
+		fprintf(desc.ptr, "bands    %d (one per simulation year, first year %d)\n",
+			region->tmpl.ctrl.simyears, region->tmpl.ctrl.simstartyear);
+		fprintf(desc.ptr, "type     32-bit float, native byte order, row-major\n");
+		for (i=0 ; i<region->nannout ; i++)
+		{
+			fprintf(desc.ptr, "output   %d %s\n", region->anncodes[i], region->annout[i].name);
+		}
+		fclose(desc.ptr);
+	}
+
+	return (!ok);
+}
@@ -0,0 +1,385 @@
+/*
+region_tile.c
+split the grid into tiles and run them on the worker threads
+
+A tile is a run of consecutive cells in row-major order holding at most
+region->tilecells land cells. The met for the land cells of a tile is
+read from the raster stacks into one buffer, cell by cell, sized so that
+it stays in the processor cache while the cells run. The tiles together
+cover the whole grid, so writing every tile's outputs (nodata for the
+cells that are not run) fills the output rasters.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#include "regionbgc.h"
+
+/* met raster variable names, in MET_* order */
+static const char* metvar_names[NMETVAR] = {"tmax", "tmin", "prcp", "vpd",
+	"srad", "dayl"};
+
+static int region_tile_run(region_worker_struct* w, long tile);
+static int region_cell_run(region_worker_struct* w, long cell, long k,
+	long start);
+
+/* find the land cells and set the tile boundaries */
+int region_tiles(region_struct* region)
+{
+	int ok = 1;
+	int i;
+	long c, n, ntiles;
+	long metbytes;
+	float idx;
+	const grid_struct* grid = &region->grid;
+
+	if (!(region->land = (unsigned char*) malloc(grid->ncells)))
+	{
+		bgc_printf(BV_ERROR, "Error allocating for land mask: region_tiles()\n");
+		ok=0;
+	}
+
+	/* a cell is run if it has a valid epc index and all of the site
+	constants */
+	region->nland = 0;
+	for (c=0 ; ok && c<grid->ncells ; c++)
+	{
+		idx = region->epcidx[c];
+		region->land[c] = (idx != grid->nodata && idx >= 0.0 &&
+			idx < (float)region->nepc && idx == (float)(int)idx);
+		for (i=0 ; i<NSITELAYER ; i++)
+		{
+			if (region->site[i][c] == grid->nodata) region->land[c] = 0;
+		}
+		if (region->land[c]) region->nland++;
+	}
+	if (ok && region->nland == 0)
+	{
+		bgc_printf(BV_ERROR, "Error: no cells with a valid epc index and site constants: region_tiles()\n");
+		ok=0;
+	}
+
+	/* size the tiles so that the met for one tile fits in cachekb */
+	if (ok)
+	{
+		metbytes = (long)NMETVAR * 365 * region->tmpl.ctrl.metyears * (long)sizeof(float);
+		region->tilecells = (long)region->cachekb * 1024 / metbytes;
+		if (region->tilecells < 1) region->tilecells = 1;
+	}
+
+	/* count the tiles, then set their first cells. A new tile starts at
+	the first land cell after a full tile, so the cells with no data
+	between tiles belong to the tile before them. */
+	if (ok)
+	{
+		ntiles = (region->nland + region->tilecells - 1) / region->tilecells;
+		if (!(region->tile_start = (long*) malloc((ntiles+1) * sizeof(long))))
+		{
+			bgc_printf(BV_ERROR, "Error allocating for tile array: region_tiles()\n");
+			ok=0;
+		}
+	}
+	if (ok)
+	{
+		region->ntiles = 0;
+		region->tile_start[0] = 0;
+		n = 0;
+		for (c=0 ; c<grid->ncells ; c++)
+		{
+			if (!region->land[c]) continue;
+			if (n == region->tilecells)
+			{
+				region->tile_start[++region->ntiles] = c;
+				n = 0;
+			}
+			n++;
+		}
+		region->tile_start[++region->ntiles] = grid->ncells;
+
+		region->maxspan = 0;
+		for (c=0 ; c<region->ntiles ; c++)
+		{
+			n = region->tile_start[c+1] - region->tile_start[c];
+			if (n > region->maxspan) region->maxspan = n;
+		}
+	}
+
+	return (!ok);
+}
+
+/* worker thread: take tiles from the shared counter until they are all
+done or a worker has hit an error that stops the run */
+void* region_worker(void* arg)
+{
+	region_worker_struct* w = (region_worker_struct*) arg;
+	region_struct* region = w->region;
+	long tile;
+
+	while (1)
+	{
+		pthread_mutex_lock(&region->lock);
+		tile = (region->ok && region->next_tile < region->ntiles) ?
+			region->next_tile++ : -1;
+		pthread_mutex_unlock(&region->lock);
+		if (tile < 0) break;
+
+		if (region_tile_run(w, tile))
+		{
+			bgc_printf(BV_ERROR, "Error in call to region_tile_run() for tile %ld, worker %d\n",tile,w->id);
+			pthread_mutex_lock(&region->lock);
+			region->ok = 0;
+			pthread_mutex_unlock(&region->lock);
+		}
+	}
+
+	return NULL;
+}
+
+static int region_tile_run(region_worker_struct* w, long tile)
+{
+	int ok = 1;
+	int v, y, d, j;
+	long c, k, ndays, span, start, nl, nfail;
+	long nout;
+	file metf;
+	region_struct* region = w->region;
+	const grid_struct* grid = &region->grid;
+	int simyears = region->tmpl.ctrl.simyears;
+
+	start = region->tile_start[tile];
+	span = region->tile_start[tile+1] - start;
+	ndays = 365 * region->tmpl.ctrl.metyears;
+
+	/* read the met for the land cells, one band at a time, into the
+	tile buffer as [land cell][var][day] */
+	for (y=0 ; ok && y<region->tmpl.ctrl.metyears ; y++)
+	{
+		for (v=0 ; ok && v<NMETVAR ; v++)
+		{
+			sprintf(metf.name, "%s_%s_%d.flt", region->metprefix, metvar_names[v],
+				region->metfirstyr + y);
+			if (file_open(&metf, 'r'))
+			{
+				bgc_printf(BV_ERROR, "Error opening met raster %s: region_tile_run()\n",metf.name);
+				ok=0;
+				break;
+			}
+			for (d=0 ; ok && d<365 ; d++)
+			{
+				if (raster_read_span(metf.ptr, grid, d, start, span, w->span))
+				{
+					bgc_printf(BV_ERROR, "Error reading met raster %s: region_tile_run()\n",metf.name);
+					ok=0;
+				}
+				for (c=0, k=0 ; ok && c<span ; c++)
+				{
+					if (!region->land[start+c]) continue;
+					w->met[(k*NMETVAR + v)*ndays + y*365 + d] = w->span[c];
+					k++;
+				}
+			}
+			fclose(metf.ptr);
+		}
+	}
+
+	/* outputs start as nodata, and are filled in by the land cells that
+	run without error */
+	nout = (long)region->nannout * simyears * region->maxspan;
+	for (c=0 ; c<nout ; c++)
+	{
+		w->out[c] = grid->nodata;
+	}
+
+	/* run the land cells */
+	nl = 0;
+	nfail = 0;
+	for (c=0 ; ok && c<span ; c++)
+	{
+		if (!region->land[start+c]) continue;
+		if (region_cell_run(w, start+c, nl, start))
+		{
+			bgc_printf(BV_WARN, "Warning: cell at row %ld, column %ld failed, outputs set to nodata\n",
+				(start+c)/grid->ncols, (start+c)%grid->ncols);
+			for (j=0 ; j<region->nannout ; j++)
+			{
+				for (y=0 ; y<simyears ; y++)
+				{
+					w->out[((long)j*simyears + y)*region->maxspan + c] = grid->nodata;
+				}
+			}
+			nfail++;
+		}
+		nl++;
+	}
+
+	/* write the tile into each output stack, one band per year */
+	pthread_mutex_lock(&region->lock);
+	for (j=0 ; ok && j<region->nannout ; j++)
+	{
+		for (y=0 ; ok && y<simyears ; y++)
+		{
+			if (raster_write_span(region->annout[j].ptr, grid, y, start, span,
+				&w->out[((long)j*simyears + y)*region->maxspan]))
+			{
+				bgc_printf(BV_ERROR, "Error writing output raster %s: region_tile_run()\n",region->annout[j].name);
+				ok=0;
+			}
+		}
+	}
+	region->ndone += nl;
+	region->nfail += nfail;
+	bgc_printf(BV_PROGRESS, "Tile %ld of %ld done: %ld of %ld land cells finished\n",
+		tile+1, region->ntiles, region->ndone, region->nland);
+	pthread_mutex_unlock(&region->lock);
+
+	return (!ok);
+}
+
+/* run one land cell. cell is its index in the grid, k its index among
+the land cells of the tile, and start the first cell of the tile. */
+static int region_cell_run(region_worker_struct* w, long cell, long k,
+	long start)
+{
+	int ok = 1;
+	int j, y, siminit = 0;
+	long i, ndays;
+	double sand, silt, clay, sum;
+	float* met;
+	region_struct* region = w->region;
+	const epconst_struct* epc;
+	int simyears = region->tmpl.ctrl.simyears;
+	bgcin_struct bgcin;
+	bgcout_struct bgcout;
+	bgcsim_struct sim;
+
+	ndays = 365 * region->tmpl.ctrl.metyears;
+	bgcin = region->tmpl;
+	memset(&bgcout, 0, sizeof(bgcout_struct));
+
+	/* site constants. Texture is scaled to sum to exactly 100%, since
+	the layers are stored as floats. */
+	bgcin.sitec.soil_depth = region->site[SITE_DEPTH][cell];
+	bgcin.sitec.elev = region->site[SITE_ELEV][cell];
+	bgcin.sitec.lat = region->site[SITE_LAT][cell];
+	bgcin.sitec.sw_alb = region->site[SITE_ALBEDO][cell];
+	bgcin.sitec.ndep = region->site[SITE_NDEP][cell];
+	bgcin.sitec.nfix = region->site[SITE_NFIX][cell];
+	sand = region->site[SITE_SAND][cell];
+	silt = region->site[SITE_SILT][cell];
+	clay = region->site[SITE_CLAY][cell];
+	sum = sand + silt + clay;
+	if (fabs(sum - 100.0) > 1.0)
+	{
+		bgc_printf(BV_ERROR, "Error: %%sand + %%silt + %%clay = %.2f in cell %ld\n",sum,cell);
+		ok=0;
+	}
+	if (ok && sitec_soil_init(&bgcin.sitec, sand*100.0/sum, silt*100.0/sum,
+		clay*100.0/sum))
+	{
+		bgc_printf(BV_ERROR, "Error in call to sitec_soil_init() from region_cell_run()\n");
+		ok=0;
+	}
+
+	/* ecophysiological constants, and the initial litter and CWD
+	nitrogen that follow from them, as in cnstate_init() */
+	epc = &region->epc[(int)region->epcidx[cell]];
+	bgcin.epc = *epc;
+	bgcin.ns.cwdn = bgcin.cs.cwdc / epc->deadwood_cn;
+	bgcin.ns.litr2n = bgcin.cs.litr2c / epc->leaflitr_cn;
+	bgcin.ns.litr3n = bgcin.cs.litr3c / epc->leaflitr_cn;
+	bgcin.ns.litr4n = bgcin.cs.litr4c / epc->leaflitr_cn;
+
+	/* initial water state, as in wstate_init() */
+	bgcin.ws.snoww = region->snoww;
+	bgcin.ws.soilw = bgcin.sitec.vwc_sat * region->psat * bgcin.sitec.soil_depth * 1000.0;
+
+	/* if using ramped Ndep, copy preindustrial Ndep into ramp_ndep struct */
+	if (bgcin.ramp_ndep.doramp)
+	{
+		bgcin.ramp_ndep.preind_ndep = bgcin.sitec.ndep;
+	}
+
+	/* met arrays from the tile buffer, as in metarr_init() */
+	met = w->met + k*NMETVAR*ndays;
+	for (i=0 ; ok && i<ndays ; i++)
+	{
+		metarr_set_day(&w->metarr, i, &region->scc, met[MET_TMAX*ndays+i],
+			met[MET_TMIN*ndays+i], met[MET_PRCP*ndays+i], met[MET_VPD*ndays+i],
+			met[MET_SRAD*ndays+i], met[MET_DAYL*ndays+i]);
+	}
+	if (ok && run_avg(w->metarr.tavg, w->metarr.tavg_ra, ndays, 11, 1))
+	{
+		bgc_printf(BV_ERROR, "Error: run_avg() in region_cell_run()\n");
+		ok=0;
+	}
+	bgcin.metarr = w->metarr;
+
+	/* spinup, then start the model run from the spinup state */
+	if (ok && bgcin.ctrl.spinup)
+	{
+		if (bgc(&bgcin, &bgcout, MODE_SPINUP))
+		{
+			bgc_printf(BV_ERROR, "Error in spinup call to bgc() from region_cell_run()\n");
+			ok=0;
+		}
+		bgcin.ctrl.spinup = 0;
+		bgcin.ctrl.read_restart = 1;
+		bgcin.restart_input = bgcout.restart_output;
+	}
+
+	/* model run, keeping the annual outputs at the end of each year */
+	if (ok)
+	{
+		if (bgcsim_init(&sim, &bgcin, &bgcout, MODE_MODEL))
+		{
+			bgc_printf(BV_ERROR, "Error in call to bgcsim_init() from region_cell_run()\n");
+			ok=0;
+		}
+		siminit = 1;
+	}
+	for (y=0 ; ok && !sim.done && y<simyears ; y++)
+	{
+		if (bgcsim_step_year(&sim))
+		{
+			bgc_printf(BV_ERROR, "Error in call to bgcsim_step_year() from region_cell_run()\n");
+			ok=0;
+		}
+		for (j=0 ; ok && j<region->nannout ; j++)
+		{
+			w->out[((long)j*simyears + y)*region->maxspan + cell - start] =
+				(float) *sim.output_map[region->anncodes[j]];
+		}
+	}
+	if (siminit && bgcsim_free(&sim))
+	{
+		bgc_printf(BV_ERROR, "Error in call to bgcsim_free() from region_cell_run()\n");
+		ok=0;
+	}
+
+	return (!ok);
+}
+
+/* free the memory held in the region structure */
+int region_free(region_struct* region)
+{
+	int i;
+
+	for (i=0 ; i<NSITELAYER ; i++)
+	{
+		free(region->site[i]);
+	}
+	free(region->epcidx);
+	free(region->land);
+	free(region->epc);
+	free(region->anncodes);
+	free(region->annout);
+	free(region->tile_start);
+	if (region->tmpl.co2.varco2) free(region->tmpl.co2.co2ppm_array);
+	if (region->tmpl.co2.varco2) free(region->tmpl.co2.co2year_array);
+	if (region->tmpl.ndepctrl.varndep) free(region->tmpl.ndepctrl.ndepyear_array);
+	if (region->tmpl.ndepctrl.varndep) free(region->tmpl.ndepctrl.ndep_array);
+
+	return (0);
+}
@@ -0,0 +1,315 @@
+/*
+regionbgc.c
+front-end to BIOME-BGC for gridded regional simulations
+Uses BIOME-BGC function library
+
+Reads the daily met as binary raster stacks and the site constants and
+epc index as raster layers, runs every land cell on a pool of threads,
+and writes one raster stack of annual values per output code. See the
+regional simulations section of USAGE.TXT for the file formats.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#include "regionbgc.h"
+
+char *argv_zero = NULL;
+signed char cli_mode = MODE_INI;
+
+static void region_print_usage(void)
+{
+	bgc_printf(BV_ERROR, "\nusage: %s {-l <logfile>} {-s | -v [0..4]} {-V} {-b <mode>} {-t <threads>} <region ini file>\n\n", argv_zero);
+	bgc_printf(BV_ERROR, "       -l <logfile> send output to logfile, overwrite old logfile\n");
+	bgc_printf(BV_ERROR, "       -V print version number and build information and exit\n");
+	bgc_printf(BV_ERROR, "       -s run in silent mode, no standard out or error\n");
+	bgc_printf(BV_ERROR, "       -v [0..4] set the verbosity level\n");
+	bgc_printf(BV_ERROR, "       -b <mode> mass balance check mode (see USAGE.TXT)\n");
+	bgc_printf(BV_ERROR, "       -t <threads> number of worker threads, overrides the ini file\n");
+}
+
+int main(int argc, char *argv[])
+{
+	region_struct region;
+	region_worker_struct* workers = NULL;
+	pthread_t* threads = NULL;
+	file init;
+	int c, i, ok = 1;
+	int nthreads = -1;
+	long ndays, nmet, nout;
+	extern signed char bgc_verbosity;
+	extern int optind, opterr;
+	extern char *optarg;
+	int balance_mode = BALANCE_DAILY;	/* mass balance check mode, set with -b */
+	int balance_interval = 1;
+
+	memset(&region, 0, sizeof(region_struct));
+
+	/* Store command name for use by region_print_usage() */
+	argv_zero = (char *)malloc(strlen(argv[0])+1);
+	strncpy(argv_zero, argv[0], strlen(argv[0])+1);
+
+	/* Process command line arguments */
+	opterr = 0;
+	while((c = getopt(argc, argv, "Vsl:v:b:t:")) != -1)
+	{
+		switch(c)
+		{
+			case 'V':
+				bgc_printf(BV_ERROR, "BiomeBGC version %s (built %s %s by %s on %s)\n", VERS, __DATE__, __TIME__, USER, HOST);
+				exit(EXIT_SUCCESS);
+				break;
+			case 's':
+				bgc_verbosity = BV_SILENT;
+				break;
+			case 'v':
+				bgc_verbosity = bgc_verbosity_decode(optarg);
+				if (bgc_verbosity == BV_UNKNOWN) exit(EXIT_FAILURE);
+				break;
+			case 'l':
+				if (bgc_logfile_setup(optarg)) exit(EXIT_FAILURE);
+				bgc_printf(BV_DIAG, "Using logfile for output.\n");
+				break;
+			case 'b':  /* mass balance check mode */
+				balance_mode = bgc_balance_decode(optarg, &balance_interval);
+				if (balance_mode == BALANCE_UNKNOWN) exit(EXIT_FAILURE);
+				break;
+			case 't':  /* number of worker threads */
+				nthreads = atoi(optarg);
+				break;
+			case '?':
+				break;
+			default:
+				break;
+		}
+	}
+
+	/* initialize the template state variable structures before filling
+	with values from ini file */
+	if (presim_state_init(&region.tmpl.ws, &region.tmpl.cs, &region.tmpl.ns, &region.tmpl.cinit))
+	{
+		bgc_printf(BV_ERROR, "Error in call to presim_state_init() from regionbgc()\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/******************************
+	**                           **
+	**  BEGIN READING INIT FILE  **
+	**                           **
+	******************************/
+
+	if (optind >= argc)
+	{
+		region_print_usage();
+		exit(EXIT_FAILURE);
+	}
+	strcpy(init.name, argv[optind]);
+	if (file_open(&init,'i'))
+	{
+		bgc_printf(BV_ERROR, "Error opening init file, regionbgc.c\n");
+		exit(EXIT_FAILURE);
+	}
+	if (fgets(region.header, 100, init.ptr)==NULL)
+	{
+		bgc_printf(BV_ERROR, "Error reading header string: regionbgc.c\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/* the blocks that describe the grid and the met rasters come first,
+	then the point ini blocks with the per-cell values replaced by
+	raster layers */
+	if (ok && grid_init(init, &region.grid))
+	{
+		bgc_printf(BV_ERROR, "Error in call to grid_init() from regionbgc.c... Exiting\n");
+		ok=0;
+	}
+	if (ok && metrast_init(init, &region))
+	{
+		bgc_printf(BV_ERROR, "Error in call to metrast_init() from regionbgc.c... Exiting\n");
+		ok=0;
+	}
+	if (ok && time_init(init, &region.tmpl.ctrl))
+	{
+		bgc_printf(BV_ERROR, "Error in call to time_init() from regionbgc.c... Exiting\n");
+		ok=0;
+	}
+	if (ok && scc_init(init, &region.scc))
+	{
+		bgc_printf(BV_ERROR, "Error in call to scc_init() from regionbgc.c... Exiting\n");
+		ok=0;
+	}
+	if (ok && co2_init(init, &region.tmpl.co2, region.tmpl.ctrl.simyears, NULL))
+	{
+		bgc_printf(BV_ERROR, "Error in call to co2_init() from regionbgc.c... Exiting\n");
+		ok=0;
+	}
+	if (ok && siterast_init(init, &region))
+	{
+		bgc_printf(BV_ERROR, "Error in call to siterast_init() from regionbgc.c... Exiting\n");
+		ok=0;
+	}
+	if (ok && ramp_ndep_init(init, &region.tmpl.ramp_ndep))
+	{
+		bgc_printf(BV_ERROR, "Error in call to ramp_ndep_init() from regionbgc.c... Exiting\n");
+		ok=0;
+	}
+	if (ok && epcrast_init(init, &region))
+	{
+		bgc_printf(BV_ERROR, "Error in call to epcrast_init() from regionbgc.c... Exiting\n");
+		ok=0;
+	}
+	if (ok && region_wstate_init(init, &region))
+	{
+		bgc_printf(BV_ERROR, "Error in call to region_wstate_init() from regionbgc.c... Exiting\n");
+		ok=0;
+	}
+	/* the C and N pools are read with the first epc, and the N pools that
+	depend on the epc are set again for each cell */
+	if (ok && cnstate_init(init, &region.epc[0], &region.tmpl.cs, &region.tmpl.cinit,
+		&region.tmpl.ns))
+	{
+		bgc_printf(BV_ERROR, "Error in call to cnstate_init() from regionbgc.c... Exiting\n");
+		ok=0;
+	}
+	if (ok && region_ctrl(init, &region))
+	{
+		bgc_printf(BV_ERROR, "Error in call to region_ctrl() from regionbgc.c... Exiting\n");
+		ok=0;
+	}
+	if (ok && end_init(init))
+	{
+		bgc_printf(BV_ERROR, "Error in call to end_init() from regionbgc.c... Exiting\n");
+		ok=0;
+	}
+	fclose(init.ptr);
+	if (!ok) exit(EXIT_FAILURE);
+
+	/* simulation control shared by all cells. The cells write no files
+	of their own, their annual outputs are taken from the output map. */
+	region.tmpl.ctrl.onscreen = 0;
+	region.tmpl.ctrl.dodaily = 0;
+	region.tmpl.ctrl.domonavg = 0;
+	region.tmpl.ctrl.doannavg = 0;
+	region.tmpl.ctrl.doannual = 0;
+	region.tmpl.ctrl.ndayout = 0;
+	region.tmpl.ctrl.nannout = 0;
+	region.tmpl.ctrl.daycodes = NULL;
+	region.tmpl.ctrl.anncodes = NULL;
+	region.tmpl.ctrl.read_restart = 0;
+	region.tmpl.ctrl.write_restart = 0;
+	region.tmpl.ctrl.keep_metyr = 0;
+	region.tmpl.ctrl.balance_mode = balance_mode;
+	region.tmpl.ctrl.balance_interval = balance_interval;
+	region.tmpl.ndepctrl.varndep = 0;
+
+	/* land cells and tiles */
+	if (region_tiles(&region))
+	{
+		bgc_printf(BV_ERROR, "Error in call to region_tiles() from regionbgc.c... Exiting\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/* number of worker threads, 0 = one per processor */
+	if (nthreads >= 0) region.nthreads = nthreads;
+	if (region.nthreads <= 0) region.nthreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	if (region.nthreads <= 0) region.nthreads = 1;
+	if (region.nthreads > region.ntiles) region.nthreads = (int) region.ntiles;
+
+	bgc_printf(BV_PROGRESS, "Grid %d x %d, %ld land cells in %ld tiles of up to %ld cells, %d threads\n",
+		region.grid.ncols, region.grid.nrows, region.nland, region.ntiles,
+		region.tilecells, region.nthreads);
+
+	/* output raster stacks */
+	if (region_output_init(&region))
+	{
+		bgc_printf(BV_ERROR, "Error in call to region_output_init() from regionbgc.c... Exiting\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/* worker storage */
+	ndays = 365 * region.tmpl.ctrl.metyears;
+	nmet = region.tilecells * NMETVAR * ndays;
+	nout = (long)region.nannout * region.tmpl.ctrl.simyears * region.maxspan;
+	if (!(workers = (region_worker_struct*) calloc(region.nthreads, sizeof(region_worker_struct))) ||
+		!(threads = (pthread_t*) malloc(region.nthreads * sizeof(pthread_t))))
+	{
+		bgc_printf(BV_ERROR, "Error allocating for worker threads, regionbgc.c\n");
+		exit(EXIT_FAILURE);
+	}
+	for (i=0 ; i<region.nthreads ; i++)
+	{
+		workers[i].region = &region;
+		workers[i].id = i;
+		if (!(workers[i].span = (float*) malloc(region.maxspan * sizeof(float))) ||
+			!(workers[i].met = (float*) malloc(nmet * sizeof(float))) ||
+			!(workers[i].out = (float*) malloc(nout * sizeof(float))) ||
+			metarr_alloc(&workers[i].metarr, region.tmpl.ctrl.metyears, NULL))
+		{
+			bgc_printf(BV_ERROR, "Error allocating for worker %d, regionbgc.c\n",i);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	/*********************
+	**                  **
+	**  CALL BIOME-BGC  **
+	**                  **
+	*********************/
+
+	region.ok = 1;
+	region.next_tile = 0;
+	pthread_mutex_init(&region.lock, NULL);
+	for (i=0 ; i<region.nthreads ; i++)
+	{
+		if (pthread_create(&threads[i], NULL, region_worker, &workers[i]))
+		{
+			bgc_printf(BV_ERROR, "Error starting worker thread %d, regionbgc.c\n",i);
+			exit(EXIT_FAILURE);
+		}
+	}
+	for (i=0 ; i<region.nthreads ; i++)
+	{
+		pthread_join(threads[i], NULL);
+	}
+	pthread_mutex_destroy(&region.lock);
+	ok = region.ok;
+
+	if (region.nfail)
+	{
+		bgc_printf(BV_WARN, "Warning: %ld of %ld land cells failed and are nodata in the outputs\n",
+			region.nfail, region.nland);
+	}
+
+	/* close files and free memory */
+	for (i=0 ; i<region.nannout ; i++)
+	{
+		if (fclose(region.annout[i].ptr) != 0)
+		{
+			bgc_printf(BV_WARN, "Warning, error closing output raster %s: %s\n", region.annout[i].name, strerror(errno));
+		}
+	}
+	for (i=0 ; i<region.nthreads ; i++)
+	{
+		free(workers[i].span);
+		free(workers[i].met);
+		free(workers[i].out);
+		free(workers[i].metarr.tmax);
+		free(workers[i].metarr.tmin);
+		free(workers[i].metarr.prcp);
+		free(workers[i].metarr.vpd);
+		free(workers[i].metarr.tavg);
+		free(workers[i].metarr.tavg_ra);
+		free(workers[i].metarr.swavgfd);
+		free(workers[i].metarr.par);
+		free(workers[i].metarr.dayl);
+	}
+	free(workers);
+	free(threads);
+	region_free(&region);
+
+	bgc_logfile_finish();
+	free(argv_zero);
+	return (ok ? EXIT_SUCCESS : EXIT_FAILURE);
+} /* end of main */
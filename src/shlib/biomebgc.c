@@ -0,0 +1,81 @@
+/*
+biomebgc.c
+entry points of the Biome-BGC shared library that are not part of the
+core science library or of the pointbgc readers (see biomebgc.h)
+
+The executables define argv_zero and cli_mode in their main file. The
+library defines them here, for the programs that embed it.
+
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+Biome-BGC version 4.2 (final release)
+See copyright.txt for Copyright information
+*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+*/
+
+#include "biomebgc.h"
+
+char *argv_zero = "libbiomebgc";
+signed char cli_mode = MODE_INI;
+
+int biomebgc_version(int* major, int* minor)
+{
+	if (major) *major = BIOMEBGC_VERSION_MAJOR;
+	if (minor) *minor = BIOMEBGC_VERSION_MINOR;
+
+	return (BIOMEBGC_API);
+}
+
+int biomebgc_api(void)
+{
+	return (BIOMEBGC_API);
+}
+
+void biomebgc_set_verbosity(int level)
+{
+	extern signed char bgc_verbosity;
+
+	bgc_verbosity = (signed char) level;
+}
+
+void biomebgc_set_mode(int mode)
+{
+	cli_mode = (signed char) mode;
+}
+
+/* zeroed, ready for point_read() */
+point_input_struct* biomebgc_point_alloc(void)
+{
+	return ((point_input_struct*) calloc(1, sizeof(point_input_struct)));
+}
+
+/* free a simulation from biomebgc_point_alloc(). Call point_close()
+first if point_read() succeeded on it. */
+void biomebgc_point_free(point_input_struct* pin)
+{
+	free(pin);
+}
+
+/* the options of the bgc executable run with no flags */
+void biomebgc_opts_init(point_opts_struct* opts)
+{
+	memset(opts, 0, sizeof(point_opts_struct));
+	opts->balance_mode = BALANCE_DAILY;
+	opts->balance_interval = 1;
+}
+
+point_opts_struct* biomebgc_opts_alloc(void)
+{
+	point_opts_struct* opts;
+
+	if ((opts = (point_opts_struct*) malloc(sizeof(point_opts_struct))))
+	{
+		biomebgc_opts_init(opts);
+	}
+
+	return (opts);
+}
+
+void biomebgc_opts_free(point_opts_struct* opts)
+{
+	free(opts);
+}